@@ -0,0 +1,517 @@
+// =============================================================================
+// nLEaP - prepare input for the AMBER molecular mechanics programs
+// -----------------------------------------------------------------------------
+//    Copyright (C) 2010 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+
+#include <stdio.h>
+#include <ErrorSystem.hpp>
+#include "bench.hpp"
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <math.h>
+#include <FileName.hpp>
+#include <engine/Profiler.hpp>
+#include <types/Factory.hpp>
+#include <core/PredefinedKeys.hpp>
+#include <format/AmberParams.hpp>
+#include <format/AmberOFF.hpp>
+#include <format/SybylMol2.hpp>
+#include <misc/UnitTopology.hpp>
+
+using namespace std;
+using namespace nleap;
+
+//------------------------------------------------------------------------------
+
+// distance between copies of residues in the test system
+#define RESIDUE_SPACING 12.0
+
+// maximum distance of bonded atoms
+#define BOND_DISTANCE   1.9
+
+//------------------------------------------------------------------------------
+
+const SBenchmark CNLEaPBench::Benchmarks[] = {
+    { "property_get",   "micro", "atoms",    100, &CNLEaPBench::PropertyGet },
+    { "property_set",   "micro", "atoms",    100, &CNLEaPBench::PropertySet },
+    { "ff_lookup",      "micro", "lookups",   20, &CNLEaPBench::FFLookup },
+    { "mask_select",    "micro", "masks",     20, &CNLEaPBench::MaskSelect },
+    { "read_parm99",    "macro", "bytes",      5, &CNLEaPBench::ReadParams },
+    { "read_amino94",   "macro", "bytes",      5, &CNLEaPBench::ReadOFF },
+    { "read_mol2",      "macro", "bytes",      5, &CNLEaPBench::ReadMol2 },
+    { "clone_database", "macro", "entities",   5, &CNLEaPBench::CloneDatabase },
+    { NULL, NULL, NULL, 0, NULL }
+};
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+/// minimum, median, mean, and standard deviation of samples
+static void GetStatistics(vector<double> data, double& min, double& median,
+                          double& mean, double& sdev)
+{
+    min = median = mean = sdev = 0.0;
+    if( data.empty() ) return;
+
+    sort(data.begin(),data.end());
+    min = data.front();
+    size_t n = data.size();
+    median = (n % 2 == 1) ? data[n/2] : 0.5*(data[n/2-1] + data[n/2]);
+
+    for(size_t i=0; i < n; i++) mean += data[i];
+    mean /= n;
+    for(size_t i=0; i < n; i++) sdev += (data[i] - mean)*(data[i] - mean);
+    sdev = sqrt(sdev / n);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CNLEaPBench::CNLEaPBench(void)
+{
+    Error = false;
+    TopId = 0;
+    NumOfEntities = 0;
+    Sink = 0.0;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+int CNLEaPBench::Init(int argc,char* argv[])
+{
+    // encode program options
+    int result = Options.ParseCmdLine(argc,argv);
+
+    // should we exit or was it error?
+    if( result != SO_CONTINUE ) return(result);
+
+    // attach verbose stream to terminal stream and set desired verbosity level
+    vout.Attach(Console);
+    vout.Verbosity(CVerboseStr::low);
+
+    // messages of readers are not printed
+    Quiet.Attach(NullStream);
+    Quiet.Verbosity(CVerboseStr::none);
+    Context.SetOut(&Quiet);
+
+    return( result );
+}
+
+//------------------------------------------------------------------------------
+
+bool CNLEaPBench::Run(void)
+{
+    if( Options.GetOptList() ){
+        for(int i=0; Benchmarks[i].Name != NULL; i++){
+            vout << setw(16) << left << Benchmarks[i].Name << " " << Benchmarks[i].Kind << endl;
+        }
+        return(true);
+    }
+
+    string filter;
+    if( Options.GetOptFilter() != NULL ) filter = string(Options.GetOptFilter());
+
+    try {
+        BuildSystem();
+
+        for(int i=0; Benchmarks[i].Name != NULL; i++){
+            if( string(Benchmarks[i].Name).find(filter) == string::npos ) continue;
+            Measure(Benchmarks[i]);
+        }
+    } catch( std::exception& e ) {
+        ES_ERROR(e.what());
+        Error = true;
+        return(false);
+    }
+
+    vout << endl;
+    PrintResults(vout);
+
+    if( Options.GetOptJSONName() != NULL ){
+        vout << endl;
+        vout << "> Saving results to " << Options.GetOptJSONName() << " ..." << endl;
+        ofstream ofs( Options.GetOptJSONName() );
+        WriteJSON(ofs);
+        if( ! ofs ){
+            vout << "<red>Error:</red> unable to save results" << endl;
+            Error = true;
+            return(false);
+        }
+    }
+
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CNLEaPBench::Finalize(void)
+{
+    flush(Console);
+    return( ! Error );
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CNLEaPBench::ReadFile(const string& name, string& data)
+{
+    ifstream ifs( name.c_str() );
+    if( ! ifs ){
+        throw runtime_error("unable to open file '" + name + "' for reading");
+    }
+    stringstream str;
+    str << ifs.rdbuf();
+    data = str.str();
+}
+
+//------------------------------------------------------------------------------
+
+void CNLEaPBench::BuildSystem(void)
+{
+    CFileName data_dir;
+    if( Options.GetOptDataDir() != NULL ){
+        data_dir = Options.GetOptDataDir();
+    } else {
+        data_dir = CFileName( CContext::GetPrefix().c_str() ) / "share" / "leap";
+    }
+
+    vout << "> Loading inputs from " << (const char*)data_dir << " ..." << endl;
+    ReadFile( (const char*)(data_dir / "parm" / "parm99.dat"), ParamsData );
+    ReadFile( (const char*)(data_dir / "lib" / "all_amino94.lib"), OFFData );
+
+    CDatabasePtr db = Context.database();
+    TopId = Context.m_index_counter.GetTopIndex();
+
+    // force field
+    CAmberFFPtr ff = db->CreateAmberFF( TopId );
+    istringstream params( ParamsData );
+    CAmberParams params_reader( Quiet );
+    params_reader.Read( params, ff, TopId );
+    db->SetVariable( TopId, "parm99", ff );
+    ff->SetName( "parm99" );
+
+    // library of residues
+    istringstream off( OFFData );
+    CAmberOFF off_reader( Quiet );
+    off_reader.Read( off, db, TopId );
+
+    vector<CUnitPtr> templates;
+    CForwardIterator it = db->BeginVariables();
+    CForwardIterator ie = db->EndVariables();
+    while( it != ie ){
+        CEntityPtr obj = db->GetVariableObject( it->GetName() );
+        if( obj && (obj->GetType() == UNIT) ){
+            templates.push_back( dynamic_pointer_cast<CUnit>(obj) );
+        }
+        it++;
+    }
+    if( templates.empty() ){
+        throw runtime_error("no residue templates found in all_amino94.lib");
+    }
+
+    // test system - copies of all residue templates placed on a regular grid
+    vout << "> Building test system ..." << endl;
+    Protein = db->CreateUnit( TopId, "protein" );
+    db->SetVariable( TopId, "protein", Protein );
+
+    // the OFF reader does not keep bonds, hence atoms are bonded by distance
+    int nres = 0;
+    for(int copy=0; copy < Options.GetOptCopies(); copy++){
+        for(size_t t=0; t < templates.size(); t++){
+            CResidueRange residues = templates[t]->Residues();
+            for(CResidueRange::iterator rit = residues.begin(); rit != residues.end(); rit++){
+                double dx = RESIDUE_SPACING*(nres % 10);
+                double dy = RESIDUE_SPACING*((nres / 10) % 10);
+                double dz = RESIDUE_SPACING*(nres / 100);
+                nres++;
+
+                CResiduePtr         res = Protein->CreateResidue( rit->GetName(), TopId );
+                vector<CAtomPtr>    res_atoms;
+                CAtomRange          atoms = rit->Atoms();
+                for(CAtomRange::iterator ait = atoms.begin(); ait != atoms.end(); ait++){
+                    CAtomPtr atm = res->CreateAtom( ait->GetName(), TopId );
+                    atm->Set(TYPE, ait->Get<string>(TYPE));
+                    atm->Set(CHARGE, ait->Get<double>(CHARGE));
+                    atm->Set(POSX, ait->Get<double>(POSX) + dx);
+                    atm->Set(POSY, ait->Get<double>(POSY) + dy);
+                    atm->Set(POSZ, ait->Get<double>(POSZ) + dz);
+                    res_atoms.push_back(atm);
+                }
+
+                for(size_t i=0; i < res_atoms.size(); i++){
+                    for(size_t j=i+1; j < res_atoms.size(); j++){
+                        // geminal hydrogens are closer than the longest bonds
+                        if( (res_atoms[i]->GetName()[0] == 'H') && (res_atoms[j]->GetName()[0] == 'H') ) continue;
+                        if( Size(res_atoms[i]->GetPos() - res_atoms[j]->GetPos()) < BOND_DISTANCE ){
+                            Protein->CreateBond( res_atoms[i], res_atoms[j], 1, TopId );
+                        }
+                    }
+                }
+            }
+        }
+    }
+    Protein->FixCounters();
+    Context.m_index_counter.SetTopIndex( TopId );
+
+    // Mol2 file of the test system
+    ostringstream mol2;
+    CSybylMol2 mol2_writer( Quiet );
+    mol2_writer.Write( mol2, Protein );
+    Mol2Data = mol2.str();
+
+    // inputs of micro benchmarks
+    CAmberFF::CacheFFs( db, FFs );
+    Masks.clear();
+    Masks.push_back("@CA");
+    Masks.push_back(":ALA,GLY,SER@N,CA,C,O");
+    Masks.push_back("@%CT");
+    Masks.push_back(":1-20<:8.0");
+    Protein->GetMaskTopology( &Context );
+
+    NumOfEntities = db->NumberOfChildren(true);
+
+    vout << "  Residues = " << Protein->NumberOfResidues();
+    vout << "  Atoms = " << Protein->NumberOfAtoms();
+    vout << "  Bonds = " << Protein->NumberOfBonds();
+    vout << "  Database entities = " << NumOfEntities << endl;
+    vout << endl;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CNLEaPBench::Measure(const SBenchmark& bench)
+{
+    vout << "> Running " << bench.Name << " ..." << endl;
+
+    SBenchResult result;
+    result.Bench = &bench;
+
+    // warm-up iteration, it also determines the number of processed items
+    result.Items = (this->*bench.Fce)();
+
+    for(int r=0; r < Options.GetOptRepeats(); r++){
+        double wall = CProfiler::GetWallTime();
+        double cpu = CProfiler::GetCPUTime();
+        for(int i=0; i < bench.Iterations; i++){
+            (this->*bench.Fce)();
+        }
+        result.Wall.push_back( (CProfiler::GetWallTime() - wall) / bench.Iterations );
+        result.CPU.push_back( (CProfiler::GetCPUTime() - cpu) / bench.Iterations );
+    }
+
+    Results.push_back(result);
+}
+
+//------------------------------------------------------------------------------
+
+void CNLEaPBench::PrintResults(std::ostream& ofs)
+{
+    ofs << "# Benchmark        Kind   Iters    Min[ms] Median[ms]   Mean[ms]  SDev[ms]      Items   Items/s" << endl;
+    ofs << "# ---------------- ----- ------ ---------- ---------- ---------- --------- ---------- ---------" << endl;
+
+    for(size_t i=0; i < Results.size(); i++){
+        const SBenchResult& res = Results[i];
+        double min, median, mean, sdev;
+        GetStatistics(res.Wall,min,median,mean,sdev);
+
+        ofs << "  " << left << setw(16) << res.Bench->Name;
+        ofs << " " << setw(5) << res.Bench->Kind << right;
+        ofs << " " << setw(6) << res.Bench->Iterations;
+        ofs << fixed << setprecision(3);
+        ofs << " " << setw(10) << min*1.0e3;
+        ofs << " " << setw(10) << median*1.0e3;
+        ofs << " " << setw(10) << mean*1.0e3;
+        ofs << " " << setw(9) << sdev*1.0e3;
+        ofs << " " << setw(10) << res.Items;
+        ofs << scientific << setprecision(2);
+        ofs << " " << setw(9) << (median > 0.0 ? res.Items / median : 0.0);
+        ofs << " " << res.Bench->Items << endl;
+        ofs.unsetf(ios_base::floatfield);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void CNLEaPBench::WriteJSON(std::ostream& ofs)
+{
+    ofs << "{" << endl;
+    ofs << "  \"program\": \"nleap-bench\"," << endl;
+    ofs << "  \"version\": \"" << NLEAP_VERSION << "\"," << endl;
+    ofs << "  \"repeats\": " << Options.GetOptRepeats() << "," << endl;
+    ofs << "  \"system\": {";
+    ofs << "\"copies\": " << Options.GetOptCopies();
+    ofs << ", \"residues\": " << Protein->NumberOfResidues();
+    ofs << ", \"atoms\": " << Protein->NumberOfAtoms();
+    ofs << ", \"bonds\": " << Protein->NumberOfBonds();
+    ofs << ", \"entities\": " << NumOfEntities << "}," << endl;
+    ofs << "  \"benchmarks\": [" << endl;
+
+    ofs << setprecision(6);
+    for(size_t i=0; i < Results.size(); i++){
+        const SBenchResult& res = Results[i];
+        double min, median, mean, sdev;
+        GetStatistics(res.Wall,min,median,mean,sdev);
+        double cpu_min, cpu_median, cpu_mean, cpu_sdev;
+        GetStatistics(res.CPU,cpu_min,cpu_median,cpu_mean,cpu_sdev);
+
+        ofs << "    {\"name\": \"" << res.Bench->Name << "\"";
+        ofs << ", \"kind\": \"" << res.Bench->Kind << "\"";
+        ofs << ", \"iterations\": " << res.Bench->Iterations;
+        ofs << ", \"items\": " << res.Items;
+        ofs << ", \"item_unit\": \"" << res.Bench->Items << "\"," << endl;
+        ofs << "     \"wall_min_ms\": " << min*1.0e3;
+        ofs << ", \"wall_median_ms\": " << median*1.0e3;
+        ofs << ", \"wall_mean_ms\": " << mean*1.0e3;
+        ofs << ", \"wall_sdev_ms\": " << sdev*1.0e3;
+        ofs << ", \"cpu_median_ms\": " << cpu_median*1.0e3;
+        ofs << ", \"items_per_s\": " << (median > 0.0 ? res.Items / median : 0.0) << "," << endl;
+        ofs << "     \"samples_ms\": [";
+        for(size_t k=0; k < res.Wall.size(); k++){
+            if( k > 0 ) ofs << ", ";
+            ofs << res.Wall[k]*1.0e3;
+        }
+        ofs << "]}";
+        if( i + 1 < Results.size() ) ofs << ",";
+        ofs << endl;
+    }
+
+    ofs << "  ]" << endl;
+    ofs << "}" << endl;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+size_t CNLEaPBench::PropertyGet(void)
+{
+    double sum = 0.0;
+    CAtomRange atoms = Protein->Atoms();
+    for(CAtomRange::iterator it = atoms.begin(); it != atoms.end(); it++){
+        sum += it->Get<double>(POSX) + it->Get<double>(POSY) + it->Get<double>(POSZ);
+        sum += it->Get<double>(CHARGE);
+        sum += it->Get<string>(TYPE).size();
+    }
+    Sink += sum;
+    return( atoms.size() );
+}
+
+//------------------------------------------------------------------------------
+
+size_t CNLEaPBench::PropertySet(void)
+{
+    CAtomRange atoms = Protein->Atoms();
+    for(CAtomRange::iterator it = atoms.begin(); it != atoms.end(); it++){
+        it->Set(CHARGE, it->Get<double>(CHARGE));
+        it->Set(POSX, it->Get<double>(POSX));
+    }
+    return( atoms.size() );
+}
+
+//------------------------------------------------------------------------------
+
+size_t CNLEaPBench::FFLookup(void)
+{
+    size_t found = 0;
+    size_t lookups = 0;
+
+    CAtomRange atoms = Protein->Atoms();
+    for(CAtomRange::iterator it = atoms.begin(); it != atoms.end(); it++){
+        if( CAmberFF::FindType(FFs, it->Get<string>(TYPE)) ) found++;
+        lookups++;
+    }
+
+    CBondRange bonds = Protein->Bonds();
+    for(CBondRange::iterator it = bonds.begin(); it != bonds.end(); it++){
+        string t1 = it->Get<CEntityPtr>(ATOM1)->Get<string>(TYPE);
+        string t2 = it->Get<CEntityPtr>(ATOM2)->Get<string>(TYPE);
+        if( CAmberFF::FindBond(FFs, t1, t2) ) found++;
+        lookups++;
+    }
+
+    Sink += found;
+    return( lookups );
+}
+
+//------------------------------------------------------------------------------
+
+size_t CNLEaPBench::MaskSelect(void)
+{
+    CUnitTopology* p_top = Protein->GetMaskTopology( &Context );
+    vector<int> indices;
+    for(size_t i=0; i < Masks.size(); i++){
+        p_top->SelectAtoms( Masks[i], indices );
+        Sink += indices.size();
+    }
+    return( Masks.size() );
+}
+
+//------------------------------------------------------------------------------
+
+size_t CNLEaPBench::ReadParams(void)
+{
+    CAmberFFPtr ff = CFactory::CreateAmberFF( TopId );
+    istringstream is( ParamsData );
+    CAmberParams reader( Quiet );
+    reader.Read( is, ff, TopId );
+    return( ParamsData.size() );
+}
+
+//------------------------------------------------------------------------------
+
+size_t CNLEaPBench::ReadOFF(void)
+{
+    CDatabasePtr db = CFactory::CreateDatabase( TopId );
+    istringstream is( OFFData );
+    CAmberOFF reader( Quiet );
+    reader.Read( is, db, TopId );
+    return( OFFData.size() );
+}
+
+//------------------------------------------------------------------------------
+
+size_t CNLEaPBench::ReadMol2(void)
+{
+    CUnitPtr unit = CFactory::CreateUnit( TopId );
+    istringstream is( Mol2Data );
+    CSybylMol2 reader( Quiet );
+    reader.Read( is, unit, TopId );
+    return( Mol2Data.size() );
+}
+
+//------------------------------------------------------------------------------
+
+size_t CNLEaPBench::CloneDatabase(void)
+{
+    CEntityPtr clone = Context.database()->Clone( TopId );
+    return( NumOfEntities );
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
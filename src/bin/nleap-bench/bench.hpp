@@ -0,0 +1,129 @@
+#ifndef NLEAP_BENCH_H
+#define NLEAP_BENCH_H
+// =============================================================================
+// nLEaP - prepare input for the AMBER molecular mechanics programs
+// -----------------------------------------------------------------------------
+//    Copyright (C) 2010 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+
+#include "options.hpp"
+#include <engine/Context.hpp>
+#include <types/Unit.hpp>
+#include <types/AmberFF.hpp>
+#include <TerminalStr.hpp>
+#include <VerboseStr.hpp>
+#include <fstream>
+#include <vector>
+#include <list>
+
+//------------------------------------------------------------------------------
+
+class CNLEaPBench;
+
+/// benchmark performs one iteration and returns number of processed items
+typedef size_t (CNLEaPBench::*TBenchFce)(void);
+
+/// benchmark description
+struct SBenchmark {
+    const char* Name;
+    const char* Kind;           // micro or macro
+    const char* Items;          // what is counted by the benchmark
+    int         Iterations;     // iterations in one measurement
+    TBenchFce   Fce;
+};
+
+/// benchmark results
+struct SBenchResult {
+    const SBenchmark*   Bench;
+    size_t              Items;  // items processed in one iteration
+    std::vector<double> Wall;   // wall time of one iteration in each measurement
+    std::vector<double> CPU;    // CPU time of one iteration in each measurement
+};
+
+//------------------------------------------------------------------------------
+
+class CNLEaPBench {
+public:
+        // constructor
+        CNLEaPBench(void);
+
+// main methods ---------------------------------------------------------------
+    //! init options
+    int Init(int argc,char* argv[]);
+
+    //! main part of program
+    bool Run(void);
+
+    //! finalize program
+    bool Finalize(void);
+
+// section of private data ----------------------------------------------------
+private:
+    CNLEaPBenchOptions          Options;
+    nleap::CContext             Context;
+    CTerminalStr                Console;
+    CVerboseStr                 vout;
+    std::ofstream               NullStream;     // not opened, swallows reader messages
+    CVerboseStr                 Quiet;
+    std::vector<SBenchResult>   Results;
+    bool                        Error;
+
+    // inputs, they are kept in memory so that the disk is not measured
+    std::string         ParamsData;
+    std::string         OFFData;
+    std::string         Mol2Data;
+
+    // test system
+    int                             TopId;
+    nleap::CUnitPtr                 Protein;
+    std::list<nleap::CAmberFFPtr>   FFs;
+    std::vector<std::string>        Masks;
+    size_t                          NumOfEntities;  // entities in the database
+    double                          Sink;           // keeps results of benchmarks alive
+
+    static const SBenchmark Benchmarks[];
+
+    //! read whole file into memory
+    void ReadFile(const std::string& name, std::string& data);
+
+    //! load inputs and build the test system
+    void BuildSystem(void);
+
+    //! measure one benchmark
+    void Measure(const SBenchmark& bench);
+
+    //! print table of results
+    void PrintResults(std::ostream& ofs);
+
+    //! write results in the JSON format
+    void WriteJSON(std::ostream& ofs);
+
+// benchmarks -----------------------------------------------------------------
+    size_t PropertyGet(void);
+    size_t PropertySet(void);
+    size_t FFLookup(void);
+    size_t MaskSelect(void);
+    size_t ReadParams(void);
+    size_t ReadOFF(void);
+    size_t ReadMol2(void);
+    size_t CloneDatabase(void);
+};
+
+//------------------------------------------------------------------------------
+
+#endif
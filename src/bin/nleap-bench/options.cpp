@@ -0,0 +1,92 @@
+// =============================================================================
+// nLEaP - prepare input for the AMBER molecular mechanics programs
+// -----------------------------------------------------------------------------
+//    Copyright (C) 2010 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+
+#include "options.hpp"
+#include <ErrorSystem.hpp>
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CNLEaPBenchOptions::CNLEaPBenchOptions(void)
+{
+    SetShowMiniUsage(true);
+    SetAllowProgArgs(false);
+}
+
+//------------------------------------------------------------------------------
+
+int CNLEaPBenchOptions::CheckOptions(void)
+{
+    if( GetOptRepeats() <= 0 ){
+        if( IsVerbose() ){
+            if( IsError == false ) fprintf(stderr,"\n");
+            fprintf(stderr,"%s: number of repeats has to be greater than zero\n",(const char*)GetProgramName());
+            IsError = true;
+        }
+    }
+
+    if( GetOptCopies() <= 0 ){
+        if( IsVerbose() ){
+            if( IsError == false ) fprintf(stderr,"\n");
+            fprintf(stderr,"%s: number of copies has to be greater than zero\n",(const char*)GetProgramName());
+            IsError = true;
+        }
+    }
+
+    if( IsError == true ) return(SO_OPTS_ERROR);
+    return(SO_CONTINUE);
+}
+
+//------------------------------------------------------------------------------
+
+int CNLEaPBenchOptions::FinalizeOptions(void)
+{
+    bool ret_opt = false;
+
+    if( GetOptHelp() == true ){
+        PrintUsage();
+        ret_opt = true;
+    }
+
+    if( GetOptVersion() == true ){
+        PrintVersion();
+        ret_opt = true;
+    }
+
+    if( ret_opt == true ){
+        printf("\n");
+        return(SO_EXIT);
+    }
+
+    return(SO_CONTINUE);
+}
+
+//------------------------------------------------------------------------------
+
+int CNLEaPBenchOptions::CheckArguments(void)
+{
+    return(SO_CONTINUE);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
@@ -0,0 +1,148 @@
+#ifndef NLEAP_BENCH_OPTIONS_H
+#define NLEAP_BENCH_OPTIONS_H
+// =============================================================================
+// nLEaP - prepare input for the AMBER molecular mechanics programs
+// -----------------------------------------------------------------------------
+//    Copyright (C) 2010 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+
+#include <SimpleOptions.hpp>
+#include <NLEaPMainHeader.hpp>
+
+//------------------------------------------------------------------------------
+
+class CNLEaPBenchOptions : public CSimpleOptions {
+    public:
+        // constructor - tune option setup
+        CNLEaPBenchOptions(void);
+
+ // program name and description -----------------------------------------------
+    CSO_PROG_NAME_BEGIN
+        "nleap-bench"
+    CSO_PROG_NAME_END
+
+    CSO_PROG_DESC_BEGIN
+        "<b><red>nleap-bench</red></b> measures the performance of hot paths of the nLEaP core library. "
+        "Micro-benchmarks cover access to entity properties, force field lookups, and atom mask "
+        "evaluation, macro-benchmarks cover reading of force field parameters, OFF libraries, and Mol2 files, "
+        "and cloning of the whole database. All inputs are read into memory before measurements "
+        "and the test system is built deterministically, hence the results are comparable across releases."
+    CSO_PROG_DESC_END
+
+    CSO_PROG_VERS_BEGIN
+        NLEAP_VERSION
+    CSO_PROG_VERS_END
+
+ // list of all options and arguments ------------------------------------------
+    CSO_LIST_BEGIN
+        // options ------------------------------
+        CSO_OPT(CSmallString,DataDir)
+        CSO_OPT(CSmallString,JSONName)
+        CSO_OPT(CSmallString,Filter)
+        CSO_OPT(int,Repeats)
+        CSO_OPT(int,Copies)
+        CSO_OPT(bool,List)
+        CSO_OPT(bool,Help)
+        CSO_OPT(bool,Version)
+    CSO_LIST_END
+
+    CSO_MAP_BEGIN
+ // description of options -----------------------------------------------------
+        CSO_MAP_OPT(CSmallString,                           /* option type */
+                    DataDir,                        /* option name */
+                    NULL,                          /* default value */
+                    false,                          /* is option mandatory */
+                    'd',                           /* short option name */
+                    "data",                      /* long option name */
+                    "DIR",                           /* parametr name */
+                    "directory with parm/parm99.dat and lib/all_amino94.lib, the default is share/leap of the nLEaP installation")   /* option description */
+        //----------------------------------------------------------------------
+        CSO_MAP_OPT(CSmallString,                           /* option type */
+                    JSONName,                        /* option name */
+                    NULL,                          /* default value */
+                    false,                          /* is option mandatory */
+                    'j',                           /* short option name */
+                    "json",                      /* long option name */
+                    "FILE",                           /* parametr name */
+                    "write results in the JSON format to FILE")   /* option description */
+        //----------------------------------------------------------------------
+        CSO_MAP_OPT(CSmallString,                           /* option type */
+                    Filter,                        /* option name */
+                    NULL,                          /* default value */
+                    false,                          /* is option mandatory */
+                    'f',                           /* short option name */
+                    "filter",                      /* long option name */
+                    "TEXT",                           /* parametr name */
+                    "run only benchmarks with TEXT in their names")   /* option description */
+        //----------------------------------------------------------------------
+        CSO_MAP_OPT(int,                           /* option type */
+                    Repeats,                        /* option name */
+                    5,                          /* default value */
+                    false,                          /* is option mandatory */
+                    'r',                           /* short option name */
+                    "repeats",                      /* long option name */
+                    "NUMBER",                           /* parametr name */
+                    "number of measurements of each benchmark")   /* option description */
+        //----------------------------------------------------------------------
+        CSO_MAP_OPT(int,                           /* option type */
+                    Copies,                        /* option name */
+                    25,                          /* default value */
+                    false,                          /* is option mandatory */
+                    'c',                           /* short option name */
+                    "copies",                      /* long option name */
+                    "NUMBER",                           /* parametr name */
+                    "size of the test system as the number of copies of all amino acid residues")   /* option description */
+        //----------------------------------------------------------------------
+        CSO_MAP_OPT(bool,                           /* option type */
+                    List,                        /* option name */
+                    false,                          /* default value */
+                    false,                          /* is option mandatory */
+                    'l',                           /* short option name */
+                    "list",                      /* long option name */
+                    NULL,                           /* parametr name */
+                    "list available benchmarks and exit")   /* option description */
+        //----------------------------------------------------------------------
+        CSO_MAP_OPT(bool,                           /* option type */
+                    Version,                        /* option name */
+                    false,                          /* default value */
+                    false,                          /* is option mandatory */
+                    '\0',                           /* short option name */
+                    "version",                      /* long option name */
+                    NULL,                           /* parametr name */
+                    "output version information and exit")   /* option description */
+        //----------------------------------------------------------------------
+        CSO_MAP_OPT(bool,                           /* option type */
+                    Help,                        /* option name */
+                    false,                          /* default value */
+                    false,                          /* is option mandatory */
+                    'h',                           /* short option name */
+                    "help",                      /* long option name */
+                    NULL,                           /* parametr name */
+                    "display this help and exit")   /* option description */
+    CSO_MAP_END
+
+// final operation with options ------------------------------------------------
+    private:
+    virtual int CheckOptions(void);
+    virtual int FinalizeOptions(void);
+    virtual int CheckArguments(void);
+    };
+
+//------------------------------------------------------------------------------
+
+#endif
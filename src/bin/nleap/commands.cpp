@@ -26,7 +26,9 @@
 #include <context/History.hpp>
 #include <context/LoadState.hpp>
 #include <context/LogFile.hpp>
+#include <context/Memory.hpp>
 #include <context/NLeap.hpp>
+#include <context/Profile.hpp>
 #include <context/Redo.hpp>
 #include <context/SaveState.hpp>
 #include <context/Source.hpp>
@@ -37,7 +39,9 @@ nleapcmds::CHelpCommand             g_help_command( "help" );
 nleapcmds::CHistoryCommand          g_history_command( "history" );
 nleapcmds::CLoadStateCommand        g_loadstate_command( "loadState" );
 nleapcmds::CLogFileCommand          g_logfile_command( "logFile" );
+nleapcmds::CMemoryCommand           g_memory_command( "memory" );
 nleapcmds::CNLeapCommand            g_nleap_command( "nleap" );
+nleapcmds::CProfileCommand          g_profile_command( "profile" );
 nleapcmds::CRedoCommand             g_redo_command( "redo" );
 nleapcmds::CSaveStateCommand        g_savestate_command( "saveState" );
 nleapcmds::CSourceCommand           g_source_command( "source" );
@@ -97,6 +101,7 @@ nleapcmds::CSetCommand                  g_set_command( "set" );
 #include <input/LoadMol2.hpp>
 #include <input/LoadOFF.hpp>
 #include <input/LoadPDB.hpp>
+#include <input/ProcessMolecules.hpp>
 
 nleapcmds::CLoadAmberParamsCommand  g_loadamberparams_command( "loadAmberParams" );
 nleapcmds::CLoadAmberPrepCommand    g_loadamberprep_command( "loadAmberPrep" );
@@ -104,6 +109,7 @@ nleapcmds::CLoadMol2Command         g_loadmol2_command( "loadMol2" );
 
 nleapcmds::CLoadOFFCommand          g_loadoff_command( "loadOff" );
 nleapcmds::CLoadPDBCommand          g_loadpdb_command( "loadPdb" );
+nleapcmds::CProcessMoleculesCommand g_processmolecules_command( "processMolecules" );
 
 // openbabel commands ==========================================================
 #include <openbabel/ListOBFormats.hpp>
@@ -136,11 +142,13 @@ nleapcmds::CSavePDBCommand              g_savepdb_command( "savePdb" );
 #include <geometry/AlignAxes.hpp>
 #include <geometry/Center.hpp>
 #include <geometry/MeasureGeom.hpp>
+#include <geometry/Relax.hpp>
 #include <geometry/Translate.hpp>
 
 nleapcmds::CAlignAxesCommand        g_alignaxes_command( "alignAxes" );
 nleapcmds::CCenterCommand           g_center_command( "center" );
 nleapcmds::CMeasureGeomCommand      g_measuregeom_command( "measureGeom" );
+nleapcmds::CRelaxCommand            g_relax_command( "relax" );
 nleapcmds::CTranslateCommand        g_translate_command( "translate" );
 
 // solvent commands ============================================================
@@ -117,6 +117,11 @@ int CNLEaP::Init(int argc,char* argv[])
 
     Context.SetOut(&vout);
 
+    if( Options.GetOptProfileName() != NULL ){
+        vout << "> Profiling of commands is enabled ..." << endl;
+        Context.profiler().Enable(true);
+    }
+
     if( Options.GetOptVariables() != NULL ){
         vout << "> External variables ..." << endl;
         // get variables
@@ -262,6 +267,21 @@ bool CNLEaP::Finalize(void)
     history_truncate_file( HistoryFileName, MAX_HISTORY_LENGTH );
 #endif
 
+    // save command profile
+    if( Options.GetOptProfileName() != NULL ){
+        vout << endl;
+        vout << "> Saving command profile ..." << endl;
+        string table_name = string(Options.GetOptProfileName());
+        string trace_name = table_name + ".json";
+        std::ofstream ofs( table_name.c_str() );
+        Context.profiler().PrintTable(ofs);
+        std::ofstream tofs( trace_name.c_str() );
+        Context.profiler().WriteTrace(tofs);
+        if( ! ofs || ! tofs ){
+            vout << "<red>Error:</red> unable to save command profile" << endl;
+        }
+    }
+
     // save nleap context setup
     vout << endl;
     vout << "> Saving user context setup ..." << endl;
@@ -56,6 +56,7 @@ class CNLEaPOptions : public CSimpleOptions {
         CSO_OPT(bool,DefaultSetup)
         CSO_OPT(bool,NoHistory)
         CSO_OPT(bool,ClearHistory)
+        CSO_OPT(CSmallString,ProfileName)
         CSO_OPT(bool,Help)
         CSO_OPT(bool,Version)
     CSO_LIST_END
@@ -116,6 +117,15 @@ class CNLEaPOptions : public CSimpleOptions {
                     NULL,                           /* parametr name */
                     "clear readline history file at the startup")   /* option description */
         //----------------------------------------------------------------------
+        CSO_MAP_OPT(CSmallString,                           /* option type */
+                    ProfileName,                        /* option name */
+                    NULL,                          /* default value */
+                    false,                          /* is option mandatory */
+                    '\0',                           /* short option name */
+                    "profile",                      /* long option name */
+                    "FILE",                           /* parametr name */
+                    "profile all executed commands, the table of commands is written to FILE and Chrome trace events to FILE.json")   /* option description */
+        //----------------------------------------------------------------------
         CSO_MAP_OPT(bool,                           /* option type */
                     Version,                        /* option name */
                     false,                          /* default value */
@@ -20,12 +20,20 @@
 // =============================================================================
 
 #include <iomanip>
+#include <sstream>
 #include <XMLElement.hpp>
 #include <ErrorSystem.hpp>
 #include <core/Entity.hpp>
 #include <core/ForwardIterator.hpp>
 #include <types/Factory.hpp>
 #include <core/PredefinedKeys.hpp>
+#include <core/NameIndex.hpp>
+#include <core/Property.hpp>
+#include <core/EntityIdMap.hpp>
+
+// minimum number of children for which indexes are built
+#define CHILD_INDEX_LIMIT   16
+#define NAME_INDEX_LIMIT    16
 
 namespace nleap {
 //==============================================================================
@@ -39,6 +47,12 @@ CEntity::CEntity(const CKey& type)
     m_root = NULL;
     m_self = NULL;
     m_last = NULL;
+    m_referrers = NULL;
+    m_revision = 0;
+    m_pos_revision = 0;
+    m_num_children = 0;
+    m_child_index_valid = false;
+    m_name_index_dups = false;
 }
 
 // -------------------------------------------------------------------------
@@ -47,10 +61,16 @@ CEntity::CEntity(const CKey& type, int& top_id)
 : m_type( type )
 {
     m_id = -1;
-    SetId( top_id++ );
     m_root = NULL;
     m_self = NULL;
     m_last = NULL;
+    m_referrers = NULL;
+    m_revision = 0;
+    m_pos_revision = 0;
+    m_num_children = 0;
+    m_child_index_valid = false;
+    m_name_index_dups = false;
+    SetId( top_id++ );
 }
 
 // -------------------------------------------------------------------------
@@ -61,16 +81,13 @@ CEntity::~CEntity(void)
     m_self = NULL;
     m_last = NULL;
 
-    // unregister related objects
-    list< CEntityWPtr >::iterator it = m_related.begin();
-    list< CEntityWPtr >::iterator ie = m_related.end();
+    // there are no referrers here, each of them holds this object alive,
+    // own object properties unlink themselves from referred objects
 
-    while( it != ie ){
-        if( ! (*it).expired() ){
-            (*it).lock()->m_properties.UnsetObjectProperty( GetSelf() );
-        }
-        it++;
-    }
+    // indexes are not needed anymore
+    m_child_index_valid = false;
+    m_child_index.clear();
+    m_name_index.reset();
 
     // now destroy all children - in linear fashion
     // if this is not used then very long destruction chain (m_sibling->m_sibling->...)
@@ -84,14 +101,15 @@ CEntity::~CEntity(void)
 //------------------------------------------------------------------------------
 //==============================================================================
 
-CEntityPtr CEntity::Clone(int& top_id, int base_id)
+CEntityPtr CEntity::Clone(int& top_id, int base_id, bool move_caches)
 {
     // clone objects weakly
-    CEntityPtr cloned = CloneWeakly(top_id, base_id);
+    CEntityPtr cloned = CloneWeakly(top_id, base_id, move_caches);
 
     // create object map from cloned objects
-    map< int, CEntityPtr > obj_map;
+    CEntityIdMap obj_map;
     cloned->UpdateObjectMap(obj_map);
+    obj_map.Finalize();
 
     // bind weakly bound properties
     cloned->BindWeakProperties(obj_map);
@@ -101,7 +119,7 @@ CEntityPtr CEntity::Clone(int& top_id, int base_id)
 
 // -------------------------------------------------------------------------
 
-CEntityPtr CEntity::CloneWeakly(int& top_id, int base_id)
+CEntityPtr CEntity::CloneWeakly(int& top_id, int base_id, bool move_caches)
 {
     CEntityPtr cloned = CFactory::Create(GetType());
 
@@ -112,7 +130,8 @@ CEntityPtr CEntity::CloneWeakly(int& top_id, int base_id)
     // id
     cloned->m_name = m_name;
     cloned->m_id =  m_id + base_id;
-    if( top_id < cloned->m_id ) top_id = cloned->m_id;
+    // top_id is the next free id
+    if( top_id <= cloned->m_id ) top_id = cloned->m_id + 1;
 
     // properties
     cloned->m_properties.CloneWeakly(m_properties, base_id);
@@ -121,42 +140,63 @@ CEntityPtr CEntity::CloneWeakly(int& top_id, int base_id)
     CEntityPtr obj = m_first;
 
     while( obj ){
-        CEntityPtr child_cloned = obj->CloneWeakly(top_id, base_id);
+        CEntityPtr child_cloned = obj->CloneWeakly(top_id, base_id, move_caches);
         cloned->AddChild(child_cloned);
         obj = obj->m_sibling;
     }
 
+    // the clone has the same content, thus also the same revisions
+    cloned->m_revision = m_revision;
+    cloned->m_pos_revision = m_pos_revision;
+
+    // the source of a snapshot becomes history, other sources stay in use
+    CopyCaches(cloned.get());
+    if( move_caches ) MoveCaches(cloned.get());
+
     return(cloned);
 }
 
 // -------------------------------------------------------------------------
 
-void CEntity::BindWeakProperties(map< int, CEntityPtr >&  obj_map)
+void CEntity::CopyCaches(CEntity* p_clone)
+{
+    // nothing to be copied
+}
+
+// -------------------------------------------------------------------------
+
+void CEntity::MoveCaches(CEntity* p_clone)
+{
+    // nothing to be moved
+}
+
+// -------------------------------------------------------------------------
+
+void CEntity::BindWeakProperties(const CEntityIdMap& obj_map)
 {
     // bind weak objects
-    m_properties.BindWeak(obj_map);
+    m_properties.BindWeak(obj_map,this);
 
     // recursivelly
-    CEntityPtr obj = m_first;
+    CEntity* p_obj = m_first.get();
 
-    while( obj ){
-        obj->BindWeakProperties(obj_map);
-        obj = obj->m_sibling;
+    while( p_obj ){
+        p_obj->BindWeakProperties(obj_map);
+        p_obj = p_obj->m_sibling.get();
     }
 }
 
 // -------------------------------------------------------------------------
 
-void CEntity::UpdateObjectMap(map< int, CEntityPtr >&  obj_map)
+void CEntity::UpdateObjectMap(CEntityIdMap& obj_map)
 {
-    CEntityPtr obj = m_first;
+    CEntity* p_obj = m_first.get();
 
-    while( obj ){
-        obj_map[obj->GetId()] = obj;
-        obj->UpdateObjectMap(obj_map);
-        obj = obj->m_sibling;
+    while( p_obj ){
+        obj_map.Add(p_obj);
+        p_obj->UpdateObjectMap(obj_map);
+        p_obj = p_obj->m_sibling.get();
     }
-
 }
 
 //==============================================================================
@@ -238,7 +278,20 @@ const string CEntity::GetPathName(void) const
 
 void CEntity::SetName(const string& name)
 {
+    if( m_root ){
+        m_root->RemoveFromNameIndex(this);
+    }
+
     m_name = name;
+
+    if( m_root && m_root->m_name_index ){
+        // renamed child can precede other child of the same name
+        if( m_root->m_name_index->Insert(this) == false ){
+            m_root->m_name_index.reset();
+        }
+    }
+
+    Modified();
 }
 
 // -------------------------------------------------------------------------
@@ -263,6 +316,92 @@ void CEntity::SetId(int id)
 
 // -------------------------------------------------------------------------
 
+unsigned long CEntity::GetRevision(void) const
+{
+    return(m_revision);
+}
+
+// -------------------------------------------------------------------------
+
+unsigned long CEntity::GetPosRevision(void) const
+{
+    return(m_pos_revision);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+size_t CEntity::GetObjectSize(void) const
+{
+    size_t size = sizeof(CEntity);
+    size += GetStringSize(m_name);
+    size += m_properties.GetMemorySize();
+    size += m_child_index.capacity()*sizeof(CEntity*);
+    if( m_name_index ){
+        size += sizeof(CNameIndex) + m_name_index->GetMemorySize();
+    }
+    return(size);
+}
+
+// -------------------------------------------------------------------------
+
+size_t CEntity::GetMemorySize(void) const
+{
+    size_t size = GetObjectSize();
+
+    CEntity* p_obj = m_first.get();
+    while( p_obj ){
+        size += p_obj->GetMemorySize();
+        p_obj = p_obj->m_sibling.get();
+    }
+
+    return(size);
+}
+
+// -------------------------------------------------------------------------
+
+size_t CEntity::GetStringSize(const string& str)
+{
+    // short strings are stored inline (small string optimization)
+    if( str.capacity() <= string().capacity() ) return(0);
+    return(str.capacity() + 1);
+}
+
+// -------------------------------------------------------------------------
+
+string CEntity::FormatMemorySize(size_t size)
+{
+    stringstream str;
+    if( size < 1024 ){
+        str << size << " B";
+    } else if( size < 1024*1024 ){
+        str << fixed << setprecision(1) << size / 1024.0 << " kB";
+    } else if( size < 1024*1024*1024 ){
+        str << fixed << setprecision(1) << size / (1024.0*1024.0) << " MB";
+    } else {
+        str << fixed << setprecision(2) << size / (1024.0*1024.0*1024.0) << " GB";
+    }
+    return( str.str() );
+}
+
+// -------------------------------------------------------------------------
+
+void CEntity::Modified(bool pos_only)
+{
+    CEntity* p_ent = this;
+    while( p_ent ){
+        if( pos_only ){
+            p_ent->m_pos_revision++;
+        } else {
+            p_ent->m_revision++;
+        }
+        p_ent = p_ent->m_root;
+    }
+}
+
+// -------------------------------------------------------------------------
+
 void CEntity::Desc(ostream& ofs)
 {
     ofs << GetType().GetName() << endl;
@@ -273,12 +412,13 @@ void CEntity::Desc(ostream& ofs)
     int naprops = m_properties.NumberOfProperties();
     int noprops = m_properties.NumberOfObjectProperties();
     int nchildren = NumberOfChildren();
-    int nrel = m_related.size();
+    int nrel = NumberOfReferrers();
 
     ofs << "   Properties        : " << naprops - noprops << endl;
     ofs << "   Object properties : " << noprops << endl;
     ofs << "   Children objects  : " << nchildren << endl;
     ofs << "   Related objects   : " << nrel << endl;
+    ofs << "   Memory footprint  : " << FormatMemorySize(GetMemorySize()) << endl;
 
     m_properties.Desc(ofs);
 
@@ -310,22 +450,17 @@ void CEntity::Desc(ostream& ofs)
         ofs << "   GID          Type       Name                                          " << endl;
         ofs << "   ------------ ---------- ----------------------------------------------" << endl;
 
-        list< CEntityWPtr >::iterator oit = m_related.begin();
-        list< CEntityWPtr >::iterator oie = m_related.end();
+        CEntityRef* p_ref = m_referrers;
 
         ofs << resetiosflags(ios_base::right) << setiosflags(ios_base::left);
-        while( oit != oie ){
+        while( p_ref ){
+            CEntity* p_obj = p_ref->Owner;
             ofs << "   ";
-            CEntityPtr obj( *oit );
-            if( ! obj ){
-                ofs << setw(12) << obj->GetId() << " ";
-                ofs << setw(10) << obj->GetType().GetName() << " ";
-                ofs << obj->GetName() << " ";
-                ofs << endl;
-            } else {
-                ofs << "DEAD OBJECT" << endl;
-            }
-            oit++;
+            ofs << setw(12) << p_obj->GetId() << " ";
+            ofs << setw(10) << p_obj->GetType().GetName() << " ";
+            ofs << p_obj->GetName() << " ";
+            ofs << endl;
+            p_ref = p_ref->Next;
         }
 
     }
@@ -428,6 +563,7 @@ CEntityPtr CEntity::GetSubObj(const string& oname)
 void CEntity::Set(const CKey& parmid, const int& value)
 {
     m_properties.Set(parmid,value);
+    Modified( (parmid == POSX) || (parmid == POSY) || (parmid == POSZ) );
 }
 
 // -------------------------------------------------------------------------
@@ -435,6 +571,7 @@ void CEntity::Set(const CKey& parmid, const int& value)
 void CEntity::Set(const CKey& parmid, const double& value)
 {
     m_properties.Set(parmid,value);
+    Modified( (parmid == POSX) || (parmid == POSY) || (parmid == POSZ) );
 }
 
 // -------------------------------------------------------------------------
@@ -442,6 +579,7 @@ void CEntity::Set(const CKey& parmid, const double& value)
 void CEntity::Set(const CKey& parmid, const string& value)
 {
     m_properties.Set(parmid,value);
+    Modified( (parmid == POSX) || (parmid == POSY) || (parmid == POSZ) );
 }
 
 // -------------------------------------------------------------------------
@@ -452,16 +590,9 @@ void CEntity::Set(const CKey& parmid, const CEntityPtr& value)
         throw runtime_error("value is illegal in CEntity::Set(const CKey& parmid, const CEntityPtr& value)");
     }
 
-    // unregister previous value
-    CEntityPtr prev;
-    m_properties.Get(parmid,prev);
-    if( prev ){
-        prev->RemoveRelated(GetSelf());
-    }
-
-    // register new value
-    m_properties.Set(parmid, value);
-    value->m_related.push_back(GetSelf());
+    // previous value is unlinked from its referrers by the property
+    m_properties.Set(parmid,value,this);
+    Modified();
 }
 
 // -------------------------------------------------------------------------
@@ -494,17 +625,48 @@ void CEntity::Get(const CKey& parmid, CEntityPtr& value)
 
 // -------------------------------------------------------------------------
 
-void CEntity::RemoveRelated(CEntityPtr value)
+void CEntity::RemoveObjectProperty(CEntityPtr value)
 {
-    list< CEntityWPtr >::iterator oit = m_related.begin();
-    list< CEntityWPtr >::iterator oie = m_related.end();
-
-    while( oit != oie ){
-        list< CEntityWPtr >::iterator old = oit;
-        oit++;
-        if( (*old).lock() == value ){
-            m_related.erase(old,old);
+    if( ! value ) return;
+
+    // only references to value are visited
+    bool        modified = false;
+    CEntityRef* p_ref = value->m_referrers;
+    while( p_ref ){
+        CEntityRef* p_next = p_ref->Next;
+        if( p_ref->Owner == this ){
+            CProperty::UnlinkRef(p_ref);
+            p_ref->Object.reset();
+            modified = true;
         }
+        p_ref = p_next;
+    }
+
+    if( modified ) Modified();
+}
+
+// -------------------------------------------------------------------------
+
+size_t CEntity::NumberOfReferrers(void) const
+{
+    size_t      num = 0;
+    CEntityRef* p_ref = m_referrers;
+    while( p_ref ){
+        num++;
+        p_ref = p_ref->Next;
+    }
+    return(num);
+}
+
+// -------------------------------------------------------------------------
+
+void CEntity::GetReferrers(vector<CEntity*>& referrers) const
+{
+    referrers.clear();
+    CEntityRef* p_ref = m_referrers;
+    while( p_ref ){
+        referrers.push_back(p_ref->Owner);
+        p_ref = p_ref->Next;
     }
 }
 
@@ -557,6 +719,62 @@ void CEntity::AddChild( CEntityPtr child )
         m_first = child;
         m_last = child->GetThis();
     }
+
+    ChildAdded(child->GetThis());
+    Modified();
+}
+
+// -------------------------------------------------------------------------
+
+void CEntity::ChildAdded(CEntity* p_child)
+{
+    m_num_children++;
+
+    if( m_child_index_valid ){
+        m_child_index.push_back(p_child);
+    }
+
+    if( m_name_index ){
+        if( m_name_index->Insert(p_child) == false ){
+            m_name_index_dups = true;
+        }
+    }
+}
+
+// -------------------------------------------------------------------------
+
+void CEntity::ChildRemoved(CEntity* p_child, bool last)
+{
+    m_num_children--;
+
+    if( m_child_index_valid ){
+        if( last ){
+            m_child_index.pop_back();
+        } else {
+            m_child_index_valid = false;
+            m_child_index.clear();
+        }
+    }
+
+    RemoveFromNameIndex(p_child);
+}
+
+// -------------------------------------------------------------------------
+
+void CEntity::RemoveFromNameIndex(CEntity* p_child)
+{
+    if( ! m_name_index ) return;
+
+    // only the first child of given name is indexed
+    if( m_name_index->Find(p_child->m_name) != p_child ) return;
+
+    if( m_name_index_dups ){
+        // other child of the same name could be promoted - rebuild later
+        m_name_index.reset();
+        return;
+    }
+
+    m_name_index->Remove(p_child->m_name);
 }
 
 // -------------------------------------------------------------------------
@@ -584,6 +802,8 @@ void CEntity::RemoveChild( CEntityPtr child )
     }
 
     // remove middle object
+    ChildRemoved(child->GetThis(),false);
+
     CEntityPtr next = child->m_sibling;
     CEntityPtr prev = child->GetPrev();
     prev->m_sibling = next;
@@ -592,6 +812,8 @@ void CEntity::RemoveChild( CEntityPtr child )
     // update object - before its (possible) destruction
     child->m_root = NULL;
     child->m_self = NULL;
+
+    Modified();
 }
 
 // -------------------------------------------------------------------------
@@ -601,6 +823,8 @@ void CEntity::RemoveFirstChild(void)
     if( m_first ){
         CEntityPtr old_first = m_first;
 
+        ChildRemoved(old_first->GetThis(),m_num_children == 1);
+
         // set and update new first object
         m_first = m_first->m_sibling;
         if( m_first ){
@@ -614,6 +838,8 @@ void CEntity::RemoveFirstChild(void)
         old_first->m_root = NULL;
         old_first->m_self = NULL;
         old_first->m_sibling = CEntityPtr();
+
+        Modified();
     }
 }
 
@@ -628,6 +854,8 @@ void CEntity::RemoveLastChild(void)
             throw runtime_error("unable get self reference - CEntity::RemoveLastChild");
         }
 
+        ChildRemoved(old_last->GetThis(),true);
+
         CEntityPtr prev = old_last->GetPrev();
 
         if( prev ){
@@ -643,6 +871,8 @@ void CEntity::RemoveLastChild(void)
         old_last->m_root = NULL;
         old_last->m_self = NULL;
         old_last->m_sibling = CEntityPtr();
+
+        Modified();
     }
 }
 
@@ -650,7 +880,7 @@ void CEntity::RemoveLastChild(void)
 
 void CEntity::RemoveAllChildren(void)
 {
-    while( NumberOfChildren() > 0 ){
+    while( m_first ){
         RemoveFirstChild();
     }
 }
@@ -659,12 +889,31 @@ void CEntity::RemoveAllChildren(void)
 
 CEntityPtr CEntity::FindChild(const string& name, bool recursive)
 {
+    if( ! recursive ){
+        if( (! m_name_index) && (m_num_children >= NAME_INDEX_LIMIT) ){
+            m_name_index = shared_ptr<CNameIndex>(new CNameIndex);
+            m_name_index_dups = false;
+            CEntityPtr obj = m_first;
+            while( obj ){
+                if( m_name_index->Insert(obj->GetThis()) == false ){
+                    m_name_index_dups = true;
+                }
+                obj = obj->m_sibling;
+            }
+        }
+        if( m_name_index ){
+            CEntity* p_obj = m_name_index->Find(name);
+            if( p_obj == NULL ) return( CEntityPtr() );
+            return( p_obj->GetSelf() );
+        }
+    }
+
     CEntityPtr obj = m_first;
 
     while( obj ){
         if( obj->GetName() == name ) return( obj );
         if( recursive ){
-            CEntityPtr sub = FindChild( name, recursive );
+            CEntityPtr sub = obj->FindChild( name, recursive );
             if( sub ) return( sub );
         }
         obj = obj->m_sibling;
@@ -712,6 +961,8 @@ bool CEntity::IsChild(CEntityPtr cobj, bool recursive)
 
 size_t CEntity::NumberOfChildren(bool recursive)
 {
+    if( ! recursive ) return( m_num_children );
+
     size_t      size = 0;
     CEntityPtr  obj = m_first;
 
@@ -730,6 +981,16 @@ size_t CEntity::NumberOfChildren(bool recursive)
 
 CEntityPtr CEntity::GetChild(size_t index)
 {
+    if( index >= m_num_children ) return( CEntityPtr() );
+    if( index == m_num_children - 1 ) return( GetLastChild() );
+
+    if( m_num_children >= CHILD_INDEX_LIMIT ){
+        BuildChildIndex();
+    }
+    if( m_child_index_valid ){
+        return( m_child_index[index]->GetSelf() );
+    }
+
     size_t      lindex = 0;
     CEntityPtr  obj = m_first;
 
@@ -746,6 +1007,22 @@ CEntityPtr CEntity::GetChild(size_t index)
 
 // -------------------------------------------------------------------------
 
+void CEntity::BuildChildIndex(void)
+{
+    if( m_child_index_valid ) return;
+
+    m_child_index.clear();
+    m_child_index.reserve(m_num_children);
+    CEntityPtr obj = m_first;
+    while( obj ){
+        m_child_index.push_back(obj->GetThis());
+        obj = obj->m_sibling;
+    }
+    m_child_index_valid = true;
+}
+
+// -------------------------------------------------------------------------
+
 CEntityPtr CEntity::GetFirstChild( )
 {
     return( m_first );
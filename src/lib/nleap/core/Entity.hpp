@@ -25,11 +25,13 @@
 #include <map>
 #include <list>
 #include <string>
+#include <vector>
 #include <iostream>
 #include <stdexcept>
 #include <boost/shared_ptr.hpp>
 #include <boost/weak_ptr.hpp>
 #include <core/PropertyMap.hpp>
+#include <core/EntityRange.hpp>
 
 // -----------------------------------------------------------------------------
 
@@ -44,6 +46,9 @@ using namespace boost;
 class   CKey;
 class   CEntity;
 class   CForwardIterator;
+class   CNameIndex;
+class   CEntityIdMap;
+struct  CEntityRef;
 typedef shared_ptr< CEntity >   CEntityPtr;
 typedef weak_ptr< CEntity >     CEntityWPtr;
 
@@ -64,17 +69,17 @@ public:
 
 // object clonning  ------------------------------------------------------------
 
-    //! clone
-    CEntityPtr Clone(int& top_id, int base_id = 0);
+    //! clone, if move_caches is true then caches are moved to the clone (database snapshots)
+    CEntityPtr Clone(int& top_id, int base_id = 0, bool move_caches = false);
 
     //! clone entity weakly
-    CEntityPtr CloneWeakly(int& top_id, int base_id = 0);
+    CEntityPtr CloneWeakly(int& top_id, int base_id = 0, bool move_caches = false);
 
     //! bind weakly cloned object properties
-    void BindWeakProperties(map< int, CEntityPtr >& obj_map);
+    void BindWeakProperties(const CEntityIdMap& obj_map);
 
     //! update object map with children objects
-    void UpdateObjectMap(map< int, CEntityPtr >& obj_map);
+    void UpdateObjectMap(CEntityIdMap& obj_map);
 
 // object references  ----------------------------------------------------------
 
@@ -113,6 +118,12 @@ public:
     //! set entity ID
     void SetId(int id);
 
+    //! get revision of entity subtree - changed by any modification except positions
+    unsigned long GetRevision(void) const;
+
+    //! get revision of positions in entity subtree
+    unsigned long GetPosRevision(void) const;
+
     //! describe entity
     virtual void Desc(ostream& ofs);
 
@@ -122,6 +133,20 @@ public:
     //! get subobject
     virtual CEntityPtr GetSubObj(const string& oname);
 
+// memory footprint ------------------------------------------------------------
+
+    //! memory of this object, its properties and indexes, children are not included
+    virtual size_t GetObjectSize(void) const;
+
+    //! memory of this object and all its children
+    size_t GetMemorySize(void) const;
+
+    //! approximate heap memory of string
+    static size_t GetStringSize(const string& str);
+
+    //! format memory size in B, kB, MB or GB
+    static string FormatMemorySize(size_t size);
+
 // properties ------------------------------------------------------------------
 
     //! property setter method - int
@@ -151,9 +176,15 @@ public:
     template <typename T1>
     inline const T1 Get(const CKey& parmid);
 
-    //! remove object property
+    //! unset all object properties of this object referring to value
     void RemoveObjectProperty(CEntityPtr value);
 
+    //! number of object properties referring to this object
+    size_t NumberOfReferrers(void) const;
+
+    //! get owners of object properties referring to this object
+    void GetReferrers(vector<CEntity*>& referrers) const;
+
 // children objects ------------------------------------------------------------
 
     //! beginning of children objects
@@ -177,7 +208,7 @@ public:
     //! remove all childern
     void RemoveAllChildren(void);
 
-    //! find child object by name
+    //! find child object by name, large containers are searched via name index
     CEntityPtr FindChild(const string& name, bool recursive = false);
 
     //! find child object by id
@@ -189,7 +220,7 @@ public:
     //! get number of children
     size_t NumberOfChildren(bool recursive = false );
 
-    //! get child
+    //! get child, large containers are accessed via child index
     CEntityPtr GetChild(size_t index);
 
     //! get first child
@@ -198,6 +229,10 @@ public:
     //! get last child
     CEntityPtr GetLastChild(void);
 
+    //! children as a range, all children must be of type T
+    template <typename T>
+    inline CEntityRange<T> Children(void);
+
 // input/output methods --------------------------------------------------------
     //! load from XML
     virtual bool Load(CXMLElement* p_ele);
@@ -216,9 +251,37 @@ protected:
     CEntity*                m_self;         // node owing this node (prev or root)
     CEntity*                m_last;         // last child entity
     CPropertyMap            m_properties;   // entity properties
-    list< CEntityWPtr >     m_related;      // related objects
+    CEntityRef*             m_referrers;    // object properties referring to this object
+    unsigned long           m_revision;     // subtree revision
+    unsigned long           m_pos_revision; // subtree positions revision
+    size_t                  m_num_children; // number of children
+    vector<CEntity*>        m_child_index;  // children in order, built on demand
+    bool                    m_child_index_valid;
+    shared_ptr<CNameIndex>  m_name_index;   // children by name, built on demand
+    bool                    m_name_index_dups;  // children with duplicate names
+
+    //! update children counter and indexes after child addition
+    void ChildAdded(CEntity* p_child);
 
-    void RemoveRelated(CEntityPtr value);
+    //! update children counter and indexes before child removal
+    void ChildRemoved(CEntity* p_child, bool last);
+
+    //! remove child from name index
+    void RemoveFromNameIndex(CEntity* p_child);
+
+    //! build contiguous child index if it is not valid
+    void BuildChildIndex(void);
+
+    //! mark entity and all its owners as modified
+    void Modified(bool pos_only = false);
+
+    //! copy data derived from the subtree to its weak clone
+    virtual void CopyCaches(CEntity* p_clone);
+
+    //! hand over data derived from the subtree to its weak clone
+    virtual void MoveCaches(CEntity* p_clone);
+
+    friend class CProperty;
 };
 
 //--------------------------------------------------------------------------
@@ -231,6 +294,16 @@ inline const T1 CEntity::Get(const CKey& parmid)
     return(value);
 }
 
+//--------------------------------------------------------------------------
+
+template <typename T>
+inline CEntityRange<T> CEntity::Children(void)
+{
+    BuildChildIndex();
+    if( m_child_index.empty() ) return( CEntityRange<T>() );
+    return( CEntityRange<T>(&m_child_index[0],m_child_index.size()) );
+}
+
 //--------------------------------------------------------------------------
 }
 
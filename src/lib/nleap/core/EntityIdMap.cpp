@@ -0,0 +1,109 @@
+// =============================================================================
+// nLEaP - A molecular manipulation program and coding environment
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2011 Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2006 gLEaP authors, see AUTHORS file in the main directory
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <core/EntityIdMap.hpp>
+#include <core/Entity.hpp>
+#include <algorithm>
+
+namespace nleap {
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CEntityIdMap::CEntityIdMap(void)
+{
+    m_min_id = 0;
+    m_use_dense = false;
+}
+
+//------------------------------------------------------------------------------
+
+void CEntityIdMap::Add(CEntity* p_obj)
+{
+    m_entries.push_back( CIdEntry(p_obj->GetId(),p_obj) );
+}
+
+//------------------------------------------------------------------------------
+
+bool CEntityIdMap::LessId(const CIdEntry& left,const CIdEntry& right)
+{
+    return( left.first < right.first );
+}
+
+//------------------------------------------------------------------------------
+
+void CEntityIdMap::Finalize(void)
+{
+    m_dense.clear();
+    m_use_dense = false;
+    if( m_entries.empty() ) return;
+
+    int min_id = m_entries[0].first;
+    int max_id = m_entries[0].first;
+    for(size_t i=1; i < m_entries.size(); i++){
+        if( m_entries[i].first < min_id ) min_id = m_entries[i].first;
+        if( m_entries[i].first > max_id ) max_id = m_entries[i].first;
+    }
+
+    size_t range = (size_t)((long)max_id - (long)min_id + 1);
+
+    // dense table unless IDs are very sparse
+    if( range <= 4*m_entries.size() + 1024 ){
+        m_min_id = min_id;
+        m_dense.assign(range,(CEntity*)NULL);
+        for(size_t i=0; i < m_entries.size(); i++){
+            m_dense[m_entries[i].first - min_id] = m_entries[i].second;
+        }
+        m_entries.clear();
+        m_use_dense = true;
+        return;
+    }
+
+    // stable sort keeps the order of addition for duplicate IDs
+    stable_sort(m_entries.begin(),m_entries.end(),LessId);
+}
+
+//------------------------------------------------------------------------------
+
+CEntityPtr CEntityIdMap::Find(int id) const
+{
+    CEntity* p_obj = NULL;
+
+    if( m_use_dense ){
+        if( (id >= m_min_id) && ((size_t)((long)id - (long)m_min_id) < m_dense.size()) ){
+            p_obj = m_dense[id - m_min_id];
+        }
+    } else {
+        vector<CIdEntry>::const_iterator it;
+        it = upper_bound(m_entries.begin(),m_entries.end(),CIdEntry(id,(CEntity*)NULL),LessId);
+        if( (it != m_entries.begin()) && ((it-1)->first == id) ){
+            p_obj = (it-1)->second;
+        }
+    }
+
+    if( p_obj == NULL ) return( CEntityPtr() );
+    return( p_obj->GetSelf() );
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+}
@@ -0,0 +1,75 @@
+#ifndef NLEAP_CORE_ENTITY_ID_MAP_HPP
+#define NLEAP_CORE_ENTITY_ID_MAP_HPP
+// =============================================================================
+// nLEaP - A molecular manipulation program and coding environment
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2011 Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2006 gLEaP authors, see AUTHORS file in the main directory
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <NLEaPMainHeader.hpp>
+#include <boost/shared_ptr.hpp>
+#include <vector>
+#include <utility>
+
+namespace nleap {
+//------------------------------------------------------------------------------
+
+using namespace std;
+using namespace boost;
+
+class   CEntity;
+typedef shared_ptr< CEntity >   CEntityPtr;
+
+//------------------------------------------------------------------------------
+
+/// CEntityIdMap resolves entity IDs to entities during cloning
+/*!
+ IDs of cloned objects form a compact interval (original IDs shifted by
+ base_id), thus the map is a flat vector indexed by ID offset. If IDs are
+ too sparse, a sorted vector with binary search is used instead.
+*/
+
+class NLEAP_PACKAGE CEntityIdMap {
+public:
+    CEntityIdMap(void);
+
+    //! add entity, later entities with the same ID win
+    void Add(CEntity* p_obj);
+
+    //! prepare map for lookups
+    void Finalize(void);
+
+    //! find entity by ID, NULL pointer if not found
+    CEntityPtr Find(int id) const;
+
+// section of private data -----------------------------------------------------
+private:
+    typedef pair<int,CEntity*>  CIdEntry;
+
+    vector<CIdEntry>    m_entries;      // in order of addition, then sorted
+    vector<CEntity*>    m_dense;        // indexed by id - m_min_id
+    int                 m_min_id;
+    bool                m_use_dense;
+
+    static bool LessId(const CIdEntry& left,const CIdEntry& right);
+};
+
+//------------------------------------------------------------------------------
+}
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef NLEAP_CORE_ENTITY_RANGE_HPP
+#define NLEAP_CORE_ENTITY_RANGE_HPP
+// =============================================================================
+// nLEaP - A molecular manipulation program and coding environment
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2011 Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2006 gLEaP authors, see AUTHORS file in the main directory
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <NLEaPMainHeader.hpp>
+#include <cstddef>
+
+namespace nleap {
+//------------------------------------------------------------------------------
+
+class CEntity;
+
+//------------------------------------------------------------------------------
+
+/// CEntityRange is a contiguous range of entities of the same type
+/*!
+ The range refers to an array of raw entity pointers owned by the container,
+ thus iteration does not touch reference counters. The range is valid until
+ the container structure is modified. It provides random access and can be
+ split into chunks for parallel loops.
+*/
+
+template <class T>
+class CEntityRange {
+public:
+    class iterator {
+    public:
+        iterator(void) : m_ptr(NULL) {}
+        iterator(CEntity* const* ptr) : m_ptr(ptr) {}
+
+        T& operator * (void) const { return( *static_cast<T*>(*m_ptr) ); }
+        T* operator -> (void) const { return( static_cast<T*>(*m_ptr) ); }
+
+        iterator& operator ++ (void) { m_ptr++; return(*this); }
+        iterator operator ++ (int) { iterator it(*this); m_ptr++; return(it); }
+
+        bool operator == (const iterator& left) const { return( m_ptr == left.m_ptr ); }
+        bool operator != (const iterator& left) const { return( m_ptr != left.m_ptr ); }
+
+    private:
+        CEntity* const* m_ptr;
+    };
+
+    //! constructor - empty range
+    CEntityRange(void) : m_begin(NULL), m_size(0) {}
+
+    //! constructor
+    CEntityRange(CEntity* const* begin, size_t size) : m_begin(begin), m_size(size) {}
+
+    //! beginning of range
+    iterator begin(void) const { return( iterator(m_begin) ); }
+
+    //! end of range
+    iterator end(void) const { return( iterator(m_begin + m_size) ); }
+
+    //! number of entities
+    size_t size(void) const { return( m_size ); }
+
+    //! is range empty?
+    bool empty(void) const { return( m_size == 0 ); }
+
+    //! access entity
+    T& operator [] (size_t index) const { return( *static_cast<T*>(m_begin[index]) ); }
+
+    //! get chunk-th of nchunks nearly equal parts of the range
+    CEntityRange Chunk(size_t chunk, size_t nchunks) const
+    {
+        size_t first = m_size * chunk / nchunks;
+        size_t last  = m_size * (chunk + 1) / nchunks;
+        return( CEntityRange(m_begin + first, last - first) );
+    }
+
+// private data ------------------------------------------------------------
+private:
+    CEntity* const* m_begin;
+    size_t          m_size;
+};
+
+//------------------------------------------------------------------------------
+}
+
+#endif
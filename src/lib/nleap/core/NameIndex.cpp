@@ -0,0 +1,205 @@
+// =============================================================================
+// nLEaP - A molecular manipulation program and coding environment
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2011 Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2006 gLEaP authors, see AUTHORS file in the main directory
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <core/NameIndex.hpp>
+#include <core/Entity.hpp>
+#include <algorithm>
+
+namespace nleap {
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CNameIndex::CNameIndex(void)
+{
+    m_size = 0;
+    m_used = 0;
+}
+
+//------------------------------------------------------------------------------
+
+void CNameIndex::Clear(void)
+{
+    m_slots.clear();
+    m_size = 0;
+    m_used = 0;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+size_t CNameIndex::Hash(const string& name)
+{
+    // FNV-1a
+    size_t hash = 2166136261u;
+    for(size_t i=0; i < name.size(); i++){
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+    return(hash);
+}
+
+//------------------------------------------------------------------------------
+
+long CNameIndex::FindSlot(const string& name, size_t hash) const
+{
+    if( m_slots.empty() ) return(-1);
+
+    size_t mask = m_slots.size() - 1;
+    size_t i = hash & mask;
+
+    // linear probing, table is never full
+    while( (m_slots[i].Object != NULL) || m_slots[i].Deleted ){
+        const SSlot& slot = m_slots[i];
+        if( (slot.Object != NULL) && (slot.Hash == hash) && (slot.Object->GetName() == name) ){
+            return(i);
+        }
+        i = (i + 1) & mask;
+    }
+
+    return(-1);
+}
+
+//------------------------------------------------------------------------------
+
+void CNameIndex::Rehash(size_t capacity)
+{
+    vector<SSlot> old_slots;
+    old_slots.swap(m_slots);
+
+    SSlot empty;
+    empty.Hash = 0;
+    empty.Object = NULL;
+    empty.Deleted = false;
+    m_slots.assign(capacity,empty);
+
+    size_t mask = capacity - 1;
+    for(size_t j=0; j < old_slots.size(); j++){
+        if( old_slots[j].Object == NULL ) continue;
+        size_t i = old_slots[j].Hash & mask;
+        while( m_slots[i].Object != NULL ){
+            i = (i + 1) & mask;
+        }
+        m_slots[i] = old_slots[j];
+    }
+    m_used = m_size;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CNameIndex::Insert(CEntity* p_obj)
+{
+    if( p_obj == NULL ) return(false);
+
+    const string& name = p_obj->GetName();
+    size_t hash = Hash(name);
+    if( FindSlot(name,hash) >= 0 ) return(false);
+
+    // keep load factor including tombstones below one half
+    if( 2*(m_used + 1) > m_slots.size() ){
+        size_t capacity = 16;
+        while( capacity < 4*(m_size + 1) ) capacity *= 2;
+        Rehash(capacity);
+    }
+
+    size_t mask = m_slots.size() - 1;
+    size_t i = hash & mask;
+    while( m_slots[i].Object != NULL ){
+        i = (i + 1) & mask;
+    }
+    if( ! m_slots[i].Deleted ) m_used++;
+    m_slots[i].Hash = hash;
+    m_slots[i].Object = p_obj;
+    m_slots[i].Deleted = false;
+    m_size++;
+
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CNameIndex::Remove(const string& name)
+{
+    long i = FindSlot(name,Hash(name));
+    if( i < 0 ) return(false);
+
+    m_slots[i].Object = NULL;
+    m_slots[i].Deleted = true;
+    m_size--;
+
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+CEntity* CNameIndex::Find(const string& name) const
+{
+    long i = FindSlot(name,Hash(name));
+    if( i < 0 ) return(NULL);
+    return( m_slots[i].Object );
+}
+
+//------------------------------------------------------------------------------
+
+bool CNameIndex::CopyCloned(const CNameIndex& other, const vector< pair<CEntity*,CEntity*> >& clones)
+{
+    // the clones have the same names, thus also the same slots
+    m_slots = other.m_slots;
+    m_size = other.m_size;
+    m_used = other.m_used;
+
+    pair<CEntity*,CEntity*> key(NULL,NULL);
+    for(size_t i=0; i < m_slots.size(); i++){
+        if( m_slots[i].Object == NULL ) continue;
+        key.first = m_slots[i].Object;
+        vector< pair<CEntity*,CEntity*> >::const_iterator it;
+        it = lower_bound(clones.begin(),clones.end(),key);
+        if( (it == clones.end()) || (it->first != key.first) ){
+            Clear();
+            return(false);
+        }
+        m_slots[i].Object = it->second;
+    }
+
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+size_t CNameIndex::Size(void) const
+{
+    return(m_size);
+}
+
+//------------------------------------------------------------------------------
+
+size_t CNameIndex::GetMemorySize(void) const
+{
+    return( m_slots.capacity()*sizeof(SSlot) );
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+}
@@ -0,0 +1,96 @@
+#ifndef NLEAP_CORE_NAME_INDEX_HPP
+#define NLEAP_CORE_NAME_INDEX_HPP
+// =============================================================================
+// nLEaP - A molecular manipulation program and coding environment
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2011 Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2006 gLEaP authors, see AUTHORS file in the main directory
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <NLEaPMainHeader.hpp>
+#include <string>
+#include <vector>
+#include <utility>
+
+namespace nleap {
+//------------------------------------------------------------------------------
+
+using namespace std;
+
+class CEntity;
+
+//------------------------------------------------------------------------------
+
+/// open-addressing hash index of entities by their names
+/*!
+ The index does not own entities, names are read directly from them.
+ Thus an entity must be removed from the index before it is renamed or
+ destroyed. Only the first entity of a given name is indexed.
+*/
+
+class NLEAP_PACKAGE CNameIndex {
+public:
+    CNameIndex(void);
+
+    //! remove all entries
+    void Clear(void);
+
+    //! insert entity, return false if the name is already indexed
+    bool Insert(CEntity* p_obj);
+
+    //! remove entity of given name, return false if there is none
+    bool Remove(const string& name);
+
+    //! find entity by name, NULL if not found
+    CEntity* Find(const string& name) const;
+
+    //! copy index of other entities, clones are pairs of the other entities and
+    //! their replacements sorted by the other entities, false if some entity has no clone
+    bool CopyCloned(const CNameIndex& other, const vector< pair<CEntity*,CEntity*> >& clones);
+
+    //! number of indexed entities
+    size_t Size(void) const;
+
+    //! memory of index slots
+    size_t GetMemorySize(void) const;
+
+    //! hash function used by the index
+    static size_t Hash(const string& name);
+
+// section of private data -----------------------------------------------------
+private:
+    struct SSlot {
+        size_t      Hash;
+        CEntity*    Object;     // NULL - empty slot
+        bool        Deleted;    // tombstone
+    };
+
+    vector<SSlot>   m_slots;    // size is power of two
+    size_t          m_size;     // number of entities
+    size_t          m_used;     // number of entities and tombstones
+
+    //! find slot with the name, -1 if not found
+    long FindSlot(const string& name, size_t hash) const;
+
+    //! rehash into table with given capacity
+    void Rehash(size_t capacity);
+};
+
+//------------------------------------------------------------------------------
+}
+
+#endif
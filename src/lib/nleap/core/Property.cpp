@@ -22,6 +22,7 @@
 #include <core/Property.hpp>
 #include <core/PredefinedKeys.hpp>
 #include <core/Entity.hpp>
+#include <core/EntityIdMap.hpp>
 
 namespace nleap {
 //==============================================================================
@@ -70,13 +71,13 @@ void CProperty::CloneWeakly(const CProperty& src, int base_id)
 
 // ---------------------------------------------------------------------
 
-void CProperty::BindWeak(map< int, CEntityPtr >&  obj_map)
+void CProperty::BindWeak(const CEntityIdMap& obj_map,CEntity* p_owner)
 {
     if( m_type != IPTR_PROP ) return;
     int id;
     GetId(id);
-    CEntityPtr obj = obj_map[id];
-    Set(obj);
+    CEntityPtr obj = obj_map.Find(id);
+    Set(obj,p_owner);
 }
 
 // ---------------------------------------------------------------------
@@ -95,6 +96,19 @@ const CKey& CProperty::GetType(void) const
 
 // ---------------------------------------------------------------------
 
+size_t CProperty::GetValueSize(void) const
+{
+    if( m_type == STR__PROP ){
+        return( sizeof(string) + CEntity::GetStringSize(*((string*)m_value.m_x_value)) );
+    }
+    if( m_type == PTR__PROP ){
+        return( sizeof(CEntityRef) );
+    }
+    return(0);
+}
+
+// ---------------------------------------------------------------------
+
 void CProperty::Set(const int& value)
 {
     if( (m_type == STR__PROP) || (m_type == PTR__PROP) ) Deallocate();
@@ -134,14 +148,21 @@ void CProperty::Set(const string& value)
 
 // ---------------------------------------------------------------------
 
-void CProperty::Set(const CEntityPtr& value)
+void CProperty::Set(const CEntityPtr& value,CEntity* p_owner)
 {
     if( m_type == STR__PROP ) Deallocate();
     if( m_type != PTR__PROP ) {
         m_type = PTR__PROP;
         Allocate();
     }
-    *((CEntityPtr*)m_value.m_x_value) = value;
+    CEntityRef* p_ref = (CEntityRef*)m_value.m_x_value;
+    if( (p_ref->Object == value) && (p_ref->Owner == p_owner) ) return;
+
+    // unlink before the previous object can be released
+    UnlinkRef(p_ref);
+    p_ref->Owner = p_owner;
+    p_ref->Object = value;
+    LinkRef(p_ref);
 }
 
 // ---------------------------------------------------------------------
@@ -205,7 +226,7 @@ void CProperty::Get(CEntityPtr& value) const
         value = CEntityPtr();
         return;
     }
-    value = *((CEntityPtr*)m_value.m_x_value);
+    value = ((CEntityRef*)m_value.m_x_value)->Object;
 }
 
 // ---------------------------------------------------------------------
@@ -228,7 +249,11 @@ void CProperty::Allocate(void)
         return;
     }
     if( m_type == PTR__PROP ){
-        m_value.m_x_value = new CEntityPtr;
+        CEntityRef* p_ref = new CEntityRef;
+        p_ref->Owner = NULL;
+        p_ref->Prev = NULL;
+        p_ref->Next = NULL;
+        m_value.m_x_value = p_ref;
         return;
     }
 }
@@ -242,13 +267,42 @@ void CProperty::Deallocate(void)
         return;
     }
     if( m_type == PTR__PROP ){
-        delete ((CEntityPtr*)m_value.m_x_value);
+        CEntityRef* p_ref = (CEntityRef*)m_value.m_x_value;
+        UnlinkRef(p_ref);
+        delete p_ref;
         return;
     }
 }
 
 // -------------------------------------------------------------------------
 
+void CProperty::LinkRef(CEntityRef* p_ref)
+{
+    if( ! p_ref->Object ) return;
+    CEntity* p_obj = p_ref->Object.get();
+    p_ref->Prev = NULL;
+    p_ref->Next = p_obj->m_referrers;
+    if( p_ref->Next ) p_ref->Next->Prev = p_ref;
+    p_obj->m_referrers = p_ref;
+}
+
+// -------------------------------------------------------------------------
+
+void CProperty::UnlinkRef(CEntityRef* p_ref)
+{
+    if( ! p_ref->Object ) return;
+    if( p_ref->Prev ){
+        p_ref->Prev->Next = p_ref->Next;
+    } else {
+        p_ref->Object->m_referrers = p_ref->Next;
+    }
+    if( p_ref->Next ) p_ref->Next->Prev = p_ref->Prev;
+    p_ref->Prev = NULL;
+    p_ref->Next = NULL;
+}
+
+// -------------------------------------------------------------------------
+
 ostream& operator << ( ostream& ofs, const CProperty& obj )
 {
     if( obj.GetType() == INT__PROP ){
@@ -33,10 +33,26 @@ using namespace std;
 using namespace boost;
 
 class   CEntity;
+class   CEntityIdMap;
 typedef shared_ptr< CEntity >   CEntityPtr;
 
 //--------------------------------------------------------------------------
 
+//! value of object property
+/*!
+ all references to an object are kept in the intrusive list headed by
+ the referred object, so they can be enumerated and removed without
+ searching properties of other objects
+*/
+struct CEntityRef {
+    CEntityPtr  Object;     // referred object
+    CEntity*    Owner;      // object owning the property
+    CEntityRef* Prev;       // previous reference to the same object
+    CEntityRef* Next;       // next reference to the same object
+};
+
+//--------------------------------------------------------------------------
+
 //! CProperty is a simple variant object
 class NLEAP_PACKAGE CProperty {
 public:
@@ -50,7 +66,7 @@ public:
     void CloneWeakly(const CProperty& src,int base_id);
 
     //! bind weak objects
-    void BindWeak(map< int, CEntityPtr >& obj_map);
+    void BindWeak(const CEntityIdMap& obj_map,CEntity* p_owner);
 
 // ---------------------------------------------------------------------
     //! get property key
@@ -59,6 +75,9 @@ public:
     //! get property type
     const CKey& GetType(void) const;
 
+    //! memory of property value allocated outside of property
+    size_t GetValueSize(void) const;
+
 // ---------------------------------------------------------------------
     //! property setter method - int
     void Set(const int& value);
@@ -72,8 +91,8 @@ public:
     //! property setter method - string
     void Set(const string& value);
 
-    //! property setter method - CEntityPtr
-    void Set(const CEntityPtr& value);
+    //! property setter method - CEntityPtr, p_owner is object owning the property
+    void Set(const CEntityPtr& value,CEntity* p_owner);
 
 // ---------------------------------------------------------------------
     //! property getter method - int
@@ -113,7 +132,12 @@ private:
     void Allocate(void);
     void Deallocate(void);
 
+    // maintain list of references to the referred object
+    static void LinkRef(CEntityRef* p_ref);
+    static void UnlinkRef(CEntityRef* p_ref);
+
     friend class CPropertyMap;
+    friend class CEntity;
 };
 
 //--------------------------------------------------------------------------
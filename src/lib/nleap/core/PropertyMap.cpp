@@ -95,14 +95,19 @@ void CPropertyMap::CloneWeakly(const CPropertyMap& src, int base_id)
 
 // -------------------------------------------------------------------------
 
-void CPropertyMap::BindWeak(map< int, CEntityPtr >&  obj_map)
+void CPropertyMap::BindWeak(const CEntityIdMap& obj_map,CEntity* p_owner)
 {
-    size_t size = NumberOfProperties();
+    CProperty*    p_block = m_first_block;
 
-    // bind_weak
-    for(size_t i=0; i < size; i++){
-        CProperty& node = GetNode(i);
-        node.BindWeak(obj_map);
+    // bind_weak - single pass over all blocks
+    while( p_block != NULL ){
+        int i = 0;
+        while( p_block[i].m_key != NEXT_PROP ){
+            if( p_block[i].m_key == NULL_PROP ) break;
+            p_block[i].BindWeak(obj_map,p_owner);
+            i++;
+        }
+        p_block[i].Get(p_block);
     }
 }
 
@@ -148,6 +153,26 @@ size_t  CPropertyMap::NumberOfObjectProperties(void) const
 
 // -------------------------------------------------------------------------
 
+size_t  CPropertyMap::GetMemorySize(void) const
+{
+    CProperty*    p_block = m_first_block;
+    size_t size = 0;
+
+    while( p_block != NULL ){
+        int i = 0;
+        while( p_block[i].m_key != NEXT_PROP ){
+            size += p_block[i].GetValueSize();
+            i++;
+        }
+        size += (i + 1)*sizeof(CProperty);
+        p_block[i].Get(p_block);
+    }
+
+    return(size);
+}
+
+// -------------------------------------------------------------------------
+
 void CPropertyMap::Desc(ostream& ofs)
 {
     size_t naprops = NumberOfProperties();
@@ -201,23 +226,6 @@ void CPropertyMap::Desc(ostream& ofs)
 
 // -------------------------------------------------------------------------
 
-void CPropertyMap::UnsetObjectProperty(const CEntityPtr& obj)
-{
-    int num = NumberOfProperties();
-    for(int i = 0; i < num; i++){
-        CProperty& prop = GetNode(i);
-        if( prop.GetType() == PTR__PROP ){
-            CEntityPtr value;
-            prop.Get(value);
-            if( value == obj ){
-                prop.Set( CEntityPtr() );
-            }
-        }
-    }
-}
-
-// -------------------------------------------------------------------------
-
 void CPropertyMap::Set(const CKey& parmid, const int& value)
 {
     CProperty*    p_block = m_first_block;
@@ -317,7 +325,7 @@ void CPropertyMap::Set(const CKey& parmid, const string& value)
 
 // -------------------------------------------------------------------------
 
-void CPropertyMap::Set(const CKey& parmid, const CEntityPtr& value)
+void CPropertyMap::Set(const CKey& parmid, const CEntityPtr& value, CEntity* p_owner)
 {
     CProperty*    p_block = m_first_block;
 
@@ -328,7 +336,7 @@ void CPropertyMap::Set(const CKey& parmid, const CEntityPtr& value)
         while( p_block[i].m_key != NEXT_PROP ){
             if( p_block[i].m_key == NULL_PROP ) break;
             if( p_block[i].m_key == parmid ){
-                p_block[i].Set(value);
+                p_block[i].Set(value,p_owner);
                 return;
             }
             i++;
@@ -345,7 +353,7 @@ void CPropertyMap::Set(const CKey& parmid, const CEntityPtr& value)
 
     // set as new value
     p_block[i].m_key = parmid;
-    p_block[i].Set(value);
+    p_block[i].Set(value,p_owner);
 }
 
 // -------------------------------------------------------------------------
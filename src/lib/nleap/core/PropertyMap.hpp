@@ -33,6 +33,7 @@ using namespace boost;
 
 class   CEntity;
 class   CProperty;
+class   CEntityIdMap;
 typedef shared_ptr< CEntity >          CEntityPtr;
 
 //------------------------------------------------------------------------------
@@ -57,8 +58,8 @@ public:
     //! clone weakly
     void CloneWeakly(const CPropertyMap& src, int base_id);
 
-    //! bind weakly cloned object properties
-    void BindWeak(map< int, CEntityPtr >&  obj_map);
+    //! bind weakly cloned object properties owned by p_owner
+    void BindWeak(const CEntityIdMap& obj_map,CEntity* p_owner);
 
 // -----------------------------------------------------------------------------
 
@@ -68,12 +69,12 @@ public:
     //! return number of object properties
     size_t  NumberOfObjectProperties(void) const;
 
+    //! memory of property blocks and property values
+    size_t  GetMemorySize(void) const;
+
     //! describe
     void Desc(ostream& ofs);
 
-    //! unset object property
-    void UnsetObjectProperty(const CEntityPtr& obj);
-
 // -----------------------------------------------------------------------------
     //! property setter method - int
     void Set(const CKey& parmid, const int& value);
@@ -84,8 +85,8 @@ public:
     //! property setter method - string
     void Set(const CKey& parmid, const string& value);
 
-    //! property setter method - CEntityPtr
-    void Set(const CKey& parmid, const CEntityPtr& value);
+    //! property setter method - CEntityPtr, p_owner is object owning the map
+    void Set(const CKey& parmid, const CEntityPtr& value, CEntity* p_owner);
 
 // -----------------------------------------------------------------------------
     //! property getter method - int
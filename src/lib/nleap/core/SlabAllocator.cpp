@@ -0,0 +1,241 @@
+// =============================================================================
+// nLEaP - A molecular manipulation program and coding environment
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2011 Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2006 gLEaP authors, see AUTHORS file in the main directory
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <core/SlabAllocator.hpp>
+
+// approximate size of one slab
+#define SLAB_SIZE           65536
+#define SLAB_MIN_BLOCKS     16
+// block header and alignment of objects
+#define SLAB_BLOCK_ALIGN    16
+
+namespace nleap {
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CSlabPool* CSlabPool::m_pools = NULL;
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CSlabPool::CSlabPool(size_t object_size)
+{
+    m_block_size = SLAB_BLOCK_ALIGN + object_size;
+    m_block_size = (m_block_size + SLAB_BLOCK_ALIGN - 1) / SLAB_BLOCK_ALIGN * SLAB_BLOCK_ALIGN;
+
+    m_blocks_per_slab = SLAB_SIZE / m_block_size;
+    if( m_blocks_per_slab < SLAB_MIN_BLOCKS ) m_blocks_per_slab = SLAB_MIN_BLOCKS;
+
+    m_partial = NULL;
+    m_slabs = 0;
+    m_blocks = 0;
+    m_allocations = 0;
+
+    // register pool, pools are never destroyed
+    GetPoolsLock().Lock();
+    m_next_pool = m_pools;
+    m_pools = this;
+    GetPoolsLock().Unlock();
+}
+
+//------------------------------------------------------------------------------
+
+CSimpleMutex& CSlabPool::GetPoolsLock(void)
+{
+    static CSimpleMutex* p_lock = new CSimpleMutex;
+    return(*p_lock);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void* CSlabPool::Allocate(void)
+{
+    m_lock.Lock();
+
+    SSlab* p_slab = m_partial;
+    if( p_slab == NULL ){
+        // slab header occupies the first block
+        size_t hsize = (sizeof(SSlab) + SLAB_BLOCK_ALIGN - 1) / SLAB_BLOCK_ALIGN * SLAB_BLOCK_ALIGN;
+        char* p_mem = static_cast<char*>(::operator new(hsize + m_blocks_per_slab*m_block_size,std::nothrow));
+        if( p_mem == NULL ){
+            m_lock.Unlock();
+            throw std::bad_alloc();
+        }
+        p_slab = reinterpret_cast<SSlab*>(p_mem);
+        p_slab->Pool = this;
+        p_slab->Prev = NULL;
+        p_slab->Next = NULL;
+        p_slab->FreeList = NULL;
+        p_slab->Top = p_mem + hsize;
+        p_slab->End = p_slab->Top + m_blocks_per_slab*m_block_size;
+        p_slab->Used = 0;
+        LinkPartial(p_slab);
+        m_slabs++;
+    }
+
+    char* p_block;
+    if( p_slab->FreeList ){
+        p_block = static_cast<char*>(p_slab->FreeList);
+        p_slab->FreeList = *reinterpret_cast<void**>(p_block + SLAB_BLOCK_ALIGN);
+    } else {
+        p_block = p_slab->Top;
+        p_slab->Top += m_block_size;
+        *reinterpret_cast<SSlab**>(p_block) = p_slab;
+    }
+
+    p_slab->Used++;
+    m_blocks++;
+    m_allocations++;
+    if( (p_slab->FreeList == NULL) && (p_slab->Top == p_slab->End) ){
+        UnlinkPartial(p_slab); // slab is full
+    }
+
+    m_lock.Unlock();
+
+    return(p_block + SLAB_BLOCK_ALIGN);
+}
+
+//------------------------------------------------------------------------------
+
+void CSlabPool::Deallocate(void* p_obj)
+{
+    if( p_obj == NULL ) return;
+
+    char*  p_block = static_cast<char*>(p_obj) - SLAB_BLOCK_ALIGN;
+    SSlab* p_slab = *reinterpret_cast<SSlab**>(p_block);
+    p_slab->Pool->Release(p_block,p_slab);
+}
+
+//------------------------------------------------------------------------------
+
+void CSlabPool::Release(void* p_block, SSlab* p_slab)
+{
+    m_lock.Lock();
+
+    bool was_full = (p_slab->FreeList == NULL) && (p_slab->Top == p_slab->End);
+
+    *reinterpret_cast<void**>(static_cast<char*>(p_block) + SLAB_BLOCK_ALIGN) = p_slab->FreeList;
+    p_slab->FreeList = p_block;
+    p_slab->Used--;
+    m_blocks--;
+
+    if( was_full ){
+        LinkPartial(p_slab);
+    }
+
+    // return empty slab to the system unless it is the only one with free blocks
+    if( (p_slab->Used == 0) && ((p_slab->Prev != NULL) || (p_slab->Next != NULL)) ){
+        UnlinkPartial(p_slab);
+        ::operator delete(p_slab);
+        m_slabs--;
+    }
+
+    m_lock.Unlock();
+}
+
+//------------------------------------------------------------------------------
+
+void CSlabPool::LinkPartial(SSlab* p_slab)
+{
+    p_slab->Prev = NULL;
+    p_slab->Next = m_partial;
+    if( m_partial ) m_partial->Prev = p_slab;
+    m_partial = p_slab;
+}
+
+//------------------------------------------------------------------------------
+
+void CSlabPool::UnlinkPartial(SSlab* p_slab)
+{
+    if( p_slab->Prev ){
+        p_slab->Prev->Next = p_slab->Next;
+    } else {
+        m_partial = p_slab->Next;
+    }
+    if( p_slab->Next ) p_slab->Next->Prev = p_slab->Prev;
+    p_slab->Prev = NULL;
+    p_slab->Next = NULL;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+size_t CSlabPool::NumberOfSlabs(void) const
+{
+    return(m_slabs);
+}
+
+//------------------------------------------------------------------------------
+
+size_t CSlabPool::NumberOfBlocks(void) const
+{
+    return(m_blocks);
+}
+
+//------------------------------------------------------------------------------
+
+size_t CSlabPool::SlabSize(void) const
+{
+    return(m_blocks_per_slab*m_block_size);
+}
+
+//------------------------------------------------------------------------------
+
+size_t CSlabPool::BlockSize(void) const
+{
+    return(m_block_size);
+}
+
+//------------------------------------------------------------------------------
+
+size_t CSlabPool::NumberOfAllocations(void) const
+{
+    return(m_allocations);
+}
+
+//------------------------------------------------------------------------------
+
+size_t CSlabPool::TotalAllocatedBytes(void)
+{
+    size_t total = 0;
+
+    GetPoolsLock().Lock();
+    CSlabPool* p_pool = m_pools;
+    while( p_pool ){
+        p_pool->m_lock.Lock();
+        total += p_pool->m_allocations * p_pool->m_block_size;
+        p_pool->m_lock.Unlock();
+        p_pool = p_pool->m_next_pool;
+    }
+    GetPoolsLock().Unlock();
+
+    return(total);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+}
@@ -0,0 +1,173 @@
+#ifndef NLEAP_CORE_SLAB_ALLOCATOR_HPP
+#define NLEAP_CORE_SLAB_ALLOCATOR_HPP
+// =============================================================================
+// nLEaP - A molecular manipulation program and coding environment
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2011 Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2006 gLEaP authors, see AUTHORS file in the main directory
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <NLEaPMainHeader.hpp>
+#include <SimpleMutex.hpp>
+#include <cstddef>
+#include <new>
+
+namespace nleap {
+//------------------------------------------------------------------------------
+
+/// pool of fixed size blocks allocated in slabs
+/*!
+ Each block is prefixed by a pointer to its slab, thus blocks can be
+ returned without knowing their pool. Slabs that become empty are returned
+ to the system (the last one is kept for reuse), so releasing a large
+ unit or a database snapshot frees its memory in bulk.
+*/
+
+class NLEAP_PACKAGE CSlabPool {
+public:
+    CSlabPool(size_t object_size);
+
+    //! allocate one block
+    void* Allocate(void);
+
+    //! return block to its pool
+    static void Deallocate(void* p_obj);
+
+    //! number of allocated slabs
+    size_t NumberOfSlabs(void) const;
+
+    //! number of blocks in use
+    size_t NumberOfBlocks(void) const;
+
+    //! size of slab in bytes
+    size_t SlabSize(void) const;
+
+    //! size of block in bytes including its header
+    size_t BlockSize(void) const;
+
+    //! number of blocks allocated since the pool was created
+    size_t NumberOfAllocations(void) const;
+
+    //! bytes of blocks allocated by all pools since start, it never decreases
+    static size_t TotalAllocatedBytes(void);
+
+// section of private data -----------------------------------------------------
+private:
+    struct SSlab {
+        CSlabPool*  Pool;
+        SSlab*      Prev;       // list of slabs with free blocks
+        SSlab*      Next;
+        void*       FreeList;   // returned blocks
+        char*       Top;        // never used blocks
+        char*       End;
+        size_t      Used;       // blocks in use
+    };
+
+    size_t          m_block_size;
+    size_t          m_blocks_per_slab;
+    SSlab*          m_partial;  // slabs with free blocks
+    size_t          m_slabs;
+    size_t          m_blocks;
+    size_t          m_allocations;
+    CSimpleMutex    m_lock;
+    CSlabPool*      m_next_pool;    // list of all pools
+
+    static CSlabPool*   m_pools;
+    static CSimpleMutex& GetPoolsLock(void);
+
+    void Release(void* p_block, SSlab* p_slab);
+    void LinkPartial(SSlab* p_slab);
+    void UnlinkPartial(SSlab* p_slab);
+};
+
+//------------------------------------------------------------------------------
+
+/// standard allocator placing single objects into a slab pool per type
+/*!
+ Intended for allocate_shared, which rebinds the allocator to the type
+ holding both the object and its shared_ptr control block.
+*/
+
+template <class T>
+class CSlabAllocator {
+public:
+    typedef T               value_type;
+    typedef T*              pointer;
+    typedef const T*        const_pointer;
+    typedef T&              reference;
+    typedef const T&        const_reference;
+    typedef size_t          size_type;
+    typedef ptrdiff_t       difference_type;
+
+    template <class U>
+    struct rebind {
+        typedef CSlabAllocator<U> other;
+    };
+
+    CSlabAllocator(void) {}
+
+    template <class U>
+    CSlabAllocator(const CSlabAllocator<U>&) {}
+
+    pointer allocate(size_type n, const void* = 0)
+    {
+        if( n == 1 ) return( static_cast<pointer>(GetPool().Allocate()) );
+        return( static_cast<pointer>(::operator new(n*sizeof(T))) );
+    }
+
+    void deallocate(pointer p, size_type n)
+    {
+        if( n == 1 ){
+            CSlabPool::Deallocate(p);
+        } else {
+            ::operator delete(p);
+        }
+    }
+
+    void construct(pointer p, const T& value) { new(p) T(value); }
+    void destroy(pointer p) { p->~T(); }
+
+    pointer address(reference x) const { return(&x); }
+    const_pointer address(const_reference x) const { return(&x); }
+    size_type max_size(void) const { return(size_t(-1) / sizeof(T)); }
+
+    //! pool of the type, it is never destroyed as objects can outlive statics
+    static CSlabPool& GetPool(void)
+    {
+        static CSlabPool* p_pool = new CSlabPool(sizeof(T));
+        return(*p_pool);
+    }
+};
+
+//------------------------------------------------------------------------------
+
+template <class T, class U>
+inline bool operator == (const CSlabAllocator<T>&, const CSlabAllocator<U>&)
+{
+    return(true);
+}
+
+template <class T, class U>
+inline bool operator != (const CSlabAllocator<T>&, const CSlabAllocator<U>&)
+{
+    return(false);
+}
+
+//------------------------------------------------------------------------------
+}
+
+#endif
@@ -0,0 +1,202 @@
+// =============================================================================
+// nLEaP - A molecular manipulation program and coding environment
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2011 Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2006 gLEaP authors, see AUTHORS file in the main directory
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <engine/CommandHistory.hpp>
+#include <core/Entity.hpp>
+#include <stdexcept>
+
+// default number of commands kept in memory
+#define DEFAULT_CAPACITY 1000
+
+namespace nleap {
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CCommandHistory::CCommandHistory(void)
+{
+    m_capacity = DEFAULT_CAPACITY;
+    m_first = 0;
+    m_total = 0;
+    m_spilled = 0;
+}
+
+// -------------------------------------------------------------------------
+
+CCommandHistory::~CCommandHistory(void)
+{
+    if( m_spill.is_open() ) m_spill.close();
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CCommandHistory::SetCapacity(size_t capacity)
+{
+    // reorder commands from the oldest one, drop those that do not fit
+    vector<string> commands;
+    size_t nkeep = m_buffer.size() < capacity ? m_buffer.size() : capacity;
+    size_t ndrop = m_buffer.size() - nkeep;
+    commands.reserve(nkeep);
+    for(size_t i=0; i < m_buffer.size(); i++){
+        if( i < ndrop ){
+            Drop( Get(i) );
+        } else {
+            commands.push_back( Get(i) );
+        }
+    }
+
+    m_buffer.swap(commands);
+    m_first = 0;
+    m_capacity = capacity;
+}
+
+// -------------------------------------------------------------------------
+
+size_t CCommandHistory::GetCapacity(void) const
+{
+    return(m_capacity);
+}
+
+// -------------------------------------------------------------------------
+
+void CCommandHistory::SetSpillFile(const string& name)
+{
+    if( m_spill.is_open() ) m_spill.close();
+    m_spill.clear();
+    m_spill_name = name;
+    m_spilled = 0;
+
+    if( name.empty() ) return;
+
+    m_spill.open(name.c_str(), ios_base::out | ios_base::trunc);
+    if( ! m_spill ){
+        m_spill_name.clear();
+        throw runtime_error("unable to open history spill file '" + name + "'");
+    }
+}
+
+// -------------------------------------------------------------------------
+
+const string& CCommandHistory::GetSpillFile(void) const
+{
+    return(m_spill_name);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CCommandHistory::Add(const string& command)
+{
+    m_total++;
+
+    if( m_capacity == 0 ){
+        Drop(command);
+        return;
+    }
+
+    if( m_buffer.size() < m_capacity ){
+        m_buffer.push_back(command);
+        return;
+    }
+
+    // buffer is full - replace the oldest command
+    Drop(m_buffer[m_first]);
+    m_buffer[m_first] = command;
+    m_first = (m_first + 1) % m_buffer.size();
+}
+
+// -------------------------------------------------------------------------
+
+void CCommandHistory::Clear(void)
+{
+    m_buffer.clear();
+    m_first = 0;
+}
+
+// -------------------------------------------------------------------------
+
+void CCommandHistory::Drop(const string& command)
+{
+    if( ! m_spill.is_open() ) return;
+    m_spill << command << endl;
+    m_spilled++;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+size_t CCommandHistory::Size(void) const
+{
+    return(m_buffer.size());
+}
+
+// -------------------------------------------------------------------------
+
+size_t CCommandHistory::GetMemorySize(void) const
+{
+    size_t size = sizeof(CCommandHistory) + m_buffer.capacity()*sizeof(string);
+    for(size_t i=0; i < m_buffer.size(); i++){
+        size += CEntity::GetStringSize(m_buffer[i]);
+    }
+    return(size);
+}
+
+// -------------------------------------------------------------------------
+
+size_t CCommandHistory::NumberOfCommands(void) const
+{
+    return(m_total);
+}
+
+// -------------------------------------------------------------------------
+
+const string& CCommandHistory::Get(size_t index) const
+{
+    return( m_buffer[(m_first + index) % m_buffer.size()] );
+}
+
+// -------------------------------------------------------------------------
+
+void CCommandHistory::Print(ostream& ofs)
+{
+    // spilled commands first
+    if( m_spilled > 0 ){
+        m_spill.flush();
+        ifstream ifs(m_spill_name.c_str());
+        string   line;
+        while( getline(ifs,line) ){
+            ofs << line << endl;
+        }
+    }
+
+    for(size_t i=0; i < m_buffer.size(); i++){
+        ofs << Get(i) << endl;
+    }
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+}
@@ -0,0 +1,97 @@
+#ifndef NLEAP_ENGINE_COMMAND_HISTORY_H
+#define NLEAP_ENGINE_COMMAND_HISTORY_H
+// =============================================================================
+// nLEaP - A molecular manipulation program and coding environment
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2011 Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2006 gLEaP authors, see AUTHORS file in the main directory
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <NLEaPMainHeader.hpp>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <ostream>
+
+namespace nleap {
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+
+//! \brief history of executed commands
+//! the latest commands are kept in a bounded ring buffer, older commands are
+//! either dropped or appended to the spill file
+class NLEAP_PACKAGE CCommandHistory {
+public:
+    CCommandHistory(void);
+    ~CCommandHistory(void);
+
+    //! set maximum number of commands kept in memory
+    void SetCapacity(size_t capacity);
+
+    //! get maximum number of commands kept in memory
+    size_t GetCapacity(void) const;
+
+    //! spill commands dropped from memory to file, empty name disables spilling
+    void SetSpillFile(const string& name);
+
+    //! get name of spill file
+    const string& GetSpillFile(void) const;
+
+    //! append command
+    void Add(const string& command);
+
+    //! remove all commands kept in memory
+    void Clear(void);
+
+    //! number of commands kept in memory
+    size_t Size(void) const;
+
+    //! number of all recorded commands
+    size_t NumberOfCommands(void) const;
+
+    //! get command kept in memory, index 0 is the oldest one
+    const string& Get(size_t index) const;
+
+    //! print spilled commands followed by commands kept in memory
+    void Print(ostream& ofs);
+
+    //! approximate memory of commands kept in memory
+    size_t GetMemorySize(void) const;
+
+// private data and methods ----------------------------------------------------
+private:
+    vector<string>  m_buffer;       // ring buffer
+    size_t          m_capacity;
+    size_t          m_first;        // the oldest command in the buffer
+    size_t          m_total;        // all recorded commands
+    size_t          m_spilled;      // commands written to the spill file
+    string          m_spill_name;
+    ofstream        m_spill;
+
+    //! command is leaving the buffer
+    void Drop(const string& command);
+};
+
+//------------------------------------------------------------------------------
+}
+
+#endif
@@ -26,7 +26,7 @@
 #include <engine/Command.hpp>
 #include <stdexcept>
 #include <boost/algorithm/string.hpp>
-#include <fstream>
+#include <format/FileStream.hpp>
 #include <FileName.hpp>
 #include <types/Factory.hpp>
 #include <SmallTimeAndDate.hpp>
@@ -51,6 +51,9 @@ CContext::CContext()
 
     m_undo_level = 0;
     m_trans_level = 0;
+    m_trans_rollback = false;
+    m_snapshots = true;
+    m_profiler.SetIndexCounter(&m_index_counter);
 
     // create nodes
     int top_id = m_index_counter.GetTopIndex();
@@ -90,6 +93,8 @@ void CContext::InitDefault(void)
     Set(ECHO,"off");
     SetVerbosity(1);
     Set(MAXHIST,5);
+    m_history.SetCapacity(1000);
+    m_history.SetSpillFile("");
 
     // add paths
     CFileName prefix_path( GetPrefix().c_str() );
@@ -231,6 +236,20 @@ CEntityPtr CContext::tmp(void)
 
 // -------------------------------------------------------------------------
 
+CCommandHistory& CContext::history(void)
+{
+    return( m_history );
+}
+
+// -------------------------------------------------------------------------
+
+CProfiler& CContext::profiler(void)
+{
+    return( m_profiler );
+}
+
+// -------------------------------------------------------------------------
+
 string CContext::GetPrefix(void)
 {
     return(PREFIX);
@@ -240,9 +259,7 @@ string CContext::GetPrefix(void)
 
 bool CContext::Process(const string& line)
 {
-    out() << high;
-    out() << "[nleap]$ " << line << endl;
-    out() << low;
+    PrintPrompt(line);
 
     if( line.empty() ) {
         return true;
@@ -287,6 +304,15 @@ bool CContext::Process(const string& line)
 
 // -------------------------------------------------------------------------
 
+void CContext::PrintPrompt(const string& line)
+{
+    out() << high;
+    out() << "[nleap]$ " << line << endl;
+    out() << low;
+}
+
+// -------------------------------------------------------------------------
+
 void CContext::StartTransaction(void)
 {
     if( m_trans_level > 0 ) {
@@ -295,6 +321,13 @@ void CContext::StartTransaction(void)
         return;
     }
 
+    if( ! m_snapshots ){
+        // changes are done directly in the current database
+        m_trans_rollback = false;
+        m_trans_level = 1;
+        return;
+    }
+
     // remove redo records
     CEntityPtr dbs = FindChild( "dbhistory" );
     if( m_undo_level > 0 ) {
@@ -309,7 +342,8 @@ void CContext::StartTransaction(void)
         // clone the last database
         last_child = dbs->GetChild( dbs->NumberOfChildren() - 1);
         int top_id = m_index_counter.GetTopIndex();
-        last_child = last_child->Clone( top_id, top_id );
+        // the previous database becomes history, its caches are moved to the new one
+        last_child = last_child->Clone( top_id, top_id, true );
         m_index_counter.SetTopIndex( top_id );
     } else {
         // no top database create new one
@@ -365,7 +399,7 @@ void CContext::RollbackTransaction(void)
     // rollback transaction - remove last database
     CEntityPtr dbs = FindChild( "dbhistory" );
 
-    if( dbs->NumberOfChildren() > 0 ) {
+    if( m_snapshots && (dbs->NumberOfChildren() > 0) ) {
         dbs->RemoveLastChild( );
     }
 
@@ -376,14 +410,62 @@ void CContext::RollbackTransaction(void)
 
 // -------------------------------------------------------------------------
 
+void CContext::EnableSnapshots(bool set)
+{
+    m_snapshots = set;
+}
+
+// -------------------------------------------------------------------------
+
+void CContext::InitWorker(CContext* p_ctx, bool copy_database)
+{
+    if( p_ctx == NULL ){
+        throw runtime_error( "parent context is NULL in CContext::InitWorker" );
+    }
+
+    // context setup
+    Set(PATH, p_ctx->Get<string>(PATH));
+    Set(ECHO, p_ctx->Get<string>(ECHO));
+    SetVerbosity(p_ctx->Get<int>(VERBOSITY));
+
+    // private copy of the current parent database or an empty one
+    CEntityPtr dbs = FindChild( "dbhistory" );
+    dbs->RemoveAllChildren();
+
+    int top_id = m_index_counter.GetTopIndex();
+    CEntityPtr db;
+    if( copy_database ){
+        db = p_ctx->database()->Clone( top_id, top_id );
+    } else {
+        db = CFactory::CreateDatabase( top_id );
+    }
+    m_index_counter.SetTopIndex( top_id );
+    if( ! db ) {
+        throw runtime_error( "internal error CContext::InitWorker");
+    }
+    dbs->AddChild(db);
+    m_undo_level = 0;
+
+    // workers do not need undo
+    EnableSnapshots(false);
+}
+
+// -------------------------------------------------------------------------
+
 bool CContext::Run(const string& command)
 {
     CParser parser;
+    int     prof = m_profiler.BeginCommand(command);
 
     try {
+        m_profiler.BeginPhase(prof,CProfiler::phase_parse);
         parser.Parse(command);
+        m_profiler.EndPhase(prof,CProfiler::phase_parse);
 
-        if( parser.GetCmd().empty() ) return true; // empty line or comment
+        if( parser.GetCmd().empty() ){
+            m_profiler.DiscardCommand(prof);
+            return true; // empty line or comment
+        }
 
         // echo
         if( Get<string>(ECHO) == "on" ) {
@@ -404,33 +486,27 @@ bool CContext::Run(const string& command)
         }
 
         if( pcmd->IsChangingState() ) {
+            m_profiler.BeginPhase(prof,CProfiler::phase_snapshot);
             StartTransaction();
+            m_profiler.EndPhase(prof,CProfiler::phase_snapshot);
         }
 
         try {
             // clonning must be after StartTransaction since it already manipulate with the database
+            m_profiler.BeginPhase(prof,CProfiler::phase_expand);
             CCommandPtr comm = pcmd->Clone(this, parser);
             if( ! comm ) {
                 throw runtime_error( "command not cloned - internal error");
             }
-
-            // record command to command history list
-            if( m_trans_level <= 1 ) {
-                // do not record context changing commands
-                if( strcmp(pcmd->Info(CCommand::help_group),"context") != 0 ) {
-                    // well, this part should not fail
-                    CEntityPtr list = database()->FindChild("_histcmds");
-                    if( ! list ) {
-                        throw runtime_error("list is NULL, internal error in CContext::run");
-                    }
-                    int index = m_index_counter.GetIndex();
-                    CEntityPtr hist = CFactory::CreateString(index, command);
-                    list->AddChild(hist);
-                }
-            }
+            m_profiler.EndPhase(prof,CProfiler::phase_expand);
 
             m_out << low;   // set default low verbosity output
+            m_profiler.BeginPhase(prof,CProfiler::phase_exec);
             comm->Exec(this);
+            m_profiler.EndPhase(prof,CProfiler::phase_exec);
+
+            // record successful command to command history list
+            RecordHistory(command,pcmd,m_trans_level);
         } catch( std::exception& e ) {
             if( pcmd->IsChangingState() ) {
                 RollbackTransaction();
@@ -442,15 +518,51 @@ bool CContext::Run(const string& command)
             CommitTransaction();
         }
     } catch( std::exception& e ) {
+        m_profiler.EndCommand(prof,false);
         out() << "<b><red>Error:</red></b> " <<  e.what() << endl;
         return false;
     }
 
+    m_profiler.EndCommand(prof,true);
     return true;
 }
 
 // -------------------------------------------------------------------------
 
+void CContext::RecordHistory(const string& command, const CCommand* p_cmd, int level)
+{
+    // nested commands are part of the command, which started the transaction
+    if( level > 1 ) return;
+
+    // do not record context changing commands
+    if( strcmp(p_cmd->Info(CCommand::help_group),"context") == 0 ) return;
+
+    m_history.Add(command);
+}
+
+// -------------------------------------------------------------------------
+
+void CContext::RecordWorkerCommand(const string& command, CContext* p_worker)
+{
+    if( p_worker == NULL ){
+        throw runtime_error( "worker context is NULL in CContext::RecordWorkerCommand" );
+    }
+
+    CParser parser;
+    parser.Parse(command);
+    CCommand* pcmd = CCommand::Find( parser.GetCmd() );
+    if( pcmd == NULL ) return;
+
+    // the command was run as if it was nested in this context
+    int level = m_trans_level;
+    if( pcmd->IsChangingState() ) level++;
+    RecordHistory(command,pcmd,level);
+
+    m_profiler.AppendRecords(p_worker->profiler());
+}
+
+// -------------------------------------------------------------------------
+
 void CContext::AddPath(const string& path)
 {
     // remove path
@@ -498,11 +610,29 @@ void CContext::RemovePath(const string& path)
 
 // -------------------------------------------------------------------------
 
+/// file itself or its compressed variant
+static bool FindExistingFile(const string& name, string& found)
+{
+    if( CInputFile::Exists(name) ) {
+        found = name;
+        return true;
+    }
+    for( int i=0; CompressedSuffixes[i] != NULL; ++i ) {
+        if( CInputFile::Exists(name + CompressedSuffixes[i]) ) {
+            found = name + CompressedSuffixes[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+// -------------------------------------------------------------------------
+
 string CContext::FindFile(const string& name)
 {
-    std::ifstream is( name.c_str() );
-    if( is ) {
-        return name;
+    string found;
+    if( FindExistingFile(name,found) ) {
+        return found;
     }
 
     // does it contain slash?
@@ -523,10 +653,8 @@ string CContext::FindFile(const string& name)
     for( size_t i=0; i < dirs.size(); ++i ) {
         CFileName full_name = CFileName(dirs[i].c_str()) / CFileName(name.c_str());
 
-        std::ifstream is( full_name );
-
-        if(is) {
-            return (const char*)full_name;
+        if( FindExistingFile((const char*)full_name,found) ) {
+            return found;
         }
     }
     throw std::runtime_error( "cannot find file " + name + " in nLEaP PATH" );
@@ -577,6 +705,18 @@ void CContext::Desc(ostream& ofs)
         ofs << "     Undo level           : " << 0 << endl;
     }
 
+    ofs << endl;
+    ofs << "   # Command history" << endl;
+    ofs << "   # ----------------------------------------------" << endl;
+    ofs << "     Max history size     : " << m_history.GetCapacity() << endl;
+    ofs << "     Commands in memory   : " << m_history.Size() << endl;
+    ofs << "     Recorded commands    : " << m_history.NumberOfCommands() << endl;
+    if( ! m_history.GetSpillFile().empty() ) {
+        ofs << "     Spill file           : " << m_history.GetSpillFile() << endl;
+    } else {
+        ofs << "     Spill file           : none" << endl;
+    }
+
     ofs << endl;
     PrintPaths( ofs );
 
@@ -618,6 +758,24 @@ void CContext::Redo(int level)
     if( m_undo_level > (int)dbs->NumberOfChildren() - 1 ) m_undo_level = dbs->NumberOfChildren() - 1;
 }
 
+//------------------------------------------------------------------------------
+
+int CContext::GetUndoLevel(void) const
+{
+    return(m_undo_level);
+}
+
+//------------------------------------------------------------------------------
+
+size_t CContext::GetObjectSize(void) const
+{
+    size_t size = CEntity::GetObjectSize() + sizeof(CContext) - sizeof(CEntity);
+    // history and profiler objects are already included in sizeof(CContext)
+    size += m_history.GetMemorySize() - sizeof(CCommandHistory);
+    size += m_profiler.GetMemorySize() - sizeof(CProfiler);
+    return(size);
+}
+
 //==============================================================================
 //------------------------------------------------------------------------------
 //==============================================================================
@@ -26,6 +26,8 @@
 #include <string>
 #include <boost/shared_ptr.hpp>
 #include <types/Database.hpp>
+#include <engine/CommandHistory.hpp>
+#include <engine/Profiler.hpp>
 #include <core/PredefinedKeys.hpp>
 #include <IndexCounter.hpp>
 #include <VerboseStr.hpp>
@@ -36,7 +38,7 @@ namespace nleap {
 // -----------------------------------------------------------------------------
 /*
 
-context (+ context setup)
+context (+ context setup, history of commands)
  |-> history (history of database changes)
        |-> database1
        |-> database2
@@ -48,6 +50,8 @@ context (+ context setup)
 using namespace std;
 using boost::shared_ptr;
 
+class CCommand;
+
 // -----------------------------------------------------------------------------
 
 /// \brief context of leap session
@@ -95,12 +99,21 @@ public:
     /// return tmp node
     CEntityPtr tmp(void);
 
+    /// return history of commands
+    CCommandHistory& history(void);
+
+    /// return command profiler
+    CProfiler& profiler(void);
+
     /// return nleap installation prefix
     static string GetPrefix(void);
 
     /// process line
     bool Process(const string& line);
 
+    /// echo processed line with prompt
+    void PrintPrompt(const string& line);
+
     /// start transaction
     void StartTransaction(void);
 
@@ -113,9 +126,19 @@ public:
     /// source commands from a stream in a single transaction
     bool Source(const istream& is);
 
+    /// enable or disable database snapshots taken by transactions
+    void EnableSnapshots(bool set);
+
+    /// setup worker context from the parent context, the worker shares no data with the parent
+    /// if copy_database is false, the worker starts with an empty database
+    void InitWorker(CContext* p_ctx, bool copy_database = true);
+
     /// run command in given context
     bool Run(const string& command);
 
+    /// record command successfully run by the worker context to history and profile
+    void RecordWorkerCommand(const string& command, CContext* p_worker);
+
     /// add path to PATH
     void AddPath(const string& path);
 
@@ -140,6 +163,12 @@ public:
     /// redo last action
     void Redo(int level);
 
+    /// current undo level, zero is the latest database snapshot
+    int GetUndoLevel(void) const;
+
+    /// memory of the context including command history and profiler records
+    virtual size_t GetObjectSize(void) const;
+
     /// add alias
     void AddAlias(const string& str, const string& cmd);
 
@@ -159,9 +188,15 @@ private:
     string          m_pending;
     CVerboseStr     m_out;
     CTerminalStr    m_log_stream;
+    CCommandHistory m_history;              // not part of database snapshots
+    CProfiler       m_profiler;
     int             m_undo_level;           // current undo level
     int             m_trans_level;
     bool            m_trans_rollback;
+    bool            m_snapshots;            // transactions clone the database
+
+    /// record command to history, nested and context changing commands are skipped
+    void RecordHistory(const string& command, const CCommand* p_cmd, int level);
 };
 
 // -----------------------------------------------------------------------------
@@ -0,0 +1,410 @@
+// =============================================================================
+// nLEaP - A molecular manipulation program and coding environment
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2011 Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2006 gLEaP authors, see AUTHORS file in the main directory
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <engine/Profiler.hpp>
+#include <core/SlabAllocator.hpp>
+#include <core/Entity.hpp>
+#include <IndexCounter.hpp>
+#include <algorithm>
+#include <iomanip>
+#include <time.h>
+#if defined _WIN32
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
+
+// maximum length of printed commands
+#define MAX_COMMAND_LENGTH  48
+
+namespace nleap {
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+double CProfiler::GetWallTime(void)
+{
+#if defined _WIN32
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return( (double)count.QuadPart / (double)freq.QuadPart );
+#else
+    struct timeval tv;
+    gettimeofday(&tv,NULL);
+    return( tv.tv_sec + 1.0e-6*tv.tv_usec );
+#endif
+}
+
+//------------------------------------------------------------------------------
+
+double CProfiler::GetCPUTime(void)
+{
+    return( (double)clock() / CLOCKS_PER_SEC );
+}
+
+//------------------------------------------------------------------------------
+
+/// command text suitable for JSON strings
+static string JSONEscape(const string& text)
+{
+    string escaped;
+    escaped.reserve(text.size());
+    for(size_t i=0; i < text.size(); i++){
+        char c = text[i];
+        if( (c == '"') || (c == '\\') ){
+            escaped += '\\';
+            escaped += c;
+        } else if( (unsigned char)c < 0x20 ){
+            escaped += ' ';
+        } else {
+            escaped += c;
+        }
+    }
+    return(escaped);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CProfiler::CProfiler(void)
+{
+    m_enabled = false;
+    m_counter = NULL;
+    m_depth = 0;
+    m_first_id = 0;
+    m_origin = 0.0;
+}
+
+//------------------------------------------------------------------------------
+
+void CProfiler::SetIndexCounter(CIndexCounter* p_counter)
+{
+    m_counter = p_counter;
+}
+
+//------------------------------------------------------------------------------
+
+void CProfiler::Enable(bool set)
+{
+    m_enabled = set;
+}
+
+//------------------------------------------------------------------------------
+
+bool CProfiler::IsEnabled(void) const
+{
+    return(m_enabled);
+}
+
+//------------------------------------------------------------------------------
+
+void CProfiler::Clear(void)
+{
+    // ids of removed records are not reused, thus running commands
+    // cannot update records started after the clear
+    m_first_id += m_records.size();
+    m_records.clear();
+}
+
+//------------------------------------------------------------------------------
+
+size_t CProfiler::NumberOfRecords(void) const
+{
+    return(m_records.size());
+}
+
+//------------------------------------------------------------------------------
+
+size_t CProfiler::GetMemorySize(void) const
+{
+    size_t size = sizeof(CProfiler) + m_records.capacity()*sizeof(SRecord);
+    for(size_t i=0; i < m_records.size(); i++){
+        size += CEntity::GetStringSize(m_records[i].Command);
+    }
+    return(size);
+}
+
+//------------------------------------------------------------------------------
+
+const char* CProfiler::GetPhaseName(EPhase phase)
+{
+    switch(phase){
+        case phase_parse:
+            return("parse");
+        case phase_snapshot:
+            return("snapshot");
+        case phase_expand:
+            return("expand");
+        case phase_exec:
+            return("exec");
+        default:
+            return("unknown");
+    }
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CProfiler::Sample(SSample& sample) const
+{
+    sample.Wall = GetWallTime();
+    sample.CPU = GetCPUTime();
+    sample.Entities = 0;
+    if( m_counter ) sample.Entities = m_counter->GetTopIndex();
+    sample.Bytes = CSlabPool::TotalAllocatedBytes();
+}
+
+//------------------------------------------------------------------------------
+
+int CProfiler::BeginCommand(const string& command)
+{
+    if( ! m_enabled ) return(-1);
+
+    SRecord rec;
+    rec.Command = command;
+    rec.Depth = m_depth;
+    rec.Status = false;
+    rec.Open = true;
+    for(int i=0; i < num_of_phases; i++){
+        rec.PhaseUsed[i] = false;
+    }
+    Sample(rec.Begin);
+    rec.End = rec.Begin;
+
+    if( m_records.empty() ) m_origin = rec.Begin.Wall;
+    m_records.push_back(rec);
+    m_depth++;
+
+    return(m_first_id + m_records.size() - 1);
+}
+
+//------------------------------------------------------------------------------
+
+CProfiler::SRecord* CProfiler::FindRecord(int record)
+{
+    if( record < m_first_id ) return(NULL); // records were cleared
+    if( record - m_first_id >= (int)m_records.size() ) return(NULL);
+    return( &m_records[record - m_first_id] );
+}
+
+//------------------------------------------------------------------------------
+
+void CProfiler::BeginPhase(int record, EPhase phase)
+{
+    SRecord* p_rec = FindRecord(record);
+    if( p_rec == NULL ) return;
+    Sample(p_rec->PhaseBegin[phase]);
+    p_rec->PhaseEnd[phase] = p_rec->PhaseBegin[phase];
+    p_rec->PhaseUsed[phase] = true;
+}
+
+//------------------------------------------------------------------------------
+
+void CProfiler::EndPhase(int record, EPhase phase)
+{
+    SRecord* p_rec = FindRecord(record);
+    if( p_rec == NULL ) return;
+    if( ! p_rec->PhaseUsed[phase] ) return;
+    Sample(p_rec->PhaseEnd[phase]);
+}
+
+//------------------------------------------------------------------------------
+
+void CProfiler::EndCommand(int record, bool status)
+{
+    if( record < 0 ) return;
+    if( m_depth > 0 ) m_depth--;
+    SRecord* p_rec = FindRecord(record);
+    if( p_rec == NULL ) return;
+    Sample(p_rec->End);
+    p_rec->Status = status;
+    p_rec->Open = false;
+}
+
+//------------------------------------------------------------------------------
+
+void CProfiler::DiscardCommand(int record)
+{
+    if( record < 0 ) return;
+    if( m_depth > 0 ) m_depth--;
+    if( FindRecord(record) == NULL ) return;
+    if( record - m_first_id + 1 != (int)m_records.size() ) return;
+    m_records.pop_back();
+}
+
+//------------------------------------------------------------------------------
+
+void CProfiler::AppendRecords(const CProfiler& other)
+{
+    if( ! m_enabled ) return;
+
+    for(size_t i=0; i < other.m_records.size(); i++){
+        const SRecord& rec = other.m_records[i];
+        if( rec.Open ) continue;
+        if( m_records.empty() ) m_origin = rec.Begin.Wall;
+        m_records.push_back(rec);
+        m_records.back().Depth += m_depth;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+int CProfiler::GetSnapshotSize(const SRecord& rec)
+{
+    // snapshot entities are created by cloning the database
+    if( ! rec.PhaseUsed[phase_snapshot] ) return(0);
+    return( rec.PhaseEnd[phase_snapshot].Entities - rec.PhaseBegin[phase_snapshot].Entities );
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+/// records ordered by decreasing wall time
+struct SProfilerCmp {
+    const vector<double>* Times;
+    bool operator () (size_t left, size_t right) const {
+        return( (*Times)[left] > (*Times)[right] );
+    }
+};
+
+//------------------------------------------------------------------------------
+
+void CProfiler::PrintTable(ostream& ofs, size_t top) const
+{
+    // select records
+    vector<size_t> order;
+    vector<double> times;
+    for(size_t i=0; i < m_records.size(); i++){
+        times.push_back(m_records[i].End.Wall - m_records[i].Begin.Wall);
+        // skip running commands, e.g. this profile command or its source
+        if( m_records[i].Open ) continue;
+        order.push_back(i);
+    }
+    if( (top > 0) && (top < order.size()) ){
+        SProfilerCmp cmp;
+        cmp.Times = &times;
+        stable_sort(order.begin(),order.end(),cmp);
+        order.resize(top);
+    }
+
+    ofs << "# Command profile (times in seconds, memory in kB)" << endl;
+    ofs << "#    No  Wall     CPU      Parse    Snapshot Expand   Exec     Entities Memory   SnapSize Command" << endl;
+    ofs << "# ------ -------- -------- -------- -------- -------- -------- -------- -------- -------- ------------------------------------------------" << endl;
+
+    double total_wall = 0.0;
+    double total_cpu = 0.0;
+
+    ofs << fixed;
+    for(size_t k=0; k < order.size(); k++){
+        const SRecord& rec = m_records[order[k]];
+
+        ofs << "  " << right << setw(6) << order[k] + 1;
+        ofs << " " << setw(8) << setprecision(3) << rec.End.Wall - rec.Begin.Wall;
+        ofs << " " << setw(8) << setprecision(3) << rec.End.CPU - rec.Begin.CPU;
+        for(int i=0; i < num_of_phases; i++){
+            if( rec.PhaseUsed[i] ){
+                ofs << " " << setw(8) << setprecision(3) << rec.PhaseEnd[i].Wall - rec.PhaseBegin[i].Wall;
+            } else {
+                ofs << " " << setw(8) << "-";
+            }
+        }
+        ofs << " " << setw(8) << rec.End.Entities - rec.Begin.Entities;
+        ofs << " " << setw(8) << (rec.End.Bytes - rec.Begin.Bytes) / 1024;
+        ofs << " " << setw(8) << GetSnapshotSize(rec);
+
+        string cmd = string(2*rec.Depth,' ') + rec.Command;
+        if( cmd.size() > MAX_COMMAND_LENGTH ) cmd = cmd.substr(0,MAX_COMMAND_LENGTH-3) + "...";
+        ofs << " " << left << cmd;
+        if( ! rec.Status ) ofs << " (failed)";
+        ofs << endl;
+
+        // nested commands are included in their parents
+        if( rec.Depth == 0 ){
+            total_wall += rec.End.Wall - rec.Begin.Wall;
+            total_cpu += rec.End.CPU - rec.Begin.CPU;
+        }
+    }
+
+    ofs << "# ------ -------- -------- " << endl;
+    ofs << "  " << right << setw(6) << "total";
+    ofs << " " << setw(8) << setprecision(3) << total_wall;
+    ofs << " " << setw(8) << setprecision(3) << total_cpu << endl;
+
+    ofs.unsetf(ios_base::floatfield);
+    ofs << left;
+}
+
+//------------------------------------------------------------------------------
+
+void CProfiler::WriteTrace(ostream& ofs) const
+{
+    ofs << "{\"traceEvents\":[" << endl;
+
+    bool first = true;
+    ofs << fixed << setprecision(3);
+    for(size_t k=0; k < m_records.size(); k++){
+        const SRecord& rec = m_records[k];
+        if( rec.Open ) continue;
+
+        if( ! first ) ofs << "," << endl;
+        first = false;
+
+        // command event
+        ofs << "{\"name\":\"" << JSONEscape(rec.Command) << "\",\"cat\":\"command\",\"ph\":\"X\"";
+        ofs << ",\"ts\":" << (rec.Begin.Wall - m_origin)*1.0e6;
+        ofs << ",\"dur\":" << (rec.End.Wall - rec.Begin.Wall)*1.0e6;
+        ofs << ",\"pid\":1,\"tid\":1,\"args\":{";
+        ofs << "\"cpu_ms\":" << (rec.End.CPU - rec.Begin.CPU)*1.0e3;
+        ofs << ",\"entities\":" << rec.End.Entities - rec.Begin.Entities;
+        ofs << ",\"bytes\":" << rec.End.Bytes - rec.Begin.Bytes;
+        ofs << ",\"snapshot_entities\":" << GetSnapshotSize(rec);
+        ofs << ",\"status\":" << (rec.Status ? "true" : "false");
+        ofs << "}}";
+
+        // phase events
+        for(int i=0; i < num_of_phases; i++){
+            if( ! rec.PhaseUsed[i] ) continue;
+            const SSample& beg = rec.PhaseBegin[i];
+            const SSample& end = rec.PhaseEnd[i];
+            ofs << "," << endl;
+            ofs << "{\"name\":\"" << GetPhaseName((EPhase)i) << "\",\"cat\":\"phase\",\"ph\":\"X\"";
+            ofs << ",\"ts\":" << (beg.Wall - m_origin)*1.0e6;
+            ofs << ",\"dur\":" << (end.Wall - beg.Wall)*1.0e6;
+            ofs << ",\"pid\":1,\"tid\":1,\"args\":{";
+            ofs << "\"cpu_ms\":" << (end.CPU - beg.CPU)*1.0e3;
+            ofs << ",\"entities\":" << end.Entities - beg.Entities;
+            ofs << ",\"bytes\":" << end.Bytes - beg.Bytes;
+            ofs << "}}";
+        }
+    }
+
+    ofs << endl << "],\"displayTimeUnit\":\"ms\"}" << endl;
+    ofs.unsetf(ios_base::floatfield);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+}
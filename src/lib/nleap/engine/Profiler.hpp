@@ -0,0 +1,150 @@
+#ifndef NLEAP_ENGINE_PROFILER_H
+#define NLEAP_ENGINE_PROFILER_H
+// =============================================================================
+// nLEaP - A molecular manipulation program and coding environment
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2011 Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2006 gLEaP authors, see AUTHORS file in the main directory
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <NLEaPMainHeader.hpp>
+#include <vector>
+#include <string>
+#include <ostream>
+
+class CIndexCounter;
+
+namespace nleap {
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+
+//! \brief per-command performance records
+//! each executed command is split into phases, wall and CPU time, number of
+//! created entities and bytes allocated for entities are recorded for each of them
+class NLEAP_PACKAGE CProfiler {
+public:
+    enum EPhase {
+        phase_parse,        // command line parsing
+        phase_snapshot,     // database snapshot for state changing commands
+        phase_expand,       // argument expansion (command cloning)
+        phase_exec,         // command execution
+        num_of_phases
+    };
+
+    CProfiler(void);
+
+    //! set counter of entity indexes used to count created entities
+    void SetIndexCounter(CIndexCounter* p_counter);
+
+    //! enable or disable recording
+    void Enable(bool set);
+
+    //! is recording enabled?
+    bool IsEnabled(void) const;
+
+    //! remove all records
+    void Clear(void);
+
+    //! number of records
+    size_t NumberOfRecords(void) const;
+
+    //! approximate memory of all records
+    size_t GetMemorySize(void) const;
+
+// recording -------------------------------------------------------------------
+    //! start command record, return its id or -1 if recording is disabled
+    int BeginCommand(const string& command);
+
+    //! start phase of command
+    void BeginPhase(int record, EPhase phase);
+
+    //! finish phase of command
+    void EndPhase(int record, EPhase phase);
+
+    //! finish command record
+    void EndCommand(int record, bool status);
+
+    //! remove the last command record, e.g. empty command
+    void DiscardCommand(int record);
+
+    //! append finished records of other profiler nested in the running command
+    void AppendRecords(const CProfiler& other);
+
+// output ----------------------------------------------------------------------
+    //! print per-command table, if top > 0 then print only top most expensive commands
+    void PrintTable(ostream& ofs, size_t top = 0) const;
+
+    //! write records as Chrome trace events (chrome://tracing, Perfetto)
+    void WriteTrace(ostream& ofs) const;
+
+    //! phase name
+    static const char* GetPhaseName(EPhase phase);
+
+// clocks ----------------------------------------------------------------------
+    //! wall clock time in seconds
+    static double GetWallTime(void);
+
+    //! CPU time of the process in seconds
+    static double GetCPUTime(void);
+
+// private data and methods ----------------------------------------------------
+private:
+    struct SSample {
+        double  Wall;
+        double  CPU;
+        int     Entities;
+        size_t  Bytes;
+    };
+
+    struct SRecord {
+        string  Command;
+        int     Depth;                  // nesting level (source)
+        bool    Status;
+        bool    Open;                   // command is still running
+        SSample Begin;
+        SSample End;
+        SSample PhaseBegin[num_of_phases];
+        SSample PhaseEnd[num_of_phases];
+        bool    PhaseUsed[num_of_phases];
+    };
+
+    bool                m_enabled;
+    CIndexCounter*      m_counter;
+    vector<SRecord>     m_records;
+    int                 m_first_id;     // id of the first record, ids survive Clear
+    int                 m_depth;
+    double              m_origin;       // wall time of the first record
+
+    //! record of given id or NULL if it was removed
+    SRecord* FindRecord(int record);
+
+    //! take sample of all counters
+    void Sample(SSample& sample) const;
+
+    //! number of entities in the database snapshot
+    static int GetSnapshotSize(const SRecord& rec);
+};
+
+//------------------------------------------------------------------------------
+}
+
+#endif
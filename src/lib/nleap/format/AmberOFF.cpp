@@ -34,9 +34,8 @@ namespace nleap {
 //==============================================================================
 
 CAmberOFF::CAmberOFF( CVerboseStr& debug )
-    : m_debug( debug )
+    : CCommonIO( debug )
 {
-    m_line_no = 0;
     m_unit_index = -1;
 }
 
@@ -53,15 +52,16 @@ void CAmberOFF::Read( istream& is, CDatabasePtr& db, int& top_id )
     m_index.clear();
     m_unit.reset();
 
+    string keyword;
+
     getline( is, m_line );
     while( is ){
         m_line_no++;
 
         // parse line
-        stringstream    str( m_line );
-        string          keyword;
-
-        str >> keyword;
+        ResetCursor();
+        keyword.clear();
+        m_cursor.NextField( keyword );
         if( keyword.size() == 0 ){
             // skip empty lines
             getline( is, m_line );
@@ -87,15 +87,15 @@ void CAmberOFF::Read( istream& is, CDatabasePtr& db, int& top_id )
 
         // check subkeys
         if( subkeys.size() != 4 ){
-            ReadError("keyword does not contain four subkeys.");
+            EmitRWError("keyword does not contain four subkeys.");
         }
 
         if( subkeys[0] != "!entry" ){
-            ReadError("first subkey is not <b>!entry</b>");
+            EmitRWError("first subkey is not <b>!entry</b>");
         }
 
         if( subkeys[2] != "unit" ){
-            ReadError("third subkey is not <b>unit</b>");
+            EmitRWError("third subkey is not <b>unit</b>");
         }
 
         // new unit?
@@ -105,7 +105,7 @@ void CAmberOFF::Read( istream& is, CDatabasePtr& db, int& top_id )
                 stringstream str;
                 str << "out-off number of predefined units, attempted to read " << m_unit_index+1;
                 str << " but " << m_index.size() << " defined";
-                ReadError( str.str() );
+                EmitRWError( str.str() );
             }
             if( m_unit ){
                 m_unit->FixCounters();
@@ -117,7 +117,7 @@ void CAmberOFF::Read( istream& is, CDatabasePtr& db, int& top_id )
         }
 
         if( ! m_unit ){
-            ReadError("unit is not valid object");
+            EmitRWError("unit is not valid object");
         }
 
         // read unit parts
@@ -177,6 +177,8 @@ void CAmberOFF::ReadAtoms( istream& is, int& top_id )
     int         nres = 0;
     int         prev_resid = 0;
     CResiduePtr res;
+    string      atname;
+    string      type;
 
     m_atom_map.clear();
 
@@ -193,18 +195,16 @@ void CAmberOFF::ReadAtoms( istream& is, int& top_id )
             return;
         }
 
-        //parse line
-        string      atname;
-        string      type;
-        int         typex = 0;
-        int         resix = 0;
-        int         flag = 0;
-        int         atid = 0;
-        int         atz = 0;
-        double      charge = 0;
-
-        stringstream str( m_line );
-        str >> atname >> type >> typex >> resix >> flag >> atid >> atz >> charge;
+        //parse line: name type typex resx flags seq elmnt chg
+        ResetCursor();
+        GetQuotedField( atname, "atom name" );
+        GetQuotedField( type, "atom type" );
+        m_cursor.SkipField();
+        int resix = GetInt( "residue index" );
+        m_cursor.SkipField();
+        m_cursor.SkipField();
+        m_cursor.SkipField();
+        double charge = GetDouble( "atom charge" );
 
         if( prev_resid < resix ){
             prev_resid = resix;
@@ -214,15 +214,15 @@ void CAmberOFF::ReadAtoms( istream& is, int& top_id )
         }
 
         if( ! res ) {
-            throw runtime_error("errr");
+            EmitRWError( "Atom does not belong to any residue." );
         }
 
         // create atom within residue
-        CAtomPtr atm = res->CreateAtom( get_str(atname), top_id );
+        CAtomPtr atm = res->CreateAtom( atname, top_id );
         m_atom_map.push_back(atm);
 
         // populate atom with data
-        atm->Set(TYPE, get_str(type) );
+        atm->Set(TYPE, type );
         atm->Set(CHARGE, charge);
 
         natoms++;
@@ -277,15 +277,13 @@ void CAmberOFF::ReadPositions( istream& is, int& top_id )
         }
 
         //parse line
-        double      x = 0;
-        double      y = 0;
-        double      z = 0;
-
-        stringstream str( m_line );
-        str >> x >> y >> z;
+        ResetCursor();
+        double x = GetDouble( "x coordinate" );
+        double y = GetDouble( "y coordinate" );
+        double z = GetDouble( "z coordinate" );
 
         if( natoms >= m_atom_map.size() ){
-            ReadError("too many atoms in positions");
+            EmitRWError("too many atoms in positions");
         }
 
         // get atoms
@@ -324,11 +322,11 @@ void CAmberOFF::ReadUnitName( istream& is, int& top_id )
         //parse line
         string name;
 
-        stringstream str( m_line );
-        str >> name;
+        ResetCursor();
+        GetQuotedField( name, "unit name" );
 
         // populate unit with data
-        m_unit->SetName( get_str(name) );
+        m_unit->SetName( name );
 
         getline( is, m_line );
     }
@@ -343,13 +341,16 @@ string CAmberOFF::get_str( const string& str )
 
 // -------------------------------------------------------------------------
 
-void CAmberOFF::ReadError( const string& reason )
+void CAmberOFF::GetQuotedField( string& value, const char* what )
 {
-    stringstream str;
-    str << reason << endl;
-    str << "       Line " << m_line_no << " : " << m_line;
-
-    throw runtime_error( str.str() );
+    const char* begin;
+    const char* end;
+    if( ! m_cursor.NextField( begin, end ) ){
+        EmitRWError( string("Missing ") + what + "." );
+    }
+    if( (begin < end) && (*begin == '"') ) begin++;
+    if( (begin < end) && (*(end-1) == '"') ) end--;
+    value.assign( begin, end );
 }
 
 //==============================================================================
@@ -25,6 +25,7 @@
 #include <iosfwd>
 #include <types/Database.hpp>
 #include <VerboseStr.hpp>
+#include <format/CommonIO.hpp>
 #include <vector>
 
 namespace nleap {
@@ -36,7 +37,7 @@ using namespace std;
 
 /// OFF (Object File Format) reader
 /// only limited functionality is provided
-class NLEAP_PACKAGE CAmberOFF {
+class NLEAP_PACKAGE CAmberOFF : public CCommonIO {
 public:
 
     CAmberOFF( CVerboseStr& debug );
@@ -46,10 +47,6 @@ public:
 
 // private section -------------------------------------------------------------
 private:
-    CVerboseStr&                m_debug;
-    int                         m_line_no;
-    string                      m_line;
-
     // units
     std::vector< string >       m_index;    // index of units
     int                         m_unit_index;
@@ -65,7 +62,8 @@ private:
     // remove quotation
     string get_str( const string& str );
 
-    void ReadError( const string& reason );
+    /// get next field without quotation or emit error
+    void GetQuotedField( string& value, const char* what );
 };
 
 //------------------------------------------------------------------------------
@@ -20,11 +20,15 @@
 // =============================================================================
 
 #include <format/AmberParams.hpp>
+#include <misc/UnitGraph.hpp>
 #include <vector>
 #include <sstream>
 #include <types/Factory.hpp>
 #include <boost/algorithm/string.hpp>
 #include <core/PredefinedKeys.hpp>
+#include <format/FixedFormat.hpp>
+#include <types/Unit.hpp>
+#include <boost/unordered_set.hpp>
 
 using namespace boost;
 
@@ -147,45 +151,35 @@ void CAmberParams::ReadTypes(istream& is, CAmberFFPtr& ff, int& top_id)
     m_debug << "> Reading types ..." << endl;
     CEntityPtr list = ff->FindChild( "types" );
 
+    string tn1;
+    string title;
+
     while( is && (! empty(m_line)) ) {
 
         // skip comments ---------------------
         if( m_line[0]=='#' ) {
+            getline( is, m_line );
+            m_line_no++;
             continue;
         }
 
-        // split line ------------------------
-        vector<string>  ts;
-        string          line = trim_left_copy(m_line); // it has to be here, split does not remove trailing space
-        if( empty(line) ) break;
+        ResetCursor();
+        if( ! m_cursor.HasField() ) break;
 
-        split( ts, line, is_any_of(" \t"), token_compress_on );
+        const char* expected = "Atom type and its mass expected.";
 
-        if( ts.size() < 2 ){
-            EmitRWError( "Atom type and its mass expected." );
-        }
+        // read data -------------------------
+        GetType( tn1, 0, true, expected );
+        double mass = GetNumber( 1, expected );
+        double polar = 0.0;
+        m_cursor.NextDouble( polar );   // optional
+        m_cursor.GetRest( title );
 
         // create type -----------------------
         CEntityPtr obj = CFactory::CreateNode( top_id );
         list->AddChild(obj);
         top_id++;
 
-        // read data -------------------------
-        CheckItemAsType(0, ts);
-        string tn1 = ts[0];
-
-        CheckItemAsNumber(1, ts);
-        double mass = CFactory::GetNumber( ts[1] );
-        double polar = 0.0;
-
-        string title;
-        if( (ts.size() > 2) && CFactory::IsNumber(ts[2]) ) {
-            polar = CFactory::GetNumber( ts[2] );
-            title = GetComment(3, ts);
-        } else {
-            title = GetComment(2, ts);
-        }
-
         obj->SetName( tn1 );
         obj->Set( MASS, mass );
         obj->Set( POLAR, polar );
@@ -212,42 +206,35 @@ void CAmberParams::ReadBonds(istream& is, CAmberFFPtr& ff, int& top_id)
     m_debug << "> Reading bonds ..." << endl;
     CEntityPtr list = ff->FindChild( "bonds" );
 
+    string tn1, tn2;
+    string title;
+
     while( is && (! empty(m_line)) ) {
 
         // skip comments ---------------------
         if( m_line[0]=='#' ) {
+            getline( is, m_line );
+            m_line_no++;
             continue;
         }
 
-        // split line ------------------------
-        vector<string>  ts;
-        string          line = trim_left_copy(m_line); // it has to be here, split does not remove trailing space
-        if( empty(line) ) break;
+        ResetCursor();
+        if( ! m_cursor.HasField() ) break;
 
-        SplitTypes( line, 2);
-        split( ts, line, is_any_of(" \t"), token_compress_on );
+        const char* expected = "Two atom types, force constant, and equilibrium distance are expected.";
 
-        if( ts.size() < 4 ){
-            EmitRWError( "Two atom types, force constant, and equilibrium distance are expected." );
-        }
+        // read data -------------------------
+        GetType( tn1, 0, false, expected );
+        GetType( tn2, 1, true, expected );
+        double force = GetNumber( 2, expected );
+        double equil = GetNumber( 3, expected );
+        m_cursor.GetRest( title );
 
         // create bond -----------------------
         CEntityPtr obj = CFactory::CreateNode( top_id );
         list->AddChild(obj);
         top_id++;
 
-        // read data -------------------------
-        CheckItemAsType(0, ts);
-        CheckItemAsType(1, ts);
-        CheckItemAsNumber(2, ts);
-        CheckItemAsNumber(3, ts);
-
-        string tn1 = ts[0];
-        string tn2 = ts[1];
-        double force = CFactory::GetNumber( ts[2] );
-        double equil = CFactory::GetNumber( ts[3] );
-        string title = GetComment(4, ts);
-
         obj->Set( ATOM1, tn1 );
         obj->Set( ATOM2, tn2 );
         obj->Set( FORCE, force );
@@ -267,44 +254,36 @@ void CAmberParams::ReadAngles(istream& is, CAmberFFPtr& ff, int& top_id)
     m_debug << "> Reading angles ..." << endl;
     CEntityPtr list = ff->FindChild( "angles" );
 
+    string tn1, tn2, tn3;
+    string title;
+
     while( is && (! empty(m_line)) ) {
 
         // skip comments ---------------------
         if( m_line[0]=='#' ) {
+            getline( is, m_line );
+            m_line_no++;
             continue;
         }
 
-        // split line ------------------------
-        vector<string>  ts;
-        string          line = trim_left_copy(m_line); // it has to be here, split does not remove trailing space
-        if( empty(line) ) break;
+        ResetCursor();
+        if( ! m_cursor.HasField() ) break;
 
-        SplitTypes( line, 3);
-        split( ts, line, is_any_of(" \t"), token_compress_on );
+        const char* expected = "Three atom types, force constant, and equilibrium angle are expected.";
 
-        if( ts.size() < 5 ){
-            EmitRWError( "Three atom types, force constant, and equilibrium angle are expected." );
-        }
+        // read data -------------------------
+        GetType( tn1, 0, false, expected );
+        GetType( tn2, 1, false, expected );
+        GetType( tn3, 2, true, expected );
+        double force = GetNumber( 3, expected );
+        double equil = GetNumber( 4, expected );
+        m_cursor.GetRest( title );
 
         // create angle -----------------------
         CEntityPtr angle = CFactory::CreateNode( top_id );
         list->AddChild(angle);
         top_id++;
 
-        // read data -------------------------
-        CheckItemAsType(0, ts);
-        CheckItemAsType(1, ts);
-        CheckItemAsType(2, ts);
-        CheckItemAsNumber(3, ts);
-        CheckItemAsNumber(4, ts);
-
-        string tn1 = ts[0];
-        string tn2 = ts[1];
-        string tn3 = ts[2];
-        double force = CFactory::GetNumber( ts[3] );
-        double equil = CFactory::GetNumber( ts[4] );
-        string title = GetComment(5, ts);
-
         angle->Set( ATOM1, tn1 );
         angle->Set( ATOM2, tn2 );
         angle->Set( ATOM3, tn3 );
@@ -325,72 +304,62 @@ void CAmberParams::ReadTorsions(istream& is, CAmberFFPtr& ff, int& top_id)
     m_debug << "> Reading torsions ..." << endl;
     CEntityPtr list = ff->FindChild( "torsions" );
 
+    string tn1, tn2, tn3, tn4;
+    string title;
+
     while( is && (! empty(m_line)) ) {
 
         // skip comments ---------------------
         if( m_line[0]=='#' ) {
+            getline( is, m_line );
+            m_line_no++;
             continue;
         }
 
-        // split line ------------------------
-        vector<string>  ts;
-        string          line = trim_left_copy(m_line); // it has to be here, split does not remove trailing space
-        if( empty(line) ) break;
-
-        SplitTypes( line, 4);
-        split( ts, line, is_any_of(" \t"), token_compress_on );
-
-        if( ts.size() < 7 ){
-            EmitRWError( "Four atom types and dihedral angle specification (3 items at least) are expected." );
-        }
+        ResetCursor();
+        if( ! m_cursor.HasField() ) break;
 
-        // create bond -----------------------
-        CEntityPtr obj = CFactory::CreateNode( top_id );
-        list->AddChild(obj);
-        top_id++;
+        const char* expected = "Four atom types and dihedral angle specification (3 items at least) are expected.";
 
         // read data -------------------------
-        CheckItemAsType(0, ts);
-        CheckItemAsType(1, ts);
-        CheckItemAsType(2, ts);
-        CheckItemAsType(3, ts);
-
-        string tn1 = ts[0];
-        string tn2 = ts[1];
-        string tn3 = ts[2];
-        string tn4 = ts[3];
+        GetType( tn1, 0, false, expected );
+        GetType( tn2, 1, false, expected );
+        GetType( tn3, 2, false, expected );
+        GetType( tn4, 3, true, expected );
 
         double divide;
         double force;
         double equil;
         double period;
-        string title;
-
-        if( (ts.size() >= 8) && CFactory::IsNumber(ts[7]) ) {
-            CheckItemAsNumber(4, ts);
-            CheckItemAsNumber(5, ts);
-            CheckItemAsNumber(6, ts);
-            CheckItemAsNumber(7, ts);
-            divide = CFactory::GetNumber( ts[4] );
-            force  = CFactory::GetNumber( ts[5] );
-            equil  = CFactory::GetNumber( ts[6] );
-            period = CFactory::GetNumber( ts[7] );
-            title = GetComment(8, ts);
+
+        double p1 = GetNumber( 4, expected );
+        double p2 = GetNumber( 5, expected );
+        double p3 = GetNumber( 6, expected );
+
+        // the divider is optional, it is present if the eighth item is a number
+        double p4;
+        if( m_cursor.NextDouble( p4 ) ) {
+            divide = p1;
+            force  = p2;
+            equil  = p3;
+            period = p4;
         } else {
-            CheckItemAsNumber(4, ts);
-            CheckItemAsNumber(5, ts);
-            CheckItemAsNumber(6, ts);
             divide = 1.0;
-            force  = CFactory::GetNumber( ts[4] );
-            equil  = CFactory::GetNumber( ts[5] );
-            period = CFactory::GetNumber( ts[6] );
-            title = GetComment(7, ts);
+            force  = p1;
+            equil  = p2;
+            period = p3;
         }
+        m_cursor.GetRest( title );
 
         if( divide == 0.0 ) {
             divide = 1.0;
         }
 
+        // create torsion --------------------
+        CEntityPtr obj = CFactory::CreateNode( top_id );
+        list->AddChild(obj);
+        top_id++;
+
         obj->Set( ATOM1, tn1 );
         obj->Set( ATOM2, tn2 );
         obj->Set( ATOM3, tn3 );
@@ -415,56 +384,40 @@ void CAmberParams::ReadImpropers(istream& is, CAmberFFPtr& ff, int& top_id)
     m_debug << "> Reading impropers ..." << endl;
     CEntityPtr list = ff->FindChild( "impropers" );
 
+    string tn1, tn2, tn3, tn4;
+    string title;
+
     while( is && (! empty(m_line)) ) {
 
         // skip comments ---------------------
         if( m_line[0]=='#' ) {
+            getline( is, m_line );
+            m_line_no++;
             continue;
         }
 
-        // split line ------------------------
-        vector<string>  ts;
-        string          line = trim_left_copy(m_line); // it has to be here, split does not remove trailing space
-        if( empty(line) ) break;
+        ResetCursor();
+        if( ! m_cursor.HasField() ) break;
 
-        SplitTypes( line, 4);
-        split( ts, line, is_any_of(" \t"), token_compress_on );
-
-        if( ts.size() < 7 ){
-            EmitRWError( "Four atom types and dihedral angle specification (3 items at least) are expected." );
-        }
+        const char* expected = "Four atom types and dihedral angle specification (3 items at least) are expected.";
 
-        // create bond -----------------------
+        // read data -------------------------
+        GetType( tn1, 0, false, expected );
+        GetType( tn2, 1, false, expected );
+        GetType( tn3, 2, false, expected );
+        GetType( tn4, 3, true, expected );
+
+        double divide = 1.0;
+        double force  = GetNumber( 4, expected );
+        double equil  = GetNumber( 5, expected );
+        double period = GetNumber( 6, expected );
+        m_cursor.GetRest( title );
+
+        // create improper -------------------
         CEntityPtr obj = CFactory::CreateNode( top_id );
         list->AddChild(obj);
         top_id++;
 
-        // read data -------------------------
-        CheckItemAsType(0, ts);
-        CheckItemAsType(1, ts);
-        CheckItemAsType(2, ts);
-        CheckItemAsType(3, ts);
-
-        string tn1 = ts[0];
-        string tn2 = ts[1];
-        string tn3 = ts[2];
-        string tn4 = ts[3];
-
-        double divide;
-        double force;
-        double equil;
-        double period;
-        string title;
-
-        CheckItemAsNumber(4, ts);
-        CheckItemAsNumber(5, ts);
-        CheckItemAsNumber(6, ts);
-        divide = 1.0;
-        force  = CFactory::GetNumber( ts[4] );
-        equil  = CFactory::GetNumber( ts[5] );
-        period = CFactory::GetNumber( ts[6] );
-        title = GetComment(7, ts);
-
         obj->Set( ATOM1, tn1 );
         obj->Set( ATOM2, tn2 );
         obj->Set( ATOM3, tn3 );
@@ -500,21 +453,23 @@ void CAmberParams::ReadvdWMap(istream& is)
     //m_debug << "> Reading vdW map ..." << endl;
     m_vdwmap.clear();
 
+    string name, alias;
+
     while( is && (! empty(m_line)) ) {
 
         // skip comments ---------------------
         if( m_line[0]=='#' ) {
+            getline( is, m_line );
+            m_line_no++;
             continue;
         }
 
         // read aliases
-        istringstream ls( m_line );
-
-        string name, alias;
-        ls >> name;
-
-        while( ls >> alias ) {
-            m_vdwmap[ alias ] = name;
+        ResetCursor();
+        if( m_cursor.NextField( name ) ){
+            while( m_cursor.NextField( alias ) ) {
+                m_vdwmap[ alias ] = name;
+            }
         }
 
         getline( is, m_line );
@@ -539,36 +494,34 @@ void CAmberParams::ReadvdWParams(istream& is, CAmberFFPtr& ff)
 
     CEntityPtr list = ff->FindChild("types");
 
+    string tn1;
+    string title;
+
     while( is && (! empty(m_line)) ) {
 
         // skip comments ---------------------
         if( m_line[0]=='#' ) {
+            getline( is, m_line );
+            m_line_no++;
             continue;
         }
 
-        // split line ------------------------
-        vector<string>  ts;
-        string          line = trim_left_copy(m_line); // it has to be here, split does not remove trailing space
-        if( empty(line) ) break;
+        ResetCursor();
+        if( ! m_cursor.HasField() ) break;
 
-        split( ts, line, is_any_of(" \t"), token_compress_on );
-
-        if( ts.size() < 3 ){
-            EmitRWError( "Atom type, radius, and epsilon are expected." );
-        }
+        const char* expected = "Atom type, radius, and epsilon are expected.";
 
         // find type ------------------------
-        CheckItemAsType(0, ts);
-        string tn1 = ts[0];
+        GetType( tn1, 0, true, expected );
         CEntityPtr obj = list->FindChild(tn1);
         if( ! obj ){
             EmitRWError( " Atom type <b>" + tn1 + "</b> not previously defined." );
         }
 
         // read data -------------------------
-        double radius = CFactory::GetNumber( ts[1] );
-        double depth = CFactory::GetNumber( ts[2] );
-        string title = GetComment(3, ts);
+        double radius = GetNumber( 1, expected );
+        double depth = GetNumber( 2, expected );
+        m_cursor.GetRest( title );
 
         obj->Set( RSTAR, radius );
         obj->Set( DEPTH, depth );
@@ -614,7 +567,7 @@ void CAmberParams::Write(ostream& os, CAmberFFPtr& ff)
 {
     if( ! ff ){
         // invalid ff
-        throw runtime_error( "ff is NULL in CAmberParams::Read" );
+        throw runtime_error( "ff is NULL in CAmberParams::Write" );
     }
 
     m_debug << high;
@@ -629,240 +582,340 @@ void CAmberParams::Write(ostream& os, CAmberFFPtr& ff)
         throw runtime_error("unable to write title");
     }
 
-    // write individual sections
-
+    // the whole set is written in the original order, later records
+    // override earlier ones and torsion terms must stay together
+    vector<CEntityPtr> types, bonds, angles, torsions, impropers;
+    GetRecords( ff, "types", types );
+    GetRecords( ff, "bonds", bonds );
+    GetRecords( ff, "angles", angles );
+    GetRecords( ff, "torsions", torsions );
+    GetRecords( ff, "impropers", impropers );
 
+    WriteSections( os, types, bonds, angles, torsions, impropers );
 }
 
-////------------------------------------------------------------------------------
-
-//void CAmberParams::WriteTypes(istream& os, CAmberFFPtr& ff)
-//{
-//    m_debug << "> Writing types ..." << endl;
-
-//    os << "MASS" << endl;
-//    CEntityPtr list = ff->FindChild( "types" );
-
-//    CForwardIterator it = list->BeginChildren();
-//    CForwardIterator ie = list->EndChildren();
-
-//    while( it != ie ) {
-
-//        os << it->GetName() << " ";
-//        os << it->Get<double>(MASS) << " ";
-//        os << it->Get<double>(POLAR) << " ";
-//        os << it->Get<string>(TITLE);
-//        os << endl;
-
-//        it++;
-//    }
-
-//}
-
-//// -------------------------------------------------------------------------
-
-//void CAmberParams::WriteBonds(istream& is, CAmberFFPtr& ff)
-//{
-//    m_debug << "> Writing bonds ..." << endl;
-//    os << "BOND" << endl;
-
-//    CEntityPtr list = ff->FindChild( "bonds" );
-
-//    CForwardIterator it = list->BeginChildren();
-//    CForwardIterator ie = list->EndChildren();
-
-//    while( it != ie ) {
-
-//        os << it->Get<string>(ATOM1) << " ";
-//        os << it->Get<string>(ATOM2) << " ";
-//        os << it->Get<double>(FORCE) << " ";
-//        os << it->Get<double>(EQUIL) << " ";
-//        os << it->Get<string>(TITLE);
-//        os << endl;
-
-//        it++;
-//    }
-
-//}
-
-//// -------------------------------------------------------------------------
-
-//void CAmberParams::ReadAngles(istream& is, CAmberFFPtr& ff)
-//{
-//    m_debug << "> Writing angles ..." << endl;
-//    os << "ANGL" << endl;
-
-//    CEntityPtr list = ff->FindChild( "angles" );
-
-//    CForwardIterator it = list->BeginChildren();
-//    CForwardIterator ie = list->EndChildren();
+// -------------------------------------------------------------------------
 
-//    while( it != ie ) {
+void CAmberParams::WriteUsed(ostream& os, CUnitPtr& unit, list<CAmberFFPtr>& ffs)
+{
+    if( ! unit ){
+        // invalid unit
+        throw runtime_error( "unit is NULL in CAmberParams::WriteUsed" );
+    }
 
-//        os << it->Get<string>(ATOM1) << " ";
-//        os << it->Get<string>(ATOM2) << " ";
-//        os << it->Get<string>(ATOM3) << " ";
-//        os << it->Get<double>(FORCE) << " ";
-//        os << it->Get<double>(EQUIL) << " ";
-//        os << it->Get<string>(TITLE);
-//        os << endl;
+    m_debug << high;
+    m_debug << "> Collecting used terms ..." << endl;
 
-//        it++;
-//    }
+    // bonded graph --------------------------------
+    CUnitGraph graph;
+    graph.Build(unit);
 
-//}
+    // canonical type tuples, all terms are visited from their central atom
+    unordered_set<string> used_types, used_bonds, used_angles, used_torsions, used_impropers;
+    vector<int>           terms;
 
-//// -------------------------------------------------------------------------
+    for(int j=0; j < graph.NumberOfAtoms(); j++){
+        const vector<int>& nj = graph.GetNeighbours(j);
+        used_types.insert( graph.GetType(j) );
 
-//void CAmberParams::WriteTorsions(istream& os, CAmberFFPtr& ff)
-//{
-//    m_debug << "> Writing torsions ..." << endl;
-//    os << "TORS" << endl;
+        for(size_t a=0; a < nj.size(); a++){
+            int i = nj[a];
+            if( i < j ){
+                used_bonds.insert( CanonicalKey( graph.GetType(i), graph.GetType(j) ) );
+            }
+        }
 
-//    CEntityPtr list = ff->FindChild( "torsions" );
+        terms.clear();
+        graph.GetAngles(j,terms);
+        for(size_t t=0; t < terms.size(); t += 3){
+            used_angles.insert( CanonicalKey( graph.GetType(terms[t]), graph.GetType(terms[t+1]),
+                                              graph.GetType(terms[t+2]) ) );
+        }
 
-//    CForwardIterator it = list->BeginChildren();
-//    CForwardIterator ie = list->EndChildren();
+        terms.clear();
+        graph.GetTorsions(j,terms);
+        for(size_t t=0; t < terms.size(); t += 4){
+            used_torsions.insert( CanonicalKey( graph.GetType(terms[t]), graph.GetType(terms[t+1]),
+                                                graph.GetType(terms[t+2]), graph.GetType(terms[t+3]) ) );
+        }
 
-//    while( it != ie ) {
+        // impropers - central atom is the third one, outer atoms are ordered by types
+        int outer[3];
+        if( graph.GetImproperAtoms(j,outer) ){
+            used_impropers.insert( graph.GetType(outer[0]) + "-" + graph.GetType(outer[1]) + "-"
+                                   + graph.GetType(j) + "-" + graph.GetType(outer[2]) );
+        }
+    }
 
-//        os << it->Get<string>(ATOM1)  << "-";
-//        os << it->Get<string>(ATOM2)  << "-";
-//        os << it->Get<string>(ATOM3)  << "-";
-//        os << it->Get<string>(ATOM4)  << " ";
-//        os << it->Get<double>(DIVIDE) << " ";
-//        os << it->Get<double>(FORCE)  << " ";
-//        os << it->Get<double>(EQUIL)  << " ";
-//        os << it->Get<double>(PERIOD) << " ";
-//        os << it->Get<string>(TITLE);
-//        os << endl;
+    m_debug << high;
+    m_debug << "  Types = " << used_types.size() << "  Bonds = " << used_bonds.size();
+    m_debug << "  Angles = " << used_angles.size() << "  Torsions = " << used_torsions.size();
+    m_debug << "  Impropers = " << used_impropers.size() << endl;
+
+    // resolve parameters, records are sorted by their types ----
+    map<string,CEntityPtr>          types_map, bonds_map, angles_map;
+    map<string,vector<CEntityPtr> > torsions_map, impropers_map;
+    vector<string>                  ts;
+
+    for(unordered_set<string>::iterator it = used_types.begin(); it != used_types.end(); it++){
+        CEntityPtr param = CAmberFF::FindType( ffs, *it );
+        if( ! param ){
+            throw runtime_error( "missing parameters for atom type " + *it );
+        }
+        types_map[*it] = param;
+    }
 
-//        it++;
-//    }
+    for(unordered_set<string>::iterator it = used_bonds.begin(); it != used_bonds.end(); it++){
+        split( ts, *it, is_any_of("-") );
+        CEntityPtr param = CAmberFF::FindBond( ffs, ts[0], ts[1] );
+        if( ! param ){
+            throw runtime_error( "missing bond parameters for " + ts[0] + " - " + ts[1] );
+        }
+        bonds_map[*it] = param;
+    }
 
-//}
+    for(unordered_set<string>::iterator it = used_angles.begin(); it != used_angles.end(); it++){
+        split( ts, *it, is_any_of("-") );
+        CEntityPtr param = CAmberFF::FindAngle( ffs, ts[0], ts[1], ts[2] );
+        if( ! param ){
+            throw runtime_error( "missing angle parameters for " + ts[0] + " - " + ts[1] + " - " + ts[2] );
+        }
+        angles_map[*it] = param;
+    }
 
-//// -------------------------------------------------------------------------
+    // torsions without parameters are skipped
+    vector<CEntityPtr> params;
+    for(unordered_set<string>::iterator it = used_torsions.begin(); it != used_torsions.end(); it++){
+        split( ts, *it, is_any_of("-") );
+        CAmberFF::FindTorsion( ffs, ts[0], ts[1], ts[2], ts[3], params );
+        if( params.empty() ) continue;
+        torsions_map.insert( make_pair( RecordKey( params.front() ), params ) );
+    }
 
-//void CAmberParams::WriteImpropers(istream& is, CAmberFFPtr& ff)
-//{
-//    m_debug << "> Writing impropers ..." << endl;
-//    os << "IMPR" << endl;
+    for(unordered_set<string>::iterator it = used_impropers.begin(); it != used_impropers.end(); it++){
+        split( ts, *it, is_any_of("-") );
+        string outer[3] = { ts[0], ts[1], ts[3] };
+        for(int p=0; p < 3; p++){
+            const int* perm = CUnitGraph::ImproperPermutations[p];
+            CAmberFF::FindImproper( ffs, outer[perm[0]], outer[perm[1]], ts[2], outer[perm[2]], params );
+            if( params.empty() ) continue;
+            impropers_map.insert( make_pair( RecordKey( params.front() ), params ) );
+            break;
+        }
+    }
 
-//    CEntityPtr list = ff->FindChild( "impropers" );
+    // write title
+    os << "parameters used by " << unit->GetName() << endl;
+    if( ! os ){
+        throw runtime_error("unable to write title");
+    }
 
-//    CForwardIterator it = list->BeginChildren();
-//    CForwardIterator ie = list->EndChildren();
+    vector<CEntityPtr> types, bonds_list, angles, torsions, impropers;
+    for(map<string,CEntityPtr>::iterator it = types_map.begin(); it != types_map.end(); it++){
+        types.push_back( it->second );
+    }
+    for(map<string,CEntityPtr>::iterator it = bonds_map.begin(); it != bonds_map.end(); it++){
+        bonds_list.push_back( it->second );
+    }
+    for(map<string,CEntityPtr>::iterator it = angles_map.begin(); it != angles_map.end(); it++){
+        angles.push_back( it->second );
+    }
+    for(map<string,vector<CEntityPtr> >::iterator it = torsions_map.begin(); it != torsions_map.end(); it++){
+        torsions.insert( torsions.end(), it->second.begin(), it->second.end() );
+    }
+    for(map<string,vector<CEntityPtr> >::iterator it = impropers_map.begin(); it != impropers_map.end(); it++){
+        impropers.insert( impropers.end(), it->second.begin(), it->second.end() );
+    }
 
-//    while( it != ie ) {
+    WriteSections( os, types, bonds_list, angles, torsions, impropers );
+}
 
-//        os << it->Get<string>(ATOM1)  << "-";
-//        os << it->Get<string>(ATOM2)  << "-";
-//        os << it->Get<string>(ATOM3)  << "-";
-//        os << it->Get<string>(ATOM4)  << " ";
-//        os << it->Get<double>(FORCE)  << " ";
-//        os << it->Get<double>(EQUIL)  << " ";
-//        os << it->Get<double>(PERIOD) << " ";
-//        os << it->Get<string>(TITLE);
+// -------------------------------------------------------------------------
 
-//        it++;
-//    }
+void CAmberParams::GetRecords(CAmberFFPtr& ff, const char* name, vector<CEntityPtr>& records)
+{
+    CEntityPtr list = ff->FindChild( name );
 
-//}
+    CForwardIterator it = list->BeginChildren();
+    CForwardIterator ie = list->EndChildren();
 
-//// -------------------------------------------------------------------------
+    while( it != ie ) {
+        records.push_back( *it );
+        it++;
+    }
+}
 
-//void CAmberParams::ReadvdWParams(istream& is, CAmberFFPtr& ff)
-//{
-//    m_debug << "> Reading vdW parameters ..." << endl;
+// -------------------------------------------------------------------------
 
-//    CEntityPtr list = ff->FindChild("types");
+string CAmberParams::CanonicalKey(const string& t1, const string& t2)
+{
+    if( t2 < t1 ) return( t2 + "-" + t1 );
+    return( t1 + "-" + t2 );
+}
 
-//    while( is && (! empty(m_line)) ) {
+// -------------------------------------------------------------------------
 
-//        // skip comments ---------------------
-//        if( m_line[0]=='#' ) {
-//            continue;
-//        }
+string CAmberParams::CanonicalKey(const string& t1, const string& t2, const string& t3)
+{
+    if( t3 < t1 ) return( t3 + "-" + t2 + "-" + t1 );
+    return( t1 + "-" + t2 + "-" + t3 );
+}
 
-//        // split line ------------------------
-//        vector<string>  ts;
-//        string          line = trim_left_copy(m_line); // it has to be here, split does not remove trailing space
-//        if( empty(line) ) break;
+// -------------------------------------------------------------------------
 
-//        split( ts, line, is_any_of(" \t"), token_compress_on );
+string CAmberParams::CanonicalKey(const string& t1, const string& t2, const string& t3, const string& t4)
+{
+    string forward  = t1 + "-" + t2 + "-" + t3 + "-" + t4;
+    string backward = t4 + "-" + t3 + "-" + t2 + "-" + t1;
+    return( backward < forward ? backward : forward );
+}
 
-//        if( ts.size() < 3 ){
-//            EmitRWError( "Atom type, radius, and epsilon are expected." );
-//        }
+// -------------------------------------------------------------------------
 
-//        // find type ------------------------
-//        CheckItemAsType(0, ts);
-//        string tn1 = ts[0];
-//        CEntityPtr obj = list->FindChild(tn1);
-//        if( ! obj ){
-//            EmitRWError( " Atom type <b>" + tn1 + "</b> not previously defined." );
-//        }
+string CAmberParams::RecordKey(const CEntityPtr& record)
+{
+    // records with more wildcards go first so that the specific ones,
+    // which are found later, take precedence when the file is read back
+    string key;
+    int    nspecific = 0;
+    const CKey* keys[] = { &ATOM1, &ATOM2, &ATOM3, &ATOM4 };
+    for(int i=0; i < 4; i++){
+        string type = record->Get<string>(*keys[i]);
+        if( type != "X" ) nspecific++;
+        key += "-" + type;
+    }
+    return( char('0' + nspecific) + key );
+}
 
-//        // read data -------------------------
-//        double radius = CFactory::GetNumber( ts[1] );
-//        double depth = CFactory::GetNumber( ts[2] );
-//        string title = GetComment(3, ts);
+// -------------------------------------------------------------------------
 
-//        obj->Set( RSTAR, radius );
-//        obj->Set( DEPTH, depth );
-//        obj->Set( TITLE2, title );
+void CAmberParams::WriteSections(ostream& os, const vector<CEntityPtr>& types,
+                                 const vector<CEntityPtr>& bonds, const vector<CEntityPtr>& angles,
+                                 const vector<CEntityPtr>& torsions, const vector<CEntityPtr>& impropers)
+{
+    CFormatBuffer buf;
+
+    m_debug << "> Writing types ..." << endl;
+    buf.Text("MASS");
+    buf.NewLine();
+    for(size_t i=0; i < types.size(); i++){
+        buf.Left( types[i]->GetName(), 2 );
+        buf.Fixed( types[i]->Get<double>(MASS), 8, 3 );
+        buf.Fixed( types[i]->Get<double>(POLAR), 9, 3 );
+        WriteTitle( buf, types[i]->Get<string>(TITLE) );
+    }
+    buf.NewLine();
+
+    m_debug << "> Writing bonds ..." << endl;
+    buf.Text("BOND");
+    buf.NewLine();
+    for(size_t i=0; i < bonds.size(); i++){
+        WriteTypes( buf, bonds[i], 2 );
+        buf.Fixed( bonds[i]->Get<double>(FORCE), 9, 2 );
+        buf.Fixed( bonds[i]->Get<double>(EQUIL), 9, 4 );
+        WriteTitle( buf, bonds[i]->Get<string>(TITLE) );
+    }
+    buf.NewLine();
+
+    m_debug << "> Writing angles ..." << endl;
+    buf.Text("ANGLE");
+    buf.NewLine();
+    for(size_t i=0; i < angles.size(); i++){
+        WriteTypes( buf, angles[i], 3 );
+        buf.Fixed( angles[i]->Get<double>(FORCE), 9, 3 );
+        buf.Fixed( angles[i]->Get<double>(EQUIL), 10, 3 );
+        WriteTitle( buf, angles[i]->Get<string>(TITLE) );
+    }
+    buf.NewLine();
+
+    m_debug << "> Writing torsions ..." << endl;
+    buf.Text("DIHE");
+    buf.NewLine();
+    for(size_t i=0; i < torsions.size(); i++){
+        WriteTypes( buf, torsions[i], 4 );
+        buf.Int( (int)torsions[i]->Get<double>(DIVIDE), 4 );
+        buf.Fixed( torsions[i]->Get<double>(FORCE), 10, 4 );
+        buf.Fixed( torsions[i]->Get<double>(EQUIL), 10, 3 );
+        buf.Fixed( torsions[i]->Get<double>(PERIOD), 7, 1 );
+        WriteTitle( buf, torsions[i]->Get<string>(TITLE) );
+    }
+    buf.NewLine();
+
+    m_debug << "> Writing impropers ..." << endl;
+    buf.Text("IMPROPER");
+    buf.NewLine();
+    for(size_t i=0; i < impropers.size(); i++){
+        WriteTypes( buf, impropers[i], 4 );
+        buf.Fixed( impropers[i]->Get<double>(FORCE), 14, 4 );
+        buf.Fixed( impropers[i]->Get<double>(EQUIL), 10, 3 );
+        buf.Fixed( impropers[i]->Get<double>(PERIOD), 7, 1 );
+        WriteTitle( buf, impropers[i]->Get<string>(TITLE) );
+    }
+    buf.NewLine();
+
+    m_debug << "> Writing vdW parameters ..." << endl;
+    buf.Text("NONBON");
+    buf.NewLine();
+    for(size_t i=0; i < types.size(); i++){
+        buf.Text("  ");
+        buf.Left( types[i]->GetName(), 2 );
+        buf.Fixed( types[i]->Get<double>(RSTAR), 12, 4 );
+        buf.Fixed( types[i]->Get<double>(DEPTH), 12, 6 );
+        WriteTitle( buf, types[i]->Get<string>(TITLE2) );
+    }
+    buf.NewLine();
 
-//        getline( is, m_line );
-//        m_line_no++;
-//    }
-//}
+    buf.Flush( os );
+    if( ! os ){
+        throw runtime_error("unable to write parameters");
+    }
+}
 
 // -------------------------------------------------------------------------
 
-void CAmberParams::SplitTypes(string& line, int number)
+void CAmberParams::WriteTypes(CFormatBuffer& buf, const CEntityPtr& record, int n)
 {
-    number--;
-    for(size_t i=0; i < line.size(); i++){
-        if( line[i] == '-' ){
-            number--;
-            line[i] = ' ';
-        }
-        if( number <= 0 ) break;
+    const CKey* keys[] = { &ATOM1, &ATOM2, &ATOM3, &ATOM4 };
+    for(int i=0; i < n; i++){
+        if( i > 0 ) buf.Char('-');
+        buf.Left( record->Get<string>(*keys[i]), 2 );
     }
 }
 
 // -------------------------------------------------------------------------
 
-string CAmberParams::GetComment(int from, const vector<string>& ts)
+void CAmberParams::WriteTitle(CFormatBuffer& buf, const string& title)
 {
-    string title;
-
-    for(size_t i=from; i < ts.size(); i++ ){
-        title += ts[i];
-        title += " ";
+    string text = trim_copy( title );
+    if( ! text.empty() ){
+        buf.Text("    ");
+        buf.Text( text );
     }
-    return( title );
+    buf.NewLine();
 }
-
 // -------------------------------------------------------------------------
 
-void CAmberParams::CheckItemAsType(size_t item, const vector<string>& ts)
+void CAmberParams::GetType(string& name, size_t item, bool last, const char* expected)
 {
-    if( item >= ts.size() ){
+    // types in a list are separated by dashes
+    bool found = last ? m_cursor.NextField( name ) : m_cursor.NextField( name, '-' );
+    if( ! found ){
+        EmitRWError( expected );
+    }
+    if( name.empty() ){
         stringstream str;
         str << "Missing type name at position " << item+1;
         EmitRWError( str.str() );
     }
-    if( ts[item].size() > 2  ){
+    if( name.size() > 2  ){
         stringstream str;
-        str << "Type name <b>" << ts[item] << "</b> at position " << item+1;
-        str << " can have only one or two characters, but " << ts[item].size() << " are provided.";
+        str << "Type name <b>" << name << "</b> at position " << item+1;
+        str << " can have only one or two characters, but " << name.size() << " are provided.";
         EmitRWError( str.str() );
     }
-    if( isdigit(ts[item][0]) ){
+    if( isdigit(name[0]) ){
         stringstream str;
-        str << "Type name <b>" << ts[item] << "</b> at position " << item+1;
+        str << "Type name <b>" << name << "</b> at position " << item+1;
         str << " cannot start with a digit character.";
         EmitRWError( str.str() );
     }
@@ -870,20 +923,21 @@ void CAmberParams::CheckItemAsType(size_t item, const vector<string>& ts)
 
 // -------------------------------------------------------------------------
 
-void CAmberParams::CheckItemAsNumber(size_t item, const vector<string>& ts)
+double CAmberParams::GetNumber(size_t item, const char* expected)
 {
-    if( item >= ts.size() ){
-        stringstream str;
-        str << "Missing number parameter at position " << item+1;
-        EmitRWError( str.str() );
-    }
+    double value = 0.0;
+    if( m_cursor.NextDouble( value ) ) return( value );
 
-    if( ! CFactory::IsNumber(ts[item]) ){
-        stringstream str;
-        str << "Parameter <b>" << ts[item] << "</b> at position " << item+1;
-        str << " is not a number.";
-        EmitRWError( str.str() );
+    string field;
+    if( ! m_cursor.NextField( field ) ){
+        EmitRWError( expected );
     }
+
+    stringstream str;
+    str << "Parameter <b>" << field << "</b> at position " << item+1;
+    str << " is not a number.";
+    EmitRWError( str.str() );
+    return( value );
 }
 
 //==============================================================================
@@ -25,6 +25,7 @@
 #include <iosfwd>
 #include <vector>
 #include <map>
+#include <list>
 #include <string>
 #include <VerboseStr.hpp>
 #include <format/CommonIO.hpp>
@@ -35,6 +36,8 @@ namespace nleap {
 
 using namespace std;
 
+class CFormatBuffer;
+
 //------------------------------------------------------------------------------
 
 class NLEAP_PACKAGE CAmberParams : public CCommonIO {
@@ -48,6 +51,9 @@ public:
     /// write amber parameter file
     void Write(ostream& os, CAmberFFPtr& ff);
 
+    /// write frcmod file with parameters used by the unit only
+    void WriteUsed(ostream& os, CUnitPtr& unit, list<CAmberFFPtr>& ffs);
+
 // private section -------------------------------------------------------------
 private:
     map< string, string >   m_vdwmap;
@@ -65,12 +71,26 @@ private:
     void ReadvdWParams( istream& is, CAmberFFPtr& ff );
     void AssignvdW( CAmberFFPtr& ff );
 
-    void SplitTypes(string& line, int number );
-    string GetComment(int from, const vector<string>& ts );
+    /// get type name at given item position, types except the last one are followed by a dash
+    void GetType( string& name, size_t item, bool last, const char* expected );
+
+    /// get number at given item position
+    double GetNumber( size_t item, const char* expected );
+
+    void GetRecords(CAmberFFPtr& ff, const char* name, vector<CEntityPtr>& records);
+    void WriteSections(ostream& os, const vector<CEntityPtr>& types,
+                       const vector<CEntityPtr>& bonds, const vector<CEntityPtr>& angles,
+                       const vector<CEntityPtr>& torsions, const vector<CEntityPtr>& impropers);
+    void WriteTypes(CFormatBuffer& buf, const CEntityPtr& record, int n);
+    void WriteTitle(CFormatBuffer& buf, const string& title);
+
+    /// type tuple independent of the direction
+    static string CanonicalKey(const string& t1, const string& t2);
+    static string CanonicalKey(const string& t1, const string& t2, const string& t3);
+    static string CanonicalKey(const string& t1, const string& t2, const string& t3, const string& t4);
 
-    void CheckItemAsType( size_t item, const vector<string>& ts );
-    void CheckItemAsNumber( size_t item, const vector<string>& ts );
-    void ReadError( const string& reason );
+    /// sort key of torsion record, generic records first
+    static string RecordKey(const CEntityPtr& record);
 };
 
 //------------------------------------------------------------------------------
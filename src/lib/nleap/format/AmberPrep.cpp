@@ -20,275 +20,365 @@
 // =============================================================================
 
 #include <format/AmberPrep.hpp>
-#include <vector>
-#include <sstream>
-#include <types/Factory.hpp>
 #include <boost/algorithm/string.hpp>
+#include <iomanip>
+#include <cmath>
+#include <types/Factory.hpp>
+#include <types/Residue.hpp>
+#include <types/Atom.hpp>
+#include <core/PredefinedKeys.hpp>
 
 using namespace boost;
 
+#define DEG2RAD (M_PI/180.0)
+
 namespace nleap {
 //==============================================================================
 //------------------------------------------------------------------------------
 //==============================================================================
 
 CAmberPrep::CAmberPrep( CVerboseStr& debug )
-    : m_debug( debug )
+    : CCommonIO( debug )
 {
-    m_line_no = 0;
 }
 
 // -------------------------------------------------------------------------
 
-void CAmberPrep::Read( istream& is, CUnitPtr& unit, int& top_id )
+void CAmberPrep::Read( istream& is, CDatabasePtr& db, int& top_id, const string& prefix )
 {
-    if( ! unit ){
-        // invalid ff
-        throw runtime_error( "unit is NULL in amber_prep_t::read" );
+    if( ! db ){
+        // invalid db
+        throw runtime_error( "db is NULL in CAmberPrep::Read" );
     }
 
+    m_line_no = 0;
 
+    // IDBGEN, IREST, ITYPF and NAMDBF
+    for( int i = 0; i < 2; i++ ){
+        if( ! NextLine( is ) ) EmitRWError( "Unexpected end of file in the file header." );
+    }
+
+    int nres = 0;
+    while( ReadResidue( is, db, top_id, prefix ) ){
+        nres++;
+    }
+
+    m_debug << medium << "  Residues = " << setw(8) << nres << endl;
 }
 
-//==============================================================================
-//------------------------------------------------------------------------------
-//==============================================================================
+// -------------------------------------------------------------------------
 
+bool CAmberPrep::NextLine( istream& is )
+{
+    getline( is, m_line );
+    if( ! is ) return( false );
+    m_line_no++;
+    return( true );
 }
 
+// -------------------------------------------------------------------------
+
+bool CAmberPrep::ReadResidue( istream& is, CDatabasePtr& db, int& top_id, const string& prefix )
+{
+    // title or STOP
+    if( ! NextLine( is ) ) return( false );
+    if( trim_copy( m_line ) == "STOP" ) return( false );
+
+    // NAMF
+    if( ! NextLine( is ) ) EmitRWError( "Unexpected end of file in the residue header." );
+
+    // NAMRES INTX KFORM
+    if( ! NextLine( is ) ) EmitRWError( "Unexpected end of file in the residue header." );
+    string resname;
+    string crdtype;
+    ResetCursor();
+    GetField( resname, "residue name" );
+    GetField( crdtype, "coordinate type" );
+    to_upper( crdtype );
+
+    bool internal = true;
+    if( crdtype == "XYZ" ){
+        internal = false;
+    } else if( crdtype != "INT" ){
+        EmitRWError( "Coordinate type must be either INT or XYZ." );
+    }
+
+    // IFIXC IOMIT ISYMDU IPOS
+    if( ! NextLine( is ) ) EmitRWError( "Unexpected end of file in the residue header." );
+    string dummy_type = "DU";
+    string iomit = "OMIT";
+    ResetCursor();
+    m_cursor.SkipField();
+    if( m_cursor.HasField() ) GetField( iomit, "dummy atoms omission" );
+    if( m_cursor.HasField() ) GetField( dummy_type, "dummy atom type" );
+    to_upper( iomit );
+
+    // CUT
+    if( ! NextLine( is ) ) EmitRWError( "Unexpected end of file in the residue header." );
+
+    m_debug << medium << "> Reading residue " << resname << " ..." << endl;
+
+    ReadAtoms( is, internal );
+
+    // mark dummy atoms, they only define the internal coordinate frame
+    map<string,int> names;
+    for( size_t i = 0; i < m_atoms.size(); i++ ){
+        m_atoms[i].dummy = m_atoms[i].type == dummy_type;
+        m_atoms[i].omit = m_atoms[i].dummy && (iomit != "NOMIT");
+        if( ! m_atoms[i].omit ) names[m_atoms[i].name] = i;
+    }
+
+    // optional sections terminated by DONE
+    vector< pair<int,int> > loops;
+    bool done = false;
+    while( NextLine( is ) ){
+        string keyword = trim_copy( m_line );
+        if( keyword.empty() ) continue;
+        to_upper( keyword );
+        if( keyword == "DONE" ){
+            done = true;
+            break;
+        }
+        if( keyword == "LOOP" ){
+            while( NextLine( is ) && ! trim_copy( m_line ).empty() ){
+                string name1, name2;
+                ResetCursor();
+                GetField( name1, "first loop atom" );
+                GetField( name2, "second loop atom" );
+                map<string,int>::iterator at1 = names.find( name1 );
+                map<string,int>::iterator at2 = names.find( name2 );
+                if( (at1 == names.end()) || (at2 == names.end()) ){
+                    EmitRWError( "Loop closing bond refers to an undefined atom." );
+                }
+                loops.push_back( make_pair( at1->second, at2->second ) );
+            }
+        } else if( keyword == "CHARGE" ){
+            size_t ia = 0;
+            while( NextLine( is ) && ! trim_copy( m_line ).empty() ){
+                ResetCursor();
+                while( m_cursor.HasField() ){
+                    while( (ia < m_atoms.size()) && m_atoms[ia].dummy ) ia++;
+                    if( ia >= m_atoms.size() ) EmitRWError( "More charges than atoms." );
+                    m_atoms[ia++].charge = GetDouble( "atom charge" );
+                }
+            }
+        } else if( keyword == "IMPROPER" ){
+            // impropers are assigned from the force field
+            while( NextLine( is ) && ! trim_copy( m_line ).empty() );
+        } else {
+            EmitRWError( "Unknown section '" + keyword + "'." );
+        }
+    }
+    if( ! done ) EmitRWError( "Unexpected end of file, DONE expected." );
+
+    // coordinates
+    if( internal ){
+        BuildCoordinates();
+    } else {
+        m_crd.resize( 3*m_atoms.size() );
+        for( size_t i = 0; i < m_atoms.size(); i++ ){
+            for( int k = 0; k < 3; k++ ) m_crd[3*i+k] = m_atoms[i].geo[k];
+        }
+    }
+
+    // create unit with single residue
+    string      name = prefix + resname;
+    CUnitPtr    unit = db->CreateUnit( top_id, name );
+    db->SetVariable( top_id, name, unit );
+
+    CResiduePtr res = unit->CreateResidue( resname, top_id );
+
+    vector<CAtomPtr>    atoms( m_atoms.size() );
+    int                 head = 0;
+    int                 tail = 0;
+    int                 natoms = 0;
+    int                 nbonds = 0;
+
+    for( size_t i = 0; i < m_atoms.size(); i++ ){
+        const SPrepAtom& atom = m_atoms[i];
+        if( atom.omit ) continue;
+
+        CAtomPtr atm = res->CreateAtom( atom.name, top_id );
+        atm->Set(POSX, m_crd[3*i+0] );
+        atm->Set(POSY, m_crd[3*i+1] );
+        atm->Set(POSZ, m_crd[3*i+2] );
+        atm->Set(TYPE, atom.type );
+        atm->Set(CHARGE, atom.charge );
+        atoms[i] = atm;
+        natoms++;
+
+        // main chain defines connection atoms
+        if( (atom.tree == 'M') && ! atom.dummy ){
+            if( head == 0 ) head = natoms;
+            tail = natoms;
+        }
+
+        // bond to the bond partner from the tree
+        if( (atom.na >= 0) && atoms[atom.na] ){
+            unit->CreateBond( atm, atoms[atom.na], 1, top_id );
+            nbonds++;
+        }
+    }
+
+    for( size_t i = 0; i < loops.size(); i++ ){
+        unit->CreateBond( atoms[loops[i].first], atoms[loops[i].second], 1, top_id );
+        nbonds++;
+    }
+
+    unit->FixCounters();
+    if( head > 0 ) unit->Set(HEAD, head );
+    if( tail > 0 ) unit->Set(TAIL, tail );
 
+    m_debug << high << "  Atoms = " << setw(8) << natoms;
+    m_debug << high << "  Bonds = " << setw(8) << nbonds << endl;
 
+    return( true );
+}
+
+// -------------------------------------------------------------------------
+
+void CAmberPrep::ReadAtoms( istream& is, bool internal )
+{
+    m_atoms.clear();
+
+    while( NextLine( is ) ){
+        if( trim_copy( m_line ).empty() ) return;
+
+        SPrepAtom   atom;
+        string      tree;
+
+        ResetCursor();
+        GetInt( "atom number" );
+        GetField( atom.name, "atom name" );
+        GetField( atom.type, "atom type" );
+        GetField( tree, "tree type" );
+        atom.tree = tree[0];
+
+        // references are one-based, zero or negative means not defined
+        int ref[3];
+        ref[0] = GetInt( "bond partner" );
+        ref[1] = GetInt( "angle partner" );
+        ref[2] = GetInt( "torsion partner" );
+        for( int k = 0; k < 3; k++ ){
+            ref[k] = ref[k] > 0 ? ref[k] - 1 : -1;
+            if( ref[k] >= (int)m_atoms.size() ){
+                EmitRWError( "Atom refers to an atom that is not defined yet." );
+            }
+        }
+        atom.na = ref[0];
+        atom.nb = ref[1];
+        atom.nc = ref[2];
+
+        if( internal ){
+            atom.geo[0] = GetDouble( "bond length" );
+            atom.geo[1] = GetDouble( "bond angle" );
+            atom.geo[2] = GetDouble( "torsion angle" );
+        } else {
+            atom.geo[0] = GetDouble( "x coordinate" );
+            atom.geo[1] = GetDouble( "y coordinate" );
+            atom.geo[2] = GetDouble( "z coordinate" );
+        }
+
+        atom.charge = 0.0;
+        if( m_cursor.HasField() ) atom.charge = GetDouble( "atom charge" );
+        atom.dummy = false;
+        atom.omit = false;
+        atom.line_no = m_line_no;
+        atom.line = m_line;
+
+        m_atoms.push_back( atom );
+    }
 
+    EmitRWError( "Unexpected end of file in the atom section." );
+}
 
+// -------------------------------------------------------------------------
 
+void CAmberPrep::BuildCoordinates( void )
+{
+    size_t natoms = m_atoms.size();
+    m_crd.assign( 3*natoms, 0.0 );
+
+    // displacements in the frame of the bond partner, independent for all atoms
+    vector<double> local( 3*natoms );
+    for( size_t i = 0; i < natoms; i++ ){
+        double r     = m_atoms[i].geo[0];
+        double theta = m_atoms[i].geo[1] * DEG2RAD;
+        double phi   = m_atoms[i].geo[2] * DEG2RAD;
+        double rsin  = r * sin( theta );
+        local[3*i+0] = - r * cos( theta );
+        local[3*i+1] = rsin * cos( phi );
+        local[3*i+2] = rsin * sin( phi );
+    }
 
+    // place atoms (NeRF), each atom depends only on already placed atoms
+    for( size_t i = 0; i < natoms; i++ ){
+        const SPrepAtom&    atom = m_atoms[i];
+        double*             d = &m_crd[3*i];
+
+        // the first atom is at origin
+        if( atom.na < 0 ) continue;
+
+        const double* c = &m_crd[3*atom.na];
+
+        // the second atom is on the x axis
+        if( atom.nb < 0 ){
+            d[0] = c[0] + atom.geo[0];
+            d[1] = c[1];
+            d[2] = c[2];
+            continue;
+        }
+
+        const double* b = &m_crd[3*atom.nb];
+
+        double bc[3];
+        for( int k = 0; k < 3; k++ ) bc[k] = c[k] - b[k];
+        double len = sqrt( bc[0]*bc[0] + bc[1]*bc[1] + bc[2]*bc[2] );
+        if( len < 1.0e-8 ){
+            // report the atom record
+            m_line_no = atom.line_no;
+            m_line = atom.line;
+            EmitRWError( "Atom '" + atom.name + "' has an undefined bond angle, angle and bond partners coincide." );
+        }
+        for( int k = 0; k < 3; k++ ) bc[k] /= len;
+
+        // the third atom is in the xy plane
+        double ab[3] = { 0.0, 1.0, 0.0 };
+        if( atom.nc >= 0 ){
+            const double* a = &m_crd[3*atom.nc];
+            for( int k = 0; k < 3; k++ ) ab[k] = b[k] - a[k];
+        }
+
+        double n[3];
+        n[0] = ab[1]*bc[2] - ab[2]*bc[1];
+        n[1] = ab[2]*bc[0] - ab[0]*bc[2];
+        n[2] = ab[0]*bc[1] - ab[1]*bc[0];
+        len = sqrt( n[0]*n[0] + n[1]*n[1] + n[2]*n[2] );
+        if( len < 1.0e-8 ){
+            // collinear frame, any perpendicular direction will do
+            double e[3] = { 0.0, 0.0, 0.0 };
+            e[ fabs(bc[0]) < 0.9 ? 0 : 1 ] = 1.0;
+            n[0] = e[1]*bc[2] - e[2]*bc[1];
+            n[1] = e[2]*bc[0] - e[0]*bc[2];
+            n[2] = e[0]*bc[1] - e[1]*bc[0];
+            len = sqrt( n[0]*n[0] + n[1]*n[1] + n[2]*n[2] );
+        }
+        for( int k = 0; k < 3; k++ ) n[k] /= len;
+
+        double m[3];
+        m[0] = n[1]*bc[2] - n[2]*bc[1];
+        m[1] = n[2]*bc[0] - n[0]*bc[2];
+        m[2] = n[0]*bc[1] - n[1]*bc[0];
+
+        const double* l = &local[3*i];
+        for( int k = 0; k < 3; k++ ){
+            d[k] = c[k] + l[0]*bc[k] + l[1]*m[k] + l[2]*n[k];
+        }
+    }
+}
 
-//#include <sstream>
-//#include <common.hpp>
-//#include <object.hpp>
-
-//namespace mort
-//{
-//    int get_nunfill(const string& chain)
-//    {
-//        static const char IDS[] = "ESB3456";
-
-//        const char* ptr = std::find(IDS, IDS+sizeof(IDS)/sizeof(char), chain[0]);
-
-//        if( ptr != IDS+sizeof(IDS)/sizeof(char) )
-//        {
-//            return ptr - IDS;
-//        }
-        
-//        if( chain[0] == 'M' )
-//        {
-//            return 10000;
-//        }
-        
-//        throw std::runtime_error("Error: unknown chain identifier " + chain);
-//    }
-    
-//    void read_amber_prep(istream& is, molecule_t& mol)
-//    {
-//        molecule_t m;
-
-//        // ignore first line
-//	is.ignore(MAX_LINE_WIDTH, '\n');
-
-//        // name and coordinate type (INT/XYZ, 0/1)
-//	string name, crdtype, crdtypeid;
-//	is >> name >> crdtype >> crdtypeid;
-//	is.ignore(MAX_LINE_WIDTH, '\n');
-//        m.set_s(NAME, name);
-
-//        resd_t r = resd_t::create( m );
-//        r.set_s(NAME, name);
-//        r.set_s(TYPE, name.length()<3?name:name.substr(0,3));
-
-//        // CORR/CHANGE, if CHANGE then sort line according
-//	// the first column, no supported any more.
-//	string use_first_column;
-//	is >> use_first_column;
-//	//if(use_first_column.find("CORR") == string::npos)
-//        //{
-//	//    throw std::runtime_error("Error: prep format, sort by first column no longer supported");
-//	//}
-//	is.ignore(MAX_LINE_WIDTH, '\n');
-
-//        // cutoff: if > 0.0, make bond according to distance
-//	double cutoff;
-//	is >> cutoff;
-//	is.ignore(MAX_LINE_WIDTH, '\n');
-
-//        vector<CAtom> atoms;
-//        vector<numvec> crds;
-//        vector<int> nunfills;
-
-//        int head = 0;
-//        int tail = 0;
-//	char line[MAX_LINE_WIDTH];
-//	while( is.getline(line, MAX_LINE_WIDTH) && !empty(line) )
-//	{
-//            std::istringstream ls(line);
-//	    int id;
-//            ls >> id;
-
-//	    string name, type, chain;
-//            ls >> name >> type >> chain;
-
-
-//            string curt;
-//	    vector<string> terms;
-//	    while(ls >> curt)
-//	    {
-//	        terms.push_back(curt);
-//	    }
-
-//            numvec pos(3);
-//	    double pchg=0.0;
-//	    if( terms.size()==3 || terms.size()==4 )
-//	    {
-//	        double x = atof( terms[0].c_str() );
-//		double y = atof( terms[1].c_str() );
-//		double z = atof( terms[2].c_str() );
-//		pchg = (terms.size()==4) ? atof( terms[3].c_str() ) : 0.0;
-//		pos  = makevec(x,y,z);
-//	    }
-//	    else
-//	    {
-//	        assert( terms.size()==6 || terms.size()==7 );
-//		double dist = atof( terms[3].c_str() );
-//		double angl = atof( terms[4].c_str() );
-//		double tors = atof( terms[5].c_str() );
-//		pchg = (terms.size()==7) ? atof( terms[6].c_str() ) : 0.0;
-//		int len = crds.size();
-//		if(len==0)
-//		{
-//		    pos = makevec(0.0, 0.0, 0.0);
-//		}
-//		else if(len==1)
-//		{
-//		    pos = zmatrix(crds[len-1], dist);
-//		}
-//		else if(len==2)
-//		{
-//		    pos = zmatrix(crds[len-1], dist, crds[len-2], angl);
-//		}
-//		else
-//		{
-//                    pos = zmatrix(crds[len-1], dist, crds[len-2], angl, crds[len-3], tors);
-//                }
-//            }
-
-//            CAtom atom(m, -1);
-//            if( type != "DU" )
-//	    {
-//	        atom = r.CreateAtom(name);
-//	        atom.set_s(NAME, name);
-//                atom.set_s(TYPE, type);
-//	        atom.set_s(CHAIN, chain);
-//	        atom.set_v(POSITION, pos);
-//	        atom.set_d(PCHG, pchg);
-
-//                if(atoms.size() > 0)
-//		{
-//		    assert( nunfills.size()==crds.size() );
-//	            CBond::create(atom, atoms.back() ).set_i(ORDER, 1);
-//                    nunfills.back() -= 1;
-//                }
-
-//                if( chain=="M" )
-//                {
-//                    // head is the first M atom, tail is the last M atom
-//                    if( head==0 )
-//                        head = atom.absGetId()+1;
-//                    tail = atom.absGetId() + 1;
-//                }
-//	    }
-
-            
-
-//	    if( nunfills.size()>0 && nunfills.back()==0 )
-//	    {
-//	        crds.pop_back();
-//	        atoms.pop_back();
-//		nunfills.pop_back();
-//	    }
-
-//	    int nunfill = get_nunfill(chain);
-//	    if(nunfill > 0)
-//            {
-//	        crds.push_back(pos);
-//		if(type != "DU")
-//	            atoms.push_back(atom);
-//                nunfills.push_back(nunfill);
-//	    }
-            
-//        }
-
-//        m.set_i( HEAD, head );
-//        m.set_i( TAIL, tail );
-//        r.set_i( HEAD, head );
-//        r.set_i( TAIL, tail );
-
-//        string keyw;
-//	while(is >> keyw && keyw != "DONE")
-//	{
-//            is.ignore(MAX_LINE_WIDTH, '\n');
-            
-//            if(keyw=="LOOP")
-//	    {
-//	        char line[MAX_LINE_WIDTH];
-//		while( is.getline(line, MAX_LINE_WIDTH) && !empty(line) )
-//		{
-//                    std::istringstream ls(line);
-//	            string atm1, atm2;
-//		    ls >> atm1 >> atm2;
-
-//                    CAtom a1 = CAtom::get( m, atm1);
-//                    CAtom a2 = CAtom::get( m, atm2);
-//	            CBond b = CBond::create(a1, a2);
-//                    b.set_i(ORDER, 1);
-//	        }
-//	    }
-//	    else if(keyw=="CHARGE")
-//	    {
-//                char line[MAX_LINE_WIDTH];
-//		while( is.getline(line, MAX_LINE_WIDTH) && !empty(line) )
-//		{
-//                }
-//	    }
-//	    else if(keyw=="IMPROPER")
-//	    {
-//	        char line[MAX_LINE_WIDTH];
-//		while( is.getline(line, MAX_LINE_WIDTH) && !empty(line) )
-//		{
-//                }
-//            }
-//	    else
-//	    {
-//	        throw std::logic_error("Error: unknown prep keyword " + keyw);
-//	    }
-//	}
-
-//        mol.swap(m);
-//    }
-
-//    void read_amber_prep(istream& is, CDatabase& mdb)
-//    {
-//        // ignore first two lines
-//	is.ignore(MAX_LINE_WIDTH, '\n');
-//	is.ignore(MAX_LINE_WIDTH, '\n');
-
-//        string keyw;
-//	while(is>>keyw && keyw!="STOP")
-//	{
-//            is.ignore(MAX_LINE_WIDTH, '\n');
-//	    molecule_ptr pm( new molecule_t() );
-//	    read_amber_prep(is, *pm);
-//	    mdb.add( pm->get_s(NAME), pm);
-//	}
-//    }
-
-//} // namespace mort
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+}
 
@@ -23,11 +23,12 @@
 
 #include <NLEaPMainHeader.hpp>
 #include <iosfwd>
-#include <types/Unit.hpp>
+#include <types/Database.hpp>
 #include <vector>
 #include <map>
 #include <string>
 #include <VerboseStr.hpp>
+#include <format/CommonIO.hpp>
 
 namespace nleap {
 //------------------------------------------------------------------------------
@@ -36,23 +37,53 @@ using namespace std;
 
 //------------------------------------------------------------------------------
 
-class NLEAP_PACKAGE CAmberPrep {
+/// AMBER PREP (residue database) reader
+/*!
+ Each residue is read into a new unit with a single residue. Residues given by
+ internal coordinates (INT) are converted to cartesian coordinates in one pass
+ over the whole residue after it is read. Dummy atoms only define the frame of
+ the internal coordinates, they are not created unless IOMIT is NOMIT.
+*/
+
+class NLEAP_PACKAGE CAmberPrep : public CCommonIO {
 public:
     CAmberPrep( CVerboseStr& debug );
 
-    /// read amber prep file
-    void Read( istream& is, CUnitPtr& unit, int& top_id );
+    /// read amber prep file, units are named by residues with optional prefix
+    void Read( istream& is, CDatabasePtr& db, int& top_id, const string& prefix = string() );
 
     /// write amber prep file
     void Write( ostream& os, CUnitPtr& unit );
 
 // private section -------------------------------------------------------------
 private:
-    CVerboseStr&            m_debug;
-    int                     m_line_no;
-    string                  m_line;
+    struct SPrepAtom {
+        string  name;
+        string  type;
+        char    tree;           // topological type (M, S, B, E, 3, ...)
+        int     na,nb,nc;       // bond, angle, and torsion partners, -1 if not defined
+        double  geo[3];         // bond, angle, torsion or x, y, z
+        double  charge;
+        bool    dummy;          // defines the frame, no charge
+        bool    omit;           // dummy atom that is not created
+        int     line_no;        // source line for error reports
+        string  line;
+    };
+
+    vector<SPrepAtom>   m_atoms;
+    vector<double>      m_crd;      // cartesian coordinates of m_atoms
+
+    /// read next line, false at the end of stream
+    bool NextLine( istream& is );
+
+    /// read one residue, false if STOP or end of file is reached
+    bool ReadResidue( istream& is, CDatabasePtr& db, int& top_id, const string& prefix );
+
+    /// read atom records terminated by an empty line
+    void ReadAtoms( istream& is, bool internal );
 
-    void ReadError( const string& reason );
+    /// convert internal coordinates to cartesian coordinates
+    void BuildCoordinates( void );
 };
 
 //------------------------------------------------------------------------------
@@ -22,12 +22,335 @@
 #include <format/CommonIO.hpp>
 #include <stdexcept>
 #include <sstream>
+#include <cstdlib>
 
 namespace nleap {
 //==============================================================================
 //------------------------------------------------------------------------------
 //==============================================================================
 
+// mantissa digits that are accumulated exactly
+#define MAX_MANTISSA        1000000000000000000ULL
+// mantissa that is exactly representable by double
+#define MAX_EXACT_MANTISSA  9007199254740992ULL
+// exponents, for which powers of ten are exact
+#define MAX_EXACT_EXPONENT  22
+
+static const double g_pow10[MAX_EXACT_EXPONENT+1] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+//------------------------------------------------------------------------------
+
+static inline bool IsBlank( char c )
+{
+    return( (c == ' ') || (c == '\t') || (c == '\r') );
+}
+
+//------------------------------------------------------------------------------
+
+static inline bool IsDigit( char c )
+{
+    return( (c >= '0') && (c <= '9') );
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CLineCursor::CLineCursor(void)
+{
+    m_begin = NULL;
+    m_pos = NULL;
+    m_end = NULL;
+}
+
+//------------------------------------------------------------------------------
+
+void CLineCursor::Assign( const string& line )
+{
+    m_begin = line.data();
+    m_pos = m_begin;
+    m_end = m_begin + line.size();
+}
+
+//------------------------------------------------------------------------------
+
+bool CLineCursor::HasField(void)
+{
+    while( (m_pos < m_end) && IsBlank(*m_pos) ) m_pos++;
+    return( m_pos < m_end );
+}
+
+//------------------------------------------------------------------------------
+
+size_t CLineCursor::Tell(void) const
+{
+    return( m_pos - m_begin );
+}
+
+//------------------------------------------------------------------------------
+
+void CLineCursor::Seek( size_t pos )
+{
+    m_pos = m_begin + pos;
+    if( m_pos > m_end ) m_pos = m_end;
+}
+
+//------------------------------------------------------------------------------
+
+bool CLineCursor::NextField( const char*& begin, const char*& end )
+{
+    if( ! HasField() ) return(false);
+    begin = m_pos;
+    while( (m_pos < m_end) && ! IsBlank(*m_pos) ) m_pos++;
+    end = m_pos;
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CLineCursor::NextField( string& value )
+{
+    const char* begin;
+    const char* end;
+    if( ! NextField(begin,end) ) return(false);
+    value.assign(begin,end);
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CLineCursor::NextField( string& value, char delimiter )
+{
+    if( ! HasField() ) return(false);
+    const char* begin = m_pos;
+    while( (m_pos < m_end) && (! IsBlank(*m_pos)) && (*m_pos != delimiter) ) m_pos++;
+    value.assign(begin,m_pos);
+    // skip delimiter
+    const char* pos = m_pos;
+    while( (pos < m_end) && IsBlank(*pos) ) pos++;
+    if( (pos < m_end) && (*pos == delimiter) ) m_pos = pos + 1;
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CLineCursor::SkipField(void)
+{
+    const char* begin;
+    const char* end;
+    return( NextField(begin,end) );
+}
+
+//------------------------------------------------------------------------------
+
+bool CLineCursor::NextInt( int& value )
+{
+    const char* pos = m_pos;
+    const char* begin;
+    const char* end;
+    if( NextField(begin,end) && ParseInt(begin,end,value) ) return(true);
+    m_pos = pos;
+    return(false);
+}
+
+//------------------------------------------------------------------------------
+
+bool CLineCursor::NextDouble( double& value )
+{
+    const char* pos = m_pos;
+    const char* begin;
+    const char* end;
+    if( NextField(begin,end) && ParseDouble(begin,end,value) ) return(true);
+    m_pos = pos;
+    return(false);
+}
+
+//------------------------------------------------------------------------------
+
+void CLineCursor::GetRest( string& value )
+{
+    value.clear();
+    const char* begin;
+    const char* end;
+    while( NextField(begin,end) ){
+        value.append(begin,end);
+        value += ' ';
+    }
+}
+
+//------------------------------------------------------------------------------
+
+bool CLineCursor::GetColumn( size_t from, size_t len, const char*& begin, const char*& end ) const
+{
+    if( from >= (size_t)(m_end - m_begin) ) return(false);
+    begin = m_begin + from;
+    end = begin + len;
+    if( end > m_end ) end = m_end;
+    while( (begin < end) && IsBlank(*begin) ) begin++;
+    while( (begin < end) && IsBlank(*(end-1)) ) end--;
+    return( begin < end );
+}
+
+//------------------------------------------------------------------------------
+
+bool CLineCursor::ColumnField( size_t from, size_t len, string& value ) const
+{
+    const char* begin;
+    const char* end;
+    if( ! GetColumn(from,len,begin,end) ) return(false);
+    value.assign(begin,end);
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CLineCursor::ColumnInt( size_t from, size_t len, int& value ) const
+{
+    const char* begin;
+    const char* end;
+    return( GetColumn(from,len,begin,end) && ParseInt(begin,end,value) );
+}
+
+//------------------------------------------------------------------------------
+
+bool CLineCursor::ColumnDouble( size_t from, size_t len, double& value ) const
+{
+    const char* begin;
+    const char* end;
+    return( GetColumn(from,len,begin,end) && ParseDouble(begin,end,value) );
+}
+
+//------------------------------------------------------------------------------
+
+bool CLineCursor::ParseInt( const char* begin, const char* end, int& value )
+{
+    const char* p = begin;
+    bool        neg = false;
+
+    if( (p < end) && ((*p == '+') || (*p == '-')) ){
+        neg = *p == '-';
+        p++;
+    }
+    if( p == end ) return(false);
+
+    long long num = 0;
+    while( p < end ){
+        if( ! IsDigit(*p) ) return(false);
+        num = num*10 + (*p - '0');
+        if( num > 2147483648LL ) return(false);     // out of range
+        p++;
+    }
+    if( neg ) num = -num;
+    if( num > 2147483647LL ) return(false);
+
+    value = (int)num;
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CLineCursor::ParseDouble( const char* begin, const char* end, double& value )
+{
+    const char*         p = begin;
+    bool                neg = false;
+    unsigned long long  mant = 0;
+    int                 exp10 = 0;
+    bool                digits = false;
+    bool                exact = true;
+
+    if( (p < end) && ((*p == '+') || (*p == '-')) ){
+        neg = *p == '-';
+        p++;
+    }
+
+    // integer part
+    while( (p < end) && IsDigit(*p) ){
+        digits = true;
+        if( mant < MAX_MANTISSA ){
+            mant = mant*10 + (*p - '0');
+        } else {
+            exp10++;
+            if( *p != '0' ) exact = false;
+        }
+        p++;
+    }
+
+    // fractional part
+    if( (p < end) && (*p == '.') ){
+        p++;
+        while( (p < end) && IsDigit(*p) ){
+            digits = true;
+            if( mant < MAX_MANTISSA ){
+                mant = mant*10 + (*p - '0');
+                exp10--;
+            } else {
+                if( *p != '0' ) exact = false;
+            }
+            p++;
+        }
+    }
+    if( ! digits ) return(false);
+
+    // exponent, D is used by Fortran programs
+    if( (p < end) && ((*p == 'e') || (*p == 'E') || (*p == 'd') || (*p == 'D')) ){
+        p++;
+        bool eneg = false;
+        if( (p < end) && ((*p == '+') || (*p == '-')) ){
+            eneg = *p == '-';
+            p++;
+        }
+        if( (p == end) || ! IsDigit(*p) ) return(false);
+        int exp = 0;
+        while( (p < end) && IsDigit(*p) ){
+            if( exp < 100000 ) exp = exp*10 + (*p - '0');
+            p++;
+        }
+        exp10 += eneg ? -exp : exp;
+    }
+    if( p != end ) return(false);
+
+    // exact mantissa and power of ten give correctly rounded result
+    if( exact && (mant <= MAX_EXACT_MANTISSA) && (exp10 >= -MAX_EXACT_EXPONENT)
+        && (exp10 <= MAX_EXACT_EXPONENT) ){
+        double num = (double)mant;
+        if( exp10 < 0 ){
+            num /= g_pow10[-exp10];
+        } else {
+            num *= g_pow10[exp10];
+        }
+        value = neg ? -num : num;
+        return(true);
+    }
+
+    // slow path - rare for numbers in structure and parameter files
+    // FORTRAN exponents (d, D) are replaced by e
+    char        buffer[64];
+    string      long_buffer;
+    const char* p_str = buffer;
+    size_t      len = end - begin;
+    if( len >= sizeof(buffer) ){
+        long_buffer.assign(begin,end);
+        for(size_t i=0; i < len; i++){
+            if( (long_buffer[i] == 'd') || (long_buffer[i] == 'D') ) long_buffer[i] = 'e';
+        }
+        p_str = long_buffer.c_str();
+    } else {
+        for(size_t i=0; i < len; i++){
+            buffer[i] = ((begin[i] == 'd') || (begin[i] == 'D')) ? 'e' : begin[i];
+        }
+        buffer[len] = '\0';
+    }
+    value = strtod(p_str,NULL);
+    return(true);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
 CCommonIO::CCommonIO( CVerboseStr& debug )
     : m_debug( debug )
 {
@@ -36,6 +359,44 @@ CCommonIO::CCommonIO( CVerboseStr& debug )
 
 //------------------------------------------------------------------------------
 
+void CCommonIO::ResetCursor(void)
+{
+    m_cursor.Assign( m_line );
+}
+
+//------------------------------------------------------------------------------
+
+void CCommonIO::GetField( string& value, const char* what )
+{
+    if( ! m_cursor.NextField( value ) ){
+        EmitRWError( string("Missing ") + what + "." );
+    }
+}
+
+//------------------------------------------------------------------------------
+
+int CCommonIO::GetInt( const char* what )
+{
+    int value = 0;
+    if( ! m_cursor.NextInt( value ) ){
+        EmitRWError( string("Missing or invalid ") + what + " (integer number expected)." );
+    }
+    return( value );
+}
+
+//------------------------------------------------------------------------------
+
+double CCommonIO::GetDouble( const char* what )
+{
+    double value = 0.0;
+    if( ! m_cursor.NextDouble( value ) ){
+        EmitRWError( string("Missing or invalid ") + what + " (real number expected)." );
+    }
+    return( value );
+}
+
+//------------------------------------------------------------------------------
+
 void CCommonIO::EmitRWError( const string& reason )
 {
     stringstream str;
@@ -23,6 +23,8 @@
 
 #include <NLEaPMainHeader.hpp>
 #include <VerboseStr.hpp>
+#include <iosfwd>
+#include <string>
 
 namespace nleap {
 //------------------------------------------------------------------------------
@@ -31,6 +33,82 @@ using namespace std;
 
 //------------------------------------------------------------------------------
 
+/// cursor over a single line, no memory is allocated during parsing
+/*!
+ Fields are delimited by spaces or tabs, or they are given by fixed columns.
+ Numbers are parsed directly from the line characters, the field must be
+ entirely consumed. The cursor position is not changed if the field cannot
+ be parsed. The line must not be modified while the cursor is used.
+*/
+
+class NLEAP_PACKAGE CLineCursor {
+public:
+
+    CLineCursor(void);
+
+    /// start at the beginning of the line
+    void Assign( const string& line );
+
+    /// is there any other field?
+    bool HasField(void);
+
+    /// current position from the beginning of the line
+    size_t Tell(void) const;
+
+    /// set position from the beginning of the line
+    void Seek( size_t pos );
+
+// whitespace delimited fields -------------------------------------------------
+    /// get next field as a character range
+    bool NextField( const char*& begin, const char*& end );
+
+    /// get next field, value memory is reused
+    bool NextField( string& value );
+
+    /// get next field terminated by whitespace or delimiter, the delimiter is skipped
+    bool NextField( string& value, char delimiter );
+
+    /// skip next field
+    bool SkipField(void);
+
+    /// get next field as an integer number
+    bool NextInt( int& value );
+
+    /// get next field as a real number
+    bool NextDouble( double& value );
+
+    /// get remaining fields separated by single spaces, each field is followed by a space
+    void GetRest( string& value );
+
+// fixed column fields ---------------------------------------------------------
+    /// get field from columns [from,from+len), leading and trailing spaces are removed
+    bool ColumnField( size_t from, size_t len, string& value ) const;
+
+    /// get integer number from columns [from,from+len)
+    bool ColumnInt( size_t from, size_t len, int& value ) const;
+
+    /// get real number from columns [from,from+len)
+    bool ColumnDouble( size_t from, size_t len, double& value ) const;
+
+// number parsing --------------------------------------------------------------
+    /// parse integer number, whole range must be consumed
+    static bool ParseInt( const char* begin, const char* end, int& value );
+
+    /// parse real number with optional exponent (E or D), whole range must be consumed
+    static bool ParseDouble( const char* begin, const char* end, double& value );
+
+// section of private data -----------------------------------------------------
+private:
+    const char*     m_begin;
+    const char*     m_pos;
+    const char*     m_end;
+
+    /// get trimmed range of columns [from,from+len)
+    bool GetColumn( size_t from, size_t len, const char*& begin, const char*& end ) const;
+};
+
+//------------------------------------------------------------------------------
+
 class NLEAP_PACKAGE CCommonIO {
 public:
 
@@ -41,6 +119,19 @@ protected:
     CVerboseStr&            m_debug;
     int                     m_line_no;
     string                  m_line;
+    CLineCursor             m_cursor;   // cursor over m_line
+
+    /// reset the cursor to the beginning of m_line
+    void ResetCursor(void);
+
+    /// get next field or emit error
+    void GetField( string& value, const char* what );
+
+    /// get next integer number or emit error
+    int GetInt( const char* what );
+
+    /// get next real number or emit error
+    double GetDouble( const char* what );
 
     void EmitRWError( const string& reason );
 };
@@ -0,0 +1,1142 @@
+// =============================================================================
+// nLEaP - prepare input for the AMBER molecular mechanics programs
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2011 Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2006 gLEaP authors, see AUTHORS file in the main directory
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <format/FileStream.hpp>
+#include <stdexcept>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <vector>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_BZIP2
+#include <bzlib.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef HAVE_PTHREADS
+#include <pthread.h>
+#endif
+
+namespace nleap {
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+// size of one decompression buffer
+#define DECOMPRESS_BUFFER_SIZE  (256*1024)
+// size of one block of written data
+#define WRITE_BUFFER_SIZE       (1024*1024)
+
+const char* CompressedSuffixes[] = {
+#ifdef HAVE_ZLIB
+    ".gz",
+#endif
+#ifdef HAVE_BZIP2
+    ".bz2",
+#endif
+#ifdef HAVE_ZSTD
+    ".zst",
+#endif
+    NULL
+};
+
+//------------------------------------------------------------------------------
+
+static bool HasSuffix(const string& name, const string& suffix)
+{
+    if( name.size() < suffix.size() ) return(false);
+    return( name.compare(name.size()-suffix.size(),suffix.size(),suffix) == 0 );
+}
+
+//------------------------------------------------------------------------------
+
+#if ! defined HAVE_ZLIB || ! defined HAVE_BZIP2 || ! defined HAVE_ZSTD
+static void ThrowUnsupported(const string& name, const string& method)
+{
+    throw runtime_error("file '" + name + "' is " + method + " compressed but " + method
+                        + " compression is not supported by this build");
+}
+#endif
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+/// source of decompressed data
+class CDecompressor {
+public:
+    virtual ~CDecompressor(void) {}
+
+    /// read at most size bytes, return 0 at the end of data, throw on error
+    virtual int Read(char* p_data, int size) = 0;
+};
+
+//------------------------------------------------------------------------------
+
+#ifdef HAVE_ZLIB
+
+/// gzip decompressor, concatenated members are read as one stream
+class CGzipDecompressor : public CDecompressor {
+public:
+    CGzipDecompressor(const string& name)
+        : m_name(name)
+    {
+        m_file = gzopen(name.c_str(),"rb");
+        if( m_file == NULL ){
+            throw runtime_error("unable to open file '" + name + "'");
+        }
+        gzbuffer(m_file,DECOMPRESS_BUFFER_SIZE);
+    }
+
+    virtual ~CGzipDecompressor(void)
+    {
+        gzclose(m_file);
+    }
+
+    virtual int Read(char* p_data, int size)
+    {
+        int nread = gzread(m_file,p_data,size);
+        int errnum = Z_OK;
+        const char* p_msg = gzerror(m_file,&errnum);
+        // truncated data are reported as Z_BUF_ERROR at the end of file
+        if( (nread < 0) || ((nread == 0) && (errnum != Z_OK)) ){
+            throw runtime_error("unable to decompress file '" + m_name + "' (" + p_msg + ")");
+        }
+        return(nread);
+    }
+
+private:
+    string  m_name;
+    gzFile  m_file;
+};
+
+#endif
+
+//------------------------------------------------------------------------------
+
+#ifdef HAVE_BZIP2
+
+/// bzip2 decompressor, concatenated streams are read as one stream
+class CBzip2Decompressor : public CDecompressor {
+public:
+    CBzip2Decompressor(const string& name)
+        : m_name(name)
+    {
+        m_bzfile = NULL;
+        m_end = false;
+        m_file = fopen(name.c_str(),"rb");
+        if( m_file == NULL ){
+            throw runtime_error("unable to open file '" + name + "'");
+        }
+        OpenStream(NULL,0);
+    }
+
+    virtual ~CBzip2Decompressor(void)
+    {
+        int bzerror;
+        if( m_bzfile ) BZ2_bzReadClose(&bzerror,m_bzfile);
+        fclose(m_file);
+    }
+
+    virtual int Read(char* p_data, int size)
+    {
+        while( ! m_end ){
+            int bzerror;
+            int nread = BZ2_bzRead(&bzerror,m_bzfile,p_data,size);
+            if( bzerror == BZ_STREAM_END ){
+                NextStream();
+                if( nread > 0 ) return(nread);
+                continue;
+            }
+            if( bzerror != BZ_OK ){
+                throw runtime_error("unable to decompress file '" + m_name
+                                    + "' (corrupted bzip2 data)");
+            }
+            return(nread);
+        }
+        return(0);
+    }
+
+private:
+    string  m_name;
+    FILE*   m_file;
+    BZFILE* m_bzfile;
+    bool    m_end;
+
+    void OpenStream(void* p_unused, int nunused)
+    {
+        int bzerror;
+        m_bzfile = BZ2_bzReadOpen(&bzerror,m_file,0,0,p_unused,nunused);
+        if( bzerror != BZ_OK ){
+            throw runtime_error("unable to decompress file '" + m_name + "'");
+        }
+    }
+
+    /// continue with the next stream if there is any
+    void NextStream(void)
+    {
+        int     bzerror;
+        void*   p_unused;
+        int     nunused;
+        BZ2_bzReadGetUnused(&bzerror,m_bzfile,&p_unused,&nunused);
+
+        vector<char> unused((char*)p_unused,(char*)p_unused + nunused);
+        BZ2_bzReadClose(&bzerror,m_bzfile);
+        m_bzfile = NULL;
+
+        if( unused.empty() ){
+            int c = fgetc(m_file);
+            if( c == EOF ){
+                m_end = true;
+                return;
+            }
+            ungetc(c,m_file);
+        }
+        OpenStream(unused.empty() ? NULL : &unused[0],unused.size());
+    }
+};
+
+#endif
+
+//------------------------------------------------------------------------------
+
+#ifdef HAVE_ZSTD
+
+/// zstd decompressor, concatenated frames are read as one stream
+class CZstdDecompressor : public CDecompressor {
+public:
+    CZstdDecompressor(const string& name)
+        : m_name(name)
+    {
+        m_file = fopen(name.c_str(),"rb");
+        if( m_file == NULL ){
+            throw runtime_error("unable to open file '" + name + "'");
+        }
+        m_stream = ZSTD_createDStream();
+        if( m_stream == NULL ){
+            fclose(m_file);
+            throw runtime_error("unable to decompress file '" + name + "'");
+        }
+        ZSTD_initDStream(m_stream);
+        m_data.resize(ZSTD_DStreamInSize());
+        m_input.src = &m_data[0];
+        m_input.size = 0;
+        m_input.pos = 0;
+        m_frame_end = true;
+    }
+
+    virtual ~CZstdDecompressor(void)
+    {
+        ZSTD_freeDStream(m_stream);
+        fclose(m_file);
+    }
+
+    virtual int Read(char* p_data, int size)
+    {
+        ZSTD_outBuffer output;
+        output.dst = p_data;
+        output.size = size;
+        output.pos = 0;
+
+        while( output.pos == 0 ){
+            if( m_input.pos == m_input.size ){
+                m_input.size = fread(&m_data[0],1,m_data.size(),m_file);
+                m_input.pos = 0;
+                if( m_input.size == 0 ){
+                    if( ferror(m_file) || ! m_frame_end ){
+                        throw runtime_error("unable to decompress file '" + m_name
+                                            + "' (truncated zstd data)");
+                    }
+                    return(0);
+                }
+            }
+            size_t ret = ZSTD_decompressStream(m_stream,&output,&m_input);
+            if( ZSTD_isError(ret) ){
+                throw runtime_error("unable to decompress file '" + m_name
+                                    + "' (" + ZSTD_getErrorName(ret) + ")");
+            }
+            // zero is returned when a frame is completely decoded and flushed
+            m_frame_end = ret == 0;
+        }
+        return(output.pos);
+    }
+
+private:
+    string          m_name;
+    FILE*           m_file;
+    ZSTD_DStream*   m_stream;
+    vector<char>    m_data;
+    ZSTD_inBuffer   m_input;
+    bool            m_frame_end;
+};
+
+#endif
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+/// stream buffer with decompressed data
+/*!
+ Data are decompressed into two alternating blocks. If threads are available,
+ the next block is decompressed by a background thread while the current
+ block is being parsed.
+*/
+
+class CDecompressBuffer : public streambuf {
+public:
+    CDecompressBuffer(CDecompressor* p_decomp)
+    {
+        m_p_decomp = p_decomp;
+        m_current = -1;
+        m_at_end = false;
+        for(int i=0; i < 2; i++){
+            m_blocks[i].data.resize(DECOMPRESS_BUFFER_SIZE);
+            m_blocks[i].size = 0;
+            m_blocks[i].filled = false;
+        }
+#ifdef HAVE_PTHREADS
+        m_stop = false;
+        pthread_mutex_init(&m_mutex,NULL);
+        pthread_cond_init(&m_cond,NULL);
+        m_running = pthread_create(&m_thread,NULL,ThreadMain,this) == 0;
+#endif
+    }
+
+    virtual ~CDecompressBuffer(void)
+    {
+#ifdef HAVE_PTHREADS
+        if( m_running ){
+            pthread_mutex_lock(&m_mutex);
+            m_stop = true;
+            pthread_cond_broadcast(&m_cond);
+            pthread_mutex_unlock(&m_mutex);
+            pthread_join(m_thread,NULL);
+        }
+        pthread_cond_destroy(&m_cond);
+        pthread_mutex_destroy(&m_mutex);
+#endif
+        delete m_p_decomp;
+    }
+
+protected:
+    virtual int_type underflow(void)
+    {
+        if( gptr() < egptr() ) return( traits_type::to_int_type(*gptr()) );
+        if( m_at_end ) return( traits_type::eof() );
+
+        SBlock* p_block = NextBlock();
+        if( p_block->size == 0 ){
+            m_at_end = true;
+            setg(NULL,NULL,NULL);
+            if( ! p_block->error.empty() ) throw runtime_error(p_block->error);
+            return( traits_type::eof() );
+        }
+        char* p_data = &p_block->data[0];
+        setg(p_data,p_data,p_data + p_block->size);
+        return( traits_type::to_int_type(*gptr()) );
+    }
+
+// section of private data -----------------------------------------------------
+private:
+    struct SBlock {
+        vector<char>    data;
+        int             size;
+        bool            filled;
+        string          error;
+    };
+
+    CDecompressor*  m_p_decomp;
+    SBlock          m_blocks[2];
+    int             m_current;
+    bool            m_at_end;
+
+    /// decompress data into the block, empty block marks the end of data
+    void Fill(SBlock* p_block)
+    {
+        try {
+            p_block->size = m_p_decomp->Read(&p_block->data[0],p_block->data.size());
+        } catch(std::exception& e) {
+            p_block->size = 0;
+            p_block->error = e.what();
+        }
+    }
+
+#ifdef HAVE_PTHREADS
+    pthread_t       m_thread;
+    pthread_mutex_t m_mutex;
+    pthread_cond_t  m_cond;
+    bool            m_running;
+    bool            m_stop;
+
+    static void* ThreadMain(void* p_arg)
+    {
+        static_cast<CDecompressBuffer*>(p_arg)->Produce();
+        return(NULL);
+    }
+
+    /// fill blocks in turn until the end of data
+    void Produce(void)
+    {
+        int index = 0;
+        for(;;){
+            SBlock* p_block = &m_blocks[index];
+
+            pthread_mutex_lock(&m_mutex);
+            while( p_block->filled && ! m_stop ) pthread_cond_wait(&m_cond,&m_mutex);
+            bool stop = m_stop;
+            pthread_mutex_unlock(&m_mutex);
+            if( stop ) return;
+
+            Fill(p_block);
+
+            pthread_mutex_lock(&m_mutex);
+            p_block->filled = true;
+            pthread_cond_broadcast(&m_cond);
+            pthread_mutex_unlock(&m_mutex);
+
+            if( p_block->size == 0 ) return;
+            index ^= 1;
+        }
+    }
+#endif
+
+    /// release the current block and wait for the next one
+    SBlock* NextBlock(void)
+    {
+#ifdef HAVE_PTHREADS
+        if( m_running ){
+            pthread_mutex_lock(&m_mutex);
+            if( m_current >= 0 ){
+                m_blocks[m_current].filled = false;
+                pthread_cond_broadcast(&m_cond);
+                m_current ^= 1;
+            } else {
+                m_current = 0;
+            }
+            while( ! m_blocks[m_current].filled ) pthread_cond_wait(&m_cond,&m_mutex);
+            pthread_mutex_unlock(&m_mutex);
+            return( &m_blocks[m_current] );
+        }
+#endif
+        m_current = 0;
+        Fill(&m_blocks[0]);
+        return( &m_blocks[0] );
+    }
+};
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+/// destination of written data
+class CSink {
+public:
+    virtual ~CSink(void) {}
+
+    /// write size bytes, throw on error
+    virtual void Write(const char* p_data, int size) = 0;
+
+    /// finish data and close the file, throw on error
+    virtual void Finish(void) = 0;
+};
+
+//------------------------------------------------------------------------------
+
+/// uncompressed file
+class CPlainSink : public CSink {
+public:
+    CPlainSink(const string& name, FILE* p_file)
+        : m_name(name)
+    {
+        m_file = p_file;
+        // blocks are already large, stdio buffering would only copy them
+        setvbuf(m_file,NULL,_IONBF,0);
+    }
+
+    virtual ~CPlainSink(void)
+    {
+        if( m_file ) fclose(m_file);
+    }
+
+    virtual void Write(const char* p_data, int size)
+    {
+        if( fwrite(p_data,1,size,m_file) != (size_t)size ){
+            throw runtime_error("unable to write file '" + m_name + "' (" + strerror(errno) + ")");
+        }
+    }
+
+    virtual void Finish(void)
+    {
+        FILE* p_file = m_file;
+        m_file = NULL;
+        if( fclose(p_file) != 0 ){
+            throw runtime_error("unable to write file '" + m_name + "' (" + strerror(errno) + ")");
+        }
+    }
+
+private:
+    string  m_name;
+    FILE*   m_file;
+};
+
+//------------------------------------------------------------------------------
+
+#ifdef HAVE_ZLIB
+
+/// gzip compressed file
+class CGzipSink : public CSink {
+public:
+    CGzipSink(const string& name)
+        : m_name(name)
+    {
+        m_file = gzopen(name.c_str(),"wb");
+        if( m_file == NULL ) throw runtime_error("unable to open file '" + name + "'");
+        gzbuffer(m_file,WRITE_BUFFER_SIZE);
+    }
+
+    virtual ~CGzipSink(void)
+    {
+        if( m_file ) gzclose(m_file);
+    }
+
+    virtual void Write(const char* p_data, int size)
+    {
+        if( gzwrite(m_file,p_data,size) != size ){
+            throw runtime_error("unable to write compressed file '" + m_name + "'");
+        }
+    }
+
+    virtual void Finish(void)
+    {
+        gzFile file = m_file;
+        m_file = NULL;
+        if( gzclose(file) != Z_OK ){
+            throw runtime_error("unable to write compressed file '" + m_name + "'");
+        }
+    }
+
+private:
+    string  m_name;
+    gzFile  m_file;
+};
+
+#endif
+
+//------------------------------------------------------------------------------
+
+#ifdef HAVE_BZIP2
+
+/// bzip2 compressed file
+class CBzip2Sink : public CSink {
+public:
+    CBzip2Sink(const string& name)
+        : m_name(name)
+    {
+        m_file = fopen(name.c_str(),"wb");
+        if( m_file == NULL ) throw runtime_error("unable to open file '" + name + "'");
+        int bzerror;
+        m_bzfile = BZ2_bzWriteOpen(&bzerror,m_file,9,0,0);
+        if( bzerror != BZ_OK ){
+            fclose(m_file);
+            throw runtime_error("unable to compress file '" + name + "'");
+        }
+    }
+
+    virtual ~CBzip2Sink(void)
+    {
+        if( m_bzfile ){
+            int bzerror;
+            BZ2_bzWriteClose(&bzerror,m_bzfile,1,NULL,NULL);
+            fclose(m_file);
+        }
+    }
+
+    virtual void Write(const char* p_data, int size)
+    {
+        int bzerror;
+        BZ2_bzWrite(&bzerror,m_bzfile,const_cast<char*>(p_data),size);
+        if( bzerror != BZ_OK ){
+            throw runtime_error("unable to write compressed file '" + m_name + "'");
+        }
+    }
+
+    virtual void Finish(void)
+    {
+        int bzerror;
+        BZ2_bzWriteClose(&bzerror,m_bzfile,0,NULL,NULL);
+        m_bzfile = NULL;
+        bool ok = bzerror == BZ_OK;
+        ok &= fclose(m_file) == 0;
+        m_file = NULL;
+        if( ! ok ){
+            throw runtime_error("unable to write compressed file '" + m_name + "'");
+        }
+    }
+
+private:
+    string  m_name;
+    FILE*   m_file;
+    BZFILE* m_bzfile;
+};
+
+#endif
+
+//------------------------------------------------------------------------------
+
+#ifdef HAVE_ZSTD
+
+/// zstd compressed file
+class CZstdSink : public CSink {
+public:
+    CZstdSink(const string& name)
+        : m_name(name)
+    {
+        m_file = fopen(name.c_str(),"wb");
+        if( m_file == NULL ) throw runtime_error("unable to open file '" + name + "'");
+        m_stream = ZSTD_createCStream();
+        if( (m_stream == NULL) || ZSTD_isError(ZSTD_initCStream(m_stream,ZSTD_CLEVEL_DEFAULT)) ){
+            ZSTD_freeCStream(m_stream);
+            fclose(m_file);
+            throw runtime_error("unable to compress file '" + name + "'");
+        }
+        m_data.resize(ZSTD_CStreamOutSize());
+    }
+
+    virtual ~CZstdSink(void)
+    {
+        if( m_stream ){
+            ZSTD_freeCStream(m_stream);
+            fclose(m_file);
+        }
+    }
+
+    virtual void Write(const char* p_data, int size)
+    {
+        ZSTD_inBuffer input;
+        input.src = p_data;
+        input.size = size;
+        input.pos = 0;
+        while( input.pos < input.size ){
+            ZSTD_outBuffer output = GetOutput();
+            size_t ret = ZSTD_compressStream(m_stream,&output,&input);
+            if( ZSTD_isError(ret) ) ThrowWriteError();
+            WriteOutput(output);
+        }
+    }
+
+    virtual void Finish(void)
+    {
+        size_t ret;
+        do {
+            ZSTD_outBuffer output = GetOutput();
+            ret = ZSTD_endStream(m_stream,&output);
+            if( ZSTD_isError(ret) ) ThrowWriteError();
+            WriteOutput(output);
+        } while( ret > 0 );
+
+        ZSTD_freeCStream(m_stream);
+        m_stream = NULL;
+        bool ok = fclose(m_file) == 0;
+        m_file = NULL;
+        if( ! ok ) ThrowWriteError();
+    }
+
+private:
+    string          m_name;
+    FILE*           m_file;
+    ZSTD_CStream*   m_stream;
+    vector<char>    m_data;
+
+    ZSTD_outBuffer GetOutput(void)
+    {
+        ZSTD_outBuffer output;
+        output.dst = &m_data[0];
+        output.size = m_data.size();
+        output.pos = 0;
+        return(output);
+    }
+
+    void WriteOutput(const ZSTD_outBuffer& output)
+    {
+        if( fwrite(output.dst,1,output.pos,m_file) != output.pos ) ThrowWriteError();
+    }
+
+    void ThrowWriteError(void)
+    {
+        throw runtime_error("unable to write compressed file '" + m_name + "'");
+    }
+};
+
+#endif
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+/// stream buffer writing data by a background thread
+/*!
+ Data are formatted into two alternating blocks. If threads are available,
+ the full block is written (and compressed) by a background thread while the
+ other block is being filled. Flushing the stream does not wait for the file,
+ all data are written and errors are reported by Close.
+*/
+
+class CWriteBuffer : public streambuf {
+public:
+    CWriteBuffer(CSink* p_sink)
+    {
+        m_p_sink = p_sink;
+        m_current = 0;
+        m_closed = false;
+        for(int i=0; i < 2; i++){
+            m_blocks[i].data.resize(WRITE_BUFFER_SIZE);
+            m_blocks[i].size = 0;
+            m_blocks[i].full = false;
+        }
+        SetBlock();
+#ifdef HAVE_PTHREADS
+        m_stop = false;
+        pthread_mutex_init(&m_mutex,NULL);
+        pthread_cond_init(&m_cond,NULL);
+        m_running = pthread_create(&m_thread,NULL,ThreadMain,this) == 0;
+#endif
+    }
+
+    virtual ~CWriteBuffer(void)
+    {
+        try {
+            Close();
+        } catch(...) {
+            // errors cannot be reported from the destructor
+        }
+#ifdef HAVE_PTHREADS
+        pthread_cond_destroy(&m_cond);
+        pthread_mutex_destroy(&m_mutex);
+#endif
+        delete m_p_sink;
+    }
+
+    /// write remaining data and close the file
+    void Close(void)
+    {
+        if( m_closed ) return;
+        m_closed = true;
+
+        Submit();
+#ifdef HAVE_PTHREADS
+        if( m_running ){
+            pthread_mutex_lock(&m_mutex);
+            m_stop = true;
+            pthread_cond_broadcast(&m_cond);
+            pthread_mutex_unlock(&m_mutex);
+            pthread_join(m_thread,NULL);
+            m_running = false;
+        }
+#endif
+        if( m_error.empty() ){
+            try {
+                m_p_sink->Finish();
+            } catch(std::exception& e) {
+                m_error = e.what();
+            }
+        }
+        if( ! m_error.empty() ) throw runtime_error(m_error);
+    }
+
+protected:
+    virtual int_type overflow(int_type c)
+    {
+        if( m_closed || ! Submit() ) return( traits_type::eof() );
+        if( ! traits_type::eq_int_type(c,traits_type::eof()) ){
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return( traits_type::not_eof(c) );
+    }
+
+    virtual int sync(void)
+    {
+        return( Failed() ? -1 : 0 );
+    }
+
+// section of private data -----------------------------------------------------
+private:
+    struct SBlock {
+        vector<char>    data;
+        int             size;
+        bool            full;
+    };
+
+    CSink*  m_p_sink;
+    SBlock  m_blocks[2];
+    int     m_current;
+    bool    m_closed;
+    string  m_error;
+
+    /// set the put area to the current block
+    void SetBlock(void)
+    {
+        char* p_data = &m_blocks[m_current].data[0];
+        setp(p_data,p_data + m_blocks[m_current].data.size());
+    }
+
+    /// write the block, the first error is recorded and later blocks are dropped
+    void Drain(SBlock* p_block)
+    {
+        if( ! Failed() ){
+            try {
+                m_p_sink->Write(&p_block->data[0],p_block->size);
+            } catch(std::exception& e) {
+                SetError(e.what());
+            }
+        }
+        p_block->size = 0;
+    }
+
+#ifdef HAVE_PTHREADS
+    pthread_t       m_thread;
+    pthread_mutex_t m_mutex;
+    pthread_cond_t  m_cond;
+    bool            m_running;
+    bool            m_stop;
+
+    static void* ThreadMain(void* p_arg)
+    {
+        static_cast<CWriteBuffer*>(p_arg)->Consume();
+        return(NULL);
+    }
+
+    /// write blocks in turn until the buffer is closed
+    void Consume(void)
+    {
+        int index = 0;
+        for(;;){
+            SBlock* p_block = &m_blocks[index];
+
+            pthread_mutex_lock(&m_mutex);
+            while( ! p_block->full && ! m_stop ) pthread_cond_wait(&m_cond,&m_mutex);
+            bool full = p_block->full;
+            pthread_mutex_unlock(&m_mutex);
+            if( ! full ) return;
+
+            Drain(p_block);
+
+            pthread_mutex_lock(&m_mutex);
+            p_block->full = false;
+            pthread_cond_broadcast(&m_cond);
+            pthread_mutex_unlock(&m_mutex);
+
+            index ^= 1;
+        }
+    }
+#endif
+
+    /// pass the current block to the writer and continue with the other one
+    bool Submit(void)
+    {
+        SBlock* p_block = &m_blocks[m_current];
+        p_block->size = pptr() - pbase();
+        if( p_block->size > 0 ){
+#ifdef HAVE_PTHREADS
+            if( m_running ){
+                pthread_mutex_lock(&m_mutex);
+                p_block->full = true;
+                pthread_cond_broadcast(&m_cond);
+                m_current ^= 1;
+                while( m_blocks[m_current].full ) pthread_cond_wait(&m_cond,&m_mutex);
+                pthread_mutex_unlock(&m_mutex);
+            } else {
+                Drain(p_block);
+            }
+#else
+            Drain(p_block);
+#endif
+        }
+        SetBlock();
+        return( ! Failed() );
+    }
+
+    /// has writing failed?
+    bool Failed(void)
+    {
+#ifdef HAVE_PTHREADS
+        pthread_mutex_lock(&m_mutex);
+        bool failed = ! m_error.empty();
+        pthread_mutex_unlock(&m_mutex);
+        return(failed);
+#else
+        return( ! m_error.empty() );
+#endif
+    }
+
+    /// record the first error
+    void SetError(const string& error)
+    {
+#ifdef HAVE_PTHREADS
+        pthread_mutex_lock(&m_mutex);
+        if( m_error.empty() ) m_error = error;
+        pthread_mutex_unlock(&m_mutex);
+#else
+        if( m_error.empty() ) m_error = error;
+#endif
+    }
+};
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CInputFile::CInputFile(void)
+    : istream(NULL)
+{
+    m_p_decompress = NULL;
+    rdbuf(&m_file);
+}
+
+//------------------------------------------------------------------------------
+
+CInputFile::CInputFile(const string& name, ios_base::openmode mode)
+    : istream(NULL)
+{
+    m_p_decompress = NULL;
+    rdbuf(&m_file);
+    Open(name,mode);
+}
+
+//------------------------------------------------------------------------------
+
+CInputFile::~CInputFile(void)
+{
+    delete m_p_decompress;
+}
+
+//------------------------------------------------------------------------------
+
+void CInputFile::Open(const string& name, ios_base::openmode mode)
+{
+    Close();
+
+    CDecompressor* p_decomp = NULL;
+    switch( DetectCompression(name) ){
+        case compression_none:
+            if( m_file.open(name.c_str(),mode | ios_base::in) == NULL ){
+                setstate(ios_base::failbit);
+            }
+            return;
+        case compression_gzip:
+#ifdef HAVE_ZLIB
+            p_decomp = new CGzipDecompressor(name);
+            break;
+#else
+            ThrowUnsupported(name,"gzip");
+#endif
+        case compression_bzip2:
+#ifdef HAVE_BZIP2
+            p_decomp = new CBzip2Decompressor(name);
+            break;
+#else
+            ThrowUnsupported(name,"bzip2");
+#endif
+        case compression_zstd:
+#ifdef HAVE_ZSTD
+            p_decomp = new CZstdDecompressor(name);
+            break;
+#else
+            ThrowUnsupported(name,"zstd");
+#endif
+    }
+
+    m_p_decompress = new CDecompressBuffer(p_decomp);
+    rdbuf(m_p_decompress);
+    // decompression errors are thrown from the buffer
+    exceptions(ios_base::badbit);
+}
+
+//------------------------------------------------------------------------------
+
+void CInputFile::Close(void)
+{
+    exceptions(ios_base::goodbit);
+    if( m_p_decompress ){
+        rdbuf(&m_file);
+        delete m_p_decompress;
+        m_p_decompress = NULL;
+    }
+    m_file.close();
+    clear();
+}
+
+//------------------------------------------------------------------------------
+
+bool CInputFile::IsCompressed(void) const
+{
+    return( m_p_decompress != NULL );
+}
+
+//------------------------------------------------------------------------------
+
+bool CInputFile::Exists(const string& name)
+{
+    FILE* p_file = fopen(name.c_str(),"rb");
+    if( p_file == NULL ) return(false);
+    fclose(p_file);
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+ECompression CInputFile::DetectCompression(const string& name)
+{
+    unsigned char magic[4];
+    memset(magic,0,sizeof(magic));
+
+    FILE* p_file = fopen(name.c_str(),"rb");
+    if( p_file == NULL ) return(compression_none);
+    size_t nread = fread(magic,1,sizeof(magic),p_file);
+    fclose(p_file);
+
+    if( (nread >= 2) && (magic[0] == 0x1f) && (magic[1] == 0x8b) ) return(compression_gzip);
+    if( (nread >= 3) && (magic[0] == 'B') && (magic[1] == 'Z') && (magic[2] == 'h') ) return(compression_bzip2);
+    if( (nread >= 4) && (magic[0] == 0x28) && (magic[1] == 0xb5)
+        && (magic[2] == 0x2f) && (magic[3] == 0xfd) ) return(compression_zstd);
+    return(compression_none);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+COutputFile::COutputFile(void)
+    : ostream(NULL)
+{
+    m_p_buffer = NULL;
+    m_compression = compression_none;
+}
+
+//------------------------------------------------------------------------------
+
+COutputFile::COutputFile(const string& name, ios_base::openmode mode)
+    : ostream(NULL)
+{
+    m_p_buffer = NULL;
+    m_compression = compression_none;
+    Open(name,mode);
+}
+
+//------------------------------------------------------------------------------
+
+COutputFile::~COutputFile(void)
+{
+    rdbuf(NULL);
+    delete m_p_buffer;
+}
+
+//------------------------------------------------------------------------------
+
+void COutputFile::Open(const string& name, ios_base::openmode mode)
+{
+    Close();
+
+    CSink* p_sink = NULL;
+    ECompression compression = GetCompression(name);
+    switch( compression ){
+        case compression_none: {
+            FILE* p_file = fopen(name.c_str(),(mode & ios_base::app) ? "ab" : "wb");
+            if( p_file == NULL ){
+                setstate(ios_base::failbit);
+                return;
+            }
+            p_sink = new CPlainSink(name,p_file);
+            }
+            break;
+        case compression_gzip:
+#ifdef HAVE_ZLIB
+            p_sink = new CGzipSink(name);
+            break;
+#else
+            ThrowUnsupported(name,"gzip");
+#endif
+        case compression_bzip2:
+#ifdef HAVE_BZIP2
+            p_sink = new CBzip2Sink(name);
+            break;
+#else
+            ThrowUnsupported(name,"bzip2");
+#endif
+        case compression_zstd:
+#ifdef HAVE_ZSTD
+            p_sink = new CZstdSink(name);
+            break;
+#else
+            ThrowUnsupported(name,"zstd");
+#endif
+    }
+
+    m_p_buffer = new CWriteBuffer(p_sink);
+    m_compression = compression;
+    rdbuf(m_p_buffer);
+}
+
+//------------------------------------------------------------------------------
+
+void COutputFile::Close(void)
+{
+    if( m_p_buffer == NULL ) return;
+
+    flush();
+    CWriteBuffer* p_buffer = m_p_buffer;
+    m_p_buffer = NULL;
+    m_compression = compression_none;
+    rdbuf(NULL);
+    try {
+        p_buffer->Close();
+    } catch(...) {
+        delete p_buffer;
+        throw;
+    }
+    delete p_buffer;
+}
+
+//------------------------------------------------------------------------------
+
+bool COutputFile::IsCompressed(void) const
+{
+    return( m_compression != compression_none );
+}
+
+//------------------------------------------------------------------------------
+
+ECompression COutputFile::GetCompression(const string& name)
+{
+    if( HasSuffix(name,".gz") ) return(compression_gzip);
+    if( HasSuffix(name,".bz2") ) return(compression_bzip2);
+    if( HasSuffix(name,".zst") ) return(compression_zstd);
+    return(compression_none);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+}
@@ -0,0 +1,125 @@
+#ifndef NLEAP_FORMAT_FILE_STREAM_HPP
+#define NLEAP_FORMAT_FILE_STREAM_HPP
+// =============================================================================
+// nLEaP - prepare input for the AMBER molecular mechanics programs
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2011 Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2006 gLEaP authors, see AUTHORS file in the main directory
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <NLEaPMainHeader.hpp>
+#include <iostream>
+#include <fstream>
+#include <string>
+
+namespace nleap {
+//------------------------------------------------------------------------------
+
+using namespace std;
+
+class CDecompressBuffer;
+class CWriteBuffer;
+
+//------------------------------------------------------------------------------
+
+/// compression of files
+enum ECompression {
+    compression_none,
+    compression_gzip,       // .gz
+    compression_bzip2,      // .bz2
+    compression_zstd        // .zst
+};
+
+//------------------------------------------------------------------------------
+
+/// input file, compressed files are transparently decompressed
+/*!
+ Compression is detected from the file content. Compressed data are
+ decompressed by a background thread into two alternating buffers, the parser
+ reads one buffer while the other one is being filled. Decompression errors
+ are thrown as runtime_error from the stream operations.
+*/
+
+class NLEAP_PACKAGE CInputFile : public istream {
+public:
+    CInputFile(void);
+    CInputFile(const string& name, ios_base::openmode mode = ios_base::in);
+    virtual ~CInputFile(void);
+
+    /// open file, failbit is set if the file cannot be opened
+    void Open(const string& name, ios_base::openmode mode = ios_base::in);
+
+    /// close file
+    void Close(void);
+
+    /// is the file compressed?
+    bool IsCompressed(void) const;
+
+    /// does the file exist?
+    static bool Exists(const string& name);
+
+    /// detect compression from the file content
+    static ECompression DetectCompression(const string& name);
+
+// section of private data -----------------------------------------------------
+private:
+    filebuf             m_file;
+    CDecompressBuffer*  m_p_decompress;
+};
+
+//------------------------------------------------------------------------------
+
+/// output file, the file is compressed if its extension asks for it
+/*!
+ Data are written to the file (and compressed) by a background thread while
+ the next block is being formatted. Flushing the stream does not wait for the
+ file, data are complete and write errors are reported after Close.
+*/
+
+class NLEAP_PACKAGE COutputFile : public ostream {
+public:
+    COutputFile(void);
+    COutputFile(const string& name, ios_base::openmode mode = ios_base::out);
+    virtual ~COutputFile(void);
+
+    /// open file, failbit is set if the file cannot be opened
+    void Open(const string& name, ios_base::openmode mode = ios_base::out);
+
+    /// write remaining data and close file, runtime_error is thrown if data cannot be written
+    void Close(void);
+
+    /// is the file compressed?
+    bool IsCompressed(void) const;
+
+    /// get compression from the file name extension
+    static ECompression GetCompression(const string& name);
+
+// section of private data -----------------------------------------------------
+private:
+    CWriteBuffer*       m_p_buffer;
+    ECompression        m_compression;
+};
+
+//------------------------------------------------------------------------------
+
+/// suffixes of compressed files searched for by CContext::FindFile, NULL terminated
+extern NLEAP_PACKAGE const char* CompressedSuffixes[];
+
+//------------------------------------------------------------------------------
+}
+
+#endif
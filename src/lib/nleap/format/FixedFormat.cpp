@@ -0,0 +1,420 @@
+// =============================================================================
+// nLEaP - prepare input for the AMBER molecular mechanics programs
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2011 Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2006 gLEaP authors, see AUTHORS file in the main directory
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <format/FixedFormat.hpp>
+#include <stdexcept>
+#include <ostream>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <cfloat>
+
+namespace nleap {
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+// exponents, for which powers of ten are exact
+#define MAX_EXACT_EXPONENT  22
+// scaled values are converted to integers exactly below this limit (2^42)
+#define MAX_FAST_SCALED     4398046511104.0
+// fractions closer to one half are rounded by the C library (2^-9)
+#define TIE_DISTANCE        0.001953125
+// decimal digits of fixed notation, which are converted exactly
+#define MAX_FIXED_DIGITS    15
+// mantissa digits of exponential notation, which are converted exactly
+#define MAX_EXP_DIGITS      12
+// the largest supported precision
+#define MAX_PRECISION       64
+// the longest field produced by snprintf, DBL_MAX has 309 digits
+#define MAX_FALLBACK_SIZE   (320 + MAX_PRECISION)
+
+static const double g_pow10[MAX_EXACT_EXPONENT+1] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+//------------------------------------------------------------------------------
+
+/// is the sign bit set, including negative zero?
+static inline bool IsNegative( double value )
+{
+    return( (value < 0.0) || ((value == 0.0) && (1.0/value < 0.0)) );
+}
+
+//------------------------------------------------------------------------------
+
+/// write digits of the number, exactly ndigits are written if ndigits > 0
+static inline char* PutDigits( char* p_dest, unsigned long long value, int ndigits )
+{
+    char    digits[24];
+    int     n = 0;
+    do {
+        digits[n++] = '0' + (char)(value % 10);
+        value /= 10;
+    } while( (value != 0) || (n < ndigits) );
+    while( n > 0 ) *p_dest++ = digits[--n];
+    return( p_dest );
+}
+
+//------------------------------------------------------------------------------
+
+/// right justify len characters written at p_begin within the field width
+static inline char* Justify( char* p_begin, size_t len, int width )
+{
+    if( (int)len < width ){
+        size_t pad = width - len;
+        memmove( p_begin + pad, p_begin, len );
+        memset( p_begin, ' ', pad );
+        len = width;
+    }
+    return( p_begin + len );
+}
+
+//------------------------------------------------------------------------------
+
+/// round scaled value to integer, false if it is too close to a tie
+static inline bool RoundScaled( double scaled, unsigned long long& value )
+{
+    double whole = floor( scaled );
+    double frac = scaled - whole;
+    if( fabs( frac - 0.5 ) < TIE_DISTANCE ) return( false );
+    value = (unsigned long long)whole;
+    if( frac > 0.5 ) value++;
+    return( true );
+}
+
+//------------------------------------------------------------------------------
+
+static char* Fallback( char* p_dest, const char* p_format, int width, int precision, double value )
+{
+    char buffer[MAX_FALLBACK_SIZE+1];
+    int  len = snprintf( buffer, sizeof(buffer), p_format, 0, precision, value );
+    if( (len < 0) || (len > MAX_FALLBACK_SIZE) ){
+        throw runtime_error( "unable to format real number" );
+    }
+    memcpy( p_dest, buffer, len );
+    return( Justify( p_dest, len, width ) );
+}
+
+//------------------------------------------------------------------------------
+
+/// is the value with index i the last one on the line?
+static inline bool IsLineEnd( size_t i, size_t n, int per_line )
+{
+    return( (i + 1 == n) || ((per_line > 0) && ((i + 1) % per_line == 0)) );
+}
+
+//------------------------------------------------------------------------------
+
+static void CheckPrecision( int precision )
+{
+    if( (precision < 0) || (precision > MAX_PRECISION) ){
+        throw runtime_error( "unsupported precision of real number" );
+    }
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+char* CFixedFormat::Int( char* p_dest, int value, int width )
+{
+    char*               p_pos = p_dest;
+    unsigned long long  number = value;
+    if( value < 0 ){
+        *p_pos++ = '-';
+        number = - (long long)value;
+    }
+    p_pos = PutDigits( p_pos, number, 0 );
+    return( Justify( p_dest, p_pos - p_dest, width ) );
+}
+
+//------------------------------------------------------------------------------
+
+char* CFixedFormat::Fixed( char* p_dest, double value, int width, int precision )
+{
+    CheckPrecision( precision );
+
+    double              abs_value = fabs( value );
+    unsigned long long  number;
+
+    // scaling by exact power of ten is a single correctly rounded operation
+    if( (precision > MAX_FIXED_DIGITS) || ! (abs_value < MAX_FAST_SCALED / g_pow10[precision])
+        || ! RoundScaled( abs_value * g_pow10[precision], number ) ){
+        return( Fallback( p_dest, "%*.*f", width, precision, value ) );
+    }
+
+    char* p_pos = p_dest;
+    if( IsNegative( value ) ) *p_pos++ = '-';
+
+    unsigned long long scale = (unsigned long long)g_pow10[precision];
+    p_pos = PutDigits( p_pos, number / scale, 0 );
+    if( precision > 0 ){
+        *p_pos++ = '.';
+        p_pos = PutDigits( p_pos, number % scale, precision );
+    }
+    return( Justify( p_dest, p_pos - p_dest, width ) );
+}
+
+//------------------------------------------------------------------------------
+
+char* CFixedFormat::Exp( char* p_dest, double value, int width, int precision )
+{
+    CheckPrecision( precision );
+
+    double              abs_value = fabs( value );
+    unsigned long long  number = 0;
+    int                 exponent = 0;
+
+    // mantissa digits must be exactly convertible
+    if( (precision + 1 > MAX_EXP_DIGITS) || ! (abs_value <= DBL_MAX) ){
+        return( Fallback( p_dest, "%*.*E", width, precision, value ) );
+    }
+
+    if( abs_value != 0.0 ){
+
+        // log10 may be wrong by one close to powers of ten
+        exponent = (int)floor( log10( abs_value ) );
+        double scaled = 0.0;
+        for(int i=0; i < 3; i++){
+            int shift = precision - exponent;
+            if( (shift > MAX_EXACT_EXPONENT) || (shift < -MAX_EXACT_EXPONENT) ){
+                return( Fallback( p_dest, "%*.*E", width, precision, value ) );
+            }
+            scaled = shift >= 0 ? abs_value * g_pow10[shift] : abs_value / g_pow10[-shift];
+            if( scaled >= g_pow10[precision+1] ){
+                exponent++;
+            } else if( scaled < g_pow10[precision] ){
+                exponent--;
+            } else {
+                break;
+            }
+        }
+        if( (scaled >= g_pow10[precision+1]) || (scaled < g_pow10[precision])
+            || ! RoundScaled( scaled, number ) ){
+            return( Fallback( p_dest, "%*.*E", width, precision, value ) );
+        }
+        // rounding up to the next power of ten
+        if( number == (unsigned long long)g_pow10[precision+1] ){
+            number /= 10;
+            exponent++;
+        }
+    }
+
+    char* p_pos = p_dest;
+    if( IsNegative( value ) ) *p_pos++ = '-';
+
+    unsigned long long scale = (unsigned long long)g_pow10[precision];
+    *p_pos++ = '0' + (char)(number / scale);
+    if( precision > 0 ){
+        *p_pos++ = '.';
+        p_pos = PutDigits( p_pos, number % scale, precision );
+    }
+    *p_pos++ = 'E';
+    *p_pos++ = exponent < 0 ? '-' : '+';
+    p_pos = PutDigits( p_pos, exponent < 0 ? -exponent : exponent, 2 );
+    return( Justify( p_dest, p_pos - p_dest, width ) );
+}
+
+//------------------------------------------------------------------------------
+
+char* CFixedFormat::Left( char* p_dest, const string& value, int width )
+{
+    memcpy( p_dest, value.data(), value.size() );
+    char* p_pos = p_dest + value.size();
+    while( p_pos < p_dest + width ) *p_pos++ = ' ';
+    return( p_pos );
+}
+
+//------------------------------------------------------------------------------
+
+char* CFixedFormat::Right( char* p_dest, const string& value, int width )
+{
+    memcpy( p_dest, value.data(), value.size() );
+    return( Justify( p_dest, value.size(), width ) );
+}
+
+//------------------------------------------------------------------------------
+
+size_t CFixedFormat::MaxFieldSize( int width, int precision )
+{
+    size_t size = MAX_FALLBACK_SIZE;
+    if( precision < MAX_PRECISION ) size -= MAX_PRECISION - precision;
+    if( width > (int)size ) size = width;
+    return( size );
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CFormatBuffer::CFormatBuffer(void)
+{
+    m_size = 0;
+}
+
+//------------------------------------------------------------------------------
+
+char* CFormatBuffer::Reserve( size_t size )
+{
+    // one spare character keeps the end position valid for empty fields
+    if( m_data.size() < m_size + size + 1 ){
+        size_t capacity = 2*m_data.size();
+        if( capacity < m_size + size + 1 ) capacity = m_size + size + 1;
+        m_data.resize( capacity );
+    }
+    return( &m_data[m_size] );
+}
+
+//------------------------------------------------------------------------------
+
+void CFormatBuffer::Commit( char* p_end )
+{
+    m_size = p_end - &m_data[0];
+}
+
+//------------------------------------------------------------------------------
+
+void CFormatBuffer::Int( int value, int width )
+{
+    Commit( CFixedFormat::Int( Reserve( CFixedFormat::MaxFieldSize( width, 0 ) ), value, width ) );
+}
+
+//------------------------------------------------------------------------------
+
+void CFormatBuffer::Fixed( double value, int width, int precision )
+{
+    char* p_dest = Reserve( CFixedFormat::MaxFieldSize( width, precision ) );
+    Commit( CFixedFormat::Fixed( p_dest, value, width, precision ) );
+}
+
+//------------------------------------------------------------------------------
+
+void CFormatBuffer::Exp( double value, int width, int precision )
+{
+    char* p_dest = Reserve( CFixedFormat::MaxFieldSize( width, precision ) );
+    Commit( CFixedFormat::Exp( p_dest, value, width, precision ) );
+}
+
+//------------------------------------------------------------------------------
+
+void CFormatBuffer::Left( const string& value, int width )
+{
+    size_t size = (int)value.size() < width ? width : value.size();
+    Commit( CFixedFormat::Left( Reserve( size ), value, width ) );
+}
+
+//------------------------------------------------------------------------------
+
+void CFormatBuffer::Right( const string& value, int width )
+{
+    size_t size = (int)value.size() < width ? width : value.size();
+    Commit( CFixedFormat::Right( Reserve( size ), value, width ) );
+}
+
+//------------------------------------------------------------------------------
+
+void CFormatBuffer::Char( char c )
+{
+    *Reserve( 1 ) = c;
+    m_size++;
+}
+
+//------------------------------------------------------------------------------
+
+void CFormatBuffer::Text( const string& value )
+{
+    memcpy( Reserve( value.size() ), value.data(), value.size() );
+    m_size += value.size();
+}
+
+//------------------------------------------------------------------------------
+
+void CFormatBuffer::NewLine(void)
+{
+    Char( '\n' );
+}
+
+//------------------------------------------------------------------------------
+
+void CFormatBuffer::IntArray( const int* p_values, size_t n, int width, int per_line )
+{
+    for(size_t i=0; i < n; i++){
+        Int( p_values[i], width );
+        if( IsLineEnd( i, n, per_line ) ) NewLine();
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void CFormatBuffer::FixedArray( const double* p_values, size_t n, int width, int precision, int per_line )
+{
+    for(size_t i=0; i < n; i++){
+        Fixed( p_values[i], width, precision );
+        if( IsLineEnd( i, n, per_line ) ) NewLine();
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void CFormatBuffer::ExpArray( const double* p_values, size_t n, int width, int precision, int per_line )
+{
+    for(size_t i=0; i < n; i++){
+        Exp( p_values[i], width, precision );
+        if( IsLineEnd( i, n, per_line ) ) NewLine();
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void CFormatBuffer::Clear(void)
+{
+    m_size = 0;
+}
+
+//------------------------------------------------------------------------------
+
+const char* CFormatBuffer::GetData(void) const
+{
+    if( m_size == 0 ) return( "" );
+    return( &m_data[0] );
+}
+
+//------------------------------------------------------------------------------
+
+size_t CFormatBuffer::GetSize(void) const
+{
+    return( m_size );
+}
+
+//------------------------------------------------------------------------------
+
+void CFormatBuffer::Flush( ostream& os )
+{
+    os.write( GetData(), m_size );
+    m_size = 0;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+}
@@ -0,0 +1,144 @@
+#ifndef NLEAP_FORMAT_FIXED_FORMAT_HPP
+#define NLEAP_FORMAT_FIXED_FORMAT_HPP
+// =============================================================================
+// nLEaP - prepare input for the AMBER molecular mechanics programs
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2011 Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2006 gLEaP authors, see AUTHORS file in the main directory
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <NLEaPMainHeader.hpp>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace nleap {
+//------------------------------------------------------------------------------
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+
+/// fixed width fields rendered directly into character buffers
+/*!
+ Fields are formatted as by printf with %<width>d, %<width>.<precision>f,
+ %<width>.<precision>E and %-<width>s, including the rounding of the C library.
+ Values, which do not fit into the field, widen it as in printf. Most values
+ are converted by integer arithmetic, values close to a rounding tie and
+ values out of the exactly representable range are passed to snprintf.
+ Each method returns the position after the written field.
+*/
+
+class NLEAP_PACKAGE CFixedFormat {
+public:
+    /// %<width>d
+    static char* Int( char* p_dest, int value, int width );
+
+    /// %<width>.<precision>f
+    static char* Fixed( char* p_dest, double value, int width, int precision );
+
+    /// %<width>.<precision>E
+    static char* Exp( char* p_dest, double value, int width, int precision );
+
+    /// %-<width>s, left justified
+    static char* Left( char* p_dest, const string& value, int width );
+
+    /// %<width>s, right justified
+    static char* Right( char* p_dest, const string& value, int width );
+
+    /// maximum size of any numeric field of given width and precision
+    static size_t MaxFieldSize( int width, int precision );
+};
+
+//------------------------------------------------------------------------------
+
+/// reusable output buffer built from fixed width fields
+/*!
+ The buffer grows as needed and keeps its memory when it is cleared, thus a
+ writer reusing one buffer does not allocate memory once the buffer is large
+ enough. Arrays are wrapped into lines of given number of values, the last
+ incomplete line is terminated too, no line is written for an empty array.
+*/
+
+class NLEAP_PACKAGE CFormatBuffer {
+public:
+    CFormatBuffer(void);
+
+// fields ----------------------------------------------------------------------
+    /// %<width>d
+    void Int( int value, int width );
+
+    /// %<width>.<precision>f
+    void Fixed( double value, int width, int precision );
+
+    /// %<width>.<precision>E
+    void Exp( double value, int width, int precision );
+
+    /// %-<width>s
+    void Left( const string& value, int width );
+
+    /// %<width>s
+    void Right( const string& value, int width );
+
+    /// single character
+    void Char( char c );
+
+    /// string without padding
+    void Text( const string& value );
+
+    /// end of line
+    void NewLine(void);
+
+// arrays ----------------------------------------------------------------------
+    /// integer numbers, per_line values in each line
+    void IntArray( const int* p_values, size_t n, int width, int per_line );
+
+    /// real numbers in fixed notation, per_line values in each line
+    void FixedArray( const double* p_values, size_t n, int width, int precision, int per_line );
+
+    /// real numbers in exponential notation, per_line values in each line
+    void ExpArray( const double* p_values, size_t n, int width, int precision, int per_line );
+
+// buffer ----------------------------------------------------------------------
+    /// remove content, memory is kept
+    void Clear(void);
+
+    /// formatted characters, not null terminated
+    const char* GetData(void) const;
+
+    /// number of formatted characters
+    size_t GetSize(void) const;
+
+    /// write content to the stream and clear the buffer
+    void Flush( ostream& os );
+
+// section of private data -----------------------------------------------------
+private:
+    vector<char>    m_data;
+    size_t          m_size;
+
+    /// ensure space for size characters, return position of the end
+    char* Reserve( size_t size );
+
+    /// move the end after characters written to the reserved space
+    void Commit( char* p_end );
+};
+
+//------------------------------------------------------------------------------
+}
+
+#endif
@@ -21,10 +21,16 @@
 
 #include <format/FormatOB.hpp>
 #include <sstream>
-#include <boost/algorithm/string.hpp>
-#include <boost/format.hpp>
 #include <iomanip>
+#include <map>
+#include <ctype.h>
 #include <core/PredefinedKeys.hpp>
+#include <openbabel/mol.h>
+#include <openbabel/atom.h>
+#include <openbabel/bond.h>
+#include <openbabel/residue.h>
+#include <openbabel/data.h>
+#include <openbabel/obconversion.h>
 
 namespace nleap {
 //==============================================================================
@@ -34,282 +40,303 @@ namespace nleap {
 CFormatOB::CFormatOB( CVerboseStr& debug )
     : m_debug( debug )
 {
-    m_line_no = 0;
 }
 
 //------------------------------------------------------------------------------
 
-void CFormatOB::Read( istream& is, CUnitPtr& unit, int& top_id, const string& format )
+void CFormatOB::SetFormat( OpenBabel::OBConversion& conv, bool input, const string& format,
+                           const string& file_name )
 {
-    m_atoms = 0;
-    m_bonds = 0;
-    m_residues = 0;
+    OpenBabel::OBFormat* p_format = NULL;
 
-    if( ! unit ){
-        // invalid unit
-        throw runtime_error( "unit is NULL in CFormatOB::read" );
+    if( format == "auto" ){
+        if( ! file_name.empty() ){
+            p_format = OpenBabel::OBConversion::FormatFromExt( file_name.c_str() );
+        }
+        if( p_format == NULL ){
+            throw runtime_error( "unable to determine format of file '" + file_name + "', specify it explicitly" );
+        }
+    } else {
+        p_format = OpenBabel::OBConversion::FindFormat( format.c_str() );
+        if( p_format == NULL ){
+            throw runtime_error( "format '" + format + "' is not supported by OpenBabel" );
+        }
     }
 
-    m_atom_map.clear();
-
-    getline( is, m_line );
-    while( is ){
-        m_line_no++;
-        if( m_line.find("@<TRIPOS>MOLECULE") != string::npos ){
-            ReadHead( is, unit );
-        } else
-        if( m_line.find("@<TRIPOS>ATOM") != string::npos ){
-            ReadAtoms( is, unit, top_id );
-        } else
-        if( m_line.find("@<TRIPOS>BOND") != string::npos ){
-            ReadBonds( is, unit, top_id );
+    if( input ){
+        if( conv.SetInFormat( p_format ) == false ){
+            throw runtime_error( "format '" + format + "' cannot be used for reading" );
+        }
+    } else {
+        if( conv.SetOutFormat( p_format ) == false ){
+            throw runtime_error( "format '" + format + "' cannot be used for writing" );
         }
-
-        getline( is, m_line );
     }
-
-    // fix unit counters
-    unit->FixCounters();
 }
 
 //------------------------------------------------------------------------------
 
-void CFormatOB::ReadHead( istream& is, CUnitPtr& unit )
+int CFormatOB::GuessAtomicNumber( const string& name )
 {
-    m_debug << "> Reading molecule header ..." << endl;
-    string name, moltype, chgtype, status, comment, temp;
-
-    // line 0
-    getline( is, m_line );
-    m_line_no++;
-    unit->SetName( m_line );
-    m_debug << "  Name : " << m_line << endl;
-
-    // line 1
-    getline( is, m_line );
-    m_line_no++;
-
-    stringstream str(m_line);
-    str >> m_atoms >> m_bonds >> m_residues;
-
-    m_debug << "  Atoms = " << setw(8) << m_atoms;
-    m_debug << "  Bonds = " << setw(8) << m_bonds;
-    m_debug << "  Residues = " << setw(8) << m_residues << endl;
-
-    // line 2
-    getline( is, m_moltype );
-    m_line_no++;
-
-    // line 3
-    getline( is, m_chgtype );
-    m_line_no++;
-
-    // line 4 : optional
-    if( is.peek() != '@' ) {
-        getline( is, m_status );
-        m_line_no++;
-    }
-
-    // line 5: optional
-    if( is.peek() != '@' ) {
-        getline( is, m_comment );
-        m_line_no++;
-        if( ! empty(m_comment) ){
-            unit->Set( TITLE, m_comment );
-            m_debug << "  Comment  : " << m_comment << endl;
-        }
+    // skip leading digits, e.g. 1HB
+    size_t i = 0;
+    while( (i < name.size()) && ! isalpha(name[i]) ) i++;
+    if( i >= name.size() ) return(0);
+
+    // two letter symbols are recognized only in mixed case, e.g. Cl- but not CA
+    char symbol[3];
+    symbol[0] = toupper(name[i]);
+    symbol[1] = '\0';
+    symbol[2] = '\0';
+    if( (i + 1 < name.size()) && islower(name[i+1]) ){
+        symbol[1] = name[i+1];
+        int z = OpenBabel::etab.GetAtomicNum( symbol );
+        if( z > 0 ) return(z);
+        symbol[1] = '\0';
     }
+    return( OpenBabel::etab.GetAtomicNum( symbol ) );
 }
 
+//==============================================================================
 //------------------------------------------------------------------------------
+//==============================================================================
 
-void CFormatOB::ReadAtoms( istream& is, CUnitPtr& unit, int& top_id )
+void CFormatOB::Read( istream& is, CUnitPtr& unit, int& top_id, const string& format,
+                      const string& file_name )
 {
-    m_debug << "> Reading atoms ..." << endl;
-
-    int         natoms = 0;
-    int         nres = 0;
-    int         prev_resid = 0;
-    CResiduePtr res;
-
-    getline( is, m_line );
-    while( is ){
-        m_line_no++;
-
-        int         atid = 0;
-        string      atname;
-        double      x = 0;
-        double      y = 0;
-        double      z = 0;
-        string      type;
-        int         resid = 0;
-        string      resname;
-        double      charge = 0;
-
-        stringstream str( m_line );
-        str >> atid >> atname >> x >> y >> z >> type >> resid >> resname >> charge;
-
-        if( prev_resid < resid ){
-            prev_resid = resid;
-            // create new residue
-            res = unit->CreateResidue( resname, top_id );
-            nres++;
-        }
+    if( ! unit ){
+        // invalid unit
+        throw runtime_error( "unit is NULL in CFormatOB::read" );
+    }
 
-        if( ! res ) {
-            throw runtime_error("errr");
+    // exceptions must not leave the critical section
+    string error;
+#ifdef _OPENMP
+    #pragma omp critical(nleap_openbabel)
+#endif
+    {
+        try {
+            ReadMolecule( is, unit, top_id, format, file_name );
+        } catch( std::exception& e ) {
+            error = e.what();
         }
+    }
+    if( ! error.empty() ) throw runtime_error( error );
+}
 
-        // create atom within residue
-        CAtomPtr atm = res->CreateAtom( atname, top_id );
-        m_atom_map[atid] = atm;
+//------------------------------------------------------------------------------
 
-        // populate atom with data
-        atm->Set(POSX, x);
-        atm->Set(POSY, y);
-        atm->Set(POSZ, z);
-        atm->Set(TYPE, type);
-        atm->Set(CHARGE, charge);
+void CFormatOB::ReadMolecule( istream& is, CUnitPtr& unit, int& top_id, const string& format,
+                              const string& file_name )
+{
+    OpenBabel::OBConversion conv( &is, NULL );
+    SetFormat( conv, true, format, file_name );
 
-        natoms++;
-        if( natoms >= m_atoms ) break;
+    m_debug << "> Reading molecule ..." << endl;
 
-        getline( is, m_line );
+    OpenBabel::OBMol mol;
+    if( conv.Read( &mol ) == false ){
+        throw runtime_error( "unable to read molecule by OpenBabel" );
     }
 
-    m_debug << "  Atoms = " << setw(8) << natoms;
-    m_debug << "  Residues = " << setw(8) << nres << endl;
+    ConvertToUnit( mol, unit, top_id );
 }
 
 //------------------------------------------------------------------------------
 
-void CFormatOB::ReadBonds( istream& is, CUnitPtr& unit, int& top_id )
+void CFormatOB::ConvertToUnit( OpenBabel::OBMol& mol, CUnitPtr& unit, int& top_id )
 {
-    m_debug << "> Reading bonds ..." << endl;
-    int nbonds = 0;
-
-    getline( is, m_line );
-    while( is ){
-        m_line_no++;
+    if( ! unit ){
+        // invalid unit
+        throw runtime_error( "unit is NULL in CFormatOB::ConvertToUnit" );
+    }
 
-        int         boid  = 0;
-        int         atid1 = 0;
-        int         atid2 = 0;
+    string title = mol.GetTitle();
+    if( ! title.empty() ){
+        unit->SetName( title );
+        m_debug << "  Name : " << title << endl;
+    }
 
-        stringstream str( m_line );
-        str >> boid >> atid1 >> atid2;
+    int     natoms = mol.NumAtoms();
+    int     nbonds = mol.NumBonds();
+    int     nres = 0;
+    double* p_coords = mol.GetCoordinates();
+
+    // OB atom index (starting from one) to unit atoms
+    vector<CAtomPtr>    atom_map( natoms + 1 );
+    CResiduePtr         res;
+
+    for(unsigned int r=0; r < mol.NumResidues(); r++){
+        OpenBabel::OBResidue* p_obres = mol.GetResidue(r);
+        vector<OpenBabel::OBAtom*> obatoms = p_obres->GetAtoms();
+        if( obatoms.empty() ) continue;
+
+        res = unit->CreateResidue( p_obres->GetName(), top_id );
+        nres++;
+
+        for(size_t i=0; i < obatoms.size(); i++){
+            OpenBabel::OBAtom* p_obatom = obatoms[i];
+            string name = p_obres->GetAtomID( p_obatom );
+            // PDB atom names are padded by spaces
+            size_t first = name.find_first_not_of(' ');
+            size_t last = name.find_last_not_of(' ');
+            name = (first == string::npos) ? string() : name.substr(first, last - first + 1);
+
+            CAtomPtr atm = res->CreateAtom( name, top_id );
+            atom_map[p_obatom->GetIdx()] = atm;
+        }
+    }
 
-        unit->CreateBond(m_atom_map[atid1], m_atom_map[atid1], 1, top_id);
+    // atoms without residues, e.g. from SDF files, are placed into one residue
+    for(int i=1; i <= natoms; i++){
+        if( atom_map[i] ) continue;
+        if( nres == 0 ){
+            res = unit->CreateResidue( "MOL", top_id );
+            nres++;
+        }
+        OpenBabel::OBAtom* p_obatom = mol.GetAtom(i);
+        stringstream name;
+        name << OpenBabel::etab.GetSymbol( p_obatom->GetAtomicNum() ) << i;
+        atom_map[i] = res->CreateAtom( name.str(), top_id );
+    }
 
-        nbonds++;
-        if( nbonds >= m_bonds ) break;
+    // atom data in one pass over the OB atom array
+    for(int i=1; i <= natoms; i++){
+        OpenBabel::OBAtom* p_obatom = mol.GetAtom(i);
+        CAtomPtr& atm = atom_map[i];
+        atm->Set(POSX, p_coords[3*(i-1)]);
+        atm->Set(POSY, p_coords[3*(i-1)+1]);
+        atm->Set(POSZ, p_coords[3*(i-1)+2]);
+        atm->Set(TYPE, string( p_obatom->GetType() ));
+        atm->Set(CHARGE, p_obatom->GetPartialCharge());
+        atm->Set(ELEMENT, string( OpenBabel::etab.GetSymbol( p_obatom->GetAtomicNum() ) ));
+    }
 
-        getline( is, m_line );
+    for(int i=0; i < nbonds; i++){
+        OpenBabel::OBBond* p_obbond = mol.GetBond(i);
+        unit->CreateBond( atom_map[p_obbond->GetBeginAtomIdx()], atom_map[p_obbond->GetEndAtomIdx()],
+                          p_obbond->GetBondOrder(), top_id );
     }
 
-    m_debug << "  Bonds = " << setw(8) << nbonds << endl;
+    m_debug << "  Atoms = " << setw(8) << natoms;
+    m_debug << "  Bonds = " << setw(8) << nbonds;
+    m_debug << "  Residues = " << setw(8) << nres << endl;
+
+    // fix unit counters
+    unit->FixCounters();
 }
 
 // -------------------------------------------------------------------------
 // #########################################################################
 // -------------------------------------------------------------------------
 
-void CFormatOB::Write( ostream& os, CUnitPtr& unit, const string& format )
+void CFormatOB::Write( ostream& os, CUnitPtr& unit, const string& format,
+                       const string& file_name )
 {
-    WriteHead( os, unit );
-    WriteAtoms( os, unit );
-    WriteBonds( os, unit );
+    // exceptions must not leave the critical section
+    string error;
+#ifdef _OPENMP
+    #pragma omp critical(nleap_openbabel)
+#endif
+    {
+        try {
+            WriteMolecule( os, unit, format, file_name );
+        } catch( std::exception& e ) {
+            error = e.what();
+        }
+    }
+    if( ! error.empty() ) throw runtime_error( error );
 }
 
 //------------------------------------------------------------------------------
 
-void CFormatOB::WriteHead( ostream& os, CUnitPtr& unit )
+void CFormatOB::WriteMolecule( ostream& os, CUnitPtr& unit, const string& format,
+                               const string& file_name )
 {
-    os << "@<TRIPOS>MOLECULE" << endl;
+    OpenBabel::OBConversion conv( NULL, &os );
+    SetFormat( conv, false, format, file_name );
 
-    string molname = unit->GetName();
-    os << (  molname.empty() ? "untitled" : molname ) << endl;
+    OpenBabel::OBMol mol;
+    ConvertToOBMol( unit, mol );
 
-    // ----------------
-    os << format( "%8d " ) % unit->NumberOfAtoms();
-    os << format( "%8d " ) % unit->NumberOfBonds();
-    os << format( "%8d " ) % unit->NumberOfResidues() << endl;
+    m_debug << "> Writing molecule ..." << endl;
 
-    // ----------------
-    os << ( unit->NumberOfResidues() < 2 ? "SMALL" : "POLYMER" ) << endl;
-
-    // ----------------
-    os << "USER" << endl;
-    os << endl;
-    os << endl;
+    if( conv.Write( &mol ) == false ){
+        throw runtime_error( "unable to write molecule by OpenBabel" );
+    }
 }
 
 //------------------------------------------------------------------------------
 
-void CFormatOB::WriteAtoms( ostream& os, CUnitPtr& unit )
+void CFormatOB::ConvertToOBMol( CUnitPtr& unit, OpenBabel::OBMol& mol )
 {
-    if( unit->NumberOfAtoms() == 0 ) {
-        return;
+    if( ! unit ){
+        // invalid unit
+        throw runtime_error( "unit is NULL in CFormatOB::ConvertToOBMol" );
     }
 
-    os << "@<TRIPOS>ATOM" << endl;
-
-    CRecursiveIterator it = unit->BeginAtoms();
-    CRecursiveIterator ie = unit->EndAtoms();
-
-    while( it != ie ) {
-        CAtomPtr atm = dynamic_pointer_cast<CAtom>(*it);
-        if( atm ){
-            os << format( "%8d " ) % atm->Get<int>(SID);
-            os << format( "%-8s " ) % atm->GetName();
-            os << format( "%9.3f " ) % atm->Get<double>(POSX);
-            os << format( "%9.3f " ) % atm->Get<double>(POSY);
-            os << format( "%9.3f " ) % atm->Get<double>(POSZ);
-            os << format( "%-8s " ) % atm->Get<string>(TYPE);
-            os << format( "%8d " ) % atm->GetResidueId();
-            os << format( "%-8s " ) % atm->GetResidueName();
-            os << format( "%9.3f" ) % atm->Get<double>(CHARGE);
-            os << endl;
-        }
-        it++;
-    }
-}
+    mol.Clear();
+    string molname = unit->GetName();
+    mol.SetTitle( molname.empty() ? "untitled" : molname.c_str() );
 
-//------------------------------------------------------------------------------
+    // unit atom to OB atom index (starting from one)
+    map<CEntity*,int>   atom_map;
+    vector<double>      coords;
+    coords.reserve( 3*unit->NumberOfAtoms() );
 
-void CFormatOB::WriteBonds( ostream& os, CUnitPtr& unit )
-{
-    if( unit->NumberOfBonds() == 0 ) {
-        return;
+    mol.BeginModify();
+    mol.ReserveAtoms( unit->NumberOfAtoms() );
+
+    CResidueRange residues = unit->Residues();
+    int rid = 1;
+    for(CResidueRange::iterator rit = residues.begin(); rit != residues.end(); rit++){
+        OpenBabel::OBResidue* p_obres = mol.NewResidue();
+        p_obres->SetName( rit->GetName() );
+        p_obres->SetNum( rid++ );
+
+        CAtomRange atoms = rit->Atoms();
+        for(CAtomRange::iterator ait = atoms.begin(); ait != atoms.end(); ait++){
+            OpenBabel::OBAtom* p_obatom = mol.NewAtom();
+
+            string element = ait->Get<string>(ELEMENT);
+            int z = element.empty() ? 0 : OpenBabel::etab.GetAtomicNum( element.c_str() );
+            if( z == 0 ) z = GuessAtomicNumber( ait->GetName() );
+
+            p_obatom->SetAtomicNum( z );
+            p_obatom->SetType( ait->Get<string>(TYPE) );
+            p_obatom->SetPartialCharge( ait->Get<double>(CHARGE) );
+
+            p_obres->AddAtom( p_obatom );
+            p_obres->SetAtomID( p_obatom, ait->GetName() );
+            p_obres->SetHetAtom( p_obatom, false );
+
+            coords.push_back( ait->Get<double>(POSX) );
+            coords.push_back( ait->Get<double>(POSY) );
+            coords.push_back( ait->Get<double>(POSZ) );
+
+            atom_map[ &(*ait) ] = p_obatom->GetIdx();
+        }
     }
-    os << "@<TRIPOS>BOND" << std::endl;
-
-    CForwardIterator it = unit->BeginBonds();
-    CForwardIterator ie = unit->EndBonds();
-
-    int id = 1;
-    while( it != ie ) {
-        os << format("%8d ") % id;
-        int first = it->Get<CEntityPtr>(ATOM1)->Get<int>(SID);
-        int second = it->Get<CEntityPtr>(ATOM2)->Get<int>(SID);
-        os << format( "%8d " ) % std::min( first, second );
-        os << format( "%8d " ) % std::max( first, second );
-        os << format( "%8d " ) % it->Get<int>(ORDER);
-        os << std::endl;
-        id++;
-        it++;
+
+    CBondRange bonds = unit->Bonds();
+    for(CBondRange::iterator it = bonds.begin(); it != bonds.end(); it++) {
+        int first = atom_map[ it->Get<CEntityPtr>(ATOM1).get() ];
+        int second = atom_map[ it->Get<CEntityPtr>(ATOM2).get() ];
+        mol.AddBond( first, second, it->Get<int>(ORDER) );
     }
-}
 
-//------------------------------------------------------------------------------
+    mol.EndModify();
 
-void CFormatOB::rw_error( const string& reason )
-{
-    stringstream str;
-    str << reason << endl;
-    str << "       Line " << m_line_no << " : " << m_line;
+    // coordinates in one pass, charges and residues are not perceived again
+    if( ! coords.empty() ){
+        mol.SetCoordinates( &coords[0] );
+    }
+    mol.SetPartialChargesPerceived();
+    mol.SetChainsPerceived();
 
-    throw runtime_error( str.str() );
+    m_debug << "  Atoms = " << setw(8) << mol.NumAtoms();
+    m_debug << "  Bonds = " << setw(8) << mol.NumBonds();
+    m_debug << "  Residues = " << setw(8) << mol.NumResidues() << endl;
 }
 
 //==============================================================================
@@ -317,4 +344,3 @@ void CFormatOB::rw_error( const string& reason )
 //==============================================================================
 
 }
- 
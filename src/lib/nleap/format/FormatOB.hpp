@@ -26,6 +26,11 @@
 #include <types/Unit.hpp>
 #include <VerboseStr.hpp>
 
+namespace OpenBabel {
+class OBMol;
+class OBConversion;
+}
+
 namespace nleap {
 //------------------------------------------------------------------------------
 
@@ -33,42 +38,48 @@ using namespace std;
 
 //------------------------------------------------------------------------------
 
+/// units are converted directly from and to OpenBabel molecules
+/*!
+ OpenBabel keeps global tables that are not thread safe, thus Read and Write
+ are serialized by the nleap_openbabel critical section.
+*/
 class NLEAP_PACKAGE CFormatOB {
 public:
 
     CFormatOB( CVerboseStr& debug );
 
-    /// read mol2 file
-    void Read( istream& is, CUnitPtr& unit, int& top_id, const string& format = "auto" );
+    /// read molecule, format "auto" is deduced from the file name extension
+    void Read( istream& is, CUnitPtr& unit, int& top_id, const string& format = "auto",
+               const string& file_name = string() );
+
+    /// write molecule, format "auto" is deduced from the file name extension
+    void Write( ostream& os, CUnitPtr& unit, const string& format = "auto",
+                const string& file_name = string() );
 
-    /// write mol2 file
-    void Write( ostream& os, CUnitPtr& unit, const string& format = "auto" );
+    /// convert OpenBabel molecule to unit
+    void ConvertToUnit( OpenBabel::OBMol& mol, CUnitPtr& unit, int& top_id );
+
+    /// convert unit to OpenBabel molecule
+    void ConvertToOBMol( CUnitPtr& unit, OpenBabel::OBMol& mol );
 
 // private section -------------------------------------------------------------
 private:
     CVerboseStr&            m_debug;
-    int                     m_line_no;
-    string                  m_line;
-
-    int                     m_atoms;
-    int                     m_bonds;
-    int                     m_residues;
-    string                  m_moltype;
-    string                  m_chgtype;
-    string                  m_status;
-    string                  m_comment;
 
-    map< int, CAtomPtr >    m_atom_map;
+    /// read molecule, the caller holds the critical section
+    void ReadMolecule( istream& is, CUnitPtr& unit, int& top_id, const string& format,
+                       const string& file_name );
 
-    void ReadHead( istream& is, CUnitPtr& unit );
-    void ReadAtoms( istream& is, CUnitPtr& unit, int& top_id );
-    void ReadBonds( istream& is, CUnitPtr& unit, int& top_id );
+    /// write molecule, the caller holds the critical section
+    void WriteMolecule( ostream& os, CUnitPtr& unit, const string& format,
+                        const string& file_name );
 
-    void WriteHead( ostream& os, CUnitPtr& unit );
-    void WriteAtoms( ostream& os, CUnitPtr& unit );
-    void WriteBonds( ostream& os, CUnitPtr& unit );
+    /// set format of conversion
+    void SetFormat( OpenBabel::OBConversion& conv, bool input, const string& format,
+                    const string& file_name );
 
-    void rw_error( const string& reason );
+    /// guess atomic number from atom name
+    static int GuessAtomicNumber( const string& name );
 };
 
 //------------------------------------------------------------------------------
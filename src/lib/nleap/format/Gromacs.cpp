@@ -0,0 +1,731 @@
+// =============================================================================
+// nLEaP - prepare input for the AMBER molecular mechanics programs
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2011 Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2006 gLEaP authors, see AUTHORS file in the main directory
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <format/Gromacs.hpp>
+#include <format/FixedFormat.hpp>
+#include <core/PredefinedKeys.hpp>
+#include <types/Atom.hpp>
+#include <types/Residue.hpp>
+#include <algorithm>
+#include <sstream>
+#include <cmath>
+#include <set>
+
+// unit conversions from Amber to GROMACS
+#define KCAL_TO_KJ      4.184
+#define ANGSTROM_TO_NM  0.1
+// Amber 1-4 scaling factors
+#define FUDGE_LJ        0.5
+#define FUDGE_QQ        0.8333
+// buffered output is flushed to the stream when it exceeds this size
+#define FLUSH_SIZE      (64*1024)
+
+namespace nleap {
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CGromacs::CGromacs( CVerboseStr& debug )
+    : CCommonIO( debug )
+{
+    m_box_buffer = 0.0;
+    m_missing_torsions = 0;
+    m_missing_impropers = 0;
+}
+
+// -------------------------------------------------------------------------
+
+void CGromacs::SetBoxBuffer( double buffer )
+{
+    m_box_buffer = buffer;
+}
+
+// -------------------------------------------------------------------------
+
+void CGromacs::Write( ostream& top, ostream& gro, CUnitPtr& unit, list<CAmberFFPtr>& ffs )
+{
+    if( ffs.empty() ){
+        throw runtime_error("no AmberFF is loaded");
+    }
+
+    m_type_cache.clear();
+    m_param_cache.clear();
+    m_tors_cache.clear();
+    m_missing_torsions = 0;
+    m_missing_impropers = 0;
+
+    AnalyzeUnit( unit );
+
+    m_debug << medium << "> Writing GROMACS topology ..." << endl;
+    m_debug << high << "  Atoms = " << m_graph.NumberOfAtoms() << "  Molecules = " << m_molecules.size();
+    m_debug << "  Molecule types = " << m_types.size() << endl;
+
+    CFormatBuffer buffer;
+    WriteHead( buffer, unit, ffs );
+    buffer.Flush( top );
+
+    for(size_t t=0; t < m_types.size(); t++){
+        WriteMoleculeType( buffer, m_types[t], ffs );
+        buffer.Flush( top );
+    }
+
+    WriteMolecules( buffer, unit );
+    buffer.Flush( top );
+
+    WriteCoordinates( gro, unit );
+
+    if( m_missing_torsions > 0 ){
+        m_debug << low << "<b><red>Warning:</red></b> " << m_missing_torsions
+                << " proper torsion(s) without parameters were not written" << endl;
+    }
+    if( m_missing_impropers > 0 ){
+        m_debug << low << "<b><red>Warning:</red></b> " << m_missing_impropers
+                << " improper torsion(s) without parameters were not written" << endl;
+    }
+}
+
+// -------------------------------------------------------------------------
+// #########################################################################
+// -------------------------------------------------------------------------
+
+void CGromacs::AnalyzeUnit( CUnitPtr& unit )
+{
+    m_molecules.clear();
+    m_types.clear();
+
+    // atoms and bonds -----------------------------
+    m_graph.Build(unit);
+
+    int natoms = m_graph.NumberOfAtoms();
+    m_local.assign(natoms,-1);
+
+    // molecules -----------------------------------
+    vector<int> molecule(natoms,-1);
+    vector<int> stack;
+
+    for(int i=0; i < natoms; i++){
+        if( molecule[i] >= 0 ) continue;
+        int id = m_molecules.size();
+        m_molecules.push_back(SMolecule());
+        SMolecule& mol = m_molecules.back();
+
+        molecule[i] = id;
+        stack.push_back(i);
+        while( ! stack.empty() ){
+            int a = stack.back();
+            stack.pop_back();
+            mol.atoms.push_back(a);
+            const vector<int>& na = m_graph.GetNeighbours(a);
+            for(size_t n=0; n < na.size(); n++){
+                int b = na[n];
+                if( molecule[b] < 0 ){
+                    molecule[b] = id;
+                    stack.push_back(b);
+                }
+            }
+        }
+        sort(mol.atoms.begin(),mol.atoms.end());
+    }
+
+    // molecule types ------------------------------
+    map<string,int> signatures;
+    set<string>     names;
+    string          signature;
+
+    for(size_t m=0; m < m_molecules.size(); m++){
+        SMolecule& mol = m_molecules[m];
+        GetSignature(mol,signature);
+
+        map<string,int>::iterator sit = signatures.find(signature);
+        if( sit != signatures.end() ){
+            mol.type = sit->second;
+            m_types[mol.type].count++;
+            continue;
+        }
+
+        // single residue molecules are named by the residue
+        SMoleculeType type;
+        CResiduePtr first = m_graph.GetAtom(mol.atoms.front())->GetResidue();
+        CResiduePtr last = m_graph.GetAtom(mol.atoms.back())->GetResidue();
+        if( first && (first == last) && (! first->GetName().empty()) ){
+            type.name = first->GetName();
+        } else {
+            type.name = "MOL";
+        }
+        if( names.count(type.name) > 0 ){
+            string base = type.name;
+            for(int n=2; names.count(type.name) > 0; n++){
+                stringstream str;
+                str << base << "_" << n;
+                type.name = str.str();
+            }
+        }
+        names.insert(type.name);
+        type.molecule = m;
+        type.count = 1;
+
+        mol.type = m_types.size();
+        signatures[signature] = mol.type;
+        m_types.push_back(type);
+    }
+}
+
+// -------------------------------------------------------------------------
+
+void CGromacs::GetSignature( const SMolecule& mol, string& signature )
+{
+    signature.clear();
+
+    for(size_t i=0; i < mol.atoms.size(); i++){
+        m_local[mol.atoms[i]] = i;
+    }
+
+    int         resid = -1;
+    CResidue*   p_last = NULL;
+    vector<int> partners;
+
+    for(size_t i=0; i < mol.atoms.size(); i++){
+        CAtomPtr atom = m_graph.GetAtom(mol.atoms[i]);
+
+        CResiduePtr res = atom->GetResidue();
+        if( (res.get() != p_last) || (resid < 0) ){
+            resid++;
+            p_last = res.get();
+        }
+
+        double charge = atom->Get<double>(CHARGE);
+        signature.append(atom->GetName());
+        signature += '\t';
+        signature.append(atom->Get<string>(TYPE));
+        signature += '\t';
+        signature.append(res ? res->GetName() : string());
+        signature += '\t';
+        signature.append((const char*)&resid,sizeof(resid));
+        signature.append((const char*)&charge,sizeof(charge));
+
+        // bonds to atoms with higher local index
+        partners.clear();
+        const vector<int>& na = m_graph.GetNeighbours(mol.atoms[i]);
+        for(size_t n=0; n < na.size(); n++){
+            int j = m_local[na[n]];
+            if( j > (int)i ) partners.push_back(j);
+        }
+        sort(partners.begin(),partners.end());
+        int npartners = partners.size();
+        signature.append((const char*)&npartners,sizeof(npartners));
+        if( npartners > 0 ){
+            signature.append((const char*)&partners[0],npartners*sizeof(int));
+        }
+    }
+
+    for(size_t i=0; i < mol.atoms.size(); i++){
+        m_local[mol.atoms[i]] = -1;
+    }
+}
+
+// -------------------------------------------------------------------------
+// #########################################################################
+// -------------------------------------------------------------------------
+
+void CGromacs::WriteHead( CFormatBuffer& buf, CUnitPtr& unit, list<CAmberFFPtr>& ffs )
+{
+    buf.Text("; GROMACS topology of unit ");
+    buf.Text(unit->GetName().empty() ? "untitled" : unit->GetName());
+    buf.NewLine();
+    buf.NewLine();
+
+    buf.Text("[ defaults ]");
+    buf.NewLine();
+    buf.Text("; nbfunc  comb-rule  gen-pairs  fudgeLJ  fudgeQQ");
+    buf.NewLine();
+    buf.Int(1,8);
+    buf.Int(2,11);
+    buf.Right("yes",11);
+    buf.Fixed(FUDGE_LJ,9,4);
+    buf.Fixed(FUDGE_QQ,9,4);
+    buf.NewLine();
+    buf.NewLine();
+
+    // types used by molecule types
+    map<string,CEntityPtr> types;
+    for(size_t t=0; t < m_types.size(); t++){
+        const SMolecule& mol = m_molecules[m_types[t].molecule];
+        for(size_t i=0; i < mol.atoms.size(); i++){
+            types[m_graph.GetType(mol.atoms[i])] = FindType(ffs,mol.atoms[i]);
+        }
+    }
+
+    buf.Text("[ atomtypes ]");
+    buf.NewLine();
+    buf.Text("; name        mass    charge ptype        sigma      epsilon");
+    buf.NewLine();
+
+    map<string,CEntityPtr>::iterator it = types.begin();
+    map<string,CEntityPtr>::iterator ie = types.end();
+
+    while( it != ie ){
+        // Amber uses r* = rmin/2, GROMACS sigma = rmin/2^(1/6)
+        double sigma = 2.0*it->second->Get<double>(RSTAR)*ANGSTROM_TO_NM/pow(2.0,1.0/6.0);
+        double epsilon = it->second->Get<double>(DEPTH)*KCAL_TO_KJ;
+        buf.Left(it->first,6);
+        buf.Fixed(it->second->Get<double>(MASS),10,4);
+        buf.Fixed(0.0,10,4);
+        buf.Right("A",6);
+        buf.Exp(sigma,13,5);
+        buf.Exp(epsilon,13,5);
+        buf.NewLine();
+        it++;
+    }
+    buf.NewLine();
+}
+
+// -------------------------------------------------------------------------
+
+void CGromacs::WriteMoleculeType( CFormatBuffer& buf, const SMoleculeType& type, list<CAmberFFPtr>& ffs )
+{
+    const SMolecule& mol = m_molecules[type.molecule];
+    int natoms = mol.atoms.size();
+
+    for(int i=0; i < natoms; i++){
+        m_local[mol.atoms[i]] = i;
+    }
+
+    buf.Text("[ moleculetype ]");
+    buf.NewLine();
+    buf.Text("; name  nrexcl");
+    buf.NewLine();
+    buf.Text(type.name);
+    buf.Text("  3");
+    buf.NewLine();
+    buf.NewLine();
+
+    // atoms ---------------------------------------
+    buf.Text("[ atoms ]");
+    buf.NewLine();
+    buf.Text(";   nr   type  resnr residue   atom   cgnr     charge       mass");
+    buf.NewLine();
+
+    int         resid = 0;
+    CResidue*   p_last = NULL;
+
+    for(int i=0; i < natoms; i++){
+        int         a = mol.atoms[i];
+        CAtomPtr    atom = m_graph.GetAtom(a);
+        CResiduePtr res = atom->GetResidue();
+        if( (res.get() != p_last) || (resid == 0) ){
+            resid++;
+            p_last = res.get();
+        }
+        buf.Int(i+1,6);
+        buf.Right(atom->Get<string>(TYPE),7);
+        buf.Int(resid,7);
+        buf.Right(res ? res->GetName() : string("UNK"),8);
+        buf.Right(atom->GetName(),7);
+        buf.Int(i+1,7);
+        buf.Fixed(atom->Get<double>(CHARGE),11,6);
+        buf.Fixed(FindType(ffs,a)->Get<double>(MASS),11,4);
+        buf.NewLine();
+    }
+    buf.NewLine();
+
+    // bonds and 1-2 exclusions --------------------
+    set< pair<int,int> > excluded;
+    bool header = true;
+
+    for(int i=0; i < natoms; i++){
+        int a = mol.atoms[i];
+        const vector<int>& na = m_graph.GetNeighbours(a);
+        for(size_t n=0; n < na.size(); n++){
+            int b = na[n];
+            int j = m_local[b];
+            if( j <= i ) continue;
+            excluded.insert(make_pair(i,j));
+
+            CEntityPtr param = FindBond(ffs,a,b);
+            if( header ){
+                buf.Text("[ bonds ]");
+                buf.NewLine();
+                buf.Text(";   ai     aj funct         b0           kb");
+                buf.NewLine();
+                header = false;
+            }
+            buf.Int(i+1,6);
+            buf.Int(j+1,7);
+            buf.Int(1,6);
+            buf.Fixed(param->Get<double>(EQUIL)*ANGSTROM_TO_NM,11,5);
+            buf.Exp(2.0*param->Get<double>(FORCE)*KCAL_TO_KJ/(ANGSTROM_TO_NM*ANGSTROM_TO_NM),13,5);
+            buf.NewLine();
+        }
+    }
+    if( ! header ) buf.NewLine();
+
+    // angles and 1-3 exclusions -------------------
+    header = true;
+
+    vector<int> angles;
+
+    for(int j=0; j < natoms; j++){
+        angles.clear();
+        m_graph.GetAngles(mol.atoms[j],angles);
+        for(size_t t=0; t < angles.size(); t += 3){
+            int i = m_local[angles[t]];
+            int k = m_local[angles[t+2]];
+            excluded.insert(make_pair(min(i,k),max(i,k)));
+
+            CEntityPtr param = FindAngle(ffs,angles[t],angles[t+1],angles[t+2]);
+            if( header ){
+                buf.Text("[ angles ]");
+                buf.NewLine();
+                buf.Text(";   ai     aj     ak funct     theta0       ktheta");
+                buf.NewLine();
+                header = false;
+            }
+            buf.Int(i+1,6);
+            buf.Int(j+1,7);
+            buf.Int(k+1,7);
+            buf.Int(1,6);
+            buf.Fixed(param->Get<double>(EQUIL),11,4);
+            buf.Exp(2.0*param->Get<double>(FORCE)*KCAL_TO_KJ,13,5);
+            buf.NewLine();
+        }
+    }
+    if( ! header ) buf.NewLine();
+
+    // proper torsions and 1-4 pairs ---------------
+    set< pair<int,int> >    pairs14;
+    CFormatBuffer           dihedrals;
+
+    vector<int>             terms;
+
+    for(int j=0; j < natoms; j++){
+        // molecule atoms are ascending, thus also local indexes j < k
+        terms.clear();
+        m_graph.GetTorsions(mol.atoms[j],terms);
+        for(size_t t=0; t < terms.size(); t += 4){
+            int i = m_local[terms[t]];
+            int k = m_local[terms[t+2]];
+            int l = m_local[terms[t+3]];
+            pairs14.insert(make_pair(min(i,l),max(i,l)));
+
+            const vector<CEntityPtr>& params = FindTorsions(ffs,terms[t],terms[t+1],terms[t+2],terms[t+3],false);
+            if( params.empty() ) m_missing_torsions++;
+            for(size_t p=0; p < params.size(); p++){
+                dihedrals.Int(i+1,6);
+                dihedrals.Int(j+1,7);
+                dihedrals.Int(k+1,7);
+                dihedrals.Int(l+1,7);
+                dihedrals.Int(9,6);
+                dihedrals.Fixed(params[p]->Get<double>(EQUIL),11,4);
+                dihedrals.Exp(params[p]->Get<double>(FORCE)/params[p]->Get<double>(DIVIDE)*KCAL_TO_KJ,13,5);
+                dihedrals.Int((int)fabs(params[p]->Get<double>(PERIOD)),4);
+                dihedrals.NewLine();
+            }
+        }
+    }
+
+    // 1-4 pairs that are not 1-2 or 1-3 in rings
+    header = true;
+
+    set< pair<int,int> >::iterator it = pairs14.begin();
+    set< pair<int,int> >::iterator ie = pairs14.end();
+    while( it != ie ){
+        if( excluded.count(*it) == 0 ){
+            if( header ){
+                buf.Text("[ pairs ]");
+                buf.NewLine();
+                buf.Text(";   ai     aj funct");
+                buf.NewLine();
+                header = false;
+            }
+            buf.Int(it->first+1,6);
+            buf.Int(it->second+1,7);
+            buf.Int(1,6);
+            buf.NewLine();
+        }
+        it++;
+    }
+    if( ! header ) buf.NewLine();
+
+    if( dihedrals.GetSize() > 0 ){
+        buf.Text("[ dihedrals ] ; propers");
+        buf.NewLine();
+        buf.Text(";   ai     aj     ak     al funct      phase           kd mult");
+        buf.NewLine();
+        buf.Text(string(dihedrals.GetData(),dihedrals.GetSize()));
+        buf.NewLine();
+    }
+
+    // impropers - central atom is the third one, only the first
+    // matching improper is used for each central atom, see CUnitGraph
+    dihedrals.Clear();
+
+    for(int k=0; k < natoms; k++){
+        int ak = mol.atoms[k];
+        int outer[3];
+        if( ! m_graph.GetImproperAtoms(ak,outer) ) continue;
+        bool found = false;
+        for(int p=0; p < 3; p++){
+            int ai = outer[CUnitGraph::ImproperPermutations[p][0]];
+            int aj = outer[CUnitGraph::ImproperPermutations[p][1]];
+            int al = outer[CUnitGraph::ImproperPermutations[p][2]];
+            const vector<CEntityPtr>& params = FindTorsions(ffs,ai,aj,ak,al,true);
+            for(size_t t=0; t < params.size(); t++){
+                dihedrals.Int(m_local[ai]+1,6);
+                dihedrals.Int(m_local[aj]+1,7);
+                dihedrals.Int(k+1,7);
+                dihedrals.Int(m_local[al]+1,7);
+                dihedrals.Int(4,6);
+                dihedrals.Fixed(params[t]->Get<double>(EQUIL),11,4);
+                dihedrals.Exp(params[t]->Get<double>(FORCE)/params[t]->Get<double>(DIVIDE)*KCAL_TO_KJ,13,5);
+                dihedrals.Int((int)fabs(params[t]->Get<double>(PERIOD)),4);
+                dihedrals.NewLine();
+            }
+            if( ! params.empty() ){
+                found = true;
+                break;
+            }
+        }
+        if( ! found ){
+            m_missing_impropers++;
+            m_debug << medium << "<b><red>Warning:</red></b> no improper parameters for "
+                    << m_graph.GetType(outer[0]) << " - " << m_graph.GetType(outer[1]) << " - "
+                    << m_graph.GetType(ak) << " - " << m_graph.GetType(outer[2]) << endl;
+        }
+    }
+
+    if( dihedrals.GetSize() > 0 ){
+        buf.Text("[ dihedrals ] ; impropers");
+        buf.NewLine();
+        buf.Text(";   ai     aj     ak     al funct      phase           kd mult");
+        buf.NewLine();
+        buf.Text(string(dihedrals.GetData(),dihedrals.GetSize()));
+        buf.NewLine();
+    }
+
+    for(int i=0; i < natoms; i++){
+        m_local[mol.atoms[i]] = -1;
+    }
+}
+
+// -------------------------------------------------------------------------
+
+void CGromacs::WriteMolecules( CFormatBuffer& buf, CUnitPtr& unit )
+{
+    buf.Text("[ system ]");
+    buf.NewLine();
+    buf.Text(unit->GetName().empty() ? "untitled" : unit->GetName());
+    buf.NewLine();
+    buf.NewLine();
+
+    buf.Text("[ molecules ]");
+    buf.NewLine();
+    buf.Text("; compound        #mols");
+    buf.NewLine();
+
+    // consecutive molecules of the same type are counted by one line
+    size_t m = 0;
+    while( m < m_molecules.size() ){
+        int type = m_molecules[m].type;
+        int count = 0;
+        while( (m < m_molecules.size()) && (m_molecules[m].type == type) ){
+            count++;
+            m++;
+        }
+        buf.Left(m_types[type].name,16);
+        buf.Int(count,6);
+        buf.NewLine();
+    }
+}
+
+// -------------------------------------------------------------------------
+
+void CGromacs::WriteCoordinates( ostream& gro, CUnitPtr& unit )
+{
+    CFormatBuffer buf;
+
+    buf.Text(unit->GetName().empty() ? "untitled" : unit->GetName());
+    buf.NewLine();
+    buf.Int(m_graph.NumberOfAtoms(),5);
+    buf.NewLine();
+
+    // the unit has no box, the bounding box enlarged by the buffer is used
+    double      lo[3] = {0.0,0.0,0.0};
+    double      hi[3] = {0.0,0.0,0.0};
+    for(int i=0; i < m_graph.NumberOfAtoms(); i++){
+        double pos[3];
+        pos[0] = m_graph.GetAtom(i)->Get<double>(POSX);
+        pos[1] = m_graph.GetAtom(i)->Get<double>(POSY);
+        pos[2] = m_graph.GetAtom(i)->Get<double>(POSZ);
+        for(int d=0; d < 3; d++){
+            if( (i == 0) || (pos[d] < lo[d]) ) lo[d] = pos[d];
+            if( (i == 0) || (pos[d] > hi[d]) ) hi[d] = pos[d];
+        }
+    }
+
+    // padded unit is moved into the box
+    double shift[3] = {0.0,0.0,0.0};
+    if( m_box_buffer > 0.0 ){
+        for(int d=0; d < 3; d++) shift[d] = m_box_buffer - lo[d];
+    } else {
+        m_debug << low << "<b><red>Warning:</red></b> the box in the coordinate file is the bounding box "
+                << "of the unit, periodic images of atoms at its faces overlap" << endl;
+    }
+
+    // atoms are written in the order of molecules in the topology
+    int         nr = 0;
+    int         resid = 0;
+
+    for(size_t m=0; m < m_molecules.size(); m++){
+        const SMolecule& mol = m_molecules[m];
+        CResidue* p_last = NULL;
+
+        for(size_t i=0; i < mol.atoms.size(); i++){
+            CAtomPtr    atom = m_graph.GetAtom(mol.atoms[i]);
+            CResiduePtr res = atom->GetResidue();
+            if( (res.get() != p_last) || (i == 0) ){
+                resid++;
+                p_last = res.get();
+            }
+            nr++;
+
+            double pos[3];
+            pos[0] = atom->Get<double>(POSX);
+            pos[1] = atom->Get<double>(POSY);
+            pos[2] = atom->Get<double>(POSZ);
+            for(int d=0; d < 3; d++) pos[d] += shift[d];
+
+            // numbers wrap around and names are truncated to keep fixed columns
+            buf.Int(resid % 100000,5);
+            buf.Left((res ? res->GetName() : string("UNK")).substr(0,5),5);
+            buf.Right(atom->GetName().substr(0,5),5);
+            buf.Int(nr % 100000,5);
+            buf.Fixed(pos[0]*ANGSTROM_TO_NM,8,3);
+            buf.Fixed(pos[1]*ANGSTROM_TO_NM,8,3);
+            buf.Fixed(pos[2]*ANGSTROM_TO_NM,8,3);
+            buf.NewLine();
+            if( buf.GetSize() > FLUSH_SIZE ) buf.Flush( gro );
+        }
+    }
+
+    for(int d=0; d < 3; d++){
+        buf.Fixed((hi[d]-lo[d]+2.0*m_box_buffer)*ANGSTROM_TO_NM,10,5);
+    }
+    buf.NewLine();
+    buf.Flush( gro );
+}
+
+// -------------------------------------------------------------------------
+// #########################################################################
+// -------------------------------------------------------------------------
+
+CEntityPtr CGromacs::FindType( list<CAmberFFPtr>& ffs, int atom )
+{
+    string type = m_graph.GetType(atom);
+
+    map<string,CEntityPtr>::iterator tc = m_type_cache.find(type);
+    if( tc != m_type_cache.end() ) return(tc->second);
+
+    CEntityPtr ffatom = CAmberFF::FindType(ffs,type);
+    if( ! ffatom ){
+        stringstream str;
+        str << "atom type <b>" << type << "</b> of atom " << m_graph.GetAtom(atom)->GetPathName() << " is not defined in any AmberFF";
+        throw runtime_error(str.str());
+    }
+    m_type_cache[type] = ffatom;
+    return(ffatom);
+}
+
+// -------------------------------------------------------------------------
+
+CEntityPtr CGromacs::FindBond( list<CAmberFFPtr>& ffs, int i, int j )
+{
+    string t1 = m_graph.GetType(i);
+    string t2 = m_graph.GetType(j);
+    string key = t1 + "-" + t2;
+
+    map<string,CEntityPtr>::iterator pc = m_param_cache.find(key);
+    if( pc != m_param_cache.end() ) return(pc->second);
+
+    CEntityPtr param = CAmberFF::FindBond(ffs,t1,t2);
+    if( ! param ){
+        stringstream str;
+        str << "missing bond parameters for " << t1 << " - " << t2;
+        throw runtime_error(str.str());
+    }
+    m_param_cache[key] = param;
+    return(param);
+}
+
+// -------------------------------------------------------------------------
+
+CEntityPtr CGromacs::FindAngle( list<CAmberFFPtr>& ffs, int i, int j, int k )
+{
+    string t1 = m_graph.GetType(i);
+    string t2 = m_graph.GetType(j);
+    string t3 = m_graph.GetType(k);
+    string key = t1 + "-" + t2 + "-" + t3;
+
+    map<string,CEntityPtr>::iterator pc = m_param_cache.find(key);
+    if( pc != m_param_cache.end() ) return(pc->second);
+
+    CEntityPtr param = CAmberFF::FindAngle(ffs,t1,t2,t3);
+    if( ! param ){
+        stringstream str;
+        str << "missing angle parameters for " << t1 << " - " << t2 << " - " << t3;
+        throw runtime_error(str.str());
+    }
+    m_param_cache[key] = param;
+    return(param);
+}
+
+// -------------------------------------------------------------------------
+
+const vector<CEntityPtr>& CGromacs::FindTorsions( list<CAmberFFPtr>& ffs, int i, int j, int k, int l, bool improper )
+{
+    string t1 = m_graph.GetType(i);
+    string t2 = m_graph.GetType(j);
+    string t3 = m_graph.GetType(k);
+    string t4 = m_graph.GetType(l);
+    string key = t1 + "-" + t2 + "-" + t3 + "-" + t4;
+    if( improper ) key += "-I";
+
+    map<string,vector<CEntityPtr> >::iterator pc = m_tors_cache.find(key);
+    if( pc != m_tors_cache.end() ) return(pc->second);
+
+    // torsions without parameters are skipped and counted by the caller,
+    // missing propers are reported once per combination of types
+    vector<CEntityPtr>& params = m_tors_cache[key];
+    if( improper ){
+        CAmberFF::FindImproper(ffs,t1,t2,t3,t4,params);
+    } else {
+        CAmberFF::FindTorsion(ffs,t1,t2,t3,t4,params);
+        if( params.empty() ){
+            m_debug << low << "<b><red>Warning:</red></b> no torsion parameters for "
+                    << t1 << " - " << t2 << " - " << t3 << " - " << t4 << endl;
+        }
+    }
+    return(params);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+}
@@ -0,0 +1,108 @@
+#ifndef NLEAP_FORMAT_GROMACS_HPP
+#define NLEAP_FORMAT_GROMACS_HPP
+// =============================================================================
+// nLEaP - prepare input for the AMBER molecular mechanics programs
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2011 Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2006 gLEaP authors, see AUTHORS file in the main directory
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <NLEaPMainHeader.hpp>
+#include <iosfwd>
+#include <types/Unit.hpp>
+#include <types/AmberFF.hpp>
+#include <VerboseStr.hpp>
+#include <format/CommonIO.hpp>
+#include <misc/UnitGraph.hpp>
+#include <vector>
+#include <map>
+
+namespace nleap {
+//------------------------------------------------------------------------------
+
+using namespace std;
+
+class CFormatBuffer;
+
+//------------------------------------------------------------------------------
+
+/// GROMACS topology (.top) and coordinates (.gro)
+/*!
+ The unit is split into molecules, i.e. groups of bonded atoms. Molecules with
+ the same atoms, charges, residues, and bonds share one [ moleculetype ],
+ which is parametrized and written only once, consecutive copies are counted
+ by one line in [ molecules ]. Amber parameters are converted to GROMACS units.
+*/
+
+class NLEAP_PACKAGE CGromacs : public CCommonIO {
+public:
+
+    CGromacs( CVerboseStr& debug );
+
+    /// set distance in angstroms between the unit and the faces of the box
+    void SetBoxBuffer( double buffer );
+
+    /// write topology and coordinates of the unit
+    void Write( ostream& top, ostream& gro, CUnitPtr& unit, list<CAmberFFPtr>& ffs );
+
+// private section -------------------------------------------------------------
+private:
+    struct SMolecule {
+        vector<int>     atoms;      // unit atom indexes, ascending
+        int             type;
+    };
+
+    struct SMoleculeType {
+        string          name;
+        int             molecule;   // first molecule of this type
+        int             count;
+    };
+
+    CUnitGraph                      m_graph;
+    vector<SMolecule>               m_molecules;
+    vector<SMoleculeType>           m_types;
+    vector<int>                     m_local;    // local indexes of processed molecule, -1 otherwise
+    double                          m_box_buffer;
+    int                             m_missing_torsions;     // skipped for missing parameters
+    int                             m_missing_impropers;
+
+    // parameters are looked up once per unique combination of types
+    map<string,CEntityPtr>          m_type_cache;
+    map<string,CEntityPtr>          m_param_cache;
+    map<string,vector<CEntityPtr> > m_tors_cache;
+
+    /// collect atoms and bonds, find molecules and their types
+    void AnalyzeUnit( CUnitPtr& unit );
+
+    /// signature of the molecule, identical molecules have identical signatures
+    void GetSignature( const SMolecule& mol, string& signature );
+
+    void WriteHead( CFormatBuffer& buf, CUnitPtr& unit, list<CAmberFFPtr>& ffs );
+    void WriteMoleculeType( CFormatBuffer& buf, const SMoleculeType& type, list<CAmberFFPtr>& ffs );
+    void WriteMolecules( CFormatBuffer& buf, CUnitPtr& unit );
+    void WriteCoordinates( ostream& gro, CUnitPtr& unit );
+
+    CEntityPtr FindType( list<CAmberFFPtr>& ffs, int atom );
+    CEntityPtr FindBond( list<CAmberFFPtr>& ffs, int i, int j );
+    CEntityPtr FindAngle( list<CAmberFFPtr>& ffs, int i, int j, int k );
+    const vector<CEntityPtr>& FindTorsions( list<CAmberFFPtr>& ffs, int i, int j, int k, int l, bool improper );
+};
+
+//------------------------------------------------------------------------------
+}
+
+#endif
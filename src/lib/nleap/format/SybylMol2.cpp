@@ -20,11 +20,13 @@
 // =============================================================================
 
 #include <format/SybylMol2.hpp>
-#include <sstream>
 #include <boost/algorithm/string.hpp>
-#include <boost/format.hpp>
 #include <iomanip>
 #include <core/PredefinedKeys.hpp>
+#include <format/FixedFormat.hpp>
+
+// buffered output is flushed to the stream when it exceeds this size
+#define FLUSH_SIZE (64*1024)
 
 namespace nleap {
 //==============================================================================
@@ -32,14 +34,24 @@ namespace nleap {
 //==============================================================================
 
 CSybylMol2::CSybylMol2( CVerboseStr& debug )
-    : m_debug( debug )
+    : CCommonIO( debug )
 {
-    m_line_no = 0;
+    m_pending_molecule = false;
 }
 
 // -------------------------------------------------------------------------
 
 void CSybylMol2::Read( istream& is, CUnitPtr& unit, int& top_id )
+{
+    m_pending_molecule = false;
+
+    // only the first molecule is read
+    ReadNext( is, unit, top_id );
+}
+
+// -------------------------------------------------------------------------
+
+bool CSybylMol2::ReadNext( istream& is, CUnitPtr& unit, int& top_id )
 {
     m_atoms = 0;
     m_bonds = 0;
@@ -47,16 +59,32 @@ void CSybylMol2::Read( istream& is, CUnitPtr& unit, int& top_id )
 
     if( ! unit ){
         // invalid unit
-        throw runtime_error( "unit is NULL in CSybylMol2::read" );
+        throw runtime_error( "unit is NULL in CSybylMol2::ReadNext" );
     }
 
     m_atom_map.clear();
 
+    // find beginning of the molecule unless it was already consumed by the previous call
+    if( ! m_pending_molecule ){
+        getline( is, m_line );
+        while( is ){
+            m_line_no++;
+            if( m_line.find("@<TRIPOS>MOLECULE") != string::npos ) break;
+            getline( is, m_line );
+        }
+        if( ! is ) return( false );
+    }
+    m_pending_molecule = false;
+
+    ReadHead( is, unit );
+
     getline( is, m_line );
     while( is ){
         m_line_no++;
         if( m_line.find("@<TRIPOS>MOLECULE") != string::npos ){
-            ReadHead( is, unit );
+            // beginning of the next molecule
+            m_pending_molecule = true;
+            break;
         } else
         if( m_line.find("@<TRIPOS>ATOM") != string::npos ){
             ReadAtoms( is, unit, top_id );
@@ -70,6 +98,8 @@ void CSybylMol2::Read( istream& is, CUnitPtr& unit, int& top_id )
 
     // fix unit counters
     unit->FixCounters();
+
+    return( true );
 }
 
 // -------------------------------------------------------------------------
@@ -89,8 +119,10 @@ void CSybylMol2::ReadHead( istream& is, CUnitPtr& unit )
     getline( is, m_line );
     m_line_no++;
 
-    stringstream str(m_line);
-    str >> m_atoms >> m_bonds >> m_residues;
+    ResetCursor();
+    m_atoms = GetInt( "number of atoms" );
+    m_cursor.NextInt( m_bonds );        // optional
+    m_cursor.NextInt( m_residues );     // optional
 
     m_debug << "  Atoms = " << setw(8) << m_atoms;
     m_debug << "  Bonds = " << setw(8) << m_bonds;
@@ -131,23 +163,29 @@ void CSybylMol2::ReadAtoms( istream& is, CUnitPtr& unit, int& top_id )
     int         nres = 0;
     int         prev_resid = 0;
     CResiduePtr res;
+    string      atname;
+    string      type;
+    string      resname;
 
     getline( is, m_line );
     while( is ){
         m_line_no++;
 
-        int         atid = 0;
-        string      atname;
-        double      x = 0;
-        double      y = 0;
-        double      z = 0;
-        string      type;
         int         resid = 0;
-        string      resname;
         double      charge = 0;
 
-        stringstream str( m_line );
-        str >> atid >> atname >> x >> y >> z >> type >> resid >> resname >> charge;
+        ResetCursor();
+        int    atid = GetInt( "atom id" );
+        GetField( atname, "atom name" );
+        double x = GetDouble( "x coordinate" );
+        double y = GetDouble( "y coordinate" );
+        double z = GetDouble( "z coordinate" );
+        GetField( type, "atom type" );
+
+        // substructure and charge are optional
+        if( m_cursor.HasField() ) resid = GetInt( "substructure id" );
+        if( m_cursor.HasField() ) GetField( resname, "substructure name" );
+        if( m_cursor.HasField() ) charge = GetDouble( "atom charge" );
 
         if( prev_resid < resid ){
             prev_resid = resid;
@@ -157,7 +195,7 @@ void CSybylMol2::ReadAtoms( istream& is, CUnitPtr& unit, int& top_id )
         }
 
         if( ! res ) {
-            throw runtime_error("errr");
+            EmitRWError( "Atom does not belong to any substructure." );
         }
 
         // create atom within residue
@@ -192,14 +230,18 @@ void CSybylMol2::ReadBonds( istream& is, CUnitPtr& unit, int& top_id )
     while( is ){
         m_line_no++;
 
-        int         boid  = 0;
-        int         atid1 = 0;
-        int         atid2 = 0;
+        ResetCursor();
+        GetInt( "bond id" );
+        int atid1 = GetInt( "origin atom id" );
+        int atid2 = GetInt( "target atom id" );
 
-        stringstream str( m_line );
-        str >> boid >> atid1 >> atid2;
+        map< int, CAtomPtr >::iterator at1 = m_atom_map.find( atid1 );
+        map< int, CAtomPtr >::iterator at2 = m_atom_map.find( atid2 );
+        if( (at1 == m_atom_map.end()) || (at2 == m_atom_map.end()) ){
+            EmitRWError( "Bond refers to an undefined atom." );
+        }
 
-        unit->CreateBond(m_atom_map[atid1], m_atom_map[atid1], 1, top_id);
+        unit->CreateBond(at1->second, at2->second, 1, top_id);
 
         nbonds++;
         if( nbonds >= m_bonds ) break;
@@ -231,9 +273,15 @@ void CSybylMol2::WriteHead( ostream& os, CUnitPtr& unit )
     os << (  molname.empty() ? "untitled" : molname ) << endl;
 
     // ----------------
-    os << format( "%8d " ) % unit->NumberOfAtoms();
-    os << format( "%8d " ) % unit->NumberOfBonds();
-    os << format( "%8d " ) % unit->NumberOfResidues() << endl;
+    CFormatBuffer buffer;
+    buffer.Int( unit->NumberOfAtoms(), 8 );
+    buffer.Char( ' ' );
+    buffer.Int( unit->NumberOfBonds(), 8 );
+    buffer.Char( ' ' );
+    buffer.Int( unit->NumberOfResidues(), 8 );
+    buffer.Char( ' ' );
+    buffer.NewLine();
+    buffer.Flush( os );
 
     // ----------------
     os << ( unit->NumberOfResidues() < 2 ? "SMALL" : "POLYMER" ) << endl;
@@ -254,25 +302,31 @@ void CSybylMol2::WriteAtoms( ostream& os, CUnitPtr& unit )
 
     os << "@<TRIPOS>ATOM" << endl;
 
-    CRecursiveIterator it = unit->BeginAtoms();
-    CRecursiveIterator ie = unit->EndAtoms();
-
-    while( it != ie ) {
-        CAtomPtr atm = dynamic_pointer_cast<CAtom>(*it);
-        if( atm ){
-            os << format( "%8d " ) % atm->Get<int>(SID);
-            os << format( "%-8s " ) % atm->GetName();
-            os << format( "%9.3f " ) % atm->Get<double>(POSX);
-            os << format( "%9.3f " ) % atm->Get<double>(POSY);
-            os << format( "%9.3f " ) % atm->Get<double>(POSZ);
-            os << format( "%-8s " ) % atm->Get<string>(TYPE);
-            os << format( "%8d " ) % atm->GetResidueId();
-            os << format( "%-8s " ) % atm->GetResidueName();
-            os << format( "%9.3f" ) % atm->Get<double>(CHARGE);
-            os << endl;
-        }
-        it++;
+    CAtomRange      atoms = unit->Atoms();
+    CFormatBuffer   buffer;
+
+    for(CAtomRange::iterator atm = atoms.begin(); atm != atoms.end(); atm++) {
+        buffer.Int( atm->Get<int>(SID), 8 );
+        buffer.Char( ' ' );
+        buffer.Left( atm->GetName(), 8 );
+        buffer.Char( ' ' );
+        buffer.Fixed( atm->Get<double>(POSX), 9, 3 );
+        buffer.Char( ' ' );
+        buffer.Fixed( atm->Get<double>(POSY), 9, 3 );
+        buffer.Char( ' ' );
+        buffer.Fixed( atm->Get<double>(POSZ), 9, 3 );
+        buffer.Char( ' ' );
+        buffer.Left( atm->Get<string>(TYPE), 8 );
+        buffer.Char( ' ' );
+        buffer.Int( atm->GetResidueId(), 8 );
+        buffer.Char( ' ' );
+        buffer.Left( atm->GetResidueName(), 8 );
+        buffer.Char( ' ' );
+        buffer.Fixed( atm->Get<double>(CHARGE), 9, 3 );
+        buffer.NewLine();
+        if( buffer.GetSize() > FLUSH_SIZE ) buffer.Flush( os );
     }
+    buffer.Flush( os );
 }
 
 // -------------------------------------------------------------------------
@@ -284,32 +338,26 @@ void CSybylMol2::WriteBonds( ostream& os, CUnitPtr& unit )
     }
     os << "@<TRIPOS>BOND" << std::endl;
 
-    CForwardIterator it = unit->BeginBonds();
-    CForwardIterator ie = unit->EndBonds();
+    CBondRange      bonds = unit->Bonds();
+    CFormatBuffer   buffer;
 
     int id = 1;
-    while( it != ie ) {
-        os << format("%8d ") % id;
+    for(CBondRange::iterator it = bonds.begin(); it != bonds.end(); it++) {
         int first = it->Get<CEntityPtr>(ATOM1)->Get<int>(SID);
         int second = it->Get<CEntityPtr>(ATOM2)->Get<int>(SID);
-        os << format( "%8d " ) % std::min( first, second );
-        os << format( "%8d " ) % std::max( first, second );
-        os << format( "%8d " ) % it->Get<int>(ORDER);
-        os << std::endl;
+        buffer.Int( id, 8 );
+        buffer.Char( ' ' );
+        buffer.Int( std::min( first, second ), 8 );
+        buffer.Char( ' ' );
+        buffer.Int( std::max( first, second ), 8 );
+        buffer.Char( ' ' );
+        buffer.Int( it->Get<int>(ORDER), 8 );
+        buffer.Char( ' ' );
+        buffer.NewLine();
+        if( buffer.GetSize() > FLUSH_SIZE ) buffer.Flush( os );
         id++;
-        it++;
     }
-}
-
-// -------------------------------------------------------------------------
-
-void CSybylMol2::rw_error( const string& reason )
-{
-    stringstream str;
-    str << reason << endl;
-    str << "       Line " << m_line_no << " : " << m_line;
-
-    throw runtime_error( str.str() );
+    buffer.Flush( os );
 }
 
 //==============================================================================
@@ -25,6 +25,7 @@
 #include <iosfwd>
 #include <types/Unit.hpp>
 #include <VerboseStr.hpp>
+#include <format/CommonIO.hpp>
 
 namespace nleap {
 //------------------------------------------------------------------------------
@@ -33,22 +34,23 @@ using namespace std;
 
 //------------------------------------------------------------------------------
 
-class NLEAP_PACKAGE CSybylMol2 {
+class NLEAP_PACKAGE CSybylMol2 : public CCommonIO {
 public:
 
     CSybylMol2( CVerboseStr& debug );
 
-    /// read mol2 file
+    /// read the first molecule from mol2 file
     void Read( istream& is, CUnitPtr& unit, int& top_id );
 
+    /// read next molecule from multi-molecule mol2 stream, false at the end of stream
+    bool ReadNext( istream& is, CUnitPtr& unit, int& top_id );
+
     /// write mol2 file
     void Write( ostream& os, CUnitPtr& unit );
 
 // private section -------------------------------------------------------------
 private:
-    CVerboseStr&            m_debug;
-    int                     m_line_no;
-    string                  m_line;
+    bool                    m_pending_molecule; // MOLECULE record already read
 
     int                     m_atoms;
     int                     m_bonds;
@@ -67,8 +69,6 @@ private:
     void WriteHead( ostream& os, CUnitPtr& unit );
     void WriteAtoms( ostream& os, CUnitPtr& unit );
     void WriteBonds( ostream& os, CUnitPtr& unit );
-
-    void rw_error( const string& reason );
 };
 
 //------------------------------------------------------------------------------
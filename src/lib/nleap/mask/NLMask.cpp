@@ -99,6 +99,20 @@ bool CNLMask::SetMask(const CSmallString& mask)
     if(Selection != NULL) delete Selection;
     Selection = NULL;
 
+// the parser uses global data, thus only one mask can be parsed at a time
+    bool result;
+    #pragma omp critical(nleap_mask_parser)
+    {
+        result = ParseMask();
+    }
+
+    return(result);
+}
+
+//------------------------------------------------------------------------------
+
+bool CNLMask::ParseMask(void)
+{
 // init mask parser
     init_mask();
 
@@ -178,6 +192,15 @@ bool CNLMask::IsAtomSelected(int index)
     return(Selection->GetSelectedAtom(index) != NULL);
 }
 
+//------------------------------------------------------------------------------
+
+void CNLMask::GetSelectedIndices(std::vector<int>& indices)
+{
+    indices.clear();
+    if(Selection == NULL) return;
+    Selection->GetSelectedIndices(indices);
+}
+
 //==============================================================================
 //------------------------------------------------------------------------------
 //==============================================================================
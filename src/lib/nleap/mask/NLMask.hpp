@@ -23,6 +23,7 @@
 #include <NLEaPMainHeader.hpp>
 #include <SmallString.hpp>
 #include <NLEaPMainHeader.hpp>
+#include <vector>
 
 //---------------------------------------------------------------------------
 
@@ -61,12 +62,16 @@ public:
     int         GetNumberOfSelectedAtoms(void);
     CNLAtom*    GetSelectedAtom(int index);
     bool        IsAtomSelected(int index);
+    void        GetSelectedIndices(std::vector<int>& indices);
 
 // section of private data ----------------------------------------------------
 private:
     CNLTopology*        Topology;
     CSmallString        Mask;
     CNLMaskSelection*   Selection;
+
+    //! parse mask and build selection tree, the parser is not reentrant
+    bool ParseMask(void);
 };
 
 //---------------------------------------------------------------------------
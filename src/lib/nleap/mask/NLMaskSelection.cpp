@@ -22,11 +22,70 @@
 #include <string.h>
 #include <ctype.h>
 #include <stdlib.h>
+#include <math.h>
 #include <ErrorSystem.hpp>
+#include <algorithm>
 
 #include <mask/NLTopology.hpp>
 #include <mask/NLMaskSelection.hpp>
 #include <mask/NLMask.hpp>
+#include <mask/NLSpatialGrid.hpp>
+
+#define NL_WORD_BITS 64
+
+//------------------------------------------------------------------------------
+
+static inline int nl_popcount(uint64_t word)
+{
+#if defined(__GNUC__)
+    return(__builtin_popcountll(word));
+#else
+    int count = 0;
+    while(word != 0) {
+        word &= word - 1;
+        count++;
+    }
+    return(count);
+#endif
+}
+
+//------------------------------------------------------------------------------
+
+static inline int nl_ctz(uint64_t word)
+{
+#if defined(__GNUC__)
+    return(__builtin_ctzll(word));
+#else
+    int count = 0;
+    while((word & 1) == 0) {
+        word >>= 1;
+        count++;
+    }
+    return(count);
+#endif
+}
+
+//------------------------------------------------------------------------------
+
+// centroid of residue and radius of sphere enclosing all its atoms
+static void GetResidueSphere(CNLTopology* p_top,CNLResidue* p_res,
+                             CPoint& centre,double& radius)
+{
+    centre = CPoint();
+    radius = 0.0;
+    if(p_res->GetNumberOfAtoms() <= 0) return;
+
+    for(int j = 0; j < p_res->GetNumberOfAtoms(); j++) {
+        centre += p_top->GetAtom(j + p_res->GetFirstAtomIndex())->GetPosition();
+    }
+    centre /= p_res->GetNumberOfAtoms();
+
+    for(int j = 0; j < p_res->GetNumberOfAtoms(); j++) {
+        double r2 = Square(p_top->GetAtom(j + p_res->GetFirstAtomIndex())->GetPosition() - centre);
+        if(r2 > radius) radius = r2;
+    }
+    radius = sqrt(radius);
+}
 
 //==============================================================================
 //------------------------------------------------------------------------------
@@ -35,9 +94,11 @@
 CNLMaskSelection::CNLMaskSelection(CNLMask* p_owner)
 {
     Owner = p_owner;
-    if(Owner->GetNumberOfTopologyAtoms() > 0) {
-        Atoms.CreateVector(Owner->GetNumberOfTopologyAtoms());
-        for(int i=0; i < Owner->GetNumberOfTopologyAtoms(); i++) Atoms[i] = NULL;
+    NumOfAtoms = Owner->GetNumberOfTopologyAtoms();
+    NumOfWords = (NumOfAtoms + NL_WORD_BITS - 1) / NL_WORD_BITS;
+    if(NumOfWords > 0) {
+        Bits.CreateVector(NumOfWords);
+        for(int i=0; i < NumOfWords; i++) Bits[i] = 0;
     }
 }
 
@@ -53,8 +114,8 @@ CNLMaskSelection::~CNLMaskSelection(void)
 
 bool CNLMaskSelection::ExpandAndReduceTree(struct SExpression* p_expr)
 {
-    if(Atoms == NULL) {
-        ES_ERROR("Atoms is NULL");
+    if(NumOfWords == 0) {
+        ES_ERROR("selection is empty");
         return(false);
     }
 
@@ -88,7 +149,6 @@ bool CNLMaskSelection::ExpandAndReduceTree(
     }
 
     CNLMaskSelection* p_left  = NULL;
-    CNLMaskSelection* p_right = NULL;
 
 // it is operator - allocate left operand
     switch(p_expr->Operator) {
@@ -147,15 +207,14 @@ bool CNLMaskSelection::ExpandAndReduceTree(
             return(false);
     }
 
-// it is operator - allocate right operand
+// expand and reduce right operand directly to the root selection,
+// which is empty at this moment, and combine it with the left operand
     switch(p_expr->Operator) {
         case O_NOT:
         case O_AND:
         case O_OR:
-            try {
-                p_right = new CNLMaskSelection(p_root->Owner);
-            } catch(...) {
-                ES_ERROR("unable to allocate right operand");
+            if(ExpandAndReduceTree(p_root,p_expr->RightExpression) == false) {
+                ES_ERROR("cannot expand and reduce right operand");
                 if(p_left != NULL) delete p_left;
                 return(false);
             }
@@ -172,44 +231,16 @@ bool CNLMaskSelection::ExpandAndReduceTree(
             return(false);
     }
 
-// expand and reduce right operand
-    if(p_right != NULL) {
-        if(ExpandAndReduceTree(p_right,p_expr->RightExpression) == false) {
-            ES_ERROR("cannot expand and reduce right operand");
-            if(p_left != NULL) delete p_left;
-            delete p_right;
-            return(false);
-        }
-    }
-
 // do arithemetic
     switch(p_expr->Operator) {
         case O_NOT:
-            for(int i=0; i < p_root->Owner->GetNumberOfTopologyAtoms(); i++) {
-                if(p_right->Atoms[i] == NULL) {
-                    p_root->Atoms[i] = p_root->Owner->GetTopology()->GetAtom(i);
-                } else {
-                    p_root->Atoms[i] = NULL;
-                }
-            }
+            p_root->Invert();
             break;
         case O_AND:
-            for(int i=0; i < p_root->Owner->GetNumberOfTopologyAtoms(); i++) {
-                if((p_left->Atoms[i] != NULL) && (p_right->Atoms[i] != NULL)) {
-                    p_root->Atoms[i] = p_root->Owner->GetTopology()->GetAtom(i);
-                } else {
-                    p_root->Atoms[i] = NULL;
-                }
-            }
+            p_root->And(p_left);
             break;
         case O_OR:
-            for(int i=0; i < p_root->Owner->GetNumberOfTopologyAtoms(); i++) {
-                if((p_left->Atoms[i] != NULL) || (p_right->Atoms[i] != NULL)) {
-                    p_root->Atoms[i] = p_root->Owner->GetTopology()->GetAtom(i);
-                } else {
-                    p_root->Atoms[i] = NULL;
-                }
-            }
+            p_root->Or(p_left);
             break;
         case O_RLT:
         case O_RGT: {
@@ -231,10 +262,14 @@ bool CNLMaskSelection::ExpandAndReduceTree(
                     result = p_root->SelectResidueByDistanceFromPlane(p_left,p_expr->Operator,p_expr->Distance);
                     break;
                 default:
+                    if(p_left != NULL) delete p_left;
                     ES_ERROR("not implemented");
                     return(false);
             }
-            if(result == false) return(false);
+            if(result == false) {
+                if(p_left != NULL) delete p_left;
+                return(false);
+            }
         }
         break;
         case O_AGT:
@@ -257,22 +292,24 @@ bool CNLMaskSelection::ExpandAndReduceTree(
                     result = p_root->SelectAtomByDistanceFromPlane(p_left,p_expr->Operator,p_expr->Distance);
                     break;
                 default:
+                    if(p_left != NULL) delete p_left;
                     ES_ERROR("not implemented");
                     return(false);
             }
-            if(result == false) return(false);
+            if(result == false) {
+                if(p_left != NULL) delete p_left;
+                return(false);
+            }
         }
         break;
         default:
             if(p_left != NULL) delete p_left;
-            if(p_right != NULL) delete p_right;
             ES_ERROR("not implemented");
             return(false);
     }
 
 // deallocate operands
     if(p_left != NULL) delete p_left;
-    if(p_right != NULL) delete p_right;
 
     return(true);
 }
@@ -300,9 +337,7 @@ bool CNLMaskSelection::Select(struct SSelection* p_sel)
     while(p_item != NULL) {
         if(p_item->Index < 0) {
             // no matter of selector - this always means all atoms
-            for(int i=0; i < Owner->GetNumberOfTopologyAtoms(); i++) {
-                Atoms[i] = Owner->GetTopology()->GetAtom(i);
-            }
+            SelectAll();
         }
         if(p_item->Index > 0) {
             if(p_item->Length >= 1) {
@@ -358,7 +393,7 @@ void CNLMaskSelection::SelectAtomByIndex(int index,int length)
 
         // check range - this is mandatory because mask can be general
         if((aindex >= 0) && (aindex < Owner->GetTopology()->GetNumberOfAtoms())) {
-            Atoms[aindex] = Owner->GetTopology()->GetAtom(aindex);
+            SetAtom(aindex);
         }
     }
 }
@@ -370,22 +405,15 @@ void CNLMaskSelection::SelectAtomByName(const char* p_name)
 // wild card '*' is treated on parser level!
 // see bool Select(struct SSelection* p_sel) method
 
-// here we need to manage only '=' wild card
-// this wild card can be only at the end of p_name
+// here we need to manage only '=', '*', and '?' wild cards within the name
 
-    int search_len = 4;
-// try to find wild card
-    for(int i=3; i >= 0; i--) {
-        if(p_name[i] == '=') {
-            search_len = i;
-            break;
-        }
-    }
+    std::vector<const std::vector<int>*> lists;
+    Owner->GetTopology()->MatchAtomNames(p_name,lists);
 
-    for(int i=0; i < Owner->GetTopology()->GetNumberOfAtoms(); i++) {
-        CNLAtom* p_atom = Owner->GetTopology()->GetAtom(i);
-        if(strncmp(p_atom->GetName(),p_name,search_len) == 0) {
-            Atoms[i] = p_atom;
+    for(size_t i=0; i < lists.size(); i++) {
+        const std::vector<int>& indices = *lists[i];
+        for(size_t j=0; j < indices.size(); j++) {
+            SetAtom(indices[j]);
         }
     }
 }
@@ -397,22 +425,15 @@ void CNLMaskSelection::SelectAtomByType(const char* p_name)
 // wild card '*' is treated on parser level!
 // see bool Select(struct SSelection* p_sel) method
 
-// here we need to manage only '=' wild card
-// this wild card can be only at the end of p_name
+// here we need to manage only '=', '*', and '?' wild cards within the name
 
-    int search_len = 4;
-// try to find wild card
-    for(int i=3; i >= 0; i--) {
-        if(p_name[i] == '=') {
-            search_len = i;
-            break;
-        }
-    }
+    std::vector<const std::vector<int>*> lists;
+    Owner->GetTopology()->MatchAtomTypes(p_name,lists);
 
-    for(int i=0; i < Owner->GetTopology()->GetNumberOfAtoms(); i++) {
-        CNLAtom* p_atom = Owner->GetTopology()->GetAtom(i);
-        if(strncmp(p_atom->GetType(),p_name,search_len) == 0) {
-            Atoms[i] = p_atom;
+    for(size_t i=0; i < lists.size(); i++) {
+        const std::vector<int>& indices = *lists[i];
+        for(size_t j=0; j < indices.size(); j++) {
+            SetAtom(indices[j]);
         }
     }
 }
@@ -428,10 +449,7 @@ void CNLMaskSelection::SelectResidueByIndex(int index,int length)
                 (rindex < Owner->GetTopology()->GetNumberOfResidues())) {
             CNLResidue* p_res = Owner->GetTopology()->GetResidue(rindex);
             // select whole residue
-            for(int j = 0; j < p_res->GetNumberOfAtoms(); j++) {
-                int aindex = j + p_res->GetFirstAtomIndex();
-                Atoms[aindex] = Owner->GetTopology()->GetAtom(aindex);
-            }
+            SetAtomRange(p_res->GetFirstAtomIndex(),p_res->GetNumberOfAtoms());
         }
     }
 }
@@ -443,26 +461,16 @@ void CNLMaskSelection::SelectResidueByName(const char* p_name)
 // wild card '*' is treated on parser level!
 // see bool Select(struct SSelection* p_sel) method
 
-// here we need to manage only '=' wild card
-// this wild card can be only at the end
-
-    int search_len = 4;
-// try to find wild card
-    for(int i=3; i >= 0; i--) {
-        if(p_name[i] == '=') {
-            search_len = i;
-            break;
-        }
-    }
+// here we need to manage only '=', '*', and '?' wild cards within the name
 
-    for(int i=0; i < Owner->GetTopology()->GetNumberOfResidues(); i++) {
-        CNLResidue* p_res = Owner->GetTopology()->GetResidue(i);
+    std::vector<const std::vector<int>*> lists;
+    Owner->GetTopology()->MatchResidueNames(p_name,lists);
 
-        if(strncmp(p_res->GetName(),p_name,search_len) == 0) {
-            for(int j = 0; j < p_res->GetNumberOfAtoms(); j++) {
-                int aindex = j + p_res->GetFirstAtomIndex();
-                Atoms[aindex] = Owner->GetTopology()->GetAtom(aindex);
-            }
+    for(size_t i=0; i < lists.size(); i++) {
+        const std::vector<int>& indices = *lists[i];
+        for(size_t j=0; j < indices.size(); j++) {
+            CNLResidue* p_res = Owner->GetTopology()->GetResidue(indices[j]);
+            SetAtomRange(p_res->GetFirstAtomIndex(),p_res->GetNumberOfAtoms());
         }
     }
 }
@@ -481,10 +489,10 @@ bool CNLMaskSelection::SelectAtomByDistanceFromOrigin(SOperator dist_oper,double
         double ldist2 = Square(pos);
         switch(dist_oper) {
             case O_ALT:
-                if(ldist2 < dist2) Atoms[i] = p_atom;
+                if(ldist2 < dist2) SetAtom(i);
                 break;
             case O_AGT:
-                if(ldist2 > dist2) Atoms[i] = p_atom;
+                if(ldist2 > dist2) SetAtom(i);
                 break;
             case O_RLT:
             case O_RGT:
@@ -515,10 +523,10 @@ bool CNLMaskSelection::SelectAtomByDistanceFromCentreOfBox(SOperator dist_oper,d
         double ldist2 = Square(pos-cbox);
         switch(dist_oper) {
             case O_ALT:
-                if(ldist2 < dist2) Atoms[i] = p_atom;
+                if(ldist2 < dist2) SetAtom(i);
                 break;
             case O_AGT:
-                if(ldist2 > dist2) Atoms[i] = p_atom;
+                if(ldist2 > dist2) SetAtom(i);
                 break;
             case O_RLT:
             case O_RGT:
@@ -536,37 +544,25 @@ bool CNLMaskSelection::SelectAtomByDistanceFromCentreOfBox(SOperator dist_oper,d
 bool CNLMaskSelection::SelectAtomByDistanceFromList(CNLMaskSelection* p_left,
         SOperator dist_oper,double dist)
 {
-    double dist2 = dist*dist;
+    if((dist_oper != O_ALT) && (dist_oper != O_AGT)) {
+        ES_ERROR("incorrect operator");
+        return(false);
+    }
+
+    std::vector<int> ref;
+    p_left->GetSelectedIndices(ref);
+    if(ref.empty()) return(true);
+
+// spatial grid over reference atoms
+    CNLSpatialGrid grid;
+    grid.Build(Owner->GetTopology(),ref,dist);
 
     for(int i=0; i < Owner->GetTopology()->GetNumberOfAtoms(); i++) {
-        CNLAtom* p_atom1 = Owner->GetTopology()->GetAtom(i);
-        CPoint pos1 = p_atom1->GetPosition();
-
-        for(int j=0; j < Owner->GetTopology()->GetNumberOfAtoms(); j++) {
-            if(p_left->Atoms[j] == NULL) continue;
-            CPoint pos2 = p_left->Atoms[j]->GetPosition();
-            double ldist2 = Square(pos2-pos1);
-            bool set = false;
-            switch(dist_oper) {
-                case O_ALT:
-                    if(ldist2 < dist2) {
-                        Atoms[i] = p_atom1;
-                        set = true;
-                    }
-                    break;
-                case O_AGT:
-                    if(ldist2 > dist2) {
-                        Atoms[i] = p_atom1;
-                        set = true;
-                    }
-                    break;
-                case O_RLT:
-                case O_RGT:
-                default:
-                    ES_ERROR("incorrect operator");
-                    return(false);
-            }
-            if(set == true) break;
+        const CPoint& pos = Owner->GetTopology()->GetAtom(i)->GetPosition();
+        if(dist_oper == O_ALT) {
+            if(grid.HasPointWithin(pos,dist)) SetAtom(i);
+        } else {
+            if(grid.HasPointFartherThan(pos,dist)) SetAtom(i);
         }
     }
 
@@ -582,9 +578,11 @@ bool CNLMaskSelection::SelectAtomByDistanceFromCOM(CNLMaskSelection* p_left,
     CPoint     com;
     double     tmass = 0.0;
 
-    for(int i=0; i < Owner->GetTopology()->GetNumberOfAtoms(); i++) {
-        if(p_left->Atoms[i] == NULL) continue;
-        CNLAtom* p_atom = Owner->GetTopology()->GetAtom(i);
+    std::vector<int> ref;
+    p_left->GetSelectedIndices(ref);
+
+    for(size_t i=0; i < ref.size(); i++) {
+        CNLAtom* p_atom = Owner->GetTopology()->GetAtom(ref[i]);
         double mass = p_atom->GetMass();
         com += p_atom->GetPosition()*mass;
         tmass += mass;
@@ -602,10 +600,10 @@ bool CNLMaskSelection::SelectAtomByDistanceFromCOM(CNLMaskSelection* p_left,
         double ldist2 = Square(pos-com);
         switch(dist_oper) {
             case O_ALT:
-                if(ldist2 < dist2) Atoms[i] = p_atom;
+                if(ldist2 < dist2) SetAtom(i);
                 break;
             case O_AGT:
-                if(ldist2 > dist2) Atoms[i] = p_atom;
+                if(ldist2 > dist2) SetAtom(i);
                 break;
             case O_RLT:
             case O_RGT:
@@ -664,10 +662,7 @@ bool CNLMaskSelection::SelectResidueByDistanceFromOrigin(SOperator dist_oper,dou
 
         // select residue
         if(set) {
-            for(int j = 0; j < p_res->GetNumberOfAtoms(); j++) {
-                int aindex = j + p_res->GetFirstAtomIndex();
-                Atoms[aindex] = Owner->GetTopology()->GetAtom(aindex);
-            }
+            SetAtomRange(p_res->GetFirstAtomIndex(),p_res->GetNumberOfAtoms());
         }
     }
 
@@ -714,10 +709,7 @@ bool CNLMaskSelection::SelectResidueByDistanceFromCentreOfBox(SOperator dist_ope
 
         // select residue
         if(set) {
-            for(int j = 0; j < p_res->GetNumberOfAtoms(); j++) {
-                int aindex = j + p_res->GetFirstAtomIndex();
-                Atoms[aindex] = Owner->GetTopology()->GetAtom(aindex);
-            }
+            SetAtomRange(p_res->GetFirstAtomIndex(),p_res->GetNumberOfAtoms());
         }
     }
 
@@ -729,52 +721,63 @@ bool CNLMaskSelection::SelectResidueByDistanceFromCentreOfBox(SOperator dist_ope
 bool CNLMaskSelection::SelectResidueByDistanceFromList(CNLMaskSelection* p_left,
         SOperator dist_oper,double dist)
 {
-    double dist2 = dist*dist;
+    if((dist_oper != O_RLT) && (dist_oper != O_RGT)) {
+        ES_ERROR("incorrect operator");
+        return(false);
+    }
+
+    std::vector<int> ref;
+    p_left->GetSelectedIndices(ref);
+    if(ref.empty()) return(true);
+
+// spatial grid over reference atoms
+    CNLSpatialGrid grid;
+    grid.Build(Owner->GetTopology(),ref,dist);
+
+    CPoint  ref_centre;
+    double  ref_radius;
+    grid.GetBoundingSphere(ref_centre,ref_radius);
 
     for(int i=0; i < Owner->GetTopology()->GetNumberOfResidues(); i++) {
         CNLResidue* p_res = Owner->GetTopology()->GetResidue(i);
+        if(p_res->GetNumberOfAtoms() <= 0) continue;
+
+        CPoint  centre;
+        double  radius;
+        GetResidueSphere(Owner->GetTopology(),p_res,centre,radius);
 
         bool set = false;
 
-        // check any distance
-        for(int j = 0; j < p_res->GetNumberOfAtoms(); j++) {
-            int aindex = j + p_res->GetFirstAtomIndex();
-            CPoint pos1 = Owner->GetTopology()->GetAtom(aindex)->GetPosition();
-
-            for(int k=0; k < Owner->GetTopology()->GetNumberOfAtoms(); k++) {
-                if(p_left->Atoms[k] == NULL) continue;
-                CPoint pos2 = p_left->Atoms[k]->GetPosition();
-                double ldist2 = Square(pos2-pos1);
-
-                switch(dist_oper) {
-                    case O_RLT:
-                        if(ldist2 < dist2) {
-                            set = true;
-                        }
+        if(dist_oper == O_RLT) {
+            // early rejection - no reference atom close to the residue sphere
+            if(grid.HasPointWithin(centre,dist + radius)) {
+                for(int j = 0; j < p_res->GetNumberOfAtoms(); j++) {
+                    int aindex = j + p_res->GetFirstAtomIndex();
+                    if(grid.HasPointWithin(Owner->GetTopology()->GetAtom(aindex)->GetPosition(),dist)) {
+                        set = true;
                         break;
-                    case O_RGT:
-                        if(ldist2 > dist2) {
-                            set = true;
-                        }
+                    }
+                }
+            }
+        } else {
+            double cdist = sqrt(Square(centre - ref_centre));
+            if(cdist - radius - ref_radius > dist) {
+                // all pairs are farther than dist
+                set = true;
+            } else if(cdist + radius + ref_radius > dist) {
+                for(int j = 0; j < p_res->GetNumberOfAtoms(); j++) {
+                    int aindex = j + p_res->GetFirstAtomIndex();
+                    if(grid.HasPointFartherThan(Owner->GetTopology()->GetAtom(aindex)->GetPosition(),dist)) {
+                        set = true;
                         break;
-                    case O_ALT:
-                    case O_AGT:
-                    default:
-                        ES_ERROR("incorrect operator");
-                        return(false);
+                    }
                 }
-                if(set == true) break;
             }
-
-            if(set == true) break;
         }
 
         // select residue
         if(set) {
-            for(int j = 0; j < p_res->GetNumberOfAtoms(); j++) {
-                int aindex = j + p_res->GetFirstAtomIndex();
-                Atoms[aindex] = Owner->GetTopology()->GetAtom(aindex);
-            }
+            SetAtomRange(p_res->GetFirstAtomIndex(),p_res->GetNumberOfAtoms());
         }
     }
 
@@ -790,9 +793,11 @@ bool CNLMaskSelection::SelectResidueByDistanceFromCOM(CNLMaskSelection* p_left,
     CPoint     com;
     double     tmass = 0.0;
 
-    for(int i=0; i < Owner->GetTopology()->GetNumberOfAtoms(); i++) {
-        if(p_left->Atoms[i] == NULL) continue;
-        CNLAtom* p_atom = Owner->GetTopology()->GetAtom(i);
+    std::vector<int> ref;
+    p_left->GetSelectedIndices(ref);
+
+    for(size_t i=0; i < ref.size(); i++) {
+        CNLAtom* p_atom = Owner->GetTopology()->GetAtom(ref[i]);
         double mass = p_atom->GetMass();
         com += p_atom->GetPosition()*mass;
         tmass += mass;
@@ -831,10 +836,7 @@ bool CNLMaskSelection::SelectResidueByDistanceFromCOM(CNLMaskSelection* p_left,
 
         // select residue
         if(set) {
-            for(int j = 0; j < p_res->GetNumberOfAtoms(); j++) {
-                int aindex = j + p_res->GetFirstAtomIndex();
-                Atoms[aindex] = Owner->GetTopology()->GetAtom(aindex);
-            }
+            SetAtomRange(p_res->GetFirstAtomIndex(),p_res->GetNumberOfAtoms());
         }
     }
 
@@ -858,12 +860,10 @@ bool CNLMaskSelection::SelectResidueByDistanceFromPlane(CNLMaskSelection* p_left
 
 int CNLMaskSelection::GetNumberOfSelectedAtoms(void)
 {
-    if(Atoms == NULL) return(0);
-
     int num_of_select_atoms = 0;
 
-    for(int i=0; i < Owner->GetNumberOfTopologyAtoms(); i++) {
-        if(Atoms[i] != NULL) num_of_select_atoms++;
+    for(int i=0; i < NumOfWords; i++) {
+        num_of_select_atoms += nl_popcount(Bits[i]);
     }
 
     return(num_of_select_atoms);
@@ -873,12 +873,101 @@ int CNLMaskSelection::GetNumberOfSelectedAtoms(void)
 
 CNLAtom* CNLMaskSelection::GetSelectedAtom(int index)
 {
-    if(Atoms == NULL) return(NULL);
-    return(Atoms[index]);
+    if((index < 0) || (index >= NumOfAtoms)) return(NULL);
+    if(! IsAtomSet(index)) return(NULL);
+    return(Owner->GetTopology()->GetAtom(index));
+}
+
+//------------------------------------------------------------------------------
+
+void CNLMaskSelection::GetSelectedIndices(std::vector<int>& indices)
+{
+    indices.clear();
+    indices.reserve(GetNumberOfSelectedAtoms());
+
+    for(int i=0; i < NumOfWords; i++) {
+        uint64_t word = Bits[i];
+        while(word != 0) {
+            indices.push_back(i*NL_WORD_BITS + nl_ctz(word));
+            word &= word - 1;   // clear the lowest set bit
+        }
+    }
 }
 
 //==============================================================================
 //------------------------------------------------------------------------------
 //==============================================================================
 
+bool CNLMaskSelection::IsAtomSet(int index)
+{
+    return( (Bits[index / NL_WORD_BITS] >> (index % NL_WORD_BITS)) & 1 );
+}
 
+//------------------------------------------------------------------------------
+
+void CNLMaskSelection::SetAtom(int index)
+{
+    Bits[index / NL_WORD_BITS] |= ((uint64_t)1) << (index % NL_WORD_BITS);
+}
+
+//------------------------------------------------------------------------------
+
+void CNLMaskSelection::SetAtomRange(int first,int length)
+{
+    int last = std::min(first + length,NumOfAtoms);
+    if(first < 0) first = 0;
+    if(first >= last) return;
+
+    int fword = first / NL_WORD_BITS;
+    int lword = (last - 1) / NL_WORD_BITS;
+
+    uint64_t fmask = ~((uint64_t)0) << (first % NL_WORD_BITS);
+    uint64_t lmask = ~((uint64_t)0) >> (NL_WORD_BITS - 1 - (last - 1) % NL_WORD_BITS);
+
+    if(fword == lword) {
+        Bits[fword] |= fmask & lmask;
+        return;
+    }
+
+    Bits[fword] |= fmask;
+    for(int i=fword+1; i < lword; i++) Bits[i] = ~((uint64_t)0);
+    Bits[lword] |= lmask;
+}
+
+//------------------------------------------------------------------------------
+
+void CNLMaskSelection::SelectAll(void)
+{
+    SetAtomRange(0,NumOfAtoms);
+}
+
+//------------------------------------------------------------------------------
+
+void CNLMaskSelection::Invert(void)
+{
+    for(int i=0; i < NumOfWords; i++) Bits[i] = ~Bits[i];
+
+    // clear bits beyond the last atom
+    int tail = NumOfAtoms % NL_WORD_BITS;
+    if((NumOfWords > 0) && (tail != 0)) {
+        Bits[NumOfWords-1] &= ~((uint64_t)0) >> (NL_WORD_BITS - tail);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void CNLMaskSelection::And(CNLMaskSelection* p_sel)
+{
+    for(int i=0; i < NumOfWords; i++) Bits[i] &= p_sel->Bits[i];
+}
+
+//------------------------------------------------------------------------------
+
+void CNLMaskSelection::Or(CNLMaskSelection* p_sel)
+{
+    for(int i=0; i < NumOfWords; i++) Bits[i] |= p_sel->Bits[i];
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
@@ -23,6 +23,8 @@
 #include <NLEaPMainHeader.hpp>
 #include <NLEaPMainHeader.hpp>
 #include <SimpleVector.hpp>
+#include <stdint.h>
+#include <vector>
 #include "maskparser/MaskParser.hpp"
 
 //---------------------------------------------------------------------------
@@ -33,6 +35,10 @@ class CNLAtom;
 //---------------------------------------------------------------------------
 
 //! selection of atoms
+/*!
+ selection is stored as packed bitset (one bit per topology atom), logical
+ operators are evaluated over whole 64-bit words
+*/
 
 class NLEAP_PACKAGE CNLMaskSelection {
 public:
@@ -46,10 +52,24 @@ public:
     int             GetNumberOfSelectedAtoms(void);
     CNLAtom*       GetSelectedAtom(int index);
 
+    //! get indices of selected atoms in ascending order
+    void            GetSelectedIndices(std::vector<int>& indices);
+
 // section of private data ----------------------------------------------------
 private:
     CNLMask*                   Owner;
-    CSimpleVector<CNLAtom*>    Atoms;
+    int                        NumOfAtoms;
+    int                        NumOfWords;
+    CSimpleVector<uint64_t>    Bits;
+
+    // bitset operations
+    bool IsAtomSet(int index);
+    void SetAtom(int index);
+    void SetAtomRange(int first,int length);
+    void SelectAll(void);
+    void Invert(void);
+    void And(CNLMaskSelection* p_sel);
+    void Or(CNLMaskSelection* p_sel);
 
     static bool ExpandAndReduceTree(CNLMaskSelection* p_root,
                                     struct SExpression* p_expr);
@@ -81,9 +101,6 @@ private:
                                         SOperator dist_oper,double dist);
     bool SelectResidueByDistanceFromPlane(CNLMaskSelection* p_left,
                                           SOperator dist_oper,double dist);
-
-    int   strnlen(const char* p_s1,int len);
-    bool  firstmatch(const char* p_s1,const char* p_s2,int len);
 };
 
 //---------------------------------------------------------------------------
@@ -0,0 +1,270 @@
+// =============================================================================
+// nLEaP - A molecular manipulation program and coding environment
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2011 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <mask/NLSpatialGrid.hpp>
+#include <mask/NLTopology.hpp>
+#include <math.h>
+
+// maximum number of cells in one direction
+#define NL_GRID_MAX_CELLS 128
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CNLSpatialGrid::CNLSpatialGrid(void)
+{
+    CellSize = 1.0;
+    NX = 0;
+    NY = 0;
+    NZ = 0;
+    SphereRadius = 0.0;
+}
+
+//------------------------------------------------------------------------------
+
+CNLSpatialGrid::~CNLSpatialGrid(void)
+{
+
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CNLSpatialGrid::Build(CNLTopology* p_top,const std::vector<int>& indices,
+                           double cell_size)
+{
+    Points.clear();
+    CellStart.clear();
+    Extremes.clear();
+    NX = NY = NZ = 0;
+    SphereCentre = CPoint();
+    SphereRadius = 0.0;
+
+    int npoints = indices.size();
+    if(npoints == 0) return;
+
+// bounding box and centroid
+    CPoint lo = p_top->GetAtom(indices[0])->GetPosition();
+    CPoint hi = lo;
+    for(int i=0; i < npoints; i++) {
+        const CPoint& pos = p_top->GetAtom(indices[i])->GetPosition();
+        if(pos.x < lo.x) lo.x = pos.x;
+        if(pos.y < lo.y) lo.y = pos.y;
+        if(pos.z < lo.z) lo.z = pos.z;
+        if(pos.x > hi.x) hi.x = pos.x;
+        if(pos.y > hi.y) hi.y = pos.y;
+        if(pos.z > hi.z) hi.z = pos.z;
+        SphereCentre += pos;
+    }
+    SphereCentre /= npoints;
+
+    for(int i=0; i < npoints; i++) {
+        double r2 = Square(p_top->GetAtom(indices[i])->GetPosition() - SphereCentre);
+        if(r2 > SphereRadius) SphereRadius = r2;
+    }
+    SphereRadius = sqrt(SphereRadius);
+
+// points closest to corners of the bounding box
+    for(int c=0; c < 8; c++) {
+        CPoint corner((c & 1) ? hi.x : lo.x,(c & 2) ? hi.y : lo.y,(c & 4) ? hi.z : lo.z);
+        int    best = 0;
+        double best_d2 = -1.0;
+        for(int i=0; i < npoints; i++) {
+            double d2 = Square(p_top->GetAtom(indices[i])->GetPosition() - corner);
+            if((best_d2 < 0.0) || (d2 < best_d2)) {
+                best = i;
+                best_d2 = d2;
+            }
+        }
+        Extremes.push_back(p_top->GetAtom(indices[best])->GetPosition());
+    }
+
+// grid dimensions
+    CPoint extent = hi - lo;
+    double max_extent = extent.x;
+    if(extent.y > max_extent) max_extent = extent.y;
+    if(extent.z > max_extent) max_extent = extent.z;
+
+    CellSize = cell_size;
+    if(CellSize * NL_GRID_MAX_CELLS < max_extent) {
+        CellSize = max_extent / NL_GRID_MAX_CELLS;
+    }
+    if(CellSize <= 0.0) CellSize = 1.0;
+
+    Origin = lo;
+    NX = (int)(extent.x / CellSize) + 1;
+    NY = (int)(extent.y / CellSize) + 1;
+    NZ = (int)(extent.z / CellSize) + 1;
+
+// sort points into cells (counting sort)
+    std::vector<int> cells(npoints);
+    CellStart.assign(NX*NY*NZ + 1,0);
+
+    for(int i=0; i < npoints; i++) {
+        const CPoint& pos = p_top->GetAtom(indices[i])->GetPosition();
+        int ix = (int)((pos.x - Origin.x) / CellSize);
+        int iy = (int)((pos.y - Origin.y) / CellSize);
+        int iz = (int)((pos.z - Origin.z) / CellSize);
+        if(ix >= NX) ix = NX - 1;
+        if(iy >= NY) iy = NY - 1;
+        if(iz >= NZ) iz = NZ - 1;
+        cells[i] = (iz*NY + iy)*NX + ix;
+        CellStart[cells[i]+1]++;
+    }
+
+    for(size_t c=1; c < CellStart.size(); c++) {
+        CellStart[c] += CellStart[c-1];
+    }
+
+    std::vector<int> fill(CellStart.begin(),CellStart.end()-1);
+    Points.resize(npoints);
+    for(int i=0; i < npoints; i++) {
+        Points[fill[cells[i]]++] = p_top->GetAtom(indices[i])->GetPosition();
+    }
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+int CNLSpatialGrid::GetNumberOfPoints(void) const
+{
+    return(Points.size());
+}
+
+//------------------------------------------------------------------------------
+
+void CNLSpatialGrid::GetBoundingSphere(CPoint& centre,double& radius) const
+{
+    centre = SphereCentre;
+    radius = SphereRadius;
+}
+
+//------------------------------------------------------------------------------
+
+bool CNLSpatialGrid::GetCellRange(const CPoint& pos,double dist,int* lo,int* hi) const
+{
+    if(Points.empty() || (dist < 0.0)) return(false);
+
+    double plo[3], phi[3];
+    plo[0] = (pos.x - dist - Origin.x) / CellSize;
+    plo[1] = (pos.y - dist - Origin.y) / CellSize;
+    plo[2] = (pos.z - dist - Origin.z) / CellSize;
+    phi[0] = (pos.x + dist - Origin.x) / CellSize;
+    phi[1] = (pos.y + dist - Origin.y) / CellSize;
+    phi[2] = (pos.z + dist - Origin.z) / CellSize;
+
+    int n[3];
+    n[0] = NX;
+    n[1] = NY;
+    n[2] = NZ;
+
+    for(int k=0; k < 3; k++) {
+        if((phi[k] < 0.0) || (plo[k] >= n[k])) return(false);
+        lo[k] = plo[k] < 0.0 ? 0 : (int)plo[k];
+        hi[k] = phi[k] >= n[k] ? n[k] - 1 : (int)phi[k];
+    }
+
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+bool CNLSpatialGrid::HasPointWithin(const CPoint& pos,double dist) const
+{
+    int lo[3], hi[3];
+    if(GetCellRange(pos,dist,lo,hi) == false) return(false);
+
+    double dist2 = dist*dist;
+
+    for(int iz = lo[2]; iz <= hi[2]; iz++) {
+        for(int iy = lo[1]; iy <= hi[1]; iy++) {
+            int row = (iz*NY + iy)*NX;
+            for(int p = CellStart[row + lo[0]]; p < CellStart[row + hi[0] + 1]; p++) {
+                if(Square(Points[p] - pos) < dist2) return(true);
+            }
+        }
+    }
+
+    return(false);
+}
+
+//------------------------------------------------------------------------------
+
+bool CNLSpatialGrid::HasPointFartherThan(const CPoint& pos,double dist) const
+{
+    if(Points.empty()) return(false);
+
+// quick tests by bounding sphere
+    double cdist = sqrt(Square(pos - SphereCentre));
+    if(cdist - SphereRadius > dist) return(true);
+    if(cdist + SphereRadius <= dist) return(false);
+
+    double dist2 = dist*dist;
+
+// the farthest point is usually one of the extreme points
+    for(size_t i=0; i < Extremes.size(); i++) {
+        if(Square(Extremes[i] - pos) > dist2) return(true);
+    }
+
+// scan cells that can contain farther point
+    for(int iz = 0; iz < NZ; iz++) {
+        for(int iy = 0; iy < NY; iy++) {
+            for(int ix = 0; ix < NX; ix++) {
+                int c = (iz*NY + iy)*NX + ix;
+                if(CellStart[c] == CellStart[c+1]) continue;
+
+                double lo[3], hi[3], p[3];
+                lo[0] = Origin.x + ix*CellSize;
+                lo[1] = Origin.y + iy*CellSize;
+                lo[2] = Origin.z + iz*CellSize;
+                p[0] = pos.x;
+                p[1] = pos.y;
+                p[2] = pos.z;
+
+                double mind2 = 0.0;
+                double maxd2 = 0.0;
+                for(int k=0; k < 3; k++) {
+                    hi[k] = lo[k] + CellSize;
+                    double dlo = p[k] - lo[k];
+                    double dhi = p[k] - hi[k];
+                    if(dlo < 0.0) mind2 += dlo*dlo;
+                    if(dhi > 0.0) mind2 += dhi*dhi;
+                    maxd2 += dlo*dlo > dhi*dhi ? dlo*dlo : dhi*dhi;
+                }
+
+                if(maxd2 <= dist2) continue;    // whole cell is within
+                if(mind2 > dist2) return(true); // whole cell is farther
+
+                for(int i = CellStart[c]; i < CellStart[c+1]; i++) {
+                    if(Square(Points[i] - pos) > dist2) return(true);
+                }
+            }
+        }
+    }
+
+    return(false);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
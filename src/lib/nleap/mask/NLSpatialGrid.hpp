@@ -0,0 +1,79 @@
+#ifndef NLSpatialGridH
+#define NLSpatialGridH
+// =============================================================================
+// nLEaP - A molecular manipulation program and coding environment
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2011 Petr Kulhanek, kulhanek@chemi.muni.cz
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <NLEaPMainHeader.hpp>
+#include <Point.hpp>
+#include <vector>
+
+//---------------------------------------------------------------------------
+
+class CNLTopology;
+
+//---------------------------------------------------------------------------
+
+/** \brief uniform cell grid over positions of reference atoms
+
+ used by distance operators of masks, each probe visits only cells
+ overlapping with the probe sphere
+*/
+
+class NLEAP_PACKAGE CNLSpatialGrid {
+public:
+// constructor and destructor -------------------------------------------------
+    CNLSpatialGrid(void);
+    ~CNLSpatialGrid(void);
+
+// setup methods --------------------------------------------------------------
+    //! build grid from given topology atoms, cell_size should be about probe radius
+    void    Build(CNLTopology* p_top,const std::vector<int>& indices,double cell_size);
+
+// informational methods ------------------------------------------------------
+    //! number of reference points
+    int     GetNumberOfPoints(void) const;
+
+    //! centre and radius of sphere enclosing all reference points
+    void    GetBoundingSphere(CPoint& centre,double& radius) const;
+
+    //! is there any reference point closer than dist?
+    bool    HasPointWithin(const CPoint& pos,double dist) const;
+
+    //! is there any reference point farther than dist?
+    bool    HasPointFartherThan(const CPoint& pos,double dist) const;
+
+// section of private data ----------------------------------------------------
+private:
+    CPoint              Origin;         // lower corner of the grid
+    double              CellSize;
+    int                 NX,NY,NZ;
+    std::vector<int>    CellStart;      // first point in cell, CSR form
+    std::vector<CPoint> Points;         // points ordered by cells
+    CPoint              SphereCentre;
+    double              SphereRadius;
+    std::vector<CPoint> Extremes;       // points on the boundary of the set
+
+    //! get range of cells overlapping with the sphere, false if there is none
+    bool    GetCellRange(const CPoint& pos,double dist,int* lo,int* hi) const;
+};
+
+//---------------------------------------------------------------------------
+
+#endif
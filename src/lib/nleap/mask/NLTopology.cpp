@@ -65,6 +65,9 @@ void CNLTopology::Clear(void)
     Residues.FreeVector();
     BoxPresent = false;
     BoxCenter = CPoint();
+    AtomNames.clear();
+    AtomTypes.clear();
+    ResidueNames.clear();
 }
 
 //------------------------------------------------------------------------------
@@ -148,6 +151,136 @@ void CNLTopology::Finalize(void)
             Atoms[j].Residue = &Residues[i];
         }
     }
+
+// build inverted indices, masks compare only first four characters
+    AtomNames.clear();
+    AtomTypes.clear();
+    ResidueNames.clear();
+
+    for(int i=0; i < Atoms.GetLength(); i++) {
+        AtomNames[std::string(Atoms[i].GetName()).substr(0,4)].push_back(i);
+        AtomTypes[std::string(Atoms[i].GetType()).substr(0,4)].push_back(i);
+    }
+    for(int i=0; i < Residues.GetLength(); i++) {
+        ResidueNames[std::string(Residues[i].GetName()).substr(0,4)].push_back(i);
+    }
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+// match name against pattern with '*' (any sequence) and '?' (any character)
+static bool NLGlobMatch(const std::string& pattern,const std::string& name)
+{
+    size_t p = 0;
+    size_t n = 0;
+    size_t star = std::string::npos;
+    size_t mark = 0;
+
+    while(n < name.size()) {
+        if((p < pattern.size()) && ((pattern[p] == '?') || (pattern[p] == name[n]))) {
+            p++;
+            n++;
+        } else if((p < pattern.size()) && (pattern[p] == '*')) {
+            star = p++;
+            mark = n;
+        } else if(star != std::string::npos) {
+            p = star + 1;
+            n = ++mark;
+        } else {
+            return(false);
+        }
+    }
+
+    while((p < pattern.size()) && (pattern[p] == '*')) p++;
+    return(p == pattern.size());
+}
+
+//------------------------------------------------------------------------------
+
+static std::string NLTrimRight(const std::string& str)
+{
+    size_t last = str.find_last_not_of(' ');
+    if(last == std::string::npos) return(std::string());
+    return(str.substr(0,last+1));
+}
+
+//------------------------------------------------------------------------------
+
+void CNLTopology::MatchNames(const CNLNameIndex& index,const char* p_pattern,
+                             std::vector<const std::vector<int>*>& lists)
+{
+    lists.clear();
+
+// names in the index have four characters padded by spaces, the pattern
+// from parser is padded too but shorter patterns must not be read past
+    std::string pattern(p_pattern,strnlen(p_pattern,4));
+    pattern.resize(4,' ');
+
+    bool wildcard = pattern.find_first_of("*?") != std::string::npos;
+
+    int search_len = 4;
+    if(wildcard) {
+        search_len = pattern.find_first_of("*?=");
+    } else {
+        // '=' wild card can be only at the end
+        for(int i=3; i >= 0; i--) {
+            if(pattern[i] == '=') {
+                search_len = i;
+                break;
+            }
+        }
+    }
+
+// exact name
+    if(search_len == 4) {
+        CNLNameIndex::const_iterator it = index.find(pattern);
+        if(it != index.end()) lists.push_back(&it->second);
+        return;
+    }
+
+// names with common prefix are adjacent in the index
+    std::string prefix = pattern.substr(0,search_len);
+    std::string glob;
+    if(wildcard) {
+        glob = NLTrimRight(pattern);
+        for(size_t i=0; i < glob.size(); i++) {
+            if(glob[i] == '=') glob[i] = '*';
+        }
+    }
+
+    CNLNameIndex::const_iterator it = index.lower_bound(prefix);
+    while((it != index.end()) && (it->first.compare(0,search_len,prefix) == 0)) {
+        if((! wildcard) || NLGlobMatch(glob,NLTrimRight(it->first))) {
+            lists.push_back(&it->second);
+        }
+        it++;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void CNLTopology::MatchAtomNames(const char* p_pattern,
+                                 std::vector<const std::vector<int>*>& lists) const
+{
+    MatchNames(AtomNames,p_pattern,lists);
+}
+
+//------------------------------------------------------------------------------
+
+void CNLTopology::MatchAtomTypes(const char* p_pattern,
+                                 std::vector<const std::vector<int>*>& lists) const
+{
+    MatchNames(AtomTypes,p_pattern,lists);
+}
+
+//------------------------------------------------------------------------------
+
+void CNLTopology::MatchResidueNames(const char* p_pattern,
+                                    std::vector<const std::vector<int>*>& lists) const
+{
+    MatchNames(ResidueNames,p_pattern,lists);
 }
 
 //==============================================================================
@@ -26,6 +26,14 @@
 #include <mask/NLResidue.hpp>
 #include <mask/NLAtom.hpp>
 #include <SimpleVector.hpp>
+#include <map>
+#include <string>
+#include <vector>
+
+//---------------------------------------------------------------------------
+
+//! sorted indices of atoms or residues for each name
+typedef std::map<std::string, std::vector<int> >    CNLNameIndex;
 
 //---------------------------------------------------------------------------
 
@@ -61,6 +69,19 @@ public:
     bool            HasBox(void) const;
     const CPoint&   GetBoxCenter(void) const;
 
+// name lookup ----------------------------------------------------------------
+    //! find index lists of atoms with name matching the mask pattern
+    void        MatchAtomNames(const char* p_pattern,
+                               std::vector<const std::vector<int>*>& lists) const;
+
+    //! find index lists of atoms with type matching the mask pattern
+    void        MatchAtomTypes(const char* p_pattern,
+                               std::vector<const std::vector<int>*>& lists) const;
+
+    //! find index lists of residues with name matching the mask pattern
+    void        MatchResidueNames(const char* p_pattern,
+                                  std::vector<const std::vector<int>*>& lists) const;
+
     void        PrintTopology(void);
 
 // section of private data ----------------------------------------------------
@@ -69,6 +90,14 @@ private:
     CSimpleVector<CNLResidue>   Residues;
     bool                        BoxPresent;
     CPoint                      BoxCenter;
+
+    // inverted indices built by Finalize
+    CNLNameIndex                AtomNames;
+    CNLNameIndex                AtomTypes;
+    CNLNameIndex                ResidueNames;
+
+    static void MatchNames(const CNLNameIndex& index,const char* p_pattern,
+                           std::vector<const std::vector<int>*>& lists);
 };
 
 //---------------------------------------------------------------------------
@@ -0,0 +1,841 @@
+// =============================================================================
+// nLEaP - prepare input for the AMBER molecular mechanics programs
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2011 Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2006 gLEaP authors, see AUTHORS file in the main directory
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <misc/AmberFFEvaluator.hpp>
+#include <types/AmberFF.hpp>
+#include <core/PredefinedKeys.hpp>
+#include <engine/Context.hpp>
+#include <algorithm>
+#include <sstream>
+#include <cmath>
+#include <set>
+#include <map>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace nleap {
+//------------------------------------------------------------------------------
+
+// electrostatic conversion factor (kcal/mol, A, e)
+static const double ELE_FACTOR  = 332.0522;
+// default scaling of 1-4 interactions
+static const double SCEE        = 1.2;
+static const double SCNB        = 2.0;
+// nonbonded terms are switched off between cutoff-SWITCH_WIDTH and cutoff
+static const double SWITCH_WIDTH = 2.0;
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CAmberFFEvaluator::CAmberFFEvaluator(void)
+{
+    m_cutoff        = 8.0;
+    m_skin          = 2.0;
+    m_nb_updates    = 0;
+    m_rst_weight    = 0.0;
+    m_ebond         = 0.0;
+    m_eangle        = 0.0;
+    m_etors         = 0.0;
+    m_evdw          = 0.0;
+    m_eele          = 0.0;
+    m_erst          = 0.0;
+}
+
+//------------------------------------------------------------------------------
+
+void CAmberFFEvaluator::SetCutoff(double cutoff, double skin)
+{
+    if( (cutoff <= 0.0) || (skin < 0.0) ){
+        throw runtime_error("cutoff must be positive and skin non-negative");
+    }
+    m_cutoff = cutoff;
+    m_skin   = skin;
+    // force list rebuild
+    m_nb_crd.clear();
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CAmberFFEvaluator::Setup(CContext* p_ctx, CUnitPtr& unit)
+{
+    list<CAmberFFPtr> ffs;
+    CAmberFF::CacheFFs(p_ctx->database(),ffs);
+    if( ffs.empty() ){
+        throw runtime_error("no AmberFF is loaded");
+    }
+
+    m_atoms.clear();
+    m_masses.clear();
+    m_charges.clear();
+    m_rstars.clear();
+    m_depths.clear();
+    m_bonds.clear();
+    m_rst_atoms.clear();
+    m_rst_crd.clear();
+    m_nb_crd.clear();
+    m_nb_updates = 0;
+
+    // parameters are looked up once per unique combination of types
+    map<string,CEntityPtr>          type_cache;
+    map<string,CEntityPtr>          param_cache;
+    map<string,vector<CEntityPtr> > tors_cache;
+
+    // atoms ---------------------------------------
+    map<CEntity*,int> indexes;
+
+    CAtomRange atoms = unit->Atoms();
+
+    for(CAtomRange::iterator it = atoms.begin(); it != atoms.end(); it++){
+        CEntityPtr atom = it->GetSelf();
+        string     type = atom->Get<string>(TYPE);
+
+        map<string,CEntityPtr>::iterator tc = type_cache.find(type);
+        CEntityPtr ffatom;
+        if( tc != type_cache.end() ){
+            ffatom = tc->second;
+        } else {
+            ffatom = CAmberFF::FindType(ffs,type);
+            type_cache[type] = ffatom;
+        }
+        if( ! ffatom ){
+            stringstream str;
+            str << "atom type <b>" << type << "</b> of atom " << atom->GetPathName() << " is not defined in any AmberFF";
+            throw runtime_error(str.str());
+        }
+
+        indexes[atom.get()] = m_atoms.size();
+        m_atoms.push_back(atom);
+        m_masses.push_back(ffatom->Get<double>(MASS));
+        m_charges.push_back(atom->Get<double>(CHARGE));
+        m_rstars.push_back(ffatom->Get<double>(RSTAR));
+        m_depths.push_back(ffatom->Get<double>(DEPTH));
+    }
+
+    // bonds ---------------------------------------
+    vector< vector<int> > neighbours(m_atoms.size());
+
+    CBondRange bonds = unit->Bonds();
+
+    for(CBondRange::iterator bit = bonds.begin(); bit != bonds.end(); bit++){
+        CEntityPtr at1 = bit->Get<CEntityPtr>(ATOM1);
+        CEntityPtr at2 = bit->Get<CEntityPtr>(ATOM2);
+        if( (! at1) || (! at2) ) continue;
+
+        map<CEntity*,int>::iterator i1 = indexes.find(at1.get());
+        map<CEntity*,int>::iterator i2 = indexes.find(at2.get());
+        if( (i1 == indexes.end()) || (i2 == indexes.end()) ){
+            stringstream str;
+            str << "bond " << at1->GetPathName() << " - " << at2->GetPathName() << " leads outside of the unit";
+            throw runtime_error(str.str());
+        }
+
+        SBond bond;
+        bond.i = i1->second;
+        bond.j = i2->second;
+
+        string t1 = at1->Get<string>(TYPE);
+        string t2 = at2->Get<string>(TYPE);
+        string key = t1 + "-" + t2;
+        map<string,CEntityPtr>::iterator pc = param_cache.find(key);
+        CEntityPtr param;
+        if( pc != param_cache.end() ){
+            param = pc->second;
+        } else {
+            param = CAmberFF::FindBond(ffs,t1,t2);
+            param_cache[key] = param;
+        }
+        if( ! param ){
+            stringstream str;
+            str << "missing bond parameters for " << t1 << " - " << t2;
+            throw runtime_error(str.str());
+        }
+        bond.force = param->Get<double>(FORCE);
+        bond.equil = param->Get<double>(EQUIL);
+        m_bonds.push_back(bond);
+
+        neighbours[bond.i].push_back(bond.j);
+        neighbours[bond.j].push_back(bond.i);
+    }
+
+    BuildTopology(neighbours);
+
+    // angle and torsion parameters ----------------
+    vector<SAngle>::iterator ait = m_angles.begin();
+    vector<SAngle>::iterator aie = m_angles.end();
+
+    while( ait != aie ){
+        string t1 = m_atoms[ait->i]->Get<string>(TYPE);
+        string t2 = m_atoms[ait->j]->Get<string>(TYPE);
+        string t3 = m_atoms[ait->k]->Get<string>(TYPE);
+        string key = t1 + "-" + t2 + "-" + t3;
+        map<string,CEntityPtr>::iterator pc = param_cache.find(key);
+        CEntityPtr param;
+        if( pc != param_cache.end() ){
+            param = pc->second;
+        } else {
+            param = CAmberFF::FindAngle(ffs,t1,t2,t3);
+            param_cache[key] = param;
+        }
+        if( ! param ){
+            stringstream str;
+            str << "missing angle parameters for " << t1 << " - " << t2 << " - " << t3;
+            throw runtime_error(str.str());
+        }
+        ait->force = param->Get<double>(FORCE);
+        ait->equil = param->Get<double>(EQUIL)*M_PI/180.0;
+        ait++;
+    }
+
+    // BuildTopology provides torsion candidates with zero force, expand them
+    // to the individual terms, torsions without parameters are skipped
+    // only the first matching improper is used for each central atom
+    vector<STorsion> candidates;
+    candidates.swap(m_torsions);
+    int improper_center = -1;
+
+    vector<STorsion>::iterator tit = candidates.begin();
+    vector<STorsion>::iterator tie = candidates.end();
+
+    while( tit != tie ){
+        string t1 = m_atoms[tit->i]->Get<string>(TYPE);
+        string t2 = m_atoms[tit->j]->Get<string>(TYPE);
+        string t3 = m_atoms[tit->k]->Get<string>(TYPE);
+        string t4 = m_atoms[tit->l]->Get<string>(TYPE);
+
+        vector<CEntityPtr> params;
+        if( (tit->period == 0.0) || (tit->k != improper_center) ){
+            string key = t1 + "-" + t2 + "-" + t3 + "-" + t4;
+            if( tit->period != 0.0 ) key += "-I";
+            map<string,vector<CEntityPtr> >::iterator pc = tors_cache.find(key);
+            if( pc != tors_cache.end() ){
+                params = pc->second;
+            } else {
+                if( tit->period == 0.0 ){
+                    CAmberFF::FindTorsion(ffs,t1,t2,t3,t4,params);
+                } else {
+                    CAmberFF::FindImproper(ffs,t1,t2,t3,t4,params);
+                }
+                tors_cache[key] = params;
+            }
+            if( (tit->period != 0.0) && (! params.empty()) ) improper_center = tit->k;
+        }
+
+        for(size_t p=0; p < params.size(); p++){
+            STorsion tors = *tit;
+            tors.force  = params[p]->Get<double>(FORCE) / params[p]->Get<double>(DIVIDE);
+            tors.period = fabs(params[p]->Get<double>(PERIOD));
+            tors.phase  = params[p]->Get<double>(EQUIL)*M_PI/180.0;
+            m_torsions.push_back(tors);
+        }
+        tit++;
+    }
+
+    m_nb_start.clear();
+    m_nb_list.clear();
+}
+
+//------------------------------------------------------------------------------
+
+void CAmberFFEvaluator::BuildTopology(const vector< vector<int> >& neighbours)
+{
+    int natoms = m_atoms.size();
+
+    m_angles.clear();
+    m_torsions.clear();
+    m_pairs14.clear();
+
+    set< pair<int,int> > excluded;
+    set< pair<int,int> > pairs14;
+
+    // 1-2 exclusions
+    for(size_t b=0; b < m_bonds.size(); b++){
+        int i = min(m_bonds[b].i,m_bonds[b].j);
+        int j = max(m_bonds[b].i,m_bonds[b].j);
+        excluded.insert(make_pair(i,j));
+    }
+
+    // angles and 1-3 exclusions
+    for(int j=0; j < natoms; j++){
+        const vector<int>& nj = neighbours[j];
+        for(size_t a=0; a < nj.size(); a++){
+            for(size_t b=a+1; b < nj.size(); b++){
+                SAngle angle;
+                angle.i = nj[a];
+                angle.j = j;
+                angle.k = nj[b];
+                angle.force = 0.0;
+                angle.equil = 0.0;
+                m_angles.push_back(angle);
+                excluded.insert(make_pair(min(nj[a],nj[b]),max(nj[a],nj[b])));
+            }
+        }
+    }
+
+    // proper torsions (period == 0) and 1-4 pairs
+    for(size_t b=0; b < m_bonds.size(); b++){
+        int j = m_bonds[b].i;
+        int k = m_bonds[b].j;
+        for(size_t a=0; a < neighbours[j].size(); a++){
+            int i = neighbours[j][a];
+            if( i == k ) continue;
+            for(size_t d=0; d < neighbours[k].size(); d++){
+                int l = neighbours[k][d];
+                if( (l == j) || (l == i) ) continue;
+                STorsion tors;
+                tors.i = i;
+                tors.j = j;
+                tors.k = k;
+                tors.l = l;
+                tors.force = 0.0;
+                tors.period = 0.0;
+                tors.phase = 0.0;
+                m_torsions.push_back(tors);
+                pairs14.insert(make_pair(min(i,l),max(i,l)));
+            }
+        }
+    }
+
+    // improper candidates (period == 1) - central atom is the third one
+    for(int k=0; k < natoms; k++){
+        const vector<int>& nk = neighbours[k];
+        if( nk.size() != 3 ) continue;
+        static const int perm[3][3] = { {0,1,2}, {0,2,1}, {1,2,0} };
+        for(int p=0; p < 3; p++){
+            STorsion tors;
+            tors.i = nk[perm[p][0]];
+            tors.j = nk[perm[p][1]];
+            tors.k = k;
+            tors.l = nk[perm[p][2]];
+            tors.force = 0.0;
+            tors.period = 1.0;
+            tors.phase = 0.0;
+            m_torsions.push_back(tors);
+        }
+    }
+
+    // 1-4 pairs that are not 1-2 or 1-3 in rings
+    set< pair<int,int> >::iterator it = pairs14.begin();
+    set< pair<int,int> >::iterator ie = pairs14.end();
+    while( it != ie ){
+        if( excluded.count(*it) == 0 ){
+            SPair pair14;
+            pair14.i = it->first;
+            pair14.j = it->second;
+            m_pairs14.push_back(pair14);
+        }
+        it++;
+    }
+    excluded.insert(pairs14.begin(),pairs14.end());
+
+    // sorted exclusion lists
+    m_excluded.clear();
+    m_excluded.resize(natoms);
+    it = excluded.begin();
+    ie = excluded.end();
+    while( it != ie ){
+        m_excluded[it->first].push_back(it->second);
+        it++;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void CAmberFFEvaluator::SetRestraints(const vector<int>& atoms, double weight)
+{
+    m_rst_atoms = atoms;
+    m_rst_weight = weight;
+    m_rst_crd.resize(3*atoms.size());
+    for(size_t i=0; i < atoms.size(); i++){
+        CEntityPtr atom = m_atoms[atoms[i]];
+        m_rst_crd[3*i+0] = atom->Get<double>(POSX);
+        m_rst_crd[3*i+1] = atom->Get<double>(POSY);
+        m_rst_crd[3*i+2] = atom->Get<double>(POSZ);
+    }
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+int CAmberFFEvaluator::NumberOfAtoms(void) const
+{
+    return(m_atoms.size());
+}
+
+//------------------------------------------------------------------------------
+
+double CAmberFFEvaluator::GetMass(int index) const
+{
+    return(m_masses[index]);
+}
+
+//------------------------------------------------------------------------------
+
+int CAmberFFEvaluator::NumberOfListUpdates(void) const
+{
+    return(m_nb_updates);
+}
+
+//------------------------------------------------------------------------------
+
+double CAmberFFEvaluator::GetBondEnergy(void) const
+{
+    return(m_ebond);
+}
+
+//------------------------------------------------------------------------------
+
+double CAmberFFEvaluator::GetAngleEnergy(void) const
+{
+    return(m_eangle);
+}
+
+//------------------------------------------------------------------------------
+
+double CAmberFFEvaluator::GetTorsionEnergy(void) const
+{
+    return(m_etors);
+}
+
+//------------------------------------------------------------------------------
+
+double CAmberFFEvaluator::GetVdWEnergy(void) const
+{
+    return(m_evdw);
+}
+
+//------------------------------------------------------------------------------
+
+double CAmberFFEvaluator::GetEleEnergy(void) const
+{
+    return(m_eele);
+}
+
+//------------------------------------------------------------------------------
+
+double CAmberFFEvaluator::GetRestraintEnergy(void) const
+{
+    return(m_erst);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CAmberFFEvaluator::GetCoordinates(vector<double>& crd) const
+{
+    crd.resize(3*m_atoms.size());
+    for(size_t i=0; i < m_atoms.size(); i++){
+        crd[3*i+0] = m_atoms[i]->Get<double>(POSX);
+        crd[3*i+1] = m_atoms[i]->Get<double>(POSY);
+        crd[3*i+2] = m_atoms[i]->Get<double>(POSZ);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void CAmberFFEvaluator::SetCoordinates(const vector<double>& crd)
+{
+    for(size_t i=0; i < m_atoms.size(); i++){
+        m_atoms[i]->Set(POSX,crd[3*i+0]);
+        m_atoms[i]->Set(POSY,crd[3*i+1]);
+        m_atoms[i]->Set(POSZ,crd[3*i+2]);
+    }
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+bool CAmberFFEvaluator::IsListOutdated(const vector<double>& crd) const
+{
+    if( m_nb_crd.size() != crd.size() ) return(true);
+
+    double limit2 = 0.25*m_skin*m_skin;
+    for(size_t i=0; i < crd.size(); i += 3){
+        double dx = crd[i+0] - m_nb_crd[i+0];
+        double dy = crd[i+1] - m_nb_crd[i+1];
+        double dz = crd[i+2] - m_nb_crd[i+2];
+        if( dx*dx + dy*dy + dz*dz > limit2 ) return(true);
+    }
+    return(false);
+}
+
+//------------------------------------------------------------------------------
+
+void CAmberFFEvaluator::UpdateNeighbourList(const vector<double>& crd)
+{
+    int     natoms = m_atoms.size();
+    double  rlist = m_cutoff + m_skin;
+    double  rlist2 = rlist*rlist;
+
+    m_nb_start.assign(natoms+1,0);
+    m_nb_list.clear();
+    m_nb_crd = crd;
+    m_nb_updates++;
+
+    if( natoms == 0 ) return;
+
+    // bounding box and cell grid
+    double lo[3], hi[3];
+    for(int d=0; d < 3; d++){
+        lo[d] = hi[d] = crd[d];
+    }
+    for(int i=1; i < natoms; i++){
+        for(int d=0; d < 3; d++){
+            lo[d] = min(lo[d],crd[3*i+d]);
+            hi[d] = max(hi[d],crd[3*i+d]);
+        }
+    }
+
+    int     nc[3];
+    double  cs[3];
+    for(int d=0; d < 3; d++){
+        nc[d] = (int)((hi[d]-lo[d]) / rlist);
+        if( nc[d] < 1 ) nc[d] = 1;
+        if( nc[d] > 128 ) nc[d] = 128;
+        cs[d] = (hi[d]-lo[d]) / nc[d];
+        if( cs[d] <= 0.0 ) cs[d] = rlist;
+    }
+
+    vector<int> cells(natoms);
+    vector<int> head(nc[0]*nc[1]*nc[2],-1);
+    vector<int> next(natoms,-1);
+
+    for(int i=natoms-1; i >= 0; i--){
+        int c[3];
+        for(int d=0; d < 3; d++){
+            c[d] = (int)((crd[3*i+d]-lo[d]) / cs[d]);
+            if( c[d] >= nc[d] ) c[d] = nc[d]-1;
+        }
+        cells[i] = (c[2]*nc[1] + c[1])*nc[0] + c[0];
+        next[i] = head[cells[i]];
+        head[cells[i]] = i;
+    }
+
+    // partners j > i for each atom
+    vector< vector<int> > lists(natoms);
+
+    #pragma omp parallel for schedule(dynamic,64)
+    for(int i=0; i < natoms; i++){
+        int cx = cells[i] % nc[0];
+        int cy = (cells[i] / nc[0]) % nc[1];
+        int cz = cells[i] / (nc[0]*nc[1]);
+        const vector<int>& excl = m_excluded[i];
+        vector<int>& list = lists[i];
+
+        for(int z=max(cz-1,0); z <= min(cz+1,nc[2]-1); z++){
+            for(int y=max(cy-1,0); y <= min(cy+1,nc[1]-1); y++){
+                for(int x=max(cx-1,0); x <= min(cx+1,nc[0]-1); x++){
+                    int j = head[(z*nc[1] + y)*nc[0] + x];
+                    while( j >= 0 ){
+                        if( j > i ){
+                            double dx = crd[3*i+0] - crd[3*j+0];
+                            double dy = crd[3*i+1] - crd[3*j+1];
+                            double dz = crd[3*i+2] - crd[3*j+2];
+                            if( (dx*dx + dy*dy + dz*dz <= rlist2) &&
+                                (binary_search(excl.begin(),excl.end(),j) == false) ){
+                                list.push_back(j);
+                            }
+                        }
+                        j = next[j];
+                    }
+                }
+            }
+        }
+    }
+
+    // compress to CSR
+    for(int i=0; i < natoms; i++){
+        m_nb_start[i+1] = m_nb_start[i] + lists[i].size();
+    }
+    m_nb_list.resize(m_nb_start[natoms]);
+    for(int i=0; i < natoms; i++){
+        copy(lists[i].begin(),lists[i].end(),m_nb_list.begin()+m_nb_start[i]);
+    }
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+double CAmberFFEvaluator::Evaluate(const vector<double>& crd, vector<double>& grad)
+{
+    int natoms = m_atoms.size();
+    int ncrds  = 3*natoms;
+
+    if( IsListOutdated(crd) ){
+        UpdateNeighbourList(crd);
+    }
+
+    int nthreads = 1;
+#ifdef _OPENMP
+    nthreads = omp_get_max_threads();
+#endif
+    m_thread_grads.resize(nthreads);
+
+    double  ebond = 0.0;
+    double  eangle = 0.0;
+    double  etors = 0.0;
+    double  evdw = 0.0;
+    double  eele = 0.0;
+    double  rcut2 = m_cutoff*m_cutoff;
+    double  ron   = max(m_cutoff - SWITCH_WIDTH,0.0);
+    double  ron2  = ron*ron;
+    double  isw   = 1.0/((rcut2 - ron2)*(rcut2 - ron2)*(rcut2 - ron2));
+
+    int nbonds = m_bonds.size();
+    int nangles = m_angles.size();
+    int ntorsions = m_torsions.size();
+    int npairs14 = m_pairs14.size();
+
+    // number of threads that actually entered the parallel region
+    int nused = 1;
+
+    #pragma omp parallel reduction(+:ebond,eangle,etors,evdw,eele)
+    {
+        int tid = 0;
+#ifdef _OPENMP
+        tid = omp_get_thread_num();
+        #pragma omp single
+        nused = omp_get_num_threads();
+#endif
+        vector<double>& g = m_thread_grads[tid];
+        g.assign(ncrds,0.0);
+        const double* x = &crd[0];
+
+        // bonds -----------------------------------
+        #pragma omp for schedule(static)
+        for(int b=0; b < nbonds; b++){
+            const SBond& bond = m_bonds[b];
+            double dx = x[3*bond.i+0] - x[3*bond.j+0];
+            double dy = x[3*bond.i+1] - x[3*bond.j+1];
+            double dz = x[3*bond.i+2] - x[3*bond.j+2];
+            double r  = sqrt(dx*dx + dy*dy + dz*dz);
+            double dr = r - bond.equil;
+            ebond += bond.force*dr*dr;
+            if( r < 1.0e-8 ) continue;
+            double f = 2.0*bond.force*dr/r;
+            g[3*bond.i+0] += f*dx; g[3*bond.j+0] -= f*dx;
+            g[3*bond.i+1] += f*dy; g[3*bond.j+1] -= f*dy;
+            g[3*bond.i+2] += f*dz; g[3*bond.j+2] -= f*dz;
+        }
+
+        // angles ----------------------------------
+        #pragma omp for schedule(static)
+        for(int a=0; a < nangles; a++){
+            const SAngle& angle = m_angles[a];
+            double ax = x[3*angle.i+0] - x[3*angle.j+0];
+            double ay = x[3*angle.i+1] - x[3*angle.j+1];
+            double az = x[3*angle.i+2] - x[3*angle.j+2];
+            double bx = x[3*angle.k+0] - x[3*angle.j+0];
+            double by = x[3*angle.k+1] - x[3*angle.j+1];
+            double bz = x[3*angle.k+2] - x[3*angle.j+2];
+            double ra2 = ax*ax + ay*ay + az*az;
+            double rb2 = bx*bx + by*by + bz*bz;
+            if( (ra2 < 1.0e-16) || (rb2 < 1.0e-16) ) continue;
+            double rab = sqrt(ra2*rb2);
+            double cost = (ax*bx + ay*by + az*bz) / rab;
+            if( cost > 1.0 ) cost = 1.0;
+            if( cost < -1.0 ) cost = -1.0;
+            double theta = acos(cost);
+            double dt = theta - angle.equil;
+            eangle += angle.force*dt*dt;
+            double sint = sqrt(1.0 - cost*cost);
+            if( sint < 1.0e-8 ) sint = 1.0e-8;
+            // dE/dcos
+            double f = -2.0*angle.force*dt/sint;
+            double gix = f*(bx/rab - cost*ax/ra2);
+            double giy = f*(by/rab - cost*ay/ra2);
+            double giz = f*(bz/rab - cost*az/ra2);
+            double gkx = f*(ax/rab - cost*bx/rb2);
+            double gky = f*(ay/rab - cost*by/rb2);
+            double gkz = f*(az/rab - cost*bz/rb2);
+            g[3*angle.i+0] += gix; g[3*angle.i+1] += giy; g[3*angle.i+2] += giz;
+            g[3*angle.k+0] += gkx; g[3*angle.k+1] += gky; g[3*angle.k+2] += gkz;
+            g[3*angle.j+0] -= gix + gkx;
+            g[3*angle.j+1] -= giy + gky;
+            g[3*angle.j+2] -= giz + gkz;
+        }
+
+        // torsions and impropers ------------------
+        #pragma omp for schedule(static)
+        for(int t=0; t < ntorsions; t++){
+            const STorsion& tors = m_torsions[t];
+            // F = xi - xj, G = xj - xk, H = xl - xk
+            double fx = x[3*tors.i+0] - x[3*tors.j+0];
+            double fy = x[3*tors.i+1] - x[3*tors.j+1];
+            double fz = x[3*tors.i+2] - x[3*tors.j+2];
+            double gx = x[3*tors.j+0] - x[3*tors.k+0];
+            double gy = x[3*tors.j+1] - x[3*tors.k+1];
+            double gz = x[3*tors.j+2] - x[3*tors.k+2];
+            double hx = x[3*tors.l+0] - x[3*tors.k+0];
+            double hy = x[3*tors.l+1] - x[3*tors.k+1];
+            double hz = x[3*tors.l+2] - x[3*tors.k+2];
+            // A = F x G, B = H x G
+            double ax = fy*gz - fz*gy;
+            double ay = fz*gx - fx*gz;
+            double az = fx*gy - fy*gx;
+            double bx = hy*gz - hz*gy;
+            double by = hz*gx - hx*gz;
+            double bz = hx*gy - hy*gx;
+            double ra2 = ax*ax + ay*ay + az*az;
+            double rb2 = bx*bx + by*by + bz*bz;
+            double rg  = sqrt(gx*gx + gy*gy + gz*gz);
+            if( (ra2 < 1.0e-16) || (rb2 < 1.0e-16) || (rg < 1.0e-8) ) continue;
+            // phi from cos and sin
+            double cosp = (ax*bx + ay*by + az*bz);
+            double sinp = ((bx*ay - by*ax)*gz + (by*az - bz*ay)*gx + (bz*ax - bx*az)*gy) / rg;
+            double phi  = atan2(sinp,cosp);
+            double arg  = tors.period*phi - tors.phase;
+            etors += tors.force*(1.0 + cos(arg));
+            double dedphi = -tors.force*tors.period*sin(arg);
+            // gradients of phi (Blondel & Karplus)
+            double fg = fx*gx + fy*gy + fz*gz;
+            double hg = hx*gx + hy*gy + hz*gz;
+            double ca = -dedphi*rg/ra2;
+            double cb =  dedphi*rg/rb2;
+            double cj =  dedphi*fg/(ra2*rg);
+            double ck =  dedphi*hg/(rb2*rg);
+            g[3*tors.i+0] += ca*ax;
+            g[3*tors.i+1] += ca*ay;
+            g[3*tors.i+2] += ca*az;
+            g[3*tors.l+0] += cb*bx;
+            g[3*tors.l+1] += cb*by;
+            g[3*tors.l+2] += cb*bz;
+            g[3*tors.j+0] += -ca*ax + cj*ax - ck*bx;
+            g[3*tors.j+1] += -ca*ay + cj*ay - ck*by;
+            g[3*tors.j+2] += -ca*az + cj*az - ck*bz;
+            g[3*tors.k+0] += -cb*bx - cj*ax + ck*bx;
+            g[3*tors.k+1] += -cb*by - cj*ay + ck*by;
+            g[3*tors.k+2] += -cb*bz - cj*az + ck*bz;
+        }
+
+        // scaled 1-4 interactions -----------------
+        #pragma omp for schedule(static)
+        for(int p=0; p < npairs14; p++){
+            int i = m_pairs14[p].i;
+            int j = m_pairs14[p].j;
+            double dx = x[3*i+0] - x[3*j+0];
+            double dy = x[3*i+1] - x[3*j+1];
+            double dz = x[3*i+2] - x[3*j+2];
+            double r2 = dx*dx + dy*dy + dz*dz;
+            if( r2 < 1.0e-16 ) continue;
+            double ir2 = 1.0/r2;
+            double ir  = sqrt(ir2);
+            double rs  = m_rstars[i] + m_rstars[j];
+            double eps = sqrt(m_depths[i]*m_depths[j]) / SCNB;
+            double s6  = rs*rs*ir2; s6 = s6*s6*s6;
+            double qq  = ELE_FACTOR*m_charges[i]*m_charges[j]*ir / SCEE;
+            evdw += eps*(s6*s6 - 2.0*s6);
+            eele += qq;
+            double f = (12.0*eps*(s6 - s6*s6) - qq)*ir2;
+            g[3*i+0] += f*dx; g[3*j+0] -= f*dx;
+            g[3*i+1] += f*dy; g[3*j+1] -= f*dy;
+            g[3*i+2] += f*dz; g[3*j+2] -= f*dz;
+        }
+
+        // nonbonded interactions ------------------
+        #pragma omp for schedule(dynamic,64)
+        for(int i=0; i < natoms; i++){
+            double xi = x[3*i+0];
+            double yi = x[3*i+1];
+            double zi = x[3*i+2];
+            double qi = ELE_FACTOR*m_charges[i];
+            double ri = m_rstars[i];
+            double ei = m_depths[i];
+            double gxi = 0.0, gyi = 0.0, gzi = 0.0;
+            for(int n=m_nb_start[i]; n < m_nb_start[i+1]; n++){
+                int j = m_nb_list[n];
+                double dx = xi - x[3*j+0];
+                double dy = yi - x[3*j+1];
+                double dz = zi - x[3*j+2];
+                double r2 = dx*dx + dy*dy + dz*dz;
+                if( (r2 > rcut2) || (r2 < 1.0e-16) ) continue;
+                double ir2 = 1.0/r2;
+                double ir  = sqrt(ir2);
+                double rs  = ri + m_rstars[j];
+                double eps = sqrt(ei*m_depths[j]);
+                double s6  = rs*rs*ir2; s6 = s6*s6*s6;
+                double qq  = qi*m_charges[j]*ir;
+                double ev  = eps*(s6*s6 - 2.0*s6);
+                double f   = (12.0*eps*(s6 - s6*s6) - qq)*ir2;
+                if( r2 > ron2 ){
+                    // smoothly switch off both terms
+                    double sw  = (rcut2 - r2)*(rcut2 - r2)*(rcut2 + 2.0*r2 - 3.0*ron2)*isw;
+                    double dsw = 12.0*(rcut2 - r2)*(ron2 - r2)*isw;
+                    f  = f*sw + (ev + qq)*dsw;
+                    ev *= sw;
+                    qq *= sw;
+                }
+                evdw += ev;
+                eele += qq;
+                gxi += f*dx; g[3*j+0] -= f*dx;
+                gyi += f*dy; g[3*j+1] -= f*dy;
+                gzi += f*dz; g[3*j+2] -= f*dz;
+            }
+            g[3*i+0] += gxi;
+            g[3*i+1] += gyi;
+            g[3*i+2] += gzi;
+        }
+    }
+
+    // reduce thread buffers
+    grad.resize(ncrds);
+
+    #pragma omp parallel for schedule(static)
+    for(int c=0; c < ncrds; c++){
+        double sum = 0.0;
+        for(int t=0; t < nused; t++){
+            sum += m_thread_grads[t][c];
+        }
+        grad[c] = sum;
+    }
+
+    // positional restraints
+    double erst = 0.0;
+    for(size_t r=0; r < m_rst_atoms.size(); r++){
+        int i = m_rst_atoms[r];
+        for(int d=0; d < 3; d++){
+            double dx = crd[3*i+d] - m_rst_crd[3*r+d];
+            erst += m_rst_weight*dx*dx;
+            grad[3*i+d] += 2.0*m_rst_weight*dx;
+        }
+    }
+
+    m_ebond     = ebond;
+    m_eangle    = eangle;
+    m_etors     = etors;
+    m_evdw      = evdw;
+    m_eele      = eele;
+    m_erst      = erst;
+
+    return(ebond + eangle + etors + evdw + eele + erst);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+}
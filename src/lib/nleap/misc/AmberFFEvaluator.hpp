@@ -0,0 +1,162 @@
+#ifndef NLEAP_MISC_AMBER_FF_EVALUATOR_HPP
+#define NLEAP_MISC_AMBER_FF_EVALUATOR_HPP
+// =============================================================================
+// nLEaP - prepare input for the AMBER molecular mechanics programs
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2011 Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2006 gLEaP authors, see AUTHORS file in the main directory
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <NLEaPMainHeader.hpp>
+#include <types/Unit.hpp>
+#include <misc/Minimizer.hpp>
+#include <vector>
+
+namespace nleap {
+//------------------------------------------------------------------------------
+
+class CContext;
+
+//------------------------------------------------------------------------------
+
+/// energy and analytic gradient of an unit described by the Amber force field
+/*!
+ The topology (bonds, angles, torsions, impropers, 1-4 pairs, and exclusions)
+ is built once from the unit bonds and the loaded AmberFF parameters.
+ Nonbonded interactions are smoothly switched off towards the cutoff and
+ evaluated over a Verlet neighbour list that is rebuilt only when some atom
+ moved more than half of the skin since the last build. Force evaluation is
+ parallelized by OpenMP (when enabled) using per-thread gradient buffers.
+*/
+
+class NLEAP_PACKAGE CAmberFFEvaluator : public CMinimizerTarget
+{
+public:
+// constructor/destructor ------------------------------------------------------
+    CAmberFFEvaluator(void);
+
+// setup methods ---------------------------------------------------------------
+    /// set nonbonded cutoff and neighbour list skin (in A)
+    void SetCutoff(double cutoff, double skin);
+
+    /// build topology and parameters for the unit
+    void Setup(CContext* p_ctx, CUnitPtr& unit);
+
+    /// restrain atoms to their current positions by harmonic potential
+    void SetRestraints(const vector<int>& atoms, double weight);
+
+// information methods ---------------------------------------------------------
+    /// number of atoms
+    int NumberOfAtoms(void) const;
+
+    /// atom mass (taken from AmberFF types)
+    double GetMass(int index) const;
+
+    /// number of neighbour list rebuilds since setup
+    int NumberOfListUpdates(void) const;
+
+    /// last energy components
+    double GetBondEnergy(void) const;
+    double GetAngleEnergy(void) const;
+    double GetTorsionEnergy(void) const;
+    double GetVdWEnergy(void) const;
+    double GetEleEnergy(void) const;
+    double GetRestraintEnergy(void) const;
+
+// executive methods -----------------------------------------------------------
+    /// get current unit coordinates
+    void GetCoordinates(vector<double>& crd) const;
+
+    /// write coordinates back to unit atoms
+    void SetCoordinates(const vector<double>& crd);
+
+    /// calculate energy and its gradient
+    virtual double Evaluate(const vector<double>& crd, vector<double>& grad);
+
+// section of private data -----------------------------------------------------
+private:
+    struct SBond {
+        int     i,j;
+        double  force,equil;
+    };
+
+    struct SAngle {
+        int     i,j,k;
+        double  force,equil;
+    };
+
+    struct STorsion {
+        int     i,j,k,l;
+        double  force,period,phase;
+    };
+
+    struct SPair {
+        int     i,j;
+    };
+
+    double                  m_cutoff;
+    double                  m_skin;
+
+    vector<CEntityPtr>      m_atoms;
+    vector<double>          m_masses;
+    vector<double>          m_charges;
+    vector<double>          m_rstars;
+    vector<double>          m_depths;
+
+    vector<SBond>           m_bonds;
+    vector<SAngle>          m_angles;
+    vector<STorsion>        m_torsions;
+    vector<SPair>           m_pairs14;
+
+    // exclusions - sorted partners j > i for each atom i
+    vector< vector<int> >   m_excluded;
+
+    // neighbour list in CSR form (partners j > i)
+    vector<int>             m_nb_start;
+    vector<int>             m_nb_list;
+    vector<double>          m_nb_crd;
+    int                     m_nb_updates;
+
+    // restraints
+    vector<int>             m_rst_atoms;
+    vector<double>          m_rst_crd;
+    double                  m_rst_weight;
+
+    // per-thread gradient buffers
+    vector< vector<double> >    m_thread_grads;
+
+    double                  m_ebond;
+    double                  m_eangle;
+    double                  m_etors;
+    double                  m_evdw;
+    double                  m_eele;
+    double                  m_erst;
+
+    /// build angles, torsions, impropers, 1-4 pairs, and exclusions
+    void BuildTopology(const vector< vector<int> >& neighbours);
+
+    /// is neighbour list outdated?
+    bool IsListOutdated(const vector<double>& crd) const;
+
+    /// build neighbour list by cell decomposition
+    void UpdateNeighbourList(const vector<double>& crd);
+};
+
+//------------------------------------------------------------------------------
+}
+
+#endif
@@ -22,7 +22,7 @@
 #include <misc/Geometry.hpp>
 #include <types/AtomTypes.hpp>
 #include <core/PredefinedKeys.hpp>
-#include <core/RecursiveIterator.hpp>
+#include <types/Unit.hpp>
 #include <sstream>
 
 namespace nleap {
@@ -50,15 +50,11 @@ CPoint GetCOM(CContext* p_ctx,CEntityPtr& obj)
     if( (obj->GetType() == UNIT) ||
         (obj->GetType() == RESIDUE) ){
 
-        CRecursiveIterator it = CRecursiveIterator(obj);
-        it.SetFilter(ATOM);
-        it.SetToBegin();
-        CRecursiveIterator ie = it;
-        ie.SetToEnd();
+        CAtomRange atoms = GetAtomRange(obj);
 
         // calculate COM -----------------------
         double tmass = 0.0;
-        while( it != ie ){
+        for(CAtomRange::iterator it = atoms.begin(); it != atoms.end(); it++){
             CPoint pos;
             double mass;
             pos.x = it->Get<double>(POSX);
@@ -67,7 +63,6 @@ CPoint GetCOM(CContext* p_ctx,CEntityPtr& obj)
             mass  = CAtomTypes::GetMass( p_ctx, it->Get<string>(TYPE) );
             com   += pos*mass;
             tmass += mass;
-            it++;
         }
 
         if( tmass == 0 ) {
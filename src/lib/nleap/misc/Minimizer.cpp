@@ -0,0 +1,294 @@
+// =============================================================================
+// nLEaP - prepare input for the AMBER molecular mechanics programs
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2011 Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2006 gLEaP authors, see AUTHORS file in the main directory
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <misc/Minimizer.hpp>
+#include <iomanip>
+#include <cmath>
+
+namespace nleap {
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CMinimizerTarget::~CMinimizerTarget(void)
+{
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CLBFGSMinimizer::CLBFGSMinimizer(void)
+{
+    m_ncorr         = 7;
+    m_max_steps     = 1000;
+    m_rms_tol       = 0.1;
+    m_max_disp      = 0.2;
+    m_print_freq    = 50;
+    m_steps         = 0;
+    m_value         = 0.0;
+    m_rms           = 0.0;
+}
+
+//------------------------------------------------------------------------------
+
+void CLBFGSMinimizer::SetNumberOfCorrections(int num)
+{
+    if( num < 1 ) num = 1;
+    m_ncorr = num;
+}
+
+//------------------------------------------------------------------------------
+
+void CLBFGSMinimizer::SetMaxSteps(int num)
+{
+    m_max_steps = num;
+}
+
+//------------------------------------------------------------------------------
+
+void CLBFGSMinimizer::SetRMSGradient(double rms)
+{
+    m_rms_tol = rms;
+}
+
+//------------------------------------------------------------------------------
+
+void CLBFGSMinimizer::SetMaxDisplacement(double disp)
+{
+    m_max_disp = disp;
+}
+
+//------------------------------------------------------------------------------
+
+void CLBFGSMinimizer::SetPrintFrequency(int num)
+{
+    m_print_freq = num;
+}
+
+//------------------------------------------------------------------------------
+
+void CLBFGSMinimizer::SetFrozen(const vector<char>& frozen)
+{
+    m_frozen = frozen;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+int CLBFGSMinimizer::GetNumberOfSteps(void) const
+{
+    return(m_steps);
+}
+
+//------------------------------------------------------------------------------
+
+double CLBFGSMinimizer::GetValue(void) const
+{
+    return(m_value);
+}
+
+//------------------------------------------------------------------------------
+
+double CLBFGSMinimizer::GetRMSGradient(void) const
+{
+    return(m_rms);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+static double Dot(const vector<double>& a, const vector<double>& b)
+{
+    double sum = 0.0;
+    for(size_t i=0; i < a.size(); i++){
+        sum += a[i]*b[i];
+    }
+    return(sum);
+}
+
+//------------------------------------------------------------------------------
+
+double CLBFGSMinimizer::FilterGradient(vector<double>& grad) const
+{
+    double  sum = 0.0;
+    size_t  num = 0;
+
+    for(size_t i=0; i < grad.size(); i++){
+        if( (i < m_frozen.size()) && m_frozen[i] ){
+            grad[i] = 0.0;
+            continue;
+        }
+        sum += grad[i]*grad[i];
+        num++;
+    }
+
+    if( num == 0 ) return(0.0);
+    return( sqrt(sum/num) );
+}
+
+//------------------------------------------------------------------------------
+
+bool CLBFGSMinimizer::Minimize(CMinimizerTarget& target, vector<double>& x, ostream& vout)
+{
+    const double c1 = 1.0e-4;   // Armijo condition
+    const int    max_backtracks = 20;
+
+    size_t n = x.size();
+
+    vector<double>  grad(n);
+    vector<double>  dir(n);
+    vector<double>  xn(n);
+    vector<double>  gradn(n);
+    vector<double>  alpha(m_ncorr);
+
+    // correction pairs in ring buffer
+    vector< vector<double> >    s(m_ncorr);
+    vector< vector<double> >    y(m_ncorr);
+    vector<double>              rho(m_ncorr);
+    int                         nstored = 0;
+    int                         newest = -1;
+
+    m_steps = 0;
+    m_value = target.Evaluate(x,grad);
+    m_rms   = FilterGradient(grad);
+
+    if( m_print_freq > 0 ){
+        vout << "   Step         Energy     RMS grad" << endl;
+        vout << "  ------ -------------- ------------" << endl;
+    }
+
+    bool converged = false;
+    int  last_printed = -1;
+
+    while( m_steps < m_max_steps ){
+
+        if( (m_print_freq > 0) && (m_steps % m_print_freq == 0) ){
+            vout << "  " << setw(6) << m_steps << " " << fixed << setw(14) << setprecision(4) << m_value;
+            vout << " " << setw(12) << setprecision(6) << m_rms << endl;
+            last_printed = m_steps;
+        }
+
+        if( m_rms <= m_rms_tol ){
+            converged = true;
+            break;
+        }
+
+        // two-loop recursion: dir = -H*grad
+        dir = grad;
+        for(int k=0; k < nstored; k++){
+            int i = (newest - k + m_ncorr) % m_ncorr;
+            alpha[i] = rho[i]*Dot(s[i],dir);
+            for(size_t j=0; j < n; j++) dir[j] -= alpha[i]*y[i][j];
+        }
+        if( nstored > 0 ){
+            double gamma = Dot(s[newest],y[newest]) / Dot(y[newest],y[newest]);
+            for(size_t j=0; j < n; j++) dir[j] *= gamma;
+        }
+        for(int k=nstored-1; k >= 0; k--){
+            int i = (newest - k + m_ncorr) % m_ncorr;
+            double beta = rho[i]*Dot(y[i],dir);
+            for(size_t j=0; j < n; j++) dir[j] += s[i][j]*(alpha[i] - beta);
+        }
+        for(size_t j=0; j < n; j++) dir[j] = -dir[j];
+
+        double gd = Dot(grad,dir);
+        if( gd >= 0.0 ){
+            // not a descent direction - restart from steepest descent
+            nstored = 0;
+            newest = -1;
+            for(size_t j=0; j < n; j++) dir[j] = -grad[j];
+            gd = Dot(grad,dir);
+        }
+
+        // limit the largest displacement
+        double dmax = 0.0;
+        for(size_t j=0; j < n; j++){
+            if( fabs(dir[j]) > dmax ) dmax = fabs(dir[j]);
+        }
+        double step = 1.0;
+        if( dmax*step > m_max_disp ){
+            step = m_max_disp / dmax;
+        }
+
+        // backtracking line search
+        double  valuen = 0.0;
+        bool    accepted = false;
+        for(int k=0; k < max_backtracks; k++){
+            for(size_t j=0; j < n; j++) xn[j] = x[j] + step*dir[j];
+            valuen = target.Evaluate(xn,gradn);
+            if( valuen <= m_value + c1*step*gd ){
+                accepted = true;
+                break;
+            }
+            step *= 0.5;
+        }
+
+        if( ! accepted ){
+            if( nstored == 0 ){
+                // even steepest descent step failed - nothing more to do
+                break;
+            }
+            nstored = 0;
+            newest = -1;
+            continue;
+        }
+
+        double rmsn = FilterGradient(gradn);
+
+        // update correction pairs, skip those violating curvature condition
+        double sy = 0.0;
+        for(size_t j=0; j < n; j++){
+            sy += (xn[j] - x[j])*(gradn[j] - grad[j]);
+        }
+        if( sy > 1.0e-10 ){
+            newest = (newest + 1) % m_ncorr;
+            s[newest].resize(n);
+            y[newest].resize(n);
+            for(size_t j=0; j < n; j++){
+                s[newest][j] = xn[j] - x[j];
+                y[newest][j] = gradn[j] - grad[j];
+            }
+            rho[newest] = 1.0 / sy;
+            if( nstored < m_ncorr ) nstored++;
+        }
+
+        x.swap(xn);
+        grad.swap(gradn);
+        m_value = valuen;
+        m_rms   = rmsn;
+        m_steps++;
+    }
+
+    if( (m_print_freq > 0) && (last_printed != m_steps) ){
+        vout << "  " << setw(6) << m_steps << " " << fixed << setw(14) << setprecision(4) << m_value;
+        vout << " " << setw(12) << setprecision(6) << m_rms << endl;
+    }
+
+    return(converged);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+}
@@ -0,0 +1,102 @@
+#ifndef NLEAP_MISC_MINIMIZER_HPP
+#define NLEAP_MISC_MINIMIZER_HPP
+// =============================================================================
+// nLEaP - prepare input for the AMBER molecular mechanics programs
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2011 Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2006 gLEaP authors, see AUTHORS file in the main directory
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <NLEaPMainHeader.hpp>
+#include <vector>
+#include <ostream>
+
+namespace nleap {
+//------------------------------------------------------------------------------
+
+using namespace std;
+
+//------------------------------------------------------------------------------
+
+/// function to be minimized
+class NLEAP_PACKAGE CMinimizerTarget
+{
+public:
+    virtual ~CMinimizerTarget(void);
+
+    /// return value and gradient at x
+    virtual double Evaluate(const vector<double>& x, vector<double>& grad) = 0;
+};
+
+//------------------------------------------------------------------------------
+
+/// limited-memory BFGS minimizer with backtracking line search
+class NLEAP_PACKAGE CLBFGSMinimizer
+{
+public:
+// constructor -----------------------------------------------------------------
+    CLBFGSMinimizer(void);
+
+// setup methods ---------------------------------------------------------------
+    /// number of stored correction pairs
+    void SetNumberOfCorrections(int num);
+
+    /// maximum number of steps
+    void SetMaxSteps(int num);
+
+    /// convergence criterion - RMS of gradient
+    void SetRMSGradient(double rms);
+
+    /// maximum displacement of single coordinate in one step
+    void SetMaxDisplacement(double disp);
+
+    /// print progress each num steps, 0 disables printing
+    void SetPrintFrequency(int num);
+
+    /// coordinates with non-zero flag are kept fixed
+    void SetFrozen(const vector<char>& frozen);
+
+// executive methods -----------------------------------------------------------
+    /// minimize target from x, x is updated, return true if converged
+    bool Minimize(CMinimizerTarget& target, vector<double>& x, ostream& vout);
+
+// information methods ---------------------------------------------------------
+    int     GetNumberOfSteps(void) const;
+    double  GetValue(void) const;
+    double  GetRMSGradient(void) const;
+
+// section of private data -----------------------------------------------------
+private:
+    int             m_ncorr;
+    int             m_max_steps;
+    double          m_rms_tol;
+    double          m_max_disp;
+    int             m_print_freq;
+    vector<char>    m_frozen;
+
+    int             m_steps;
+    double          m_value;
+    double          m_rms;
+
+    /// zero frozen components and return RMS of the rest
+    double FilterGradient(vector<double>& grad) const;
+};
+
+//------------------------------------------------------------------------------
+}
+
+#endif
@@ -0,0 +1,169 @@
+// =============================================================================
+// nLEaP - prepare input for the AMBER molecular mechanics programs
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2011 Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2006 gLEaP authors, see AUTHORS file in the main directory
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <misc/UnitGraph.hpp>
+#include <core/PredefinedKeys.hpp>
+#include <types/Bond.hpp>
+#include <map>
+
+namespace nleap {
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+const int CUnitGraph::ImproperPermutations[3][3] = { {0,1,2}, {0,2,1}, {1,2,0} };
+
+//------------------------------------------------------------------------------
+
+CUnitGraph::CUnitGraph(void)
+{
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CUnitGraph::Build(CUnitPtr& unit)
+{
+    m_atoms.clear();
+    m_types.clear();
+    m_neighbours.clear();
+
+    // atoms ---------------------------------------
+    map<CEntity*,int> indexes;
+
+    CAtomRange atoms = unit->Atoms();
+    for(CAtomRange::iterator it = atoms.begin(); it != atoms.end(); it++){
+        CAtomPtr atom = dynamic_pointer_cast<CAtom>( it->GetSelf() );
+        indexes[atom.get()] = m_atoms.size();
+        m_atoms.push_back(atom);
+        m_types.push_back(atom->Get<string>(TYPE));
+    }
+
+    // bonds ---------------------------------------
+    m_neighbours.resize(m_atoms.size());
+
+    CBondRange bonds = unit->Bonds();
+    for(CBondRange::iterator bit = bonds.begin(); bit != bonds.end(); bit++){
+        CEntityPtr at1 = bit->Get<CEntityPtr>(ATOM1);
+        CEntityPtr at2 = bit->Get<CEntityPtr>(ATOM2);
+        if( (! at1) || (! at2) ) continue;
+        map<CEntity*,int>::iterator i1 = indexes.find(at1.get());
+        map<CEntity*,int>::iterator i2 = indexes.find(at2.get());
+        if( (i1 == indexes.end()) || (i2 == indexes.end()) ) continue;
+        m_neighbours[i1->second].push_back(i2->second);
+        m_neighbours[i2->second].push_back(i1->second);
+    }
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+int CUnitGraph::NumberOfAtoms(void) const
+{
+    return(m_atoms.size());
+}
+
+//------------------------------------------------------------------------------
+
+const CAtomPtr& CUnitGraph::GetAtom(int index) const
+{
+    return(m_atoms[index]);
+}
+
+//------------------------------------------------------------------------------
+
+const string& CUnitGraph::GetType(int index) const
+{
+    return(m_types[index]);
+}
+
+//------------------------------------------------------------------------------
+
+const vector<int>& CUnitGraph::GetNeighbours(int index) const
+{
+    return(m_neighbours[index]);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CUnitGraph::GetAngles(int j, vector<int>& angles) const
+{
+    const vector<int>& nj = m_neighbours[j];
+    for(size_t a=0; a < nj.size(); a++){
+        for(size_t b=a+1; b < nj.size(); b++){
+            angles.push_back(nj[a]);
+            angles.push_back(j);
+            angles.push_back(nj[b]);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void CUnitGraph::GetTorsions(int j, vector<int>& torsions) const
+{
+    const vector<int>& nj = m_neighbours[j];
+    for(size_t n=0; n < nj.size(); n++){
+        int k = nj[n];
+        if( k <= j ) continue;
+        const vector<int>& nk = m_neighbours[k];
+        for(size_t a=0; a < nj.size(); a++){
+            int i = nj[a];
+            if( i == k ) continue;
+            for(size_t d=0; d < nk.size(); d++){
+                int l = nk[d];
+                if( (l == j) || (l == i) ) continue;
+                torsions.push_back(i);
+                torsions.push_back(j);
+                torsions.push_back(k);
+                torsions.push_back(l);
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+bool CUnitGraph::GetImproperAtoms(int k, int outer[3]) const
+{
+    const vector<int>& nk = m_neighbours[k];
+    if( nk.size() != 3 ) return(false);
+
+    // insertion sort by types keeps the bond order of equal types
+    for(int a=0; a < 3; a++){
+        int b = a;
+        while( (b > 0) && (m_types[nk[a]] < m_types[outer[b-1]]) ){
+            outer[b] = outer[b-1];
+            b--;
+        }
+        outer[b] = nk[a];
+    }
+    return(true);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+}
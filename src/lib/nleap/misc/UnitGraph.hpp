@@ -0,0 +1,85 @@
+#ifndef NLEAP_MISC_UNIT_GRAPH_HPP
+#define NLEAP_MISC_UNIT_GRAPH_HPP
+// =============================================================================
+// nLEaP - prepare input for the AMBER molecular mechanics programs
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2011 Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2006 gLEaP authors, see AUTHORS file in the main directory
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+
+#include <NLEaPMainHeader.hpp>
+#include <types/Unit.hpp>
+#include <types/Atom.hpp>
+#include <vector>
+
+namespace nleap {
+//------------------------------------------------------------------------------
+
+/// bonded graph of an unit
+/*!
+ Atoms are indexed in the order of CUnit::Atoms(). Bonded terms are enumerated
+ from their central atom or bond, thus every angle and torsion is visited once.
+ Impropers are centred at atoms with exactly three neighbours, the outer atoms
+ are ordered by their types so that all writers try the same permutations.
+*/
+
+class NLEAP_PACKAGE CUnitGraph
+{
+public:
+// constructor -----------------------------------------------------------------
+    CUnitGraph(void);
+
+// executive methods -----------------------------------------------------------
+    /// collect atoms, their types, and bonds of the unit
+    void Build(CUnitPtr& unit);
+
+// information methods ---------------------------------------------------------
+    /// number of atoms
+    int NumberOfAtoms(void) const;
+
+    /// get unit atom
+    const CAtomPtr& GetAtom(int index) const;
+
+    /// get atom type
+    const string& GetType(int index) const;
+
+    /// get bonded atoms in the order of unit bonds
+    const vector<int>& GetNeighbours(int index) const;
+
+// bonded terms ----------------------------------------------------------------
+    /// append angles i-j-k centred at atom j, three indexes per angle
+    void GetAngles(int j, vector<int>& angles) const;
+
+    /// append torsions i-j-k-l around bonds j-k with j < k, four indexes per torsion
+    void GetTorsions(int j, vector<int>& torsions) const;
+
+    /// get outer atoms of improper centred at atom k ordered by types
+    /// return false if the atom does not have exactly three neighbours
+    bool GetImproperAtoms(int k, int outer[3]) const;
+
+    /// permutations of outer atoms tried in this order, the central atom is the third one
+    static const int ImproperPermutations[3][3];
+
+// section of private data -----------------------------------------------------
+private:
+    vector<CAtomPtr>        m_atoms;
+    vector<string>          m_types;
+    vector< vector<int> >   m_neighbours;
+};
+
+//------------------------------------------------------------------------------
+}
+
+#endif
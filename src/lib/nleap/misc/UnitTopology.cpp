@@ -0,0 +1,253 @@
+// =============================================================================
+// nLEaP - prepare input for the AMBER molecular mechanics programs
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2011 Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2006 gLEaP authors, see AUTHORS file in the main directory
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <misc/UnitTopology.hpp>
+#include <types/Unit.hpp>
+#include <types/AmberFF.hpp>
+#include <core/PredefinedKeys.hpp>
+#include <engine/Context.hpp>
+#include <mask/NLMask.hpp>
+#include <map>
+
+namespace nleap {
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+/// names are compared by the mask parser as four characters padded by spaces
+static CSmallString MaskName(const string& name)
+{
+    char buffer[5] = "    ";
+    for(size_t i=0; (i < 4) && (i < name.size()); i++){
+        buffer[i] = name[i];
+    }
+    return( CSmallString(buffer) );
+}
+
+//------------------------------------------------------------------------------
+
+/// mass of atom type from force fields, zero if the type is not defined
+static double FindMass(list<CAmberFFPtr>& ffs, const string& type, map<string,double>& masses)
+{
+    map<string,double>::iterator mit = masses.find(type);
+    if( mit != masses.end() ) return(mit->second);
+
+    double      mass = 0.0;
+    CEntityPtr  fftype = CAmberFF::FindType(ffs,type);
+    if( fftype ) mass = fftype->Get<double>(MASS);
+    masses[type] = mass;
+    return(mass);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CUnitTopology::CUnitTopology(void)
+{
+    m_owner         = NULL;
+    m_valid         = false;
+    m_revision      = 0;
+    m_pos_revision  = 0;
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CUnitTopology::Update(CContext* p_ctx, CUnit* p_unit)
+{
+    // atom masses are taken from loaded force fields
+    list<CAmberFFPtr> ffs;
+    CAmberFF::CacheFFs(p_ctx->database(),ffs);
+
+    vector< pair<int,unsigned long> > ff_key;
+    for(list<CAmberFFPtr>::iterator it = ffs.begin(); it != ffs.end(); it++){
+        ff_key.push_back(pair<int,unsigned long>((*it)->GetId(),(*it)->GetRevision()));
+    }
+
+    if( ! m_valid || (m_revision != p_unit->GetRevision()) ){
+        Build(p_unit,ffs);
+    } else {
+        // topology moved from the unit this one was cloned from
+        if( m_owner != p_unit ){
+            vector<int> first_atoms;
+            LinkAtoms(p_unit,first_atoms);
+        }
+        if( m_pos_revision != p_unit->GetPosRevision() ){
+            UpdatePositions();
+        }
+        if( m_ff_key != ff_key ){
+            UpdateMasses(ffs);
+        }
+    }
+
+    m_owner         = p_unit;
+    m_valid         = true;
+    m_revision      = p_unit->GetRevision();
+    m_pos_revision  = p_unit->GetPosRevision();
+    m_ff_key        = ff_key;
+}
+
+//------------------------------------------------------------------------------
+
+void CUnitTopology::Build(CUnit* p_unit, list<CAmberFFPtr>& ffs)
+{
+    m_topology.Clear();
+
+    map<string,double> masses;
+
+    // collect atoms and residue boundaries
+    CResidueRange       residues = p_unit->Residues();
+    vector<int>         first_atoms;
+
+    LinkAtoms(p_unit,first_atoms);
+
+    // fill topology
+    m_topology.Init(m_atoms.size(),residues.size(),false,CPoint());
+
+    for(size_t i=0; i < residues.size(); i++){
+        m_topology.SetResidue(i,MaskName(residues[i].GetName()),first_atoms[i]);
+    }
+
+    for(size_t i=0; i < m_atoms.size(); i++){
+        CEntity* p_atom = m_atoms[i];
+        string   type = p_atom->Get<string>(TYPE);
+
+        double   mass = FindMass(ffs,type,masses);
+
+        m_topology.SetAtom(i,MaskName(p_atom->GetName()),MaskName(type));
+        m_topology.SetAtom(i,mass,p_atom->Get<double>(POSX),
+                           p_atom->Get<double>(POSY),p_atom->Get<double>(POSZ));
+    }
+
+    m_topology.Finalize();
+}
+
+//------------------------------------------------------------------------------
+
+void CUnitTopology::LinkAtoms(CUnit* p_unit, vector<int>& first_atoms)
+{
+    m_atoms.clear();
+    first_atoms.clear();
+
+    CResidueRange residues = p_unit->Residues();
+
+    for(CResidueRange::iterator rit = residues.begin(); rit != residues.end(); rit++){
+        first_atoms.push_back(m_atoms.size());
+
+        CAtomRange atoms = rit->Atoms();
+        for(CAtomRange::iterator ait = atoms.begin(); ait != atoms.end(); ait++){
+            m_atoms.push_back(&(*ait));
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void CUnitTopology::UpdateMasses(list<CAmberFFPtr>& ffs)
+{
+    map<string,double> masses;
+
+    for(size_t i=0; i < m_atoms.size(); i++){
+        CEntity* p_atom = m_atoms[i];
+        string   type = p_atom->Get<string>(TYPE);
+
+        double   mass = FindMass(ffs,type,masses);
+
+        CNLAtom* p_nlatom = m_topology.GetAtom(i);
+        m_topology.SetAtom(i,mass,p_nlatom->GetPosition().x,
+                           p_nlatom->GetPosition().y,p_nlatom->GetPosition().z);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void CUnitTopology::UpdatePositions(void)
+{
+    for(size_t i=0; i < m_atoms.size(); i++){
+        CEntity* p_atom = m_atoms[i];
+        m_topology.SetAtom(i,m_topology.GetAtom(i)->GetMass(),p_atom->Get<double>(POSX),
+                           p_atom->Get<double>(POSY),p_atom->Get<double>(POSZ));
+    }
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+void CUnitTopology::SelectAtoms(const string& mask, vector<int>& indices)
+{
+    indices.clear();
+
+    if( mask.empty() ){
+        throw runtime_error("mask is empty");
+    }
+
+    if( m_atoms.empty() ) return;
+
+    CNLMask nlmask;
+    nlmask.AssignTopology(&m_topology);
+    if( nlmask.SetMask(mask.c_str()) == false ){
+        throw runtime_error("unable to set mask '" + mask + "'");
+    }
+    nlmask.GetSelectedIndices(indices);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+int CUnitTopology::NumberOfAtoms(void) const
+{
+    return( m_atoms.size() );
+}
+
+//------------------------------------------------------------------------------
+
+CEntityPtr CUnitTopology::GetAtom(int index)
+{
+    return( m_atoms[index]->GetSelf() );
+}
+
+//------------------------------------------------------------------------------
+
+CNLTopology* CUnitTopology::GetTopology(void)
+{
+    return( &m_topology );
+}
+
+//------------------------------------------------------------------------------
+
+size_t CUnitTopology::GetMemorySize(void)
+{
+    size_t size = sizeof(CUnitTopology);
+    size += m_atoms.capacity()*sizeof(CEntity*);
+    // atoms are also listed in the name and type indexes, residues in the name index
+    size += m_topology.GetNumberOfAtoms()*(sizeof(CNLAtom) + 2*sizeof(int));
+    size += m_topology.GetNumberOfResidues()*(sizeof(CNLResidue) + sizeof(int));
+    return(size);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+}
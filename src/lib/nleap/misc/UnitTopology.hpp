@@ -0,0 +1,101 @@
+#ifndef NLEAP_MISC_UNIT_TOPOLOGY_HPP
+#define NLEAP_MISC_UNIT_TOPOLOGY_HPP
+// =============================================================================
+// nLEaP - prepare input for the AMBER molecular mechanics programs
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2011 Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2006 gLEaP authors, see AUTHORS file in the main directory
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <NLEaPMainHeader.hpp>
+#include <core/Entity.hpp>
+#include <mask/NLTopology.hpp>
+#include <types/AmberFF.hpp>
+#include <vector>
+#include <list>
+
+namespace nleap {
+//------------------------------------------------------------------------------
+
+class CContext;
+class CUnit;
+
+//------------------------------------------------------------------------------
+
+/// flat mask topology of an unit
+/*!
+ The topology is built in one pass over unit residues and atoms. It is
+ rebuilt only when the unit structure changed, if only atom positions were
+ modified then just the coordinates are refreshed. Atom masses are refreshed
+ when loaded force fields are added, removed, or modified. Atoms are indexed in the
+ order of CUnit::Residues() and atoms within each residue. When the unit is
+ cloned, the topology is moved to the clone and only atom links are renewed.
+*/
+
+class NLEAP_PACKAGE CUnitTopology
+{
+public:
+// constructor -----------------------------------------------------------------
+    CUnitTopology(void);
+
+// executive methods -----------------------------------------------------------
+    /// synchronize topology with the unit
+    void Update(CContext* p_ctx, CUnit* p_unit);
+
+    /// select atoms by Amber mask, indices are sorted
+    void SelectAtoms(const string& mask, vector<int>& indices);
+
+// information methods ---------------------------------------------------------
+    /// number of atoms
+    int NumberOfAtoms(void) const;
+
+    /// get unit atom
+    CEntityPtr GetAtom(int index);
+
+    /// get mask topology
+    CNLTopology* GetTopology(void);
+
+    /// approximate memory held by the topology
+    size_t GetMemorySize(void);
+
+// section of private data -----------------------------------------------------
+private:
+    CNLTopology         m_topology;
+    vector<CEntity*>    m_atoms;
+    CUnit*              m_owner;        // unit m_atoms belong to
+    bool                m_valid;
+    unsigned long       m_revision;
+    unsigned long       m_pos_revision;
+    vector< pair<int,unsigned long> >   m_ff_key;   // ids and revisions of force fields used for masses
+
+    /// build whole topology
+    void Build(CUnit* p_unit, list<CAmberFFPtr>& ffs);
+
+    /// refresh atom masses from force fields
+    void UpdateMasses(list<CAmberFFPtr>& ffs);
+
+    /// collect unit atoms, first_atoms gets the first atom of each residue
+    void LinkAtoms(CUnit* p_unit, vector<int>& first_atoms);
+
+    /// refresh atom positions
+    void UpdatePositions(void);
+};
+
+//------------------------------------------------------------------------------
+}
+
+#endif
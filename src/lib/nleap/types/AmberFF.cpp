@@ -815,6 +815,7 @@ void CAmberFF::DescHeader(ostream& ofs)
     ofs << "   Number of angles    : " << NumberOfAngles() << endl;
     ofs << "   Number of torsions  : " << NumberOfTorsions() << endl;
     ofs << "   Number of impropers : " << NumberOfImpropers() << endl;
+    ofs << "   Memory              : " << FormatMemorySize(GetMemorySize()) << endl;
 }
 
 // -------------------------------------------------------------------------
@@ -60,6 +60,7 @@ void CAtom::Desc(ostream& ofs)
     ofs << fixed << setw(10) << setprecision(4) << Get<double>(POSZ) << " }" << endl;
     ofs << "   Charge   :  ";
     ofs << fixed << setw(10) << setprecision(4) << Get<double>(CHARGE) << endl;
+    ofs << "   Memory   : " << FormatMemorySize(GetMemorySize()) << endl;
 }
 
 // -------------------------------------------------------------------------
@@ -65,6 +65,7 @@ public:
 //------------------------------------------------------------------------------
 
 typedef shared_ptr< CAtom > CAtomPtr;
+typedef CEntityRange< CAtom > CAtomRange;
 
 //------------------------------------------------------------------------------
 }
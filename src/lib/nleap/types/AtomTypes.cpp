@@ -55,6 +55,7 @@ void CAtomTypes::Desc( ostream& ofs )
     ofs << "   Name           : " << GetName() << endl;
     ofs << "   GID            : " << GetId() << endl;
     ofs << "   Num of entries : " << NumberOfChildren() << endl;
+    ofs << "   Memory         : " << FormatMemorySize(GetMemorySize()) << endl;
 
     ofs << endl;
     ofs << "   >>> TYPES" << endl;
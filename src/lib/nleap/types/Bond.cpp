@@ -51,6 +51,7 @@ void CBond::Desc( ostream& ofs )
     ofs << "   Name  : " << GetName() << endl;
     ofs << "   ID    : " << GetId() << endl;
     ofs << "   Value : " << Get<double>(VALUE) << endl;
+    ofs << "   Memory: " << FormatMemorySize(GetMemorySize()) << endl;
 }
 
 //==============================================================================
@@ -41,6 +41,7 @@ public:
 //------------------------------------------------------------------------------
 
 typedef shared_ptr< CBond > CBondPtr;
+typedef CEntityRange< CBond > CBondRange;
 
 //------------------------------------------------------------------------------
 
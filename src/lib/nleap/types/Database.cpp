@@ -25,6 +25,7 @@
 #include <engine/Context.hpp>
 #include <types/Variable.hpp>
 #include <core/ForwardIterator.hpp>
+#include <algorithm>
 
 namespace nleap {
 //==============================================================================
@@ -34,6 +35,8 @@ namespace nleap {
 CDatabase::CDatabase(  )
 : CEntity(DATABASE)
 {
+    m_var_node = NULL;
+    m_var_revision = 0;
 }
 
 //------------------------------------------------------------------------------
@@ -41,6 +44,9 @@ CDatabase::CDatabase(  )
 CDatabase::CDatabase( int& top_id  )
 : CEntity(DATABASE)
 {
+    m_var_node = NULL;
+    m_var_revision = 0;
+
     SetId( top_id++ );
     SetName( "database" );
 
@@ -63,9 +69,6 @@ CDatabase::CDatabase( int& top_id  )
     node = CFactory::CreatePDBResMap( top_id);
     node->SetName("_pdb_res_map");
     AddChild(node);
-
-    node = CFactory::CreateNode( top_id, "_histcmds" );
-    AddChild(node);
 }
 
 //------------------------------------------------------------------------------
@@ -242,10 +245,76 @@ CPDBResMapPtr CDatabase::GetPDBResMap(void)
     return( dynamic_pointer_cast< CPDBResMap >(objs) );
 }
 
+//------------------------------------------------------------------------------
+
+size_t CDatabase::GetObjectSize(void) const
+{
+    size_t size = CEntity::GetObjectSize() + sizeof(CDatabase) - sizeof(CEntity);
+    size += m_var_index.GetMemorySize();
+    return(size);
+}
+
+//------------------------------------------------------------------------------
+
+void CDatabase::CopyCaches(CEntity* p_clone)
+{
+    CDatabase* p_db = dynamic_cast<CDatabase*>(p_clone);
+    if( p_db == NULL ) return;
+
+    CEntityPtr vars = FindChild( "_variables" );
+    CEntityPtr clone_vars = p_db->FindChild( "_variables" );
+    if( ! vars || ! clone_vars ) return;
+
+    // stale index is rebuilt by the clone on demand
+    if( (m_var_node != vars.get()) || (m_var_revision != vars->GetRevision()) ) return;
+
+    // variables are cloned in the same order
+    vector< pair<CEntity*,CEntity*> > clones;
+    clones.reserve( m_var_index.Size() );
+    CForwardIterator it = vars->BeginChildren();
+    CForwardIterator ie = vars->EndChildren();
+    CForwardIterator cit = clone_vars->BeginChildren();
+    CForwardIterator cie = clone_vars->EndChildren();
+    while( (it != ie) && (cit != cie) ){
+        clones.push_back( make_pair( it->GetThis(), cit->GetThis() ) );
+        it++;
+        cit++;
+    }
+    sort( clones.begin(), clones.end() );
+
+    if( p_db->m_var_index.CopyCloned( m_var_index, clones ) ){
+        p_db->m_var_node = clone_vars.get();
+        p_db->m_var_revision = clone_vars->GetRevision();
+    }
+}
+
 //==============================================================================
 //------------------------------------------------------------------------------
 //==============================================================================
 
+CEntityPtr CDatabase::GetVariables(void)
+{
+    CEntityPtr vars = FindChild( "_variables" );
+
+    // the index is rebuilt if the node was changed by other means than
+    // SetVariable and ReleaseVariable (e.g. after database cloning)
+    if( (m_var_node != vars.get()) || (m_var_revision != vars->GetRevision()) ){
+        m_var_index.Clear();
+        CForwardIterator it = vars->BeginChildren();
+        CForwardIterator ie = vars->EndChildren();
+        while( it != ie ){
+            m_var_index.Insert( it->GetThis() );
+            it++;
+        }
+        m_var_node = vars.get();
+        m_var_revision = vars->GetRevision();
+    }
+
+    return( vars );
+}
+
+//------------------------------------------------------------------------------
+
 CForwardIterator CDatabase::BeginVariables( )
 {
     CEntityPtr vars = FindChild( "_variables" );
@@ -264,18 +333,20 @@ CForwardIterator CDatabase::EndVariables( )
 
 bool CDatabase::IsVariable( const string& name )
 {
-    CEntityPtr vars = FindChild( "_variables" );
-    return( vars->FindChild(name) );
+    GetVariables();
+    return( m_var_index.Find(name) != NULL );
 }
 
 //------------------------------------------------------------------------------
 
 void CDatabase::ReleaseVariable( const string& name )
 {
-    CEntityPtr vars = FindChild( "_variables" );
-    CEntityPtr var = vars->FindChild( name );
-    if( var ){
-        vars->RemoveChild( var );
+    CEntityPtr vars = GetVariables();
+    CEntity* p_var = m_var_index.Find( name );
+    if( p_var ){
+        m_var_index.Remove( name );
+        vars->RemoveChild( p_var->GetSelf() );
+        m_var_revision = vars->GetRevision();
     }
 }
 
@@ -290,20 +361,22 @@ void CDatabase::SetVariable( int& top_id, const string& name, CEntityPtr object
     CVariablePtr var = CFactory::CreateVariable( top_id, name);
     var->SetObject( object );
 
-    CEntityPtr vars = FindChild( "_variables" );
+    CEntityPtr vars = GetVariables();
     vars->AddChild(var);
+    m_var_index.Insert( var.get() );
+    m_var_revision = vars->GetRevision();
 }
 
 //------------------------------------------------------------------------------
 
 CEntityPtr CDatabase::GetVariableObject( const string& name )
 {
-    CEntityPtr vars = FindChild( "_variables" );
-    CEntityPtr ovar = vars->FindChild( name );
-    if( ! ovar ){
+    GetVariables();
+    CEntity* p_var = m_var_index.Find( name );
+    if( p_var == NULL ){
         return( CEntityPtr() ); // not found
     }
-    CVariablePtr var = dynamic_pointer_cast< CVariable >(ovar);
+    CVariable* var = dynamic_cast< CVariable* >(p_var);
     if( ! var ){
         return( CEntityPtr() ); // incorrect type
     }
@@ -340,10 +413,51 @@ void CDatabase::ClearDatabase(void)
     if( node ){
         node->RemoveAllChildren();
     }
+}
 
-    node = FindChild( "_histcmds" );
-    if( node ){
-        node->RemoveAllChildren();
+//------------------------------------------------------------------------------
+
+/// assign new ids to the object and all its children
+static void RenumberObject(CEntity* p_obj, int& top_id)
+{
+    p_obj->SetId( top_id++ );
+
+    CForwardIterator it = p_obj->BeginChildren();
+    CForwardIterator ie = p_obj->EndChildren();
+    while( it != ie ){
+        RenumberObject( it->GetThis(), top_id );
+        it++;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void CDatabase::MergeDatabase(int& top_id, CDatabasePtr other)
+{
+    if( ! other ){
+        throw runtime_error("other database is NULL in CDatabase::MergeDatabase");
+    }
+
+    // move objects, ids from the other database would collide with ids of this one
+    CEntityPtr objs = FindChild( "_objects" );
+    CEntityPtr other_objs = other->FindChild( "_objects" );
+
+    while( other_objs->GetFirstChild() ){
+        CEntityPtr obj = other_objs->GetFirstChild();
+        other_objs->RemoveFirstChild();
+        objs->AddChild(obj);
+        RenumberObject( obj.get(), top_id );
+    }
+
+    // variables are set in the order in which they were created in the other database
+    CForwardIterator it = other->BeginVariables();
+    CForwardIterator ie = other->EndVariables();
+    while( it != ie ){
+        CVariable* p_var = dynamic_cast< CVariable* >( it->GetThis() );
+        if( p_var ){
+            SetVariable( top_id, p_var->GetName(), p_var->GetObject() );
+        }
+        it++;
     }
 }
 
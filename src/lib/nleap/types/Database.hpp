@@ -23,6 +23,7 @@
 
 #include <NLEaPMainHeader.hpp>
 #include <core/Entity.hpp>
+#include <core/NameIndex.hpp>
 #include <types/String.hpp>
 #include <types/Number.hpp>
 #include <types/Unit.hpp>
@@ -40,7 +41,6 @@ namespace nleap {
  database
    |->objects   (top-level objects)
    |->variables (variables)
-   |->histcmds  (list of commands used)
 
 */
 // -----------------------------------------------------------------------------
@@ -120,6 +120,24 @@ public:
     /// clear the entire database
     void ClearDatabase(void);
 
+    /// move objects and variables of other database into this database, moved objects are renumbered
+    void MergeDatabase(int& top_id, CDatabasePtr other);
+
+    /// memory of the database including the variable index
+    virtual size_t GetObjectSize(void) const;
+
+// section of private data -----------------------------------------------------
+protected:
+    /// the variable index is copied to the clone
+    virtual void CopyCaches(CEntity* p_clone);
+
+private:
+    CNameIndex      m_var_index;        // variables by name
+    CEntity*        m_var_node;         // indexed variable node
+    unsigned long   m_var_revision;     // revision of indexed variable node
+
+    /// get variable node and synchronize the index with it
+    CEntityPtr GetVariables(void);
 };
 // -----------------------------------------------------------------------------
 }
@@ -25,13 +25,36 @@
 #include <vector>
 #include <types/Factory.hpp>
 #include <core/PredefinedKeys.hpp>
+#include <core/SlabAllocator.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/ref.hpp>
 
 namespace nleap {
 //==============================================================================
 //------------------------------------------------------------------------------
 //==============================================================================
 
+// objects and their control blocks are allocated from slab pools
+
+template <class T>
+static shared_ptr<T> SlabCreate(void)
+{
+    return( allocate_shared<T>(CSlabAllocator<T>()) );
+}
+
+//------------------------------------------------------------------------------
+
+template <class T>
+static shared_ptr<T> SlabCreate(int& top_id)
+{
+    return( allocate_shared<T>(CSlabAllocator<T>(),boost::ref(top_id)) );
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
 CKey CFactory::DetermineType(const string& value)
 {
     if( value.empty() ) return(UNKNOWN);
@@ -124,33 +147,33 @@ CEntityPtr CFactory::Create(const CKey& type)
     CEntityPtr obj;
 
     if( type == NODE ){
-        obj = CEntityPtr( new CEntity(NODE) );
+        obj = allocate_shared<CEntity>(CSlabAllocator<CEntity>(),NODE);
     } else if( type == DATABASE ) {
-        obj = CDatabasePtr( new CDatabase );
+        obj = SlabCreate<CDatabase>();
     } else if( type == VARIABLE ) {
-        obj = CVariablePtr( new CVariable );
+        obj = SlabCreate<CVariable>();
     } else if( type == STRING ) {
-        obj = CStringPtr( new CString );
+        obj = SlabCreate<CString>();
     } else if( type == NUMBER ) {
-        obj = CNumberPtr( new CNumber );
+        obj = SlabCreate<CNumber>();
     } else if( type == UNIT ) {
-        obj = CUnitPtr( new CUnit );
+        obj = SlabCreate<CUnit>();
     } else if( type == RESIDUE ) {
-        obj = CResiduePtr( new CResidue );
+        obj = SlabCreate<CResidue>();
     } else if( type == ATOM ) {
-        obj = CAtomPtr( new CAtom );
+        obj = SlabCreate<CAtom>();
     } else if( type == BOND ) {
-        obj = CBondPtr( new CBond );
+        obj = SlabCreate<CBond>();
     } else if( type == AMBERFF ) {
-        obj = CAmberFFPtr( new CAmberFF );
+        obj = SlabCreate<CAmberFF>();
     } else if( type == LIST ) {
-        obj = CListPtr( new CList );
+        obj = SlabCreate<CList>();
     } else if( type == ATOMTYPES ) {
-        obj = CAtomTypesPtr( new CAtomTypes );
+        obj = SlabCreate<CAtomTypes>();
     } else if( type == PDBATOMMAP ) {
-        obj = CPDBAtomMapPtr( new CPDBAtomMap );
+        obj = SlabCreate<CPDBAtomMap>();
     } else if( type == PDBRESMAP ) {
-        obj = CPDBResMapPtr( new CPDBResMap );
+        obj = SlabCreate<CPDBResMap>();
     } else {
         // wrong
         return( obj );
@@ -163,7 +186,7 @@ CEntityPtr CFactory::Create(const CKey& type)
 
 CDatabasePtr CFactory::CreateDatabase(int& top_id)
 {
-    CDatabasePtr obj = CDatabasePtr( new CDatabase( top_id ) );
+    CDatabasePtr obj = SlabCreate<CDatabase>(top_id);
     return(obj);
 }
 
@@ -171,7 +194,7 @@ CDatabasePtr CFactory::CreateDatabase(int& top_id)
 
 CVariablePtr CFactory::CreateVariable(int& top_id, const string& name)
 {
-    CVariablePtr obj = CVariablePtr( new CVariable( top_id ) );
+    CVariablePtr obj = SlabCreate<CVariable>(top_id);
     obj->SetName(name);
     return(obj);
 }
@@ -180,7 +203,7 @@ CVariablePtr CFactory::CreateVariable(int& top_id, const string& name)
 
 CEntityPtr CFactory::CreateNode(int& top_id)
 {
-    CEntityPtr obj = CEntityPtr( new CEntity( NODE, top_id ) );
+    CEntityPtr obj = allocate_shared<CEntity>(CSlabAllocator<CEntity>(),NODE,boost::ref(top_id));
     return(obj);
 }
 
@@ -188,7 +211,7 @@ CEntityPtr CFactory::CreateNode(int& top_id)
 
 CEntityPtr CFactory::CreateNode(int& top_id, const string& name)
 {
-    CEntityPtr obj = CEntityPtr( new CEntity( NODE, top_id ) );
+    CEntityPtr obj = allocate_shared<CEntity>(CSlabAllocator<CEntity>(),NODE,boost::ref(top_id));
     obj->SetName(name);
     return(obj);
 }
@@ -197,7 +220,7 @@ CEntityPtr CFactory::CreateNode(int& top_id, const string& name)
 
 CAmberFFPtr CFactory::CreateAmberFF(int& top_id)
 {
-    CAmberFFPtr obj = CAmberFFPtr( new CAmberFF( top_id ) );
+    CAmberFFPtr obj = SlabCreate<CAmberFF>(top_id);
     return(obj);
 }
 
@@ -205,7 +228,7 @@ CAmberFFPtr CFactory::CreateAmberFF(int& top_id)
 
 CStringPtr CFactory::CreateString(int& top_id, const string& str)
 {
-    CStringPtr obj = CStringPtr( new CString( top_id ) );
+    CStringPtr obj = SlabCreate<CString>(top_id);
     obj->SetValue(str);
     return(obj);
 }
@@ -220,7 +243,7 @@ CNumberPtr CFactory::CreateNumber(int& top_id, const string& num)
     str >> n;
 
     // create object
-    CNumberPtr obj = CNumberPtr( new CNumber( top_id ) );
+    CNumberPtr obj = SlabCreate<CNumber>(top_id);
     obj->SetValue(n);
     return(obj);
 }
@@ -229,7 +252,7 @@ CNumberPtr CFactory::CreateNumber(int& top_id, const string& num)
 
 CUnitPtr CFactory::CreateUnit(int& top_id)
 {
-    CUnitPtr obj = CUnitPtr( new CUnit( top_id ) );
+    CUnitPtr obj = SlabCreate<CUnit>(top_id);
     return(obj);
 }
 
@@ -237,7 +260,7 @@ CUnitPtr CFactory::CreateUnit(int& top_id)
 
 CResiduePtr CFactory::CreateResidue(int& top_id)
 {
-    CResiduePtr obj = CResiduePtr( new CResidue( top_id ) );
+    CResiduePtr obj = SlabCreate<CResidue>(top_id);
     return(obj);
 }
 
@@ -245,7 +268,7 @@ CResiduePtr CFactory::CreateResidue(int& top_id)
 
 CAtomPtr CFactory::CreateAtom(int& top_id)
 {
-    CAtomPtr obj = CAtomPtr( new CAtom( top_id ) );
+    CAtomPtr obj = SlabCreate<CAtom>(top_id);
     return(obj);
 }
 
@@ -253,7 +276,7 @@ CAtomPtr CFactory::CreateAtom(int& top_id)
 
 CBondPtr CFactory::CreateBond(int& top_id)
 {
-    CBondPtr obj = CBondPtr( new CBond( top_id ) );
+    CBondPtr obj = SlabCreate<CBond>(top_id);
     return(obj);
 }
 
@@ -261,7 +284,7 @@ CBondPtr CFactory::CreateBond(int& top_id)
 
 CListPtr CFactory::CreateList(int& top_id)
 {
-    CListPtr obj = CListPtr( new CList( top_id ) );
+    CListPtr obj = SlabCreate<CList>(top_id);
     return(obj);
 }
 
@@ -269,7 +292,7 @@ CListPtr CFactory::CreateList(int& top_id)
 
 CListPtr CFactory::CreateList( int& top_id, const string& list_src )
 {
-    CListPtr list = CListPtr( new CList( top_id ) );
+    CListPtr list = SlabCreate<CList>(top_id);
 
     vector<string> items;
     split(items, list_src, is_any_of(" \t\n"), token_compress_on);
@@ -364,7 +387,7 @@ CListPtr CFactory::CreateList( int& top_id, const string& list_src )
 
 CAtomTypesPtr CFactory::CreateAtomTypes(int& top_id)
 {
-    CAtomTypesPtr obj = CAtomTypesPtr( new CAtomTypes( top_id ) );
+    CAtomTypesPtr obj = SlabCreate<CAtomTypes>(top_id);
     return(obj);
 }
 
@@ -372,7 +395,7 @@ CAtomTypesPtr CFactory::CreateAtomTypes(int& top_id)
 
 CPDBAtomMapPtr CFactory::CreatePDBAtomMap(int& top_id)
 {
-    CPDBAtomMapPtr obj = CPDBAtomMapPtr( new CPDBAtomMap( top_id ) );
+    CPDBAtomMapPtr obj = SlabCreate<CPDBAtomMap>(top_id);
     return(obj);
 }
 
@@ -380,7 +403,7 @@ CPDBAtomMapPtr CFactory::CreatePDBAtomMap(int& top_id)
 
 CPDBResMapPtr CFactory::CreatePDBResMap(int& top_id)
 {
-    CPDBResMapPtr obj = CPDBResMapPtr( new CPDBResMap( top_id ) );
+    CPDBResMapPtr obj = SlabCreate<CPDBResMap>(top_id);
     return(obj);
 }
 
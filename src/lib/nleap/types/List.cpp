@@ -48,6 +48,7 @@ void CList::Desc( ostream& ofs )
     ofs << "LIST" << endl;
     ofs << "   Name  : " << GetName() << endl;
     ofs << "   GID   : " << GetId() << endl;
+    ofs << "   Memory: " << FormatMemorySize(GetMemorySize()) << endl;
 }
 
 //==============================================================================
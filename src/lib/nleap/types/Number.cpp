@@ -51,6 +51,7 @@ void CNumber::Desc(ostream& ofs)
     ofs << "   Name  : " << GetName() << endl;
     ofs << "   GID   : " << GetId() << endl;
     ofs << "   Value : " << Get<double>(VALUE) << endl;
+    ofs << "   Memory: " << FormatMemorySize(GetMemorySize()) << endl;
 }
 
 // -------------------------------------------------------------------------
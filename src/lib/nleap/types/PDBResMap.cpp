@@ -53,6 +53,7 @@ void CPDBResMap::Desc( ostream& ofs )
     ofs << "   Name           : " << GetName() << endl;
     ofs << "   GID            : " << GetId() << endl;
     ofs << "   Num of entries : " << NumberOfChildren() << endl;
+    ofs << "   Memory         : " << FormatMemorySize(GetMemorySize()) << endl;
 
     ofs << endl;
     ofs << "   >>> MAP" << endl;
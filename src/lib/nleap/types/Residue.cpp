@@ -122,6 +122,7 @@ void CResidue::Desc(ostream& ofs)
     }
 
         ofs << "   Number of atoms : " << NumberOfChildren() << endl;
+        ofs << "   Memory          : " << FormatMemorySize(GetMemorySize()) << endl;
 
     int at0 = Get<int>(ATOM1);
     int at1 = Get<int>(ATOM2);
@@ -253,6 +254,13 @@ CAtomPtr CResidue::FindAtom(int lid)
     return( CAtomPtr() );
 }
 
+// -------------------------------------------------------------------------
+
+CAtomRange CResidue::Atoms(void)
+{
+    return( Children<CAtom>() );
+}
+
 //==============================================================================
 //------------------------------------------------------------------------------
 //==============================================================================
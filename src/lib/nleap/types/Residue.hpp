@@ -71,11 +71,15 @@ public:
 
     /// find atom
     CAtomPtr FindAtom(int lid);
+
+    /// atoms as a range, valid until the residue is modified
+    CAtomRange Atoms(void);
 };
 
 //------------------------------------------------------------------------------
 
 typedef shared_ptr< CResidue > CResiduePtr;
+typedef CEntityRange< CResidue > CResidueRange;
 
 //------------------------------------------------------------------------------
 }
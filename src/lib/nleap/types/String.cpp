@@ -50,6 +50,7 @@ void CString::Desc(ostream& ofs)
     ofs << "   Name  : " << GetName() << endl;
     ofs << "   GID   : " << GetId() << endl;
     ofs << "   Value : " << Get<string>(VALUE) << endl;
+    ofs << "   Memory: " << FormatMemorySize(GetMemorySize()) << endl;
 }
 
 // -------------------------------------------------------------------------
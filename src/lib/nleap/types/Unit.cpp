@@ -22,8 +22,10 @@
 #include <types/Unit.hpp>
 #include <core/PredefinedKeys.hpp>
 #include <types/Factory.hpp>
+#include <misc/UnitTopology.hpp>
 #include <iomanip>
 #include <core/ForwardIterator.hpp>
+#include <algorithm>
 
 namespace nleap {
 //==============================================================================
@@ -36,6 +38,8 @@ CUnit::CUnit(void)
     m_atoms = 0;
     m_bonds = 0;
     m_residues = 0;
+    m_atom_list_valid = false;
+    m_atom_list_revision = 0;
 }
 
 // -------------------------------------------------------------------------
@@ -56,6 +60,8 @@ CUnit::CUnit(int& top_id)
     m_atoms = 0;
     m_bonds = 0;
     m_residues = 0;
+    m_atom_list_valid = false;
+    m_atom_list_revision = 0;
 }
 
 // -------------------------------------------------------------------------
@@ -202,6 +208,7 @@ void CUnit::DescHeader(ostream& ofs)
         ofs << "   Residues  : " << m_residues << endl;
         ofs << "   Atoms     : " << m_atoms << endl;
         ofs << "   Bonds     : " << m_bonds << endl;
+        ofs << "   Memory    : " << FormatMemorySize(GetMemorySize()) << endl;
 
     int head = Get<int>(HEAD);
     int tail = Get<int>(TAIL);
@@ -532,14 +539,20 @@ void CUnit::RemoveBond(const CAtomPtr& at1, const CAtomPtr& at2)
 
 void CUnit::RemoveBonds(const CAtomPtr& at1)
 {
-    CForwardIterator it = BeginBonds();
-    CForwardIterator ie = EndBonds();
+    if( ! at1 ) return;
     CEntityPtr bonds = FindChild( "bonds" );
-
-    while( it != ie ){
-        CEntityPtr bond = *it;
-        it++;
-        if( (it->Get<CEntityPtr>(ATOM1) == at1) || (it->Get<CEntityPtr>(ATOM2) == at1) ){
+    if( ! bonds ) return;
+
+    // bonds are found among objects referring to the atom
+    vector<CEntity*> referrers;
+    at1->GetReferrers(referrers);
+    sort(referrers.begin(),referrers.end());
+    referrers.erase(unique(referrers.begin(),referrers.end()),referrers.end());
+
+    for(size_t i=0; i < referrers.size(); i++){
+        CEntityPtr bond = referrers[i]->GetSelf();
+        if( (! bond) || (bond->GetRoot() != bonds) ) continue;
+        if( (bond->Get<CEntityPtr>(ATOM1) == at1) || (bond->Get<CEntityPtr>(ATOM2) == at1) ){
             bonds->RemoveChild(bond);
             m_bonds--;
         }
@@ -628,6 +641,116 @@ void CUnit::FixCounters(void)
 
 }
 
+// -------------------------------------------------------------------------
+
+void CUnit::Clear(void)
+{
+    // bonds first, they refer to atoms
+    CEntityPtr bonds = FindChild( "bonds" );
+    if( bonds ) bonds->RemoveAllChildren();
+
+    CEntityPtr residues = FindChild( "residues" );
+    if( residues ) residues->RemoveAllChildren();
+
+    m_atoms = 0;
+    m_bonds = 0;
+    m_residues = 0;
+    m_atom_list.clear();
+    m_atom_list_valid = false;
+}
+
+// -------------------------------------------------------------------------
+
+CAtomRange CUnit::Atoms(void)
+{
+    if( (! m_atom_list_valid) || (m_atom_list_revision != GetRevision()) ){
+        m_atom_list.clear();
+
+        CResidueRange residues = Residues();
+        for(CResidueRange::iterator rit = residues.begin(); rit != residues.end(); rit++){
+            CEntityRange<CEntity> atoms = rit->Children<CEntity>();
+            for(CEntityRange<CEntity>::iterator ait = atoms.begin(); ait != atoms.end(); ait++){
+                if( ait->GetType() == ATOM ){
+                    m_atom_list.push_back(&(*ait));
+                }
+            }
+        }
+
+        m_atom_list_valid = true;
+        m_atom_list_revision = GetRevision();
+    }
+
+    if( m_atom_list.empty() ) return( CAtomRange() );
+    return( CAtomRange(&m_atom_list[0],m_atom_list.size()) );
+}
+
+// -------------------------------------------------------------------------
+
+CResidueRange CUnit::Residues(void)
+{
+    CEntityPtr residues = FindChild( "residues" );
+    return( residues->Children<CResidue>() );
+}
+
+// -------------------------------------------------------------------------
+
+CBondRange CUnit::Bonds(void)
+{
+    CEntityPtr bonds = FindChild( "bonds" );
+    return( bonds->Children<CBond>() );
+}
+
+// -------------------------------------------------------------------------
+
+CUnitTopology* CUnit::GetMaskTopology(CContext* p_ctx)
+{
+    if( ! m_topology ){
+        m_topology = shared_ptr<CUnitTopology>( new CUnitTopology );
+    }
+    m_topology->Update(p_ctx,this);
+    return( m_topology.get() );
+}
+
+// -------------------------------------------------------------------------
+
+void CUnit::MoveCaches(CEntity* p_clone)
+{
+    CUnit* p_unit = dynamic_cast<CUnit*>(p_clone);
+    if( p_unit == NULL ) return;
+    p_unit->m_topology = m_topology;
+    m_topology.reset();
+}
+
+//------------------------------------------------------------------------------
+
+size_t CUnit::GetObjectSize(void) const
+{
+    size_t size = CEntity::GetObjectSize() + sizeof(CUnit) - sizeof(CEntity);
+    size += m_atom_list.capacity()*sizeof(CEntity*);
+    if( m_topology ){
+        size += m_topology->GetMemorySize();
+    }
+    return(size);
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CAtomRange GetAtomRange(const CEntityPtr& obj)
+{
+    if( ! obj ) return( CAtomRange() );
+
+    if( obj->GetType() == UNIT ){
+        return( static_cast<CUnit*>(obj.get())->Atoms() );
+    }
+    if( obj->GetType() == RESIDUE ){
+        return( static_cast<CResidue*>(obj.get())->Atoms() );
+    }
+
+    return( CAtomRange() );
+}
+
 //==============================================================================
 //------------------------------------------------------------------------------
 //==============================================================================
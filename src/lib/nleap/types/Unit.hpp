@@ -32,6 +32,11 @@
 namespace nleap {
 //------------------------------------------------------------------------------
 
+class CContext;
+class CUnitTopology;
+
+//------------------------------------------------------------------------------
+
 /// CUnit is a unit type
 class NLEAP_PACKAGE CUnit : public CEntity
 {
@@ -76,6 +81,9 @@ public:
     /// find atom
     CAtomPtr FindAtom(int sid);
 
+    /// atoms as a range, valid until the unit structure is modified
+    CAtomRange Atoms(void);
+
 // -------------------------------------------------------------------------
 
     /// create new residue
@@ -105,6 +113,9 @@ public:
     /// has residue owned by this unit?
     bool HasResidue(CResiduePtr cres);
 
+    /// residues as a range, valid until the unit structure is modified
+    CResidueRange Residues(void);
+
 // -------------------------------------------------------------------------
 
     /// create bond between two atoms
@@ -128,22 +139,48 @@ public:
     /// end of bonds objects
     CForwardIterator   EndBonds(void);
 
+    /// bonds as a range, valid until the unit structure is modified
+    CBondRange Bonds(void);
+
 // -------------------------------------------------------------------------
 
     /// fix counters and numbering
     void FixCounters(void);
 
+    /// remove all residues and bonds, the unit can be reused for another molecule
+    void Clear(void);
+
+    /// get topology for atom masks, it is rebuilt only if the unit was modified
+    CUnitTopology* GetMaskTopology(CContext* p_ctx);
+
+    /// memory of the unit including cached atom list and mask topology
+    virtual size_t GetObjectSize(void) const;
+
 // -------------------------------------------------------------------------
+protected:
+    /// the mask topology is moved to the clone, which replaces this unit
+    /// in the snapshot history
+    virtual void MoveCaches(CEntity* p_clone);
+
 private:
     int m_atoms;
     int m_bonds;
     int m_residues;
+    shared_ptr<CUnitTopology>   m_topology;
+    vector<CEntity*>            m_atom_list;        // atoms of all residues
+    bool                        m_atom_list_valid;
+    unsigned long               m_atom_list_revision;
 };
 
 //------------------------------------------------------------------------------
 
 typedef shared_ptr< CUnit > CUnitPtr;
 
+//------------------------------------------------------------------------------
+
+/// atoms of unit or residue, empty range for other objects
+CAtomRange NLEAP_PACKAGE GetAtomRange(const CEntityPtr& obj);
+
 //------------------------------------------------------------------------------
 }
 
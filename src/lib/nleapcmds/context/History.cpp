@@ -22,7 +22,6 @@
 #include <History.hpp>
 #include <iostream>
 #include <engine/Context.hpp>
-#include <core/ForwardIterator.hpp>
 
 namespace nleapcmds {
 //==============================================================================
@@ -64,6 +63,8 @@ const char* CHistoryCommand::Info( EHelp type ) const
     "\n"
     "<b>DESCRIPTION:</b>\n"
     "Print the history of commands used so far either on screen or to the specified file <u>filename</u>.\n"
+"Only the latest commands are kept in memory (see <b>nleap</b> histsize), older commands are printed only\n"
+"if they were spilled to a file (see <b>nleap</b> histfile).\n"
     );
 }
 
@@ -71,8 +72,6 @@ const char* CHistoryCommand::Info( EHelp type ) const
 
 void CHistoryCommand::Exec( CContext* p_ctx )
 {
-    CEntityPtr list = p_ctx->database()->FindChild("_histcmds");
-
     ostream* ofs = NULL;
     fstream  fofs;
 
@@ -88,14 +87,8 @@ void CHistoryCommand::Exec( CContext* p_ctx )
         ofs = &p_ctx->out();
     }
 
-    // list all childs
-    CForwardIterator it = list->BeginChildren();
-    CForwardIterator ie = list->EndChildren();
-
-    while( it != ie ){
-        *ofs << (*it)->Get<string>(VALUE) << endl;
-        it++;
-    }
+    // list all recorded commands
+    p_ctx->history().Print(*ofs);
 }
 
 //------------------------------------------------------------------------------
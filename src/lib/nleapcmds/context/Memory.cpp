@@ -0,0 +1,193 @@
+// =============================================================================
+// nLEaP - A molecular manipulation program and coding environment
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2011 Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2006 gLEaP authors, see AUTHORS file in the main directory
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <Memory.hpp>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <engine/Context.hpp>
+#include <core/ForwardIterator.hpp>
+
+namespace nleapcmds {
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CMemoryCommand::CMemoryCommand( const string& cmd_name )
+    : CCommand( cmd_name )
+{
+    m_change_state = false;
+}
+
+//------------------------------------------------------------------------------
+
+CMemoryCommand::CMemoryCommand( const string& cmd_name,  const vector<string>& args )
+    : CCommand( cmd_name, cmd_name ), m_args( args )
+{
+    m_change_state = false;
+}
+
+//------------------------------------------------------------------------------
+
+const char* CMemoryCommand::Info( CCommand::EHelp type ) const
+{
+    if( type == help_group )
+    {
+        return("context");
+    }
+
+    if( type == help_short )
+    {
+        return("print memory footprint of the session");
+    }
+    return(
+    "<b>NAME:</b>\n"
+    "   <b>memory</b> - print memory footprint of the session\n"
+    "\n"
+    "<b>USAGE:</b>\n"
+    "   <b>memory</b>\n"
+    "\n"
+    "<b>DESCRIPTION:</b>\n"
+    "Print approximate memory occupied by the current database broken down by its sections\n"
+    "(objects, variables, atom types, and PDB maps), units and force fields among objects,\n"
+    "every level of the database history used by <b>undo</b> and <b>redo</b>, and the command\n"
+    "history. Sizes include entities, property blocks, strings, and indexes. The memory\n"
+    "footprint of individual objects is also printed by <b>desc</b>.\n"
+    );
+}
+
+//------------------------------------------------------------------------------
+
+/// print header of memory table
+static void PrintMemoryHeader(ostream& ofs, const string& title, const string& count)
+{
+    ofs << "   " << left << setw(30) << title << " " << right << setw(8) << count << " ";
+    ofs << setw(12) << "Size" << left << endl;
+    ofs << "   ------------------------------ -------- ------------" << endl;
+}
+
+//------------------------------------------------------------------------------
+
+/// print one line of memory table
+static void PrintMemoryLine(ostream& ofs, const string& name, int count, size_t size)
+{
+    ofs << "   " << left << setw(30) << name << " " << right;
+    if( count >= 0 ){
+        ofs << setw(8) << count << " ";
+    } else {
+        ofs << "         ";
+    }
+    ofs << setw(12) << CEntity::FormatMemorySize(size) << left << endl;
+}
+
+//------------------------------------------------------------------------------
+
+void CMemoryCommand::Exec( CContext* p_ctx )
+{
+    CheckNumberOfArguments( m_args, 0, 0 );
+
+    ostream& ofs = p_ctx->out();
+
+    // ------------------------------------------
+    // current database
+    CDatabasePtr db = p_ctx->database();
+
+    PrintMemoryHeader(ofs,"Current database","Objects");
+
+    CForwardIterator it = db->BeginChildren();
+    CForwardIterator ie = db->EndChildren();
+    while( it != ie ){
+        PrintMemoryLine(ofs,it->GetName(),it->NumberOfChildren(),it->GetMemorySize());
+
+        // units and force fields are summarized separately
+        if( it->GetName() == "_objects" ){
+            int     nunits = 0, nffs = 0, nothers = 0;
+            size_t  sunits = 0, sffs = 0, sothers = 0;
+            CForwardIterator oit = it->BeginChildren();
+            CForwardIterator oie = it->EndChildren();
+            while( oit != oie ){
+                size_t size = oit->GetMemorySize();
+                if( oit->GetType() == UNIT ){
+                    nunits++;
+                    sunits += size;
+                } else if( oit->GetType() == AMBERFF ){
+                    nffs++;
+                    sffs += size;
+                } else {
+                    nothers++;
+                    sothers += size;
+                }
+                oit++;
+            }
+            PrintMemoryLine(ofs,"  units",nunits,sunits);
+            PrintMemoryLine(ofs,"  force fields",nffs,sffs);
+            PrintMemoryLine(ofs,"  other objects",nothers,sothers);
+        }
+        it++;
+    }
+    PrintMemoryLine(ofs,"database total",-1,db->GetMemorySize());
+
+    // ------------------------------------------
+    // database history, the last snapshot is undo level 0
+    CEntityPtr dbs = p_ctx->FindChild( "dbhistory" );
+
+    ofs << endl;
+    PrintMemoryHeader(ofs,"Database history","Entities");
+
+    int     nlevels = dbs->NumberOfChildren();
+    int     level = nlevels - 1;
+    size_t  history = 0;
+    it = dbs->BeginChildren();
+    ie = dbs->EndChildren();
+    while( it != ie ){
+        stringstream str;
+        str << "level " << level;
+        if( level == p_ctx->GetUndoLevel() ) str << " (current)";
+        size_t size = it->GetMemorySize();
+        PrintMemoryLine(ofs,str.str(),it->NumberOfChildren(true),size);
+        history += size;
+        level--;
+        it++;
+    }
+    PrintMemoryLine(ofs,"history total",-1,history);
+
+    // ------------------------------------------
+    // context
+    ofs << endl;
+    PrintMemoryHeader(ofs,"Session","Records");
+    PrintMemoryLine(ofs,"command history",p_ctx->history().Size(),p_ctx->history().GetMemorySize());
+    PrintMemoryLine(ofs,"profiler records",p_ctx->profiler().NumberOfRecords(),p_ctx->profiler().GetMemorySize());
+    PrintMemoryLine(ofs,"session total",-1,p_ctx->GetMemorySize());
+}
+
+//-------------------------------------------------------------------------------
+
+shared_ptr< CCommand > CMemoryCommand::Clone( CContext* p_ctx, const CParser& cmdline ) const
+{
+    NoAssigmentPossible( cmdline );
+
+    return shared_ptr< CCommand >( new CMemoryCommand( m_action, cmdline.GetArgs() ) );
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+}
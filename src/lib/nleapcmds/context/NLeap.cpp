@@ -73,6 +73,12 @@ const char* CNLeapCommand::Info( CCommand::EHelp type ) const
     "   <b>nleap</b> buffer [<u>size</u>]\n"
     "       either set history buffer to <u>size</u> or print current history buffer size\n"
     "\n"
+    "   <b>nleap</b> histsize [<u>size</u>]\n"
+    "       either set the number of commands kept in the command history or print it\n"
+    "\n"
+    "   <b>nleap</b> histfile [<u>filename</u>]\n"
+    "       either spill commands dropped from the command history to <u>filename</u> or print its name\n"
+    "\n"
     "   <b>nleap</b> path\n"
     "       shows the set of directories that are used to search nLEaP scripts and parameter files\n"
     "\n"
@@ -186,6 +192,49 @@ void CNLeapCommand::Exec( CContext* p_ctx )
         }
     }
 
+    // ------------------------------------------
+    // handle histsize
+
+    if( m_args[0] == "histsize" ) {
+        CheckNumberOfArguments( m_args, 1, 2 );
+
+        if( m_args.size() == 1 ){
+            p_ctx->out() << low << "Max history size: " << p_ctx->history().GetCapacity() << endl;
+            return;
+        }
+
+        if( m_args.size() == 2 ) {
+            int vsize = 0;
+            ExpandArgument( p_ctx, m_args, 1, vsize );
+            if( vsize < 0 ){
+                WrongArgument( m_args, 1, "history size cannot be a negative number");
+            }
+            p_ctx->history().SetCapacity( vsize );
+            p_ctx->out() << medium << "Max history size changed to " << p_ctx->history().GetCapacity() << endl;
+            return;
+        }
+    }
+
+    // ------------------------------------------
+    // handle histfile
+
+    if( m_args[0] == "histfile" ) {
+        CheckNumberOfArguments( m_args, 1, 2 );
+
+        if( m_args.size() == 1 ){
+            p_ctx->out() << low << "History spill file: " << p_ctx->history().GetSpillFile() << endl;
+            return;
+        }
+
+        if( m_args.size() == 2 ) {
+            string name;
+            ExpandArgument( p_ctx, m_args, 1, name );
+            p_ctx->history().SetSpillFile( name );
+            p_ctx->out() << medium << "History spill file changed to '" << p_ctx->history().GetSpillFile() << "'" << endl;
+            return;
+        }
+    }
+
     // ------------------------------------------
     // handle path
 
@@ -0,0 +1,183 @@
+// =============================================================================
+// nLEaP - A molecular manipulation program and coding environment
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2011 Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2006 gLEaP authors, see AUTHORS file in the main directory
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <Profile.hpp>
+#include <iostream>
+#include <fstream>
+#include <engine/Context.hpp>
+
+namespace nleapcmds {
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CProfileCommand::CProfileCommand( const string& cmd_name )
+    : CCommand( cmd_name )
+{
+    m_change_state = false;
+}
+
+//------------------------------------------------------------------------------
+
+CProfileCommand::CProfileCommand( const string& cmd_name,  const vector<string>& args )
+    : CCommand( cmd_name, cmd_name ), m_args( args )
+{
+    m_change_state = false;
+}
+
+//------------------------------------------------------------------------------
+
+const char* CProfileCommand::Info( CCommand::EHelp type ) const
+{
+    if( type == help_group )
+    {
+        return("context");
+    }
+
+    if( type == help_short )
+    {
+        return("profile executed commands");
+    }
+    return(
+    "<b>NAME:</b>\n"
+    "   <b>profile</b> - profile executed commands\n"
+    "\n"
+    "<b>USAGE:</b>\n"
+    "   <b>profile</b>\n"
+    "       print wall and CPU times of all recorded commands and their phases (parse, database\n"
+    "       snapshot, argument expansion, and execution), the number of created entities,\n"
+    "       the memory allocated for entities, and the size of the database snapshot\n"
+    "\n"
+    "   <b>profile</b> on/off\n"
+    "       start or stop recording of executed commands\n"
+    "\n"
+    "   <b>profile</b> top [<u>number</u>]\n"
+    "       print only <u>number</u> (default 10) of the most time consuming commands\n"
+    "\n"
+    "   <b>profile</b> clear\n"
+    "       remove all recorded commands\n"
+    "\n"
+    "   <b>profile</b> save <u>filename</u>\n"
+    "       save the table of recorded commands to <u>filename</u>\n"
+    "\n"
+    "   <b>profile</b> trace <u>filename</u>\n"
+    "       save recorded commands to <u>filename</u> as Chrome trace events (chrome://tracing)\n"
+    "\n"
+    "<b>DESCRIPTION:</b>\n"
+    "Commands executed by <b>source</b> are nested under it and they are included in its times.\n"
+    "Recording can be also enabled by the <b>--profile</b> option of nleap.\n"
+    );
+}
+
+//------------------------------------------------------------------------------
+
+void CProfileCommand::Exec( CContext* p_ctx )
+{
+    CProfiler& prof = p_ctx->profiler();
+
+    // ------------------------------------------
+    // print profile
+    if( m_args.size() == 0 ){
+        if( ! prof.IsEnabled() && (prof.NumberOfRecords() == 0) ){
+            p_ctx->out() << low << "Profiling is off, use 'profile on' to start recording." << endl;
+            return;
+        }
+        prof.PrintTable(p_ctx->out());
+        return;
+    }
+
+    // ------------------------------------------
+    // handle on/off
+
+    if( (m_args[0] == "on") || (m_args[0] == "off") ) {
+        CheckNumberOfArguments( m_args, 1, 1 );
+        prof.Enable( m_args[0] == "on" );
+        p_ctx->out() << medium << "Profiling is " << m_args[0] << endl;
+        return;
+    }
+
+    // ------------------------------------------
+    // handle top
+
+    if( m_args[0] == "top" ) {
+        CheckNumberOfArguments( m_args, 1, 2 );
+
+        int top = 10;
+        if( m_args.size() == 2 ) {
+            ExpandArgument( p_ctx, m_args, 1, top );
+            if( top <= 0 ){
+                WrongArgument( m_args, 1, "number of commands has to be a positive number");
+            }
+        }
+        prof.PrintTable(p_ctx->out(),top);
+        return;
+    }
+
+    // ------------------------------------------
+    // handle clear
+
+    if( m_args[0] == "clear" ) {
+        CheckNumberOfArguments( m_args, 1, 1 );
+        prof.Clear();
+        return;
+    }
+
+    // ------------------------------------------
+    // handle save and trace
+
+    if( (m_args[0] == "save") || (m_args[0] == "trace") ) {
+        CheckNumberOfArguments( m_args, 2, 2 );
+
+        string name;
+        ExpandArgument( p_ctx, m_args, 1, name );
+
+        ofstream ofs( name.c_str() );
+        if( ! ofs ){
+            stringstream str;
+            str << "unable to open file '" << name << "' for writing";
+            throw runtime_error( str.str() );
+        }
+
+        if( m_args[0] == "save" ){
+            prof.PrintTable(ofs);
+        } else {
+            prof.WriteTrace(ofs);
+        }
+        return;
+    }
+
+    // ------------------------------------------
+    WrongArgument( m_args, 0, "illegal action");
+}
+
+//-------------------------------------------------------------------------------
+
+shared_ptr< CCommand > CProfileCommand::Clone( CContext* p_ctx, const CParser& cmdline ) const
+{
+    NoAssigmentPossible( cmdline );
+
+    return shared_ptr< CCommand >( new CProfileCommand( m_action, cmdline.GetArgs() ) );
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+}
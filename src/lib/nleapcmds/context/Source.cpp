@@ -21,12 +21,17 @@
 
 #include <Source.hpp>
 #include <iostream>
+#include <sstream>
 #include <engine/Context.hpp>
-#include <fstream>
+#include <engine/Parser.hpp>
+#include <format/FileStream.hpp>
+#include <boost/algorithm/string.hpp>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 using std::string;
 using std::vector;
-using std::ifstream;
 
 namespace nleapcmds {
 //==============================================================================
@@ -69,6 +74,10 @@ const char* CSourceCommand::Info( EHelp type ) const
     "Read and execute commands from <u>filename</u>. "
     "If <u>filename</u> does not contain a slash, file names in PATH (see <b>mortenv</b> command) "
     "are used to find the directory containing <u>filename</u>.\n"
+    "\n"
+    "Consecutive <b>loadOff</b>, <b>loadAmberParams</b> and <b>loadAmberPrep</b> commands, whose arguments "
+    "do not refer to variables, read their files concurrently. Loaded objects are added to the database in "
+    "the order of commands in the file.\n"
     );
 }
 
@@ -80,18 +89,132 @@ void CSourceCommand::Exec( CContext* p_ctx )
     real_file = p_ctx->FindFile( m_file  );
     p_ctx->out() << "Loading " << real_file << endl;
 
-    ifstream stream( real_file.c_str() );
+    CInputFile stream( real_file );
     if( ! stream ){
         throw runtime_error("unable to open file");
     }
-    string line;
+    string          line;
+    string          pending;    // incomplete command, see CContext::Process
+    vector<string>  loads;      // run of independent load commands
 
     while( getline( stream, line ) )
     {
+        if( pending.empty() ){
+            if( IsIndependentLoad( line ) || ( ! loads.empty() && IsBlank( line ) ) ){
+                loads.push_back( line );
+                continue;
+            }
+            ProcessLoads( p_ctx, loads );
+            loads.clear();
+        }
+
+        if( ! IsBlank( line ) ){
+            pending += line + " ";
+            if( CParser::CheckSyntax( pending ) != CParser::syntax_intermediate ) pending = "";
+        }
+
         if( p_ctx->Process( line ) == false ){
             throw runtime_error("file processing failed");
         }
     }
+
+    ProcessLoads( p_ctx, loads );
+}
+
+//------------------------------------------------------------------------------
+
+bool CSourceCommand::IsIndependentLoad( const string& line )
+{
+    if( IsBlank( line ) ) return( false );
+    if( CParser::CheckSyntax( line + " " ) != CParser::syntax_valid ) return( false );
+
+    CParser parser;
+    try {
+        parser.Parse( line + " " );
+    } catch( std::exception& e ) {
+        return( false );
+    }
+
+    // loaders only create new objects and variables
+    string cmd = to_lower_copy( parser.GetCmd() );
+    if( (cmd != "loadoff") && (cmd != "loadamberparams") && (cmd != "loadamberprep") ) return( false );
+
+    // arguments must not depend on variables
+    for( size_t i=0; i < parser.GetArgs().size(); i++ ){
+        if( starts_with( parser.GetArgs()[i], "$" ) ) return( false );
+    }
+    return( true );
+}
+
+//------------------------------------------------------------------------------
+
+bool CSourceCommand::IsBlank( const string& line )
+{
+    string tline = trim_copy( line );
+    return( tline.empty() || (tline[0] == '#') );
+}
+
+//------------------------------------------------------------------------------
+
+void CSourceCommand::ProcessLoads( CContext* p_ctx, const vector<string>& lines )
+{
+    vector<int> commands;
+    for( size_t i=0; i < lines.size(); i++ ){
+        if( ! IsBlank( lines[i] ) ) commands.push_back( i );
+    }
+
+    // a single command is not worth of staging
+    if( commands.size() < 2 ){
+        for( size_t i=0; i < lines.size(); i++ ){
+            if( p_ctx->Process( lines[i] ) == false ){
+                throw runtime_error("file processing failed");
+            }
+        }
+        return;
+    }
+
+    // files are parsed into private databases of staging contexts,
+    // contexts must be set up sequentially
+    int ncmds = commands.size();
+    vector<CContextPtr>                 workers;
+    vector< shared_ptr<ostringstream> > outputs;
+    for( int i=0; i < ncmds; i++ ){
+        shared_ptr<ostringstream> output( new ostringstream );
+        CContextPtr worker( new CContext );
+        worker->InitWorker( p_ctx, false );
+        worker->SetOut( output.get() );
+        worker->profiler().Enable( p_ctx->profiler().IsEnabled() );
+        outputs.push_back( output );
+        workers.push_back( worker );
+    }
+
+    vector<int> status( ncmds, 0 );
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic,1)
+#endif
+    for( int i=0; i < ncmds; i++ ){
+        status[i] = workers[i]->Run( lines[commands[i]] ) ? 1 : 0;
+    }
+
+    // merge in script order, the last definition of a variable wins
+    int next = 0;
+    for( size_t i=0; i < lines.size(); i++ ){
+        p_ctx->PrintPrompt( lines[i] );
+
+        if( (next >= ncmds) || (commands[next] != (int)i) ) continue;
+
+        p_ctx->out() << outputs[next]->str();
+        if( status[next] == 0 ){
+            throw runtime_error("file processing failed");
+        }
+
+        int top_id = p_ctx->m_index_counter.GetTopIndex();
+        p_ctx->database()->MergeDatabase( top_id, workers[next]->database() );
+        p_ctx->m_index_counter.SetTopIndex( top_id );
+        p_ctx->RecordWorkerCommand( lines[i], workers[next].get() );
+        next++;
+    }
 }
 
 //------------------------------------------------------------------------------
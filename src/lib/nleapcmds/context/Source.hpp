@@ -50,6 +50,15 @@ public:
 // private data and methods ----------------------------------------------------
 private:
     string m_file;
+
+    /// can the line be executed concurrently with neighbouring load commands?
+    static bool IsIndependentLoad(const string& line);
+
+    /// is the line empty or comment?
+    static bool IsBlank(const string& line);
+
+    /// execute run of independent load commands
+    void ProcessLoads(CContext* p_ctx, const vector<string>& lines);
 };
 
 //------------------------------------------------------------------------------
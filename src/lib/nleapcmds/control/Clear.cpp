@@ -64,7 +64,8 @@ const char* CClearCommand::Info( EHelp type ) const
     "       <b>clear</b>\n"
     "\n"
     "<b>DESCRIPTION:</b>\n"
-    "Clear the entire nLEaP database. This means that all variables, maps, type maps are released or deleted.</u>.\n"
+    "Clear the entire nLEaP database. This means that all variables, maps, type maps are released or deleted.</u>. "
+    "The command history is cleared as well.\n"
     );
 }
 
@@ -73,6 +74,7 @@ const char* CClearCommand::Info( EHelp type ) const
 void CClearCommand::Exec( CContext* p_ctx )
 {
     p_ctx->database()->ClearDatabase();
+    p_ctx->history().Clear();
 }
 
 //------------------------------------------------------------------------------
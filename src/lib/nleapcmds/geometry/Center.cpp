@@ -21,6 +21,9 @@
 
 #include <geometry/Center.hpp>
 #include <engine/Context.hpp>
+#include <core/PredefinedKeys.hpp>
+#include <misc/UnitTopology.hpp>
+#include <iomanip>
 
 namespace nleapcmds {
 //==============================================================================
@@ -60,9 +63,9 @@ const char* CCenterCommand::Info(  EHelp type ) const
     "       <b>center</b> <u>unit</u> [<u>mask</u>]\n"
     "\n"
     "<b>DESCRIPTION:</b>\n"
-    "This command moves the center of mass of the <u>unit</u> either to "
-    "the origin or the center of box. If <u>mask</u> is provided, only "
-    "those in the <u>mask</u> are used to calculate the center of mass."
+    "This command moves the center of mass of the <u>unit</u> to the origin. "
+    "If <u>mask</u> is provided, only atoms in the <u>mask</u> are used to calculate "
+    "the center of mass, the whole <u>unit</u> is moved."
     );
 }
 
@@ -70,7 +73,48 @@ const char* CCenterCommand::Info(  EHelp type ) const
 
 void CCenterCommand::Exec( CContext* p_ctx )
 {
+    CUnitTopology* p_top = m_unit->GetMaskTopology(p_ctx);
+
+    vector<int> atoms;
+    if( m_mask.empty() ){
+        for(int i=0; i < p_top->NumberOfAtoms(); i++){
+            atoms.push_back(i);
+        }
+    } else {
+        p_top->SelectAtoms(m_mask,atoms);
+    }
+
+    if( atoms.empty() ){
+        throw runtime_error("no atom is selected in unit '" + m_unit->GetName() + "'");
+    }
 
+    // center of mass of selected atoms
+    CPoint  com;
+    CPoint  cog;
+    double  tmass = 0.0;
+    for(size_t i=0; i < atoms.size(); i++){
+        CNLAtom* p_atom = p_top->GetTopology()->GetAtom(atoms[i]);
+        com += p_atom->GetPosition()*p_atom->GetMass();
+        cog += p_atom->GetPosition();
+        tmass += p_atom->GetMass();
+    }
+    if( tmass > 0.0 ){
+        com /= tmass;
+    } else {
+        com = cog / atoms.size();
+    }
+
+    // move whole unit
+    for(int i=0; i < p_top->NumberOfAtoms(); i++){
+        CEntityPtr atom = p_top->GetAtom(i);
+        atom->Set(POSX,atom->Get<double>(POSX) - com.x);
+        atom->Set(POSY,atom->Get<double>(POSY) - com.y);
+        atom->Set(POSZ,atom->Get<double>(POSZ) - com.z);
+    }
+
+    p_ctx->out() << "Selected atoms       : " << atoms.size() << endl;
+    p_ctx->out() << fixed << setprecision(4);
+    p_ctx->out() << "Original center      : " << com.x << " " << com.y << " " << com.z << endl;
 }
 
 // -------------------------------------------------------------------------
@@ -78,13 +122,15 @@ void CCenterCommand::Exec( CContext* p_ctx )
 shared_ptr< CCommand > CCenterCommand::Clone( CContext* p_ctx, const CParser& cmdline ) const
 {
     NoAssigmentPossible( cmdline );
-    CheckNumberOfArguments( cmdline, 2, 4);
+    CheckNumberOfArguments( cmdline, 1, 2);
 
     CEntityPtr  unit;
     string      mask;
 
     ExpandArgument( p_ctx , cmdline, 0, unit, UNIT );
-    ExpandArgument( p_ctx , cmdline, 1, mask );
+    if( cmdline.GetArgs().size() > 1 ){
+        ExpandArgument( p_ctx , cmdline, 1, mask );
+    }
 
     return shared_ptr< CCommand >( new CCenterCommand(m_action, dynamic_pointer_cast<CUnit>(unit), mask) );
 }
@@ -0,0 +1,180 @@
+// =============================================================================
+// nLEaP - A molecular manipulation program and coding environment
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2011 Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2006 gLEaP authors, see AUTHORS file in the main directory
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <geometry/Relax.hpp>
+#include <engine/Context.hpp>
+#include <misc/AmberFFEvaluator.hpp>
+#include <misc/Minimizer.hpp>
+#include <misc/UnitTopology.hpp>
+#include <iomanip>
+
+namespace nleapcmds {
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CRelaxCommand::CRelaxCommand( const string& cmd_name )
+    : CCommand( cmd_name )
+{
+}
+
+// -------------------------------------------------------------------------
+
+CRelaxCommand::CRelaxCommand( const string& cmd_name, const CUnitPtr& unit,
+                              const string& frozen, const string& restrained, double weight,
+                              int maxcyc, double rmsgrad )
+    : CCommand( cmd_name, cmd_name ), m_unit( unit ), m_frozen( frozen ),
+      m_restrained( restrained ), m_weight( weight ), m_maxcyc( maxcyc ), m_rmsgrad( rmsgrad )
+{
+}
+
+// -------------------------------------------------------------------------
+
+const char* CRelaxCommand::Info(  EHelp type ) const
+{
+    if( type == help_group )
+    {
+        return("geometry");
+    }
+
+    if( type == help_short )
+    {
+        return("relax unit geometry by energy minimization");
+    }
+    return(
+    "<b>NAME:</b>\n"
+    "       <b>relax</b> - relax unit geometry by energy minimization\n"
+    "\n"
+    "<b>SYNOPSIS:</b>\n"
+    "       <b>relax</b> <u>unit</u> [<u>frozen</u> [<u>restrained</u> [<u>weight</u> [<u>maxcyc</u> [<u>rmsgrad</u>]]]]]\n"
+    "\n"
+    "<b>DESCRIPTION:</b>\n"
+    "This command minimizes the energy of the <u>unit</u> described by the loaded AmberFFs "
+    "using the L-BFGS method and writes the optimized coordinates back to the unit. Atoms "
+    "selected by the <u>frozen</u> mask are kept fixed. Atoms selected by the <u>restrained</u> "
+    "mask are restrained to their initial positions by a harmonic potential with the force "
+    "constant <u>weight</u> (default 10.0 kcal/mol/A^2). Use \"\" for an empty mask. The "
+    "minimization stops after <u>maxcyc</u> steps (default 1000) or when the RMS of gradient "
+    "drops below <u>rmsgrad</u> (default 0.1 kcal/mol/A). Nonbonded interactions are smoothly "
+    "switched off between 6 and 8 A.\n"
+    );
+}
+
+// -------------------------------------------------------------------------
+
+void CRelaxCommand::Exec( CContext* p_ctx )
+{
+    CAmberFFEvaluator ff;
+    ff.Setup(p_ctx,m_unit);
+
+    // masks are evaluated over cached unit topology, which uses
+    // the same atom order as the evaluator
+    CUnitTopology* p_top = m_unit->GetMaskTopology(p_ctx);
+
+    // frozen atoms --------------------------------
+    vector<int>     frozen;
+    vector<char>    frozen_crds(3*ff.NumberOfAtoms(),0);
+    if( ! m_frozen.empty() ) p_top->SelectAtoms(m_frozen,frozen);
+    for(size_t i=0; i < frozen.size(); i++){
+        frozen_crds[3*frozen[i]+0] = 1;
+        frozen_crds[3*frozen[i]+1] = 1;
+        frozen_crds[3*frozen[i]+2] = 1;
+    }
+
+    // restrained atoms ----------------------------
+    vector<int>     restrained;
+    if( ! m_restrained.empty() ) p_top->SelectAtoms(m_restrained,restrained);
+    ff.SetRestraints(restrained,m_weight);
+
+    p_ctx->out() << "Number of atoms      : " << ff.NumberOfAtoms() << endl;
+    p_ctx->out() << "Frozen atoms         : " << frozen.size() << endl;
+    p_ctx->out() << "Restrained atoms     : " << restrained.size() << endl;
+
+    // minimize ------------------------------------
+    CLBFGSMinimizer minimizer;
+    minimizer.SetMaxSteps(m_maxcyc);
+    minimizer.SetRMSGradient(m_rmsgrad);
+    minimizer.SetFrozen(frozen_crds);
+
+    vector<double> crd;
+    ff.GetCoordinates(crd);
+    bool converged = minimizer.Minimize(ff,crd,p_ctx->out());
+
+    // write coordinates back
+    ff.SetCoordinates(crd);
+
+    // the last evaluation can be a rejected line search trial point
+    vector<double> grad;
+    double energy = ff.Evaluate(crd,grad);
+
+    p_ctx->out() << fixed << setprecision(4);
+    p_ctx->out() << "Bond energy          : " << setw(16) << ff.GetBondEnergy() << endl;
+    p_ctx->out() << "Angle energy         : " << setw(16) << ff.GetAngleEnergy() << endl;
+    p_ctx->out() << "Torsion energy       : " << setw(16) << ff.GetTorsionEnergy() << endl;
+    p_ctx->out() << "vdW energy           : " << setw(16) << ff.GetVdWEnergy() << endl;
+    p_ctx->out() << "Electrostatic energy : " << setw(16) << ff.GetEleEnergy() << endl;
+    p_ctx->out() << "Restraint energy     : " << setw(16) << ff.GetRestraintEnergy() << endl;
+    p_ctx->out() << "Total energy         : " << setw(16) << energy << endl;
+    p_ctx->out() << "Neighbour list builds: " << ff.NumberOfListUpdates() << endl;
+    if( ! converged ){
+        p_ctx->out() << "Minimization did not converge in " << minimizer.GetNumberOfSteps() << " steps" << endl;
+    }
+}
+
+// -------------------------------------------------------------------------
+
+shared_ptr< CCommand > CRelaxCommand::Clone( CContext* p_ctx, const CParser& cmdline ) const
+{
+    NoAssigmentPossible( cmdline );
+    CheckNumberOfArguments( cmdline, 1, 6 );
+
+    CEntityPtr  unit;
+    string      frozen;
+    string      restrained;
+    double      weight = 10.0;
+    int         maxcyc = 1000;
+    double      rmsgrad = 0.1;
+
+    ExpandArgument( p_ctx, cmdline, 0, unit, UNIT );
+    if( cmdline.GetArgs().size() > 1 ){
+        ExpandArgument( p_ctx, cmdline, 1, frozen );
+    }
+    if( cmdline.GetArgs().size() > 2 ){
+        ExpandArgument( p_ctx, cmdline, 2, restrained );
+    }
+    if( cmdline.GetArgs().size() > 3 ){
+        ExpandArgument( p_ctx, cmdline, 3, weight );
+    }
+    if( cmdline.GetArgs().size() > 4 ){
+        ExpandArgument( p_ctx, cmdline, 4, maxcyc );
+    }
+    if( cmdline.GetArgs().size() > 5 ){
+        ExpandArgument( p_ctx, cmdline, 5, rmsgrad );
+    }
+
+    return shared_ptr< CCommand >( new CRelaxCommand(m_action, dynamic_pointer_cast<CUnit>(unit),
+                                                     frozen, restrained, weight, maxcyc, rmsgrad) );
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+}
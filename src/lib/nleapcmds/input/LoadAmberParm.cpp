@@ -20,7 +20,7 @@
 // =============================================================================
 
 #include <input/LoadAmberParams.hpp>
-#include <fstream>
+#include <format/FileStream.hpp>
 #include <engine/Context.hpp>
 #include <types/Factory.hpp>
 #include <format/AmberParams.hpp>
@@ -82,7 +82,7 @@ void CLoadAmberParamsCommand::Exec( CContext* p_ctx )
     string real_file = p_ctx->FindFile( m_file  );
     p_ctx->out() << "Loading " << real_file << endl;
 
-    ifstream is( real_file.c_str() );
+    CInputFile is( real_file );
 
     if( ! is ) {
         throw runtime_error( "Cannot open file '" + real_file + "'' for reading." );
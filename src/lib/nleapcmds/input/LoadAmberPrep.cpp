@@ -20,7 +20,7 @@
 // =============================================================================
 
 #include <input/LoadAmberPrep.hpp>
-#include <fstream>
+#include <format/FileStream.hpp>
 #include <engine/Context.hpp>
 #include <types/Factory.hpp>
 #include <format/AmberPrep.hpp>
@@ -37,8 +37,8 @@ CLoadAmberPrepCommand::CLoadAmberPrepCommand( const string& cmd_name )
 
 //------------------------------------------------------------------------------
 
-CLoadAmberPrepCommand::CLoadAmberPrepCommand( const string& cmd_name, const string& file )
-    : CCommand( cmd_name, cmd_name ), m_file( file )
+CLoadAmberPrepCommand::CLoadAmberPrepCommand( const string& cmd_name, const string& file, const string& prefix )
+    : CCommand( cmd_name, cmd_name ), m_file( file ), m_prefix( prefix )
 {
 }
 
@@ -78,13 +78,21 @@ void CLoadAmberPrepCommand::Exec( CContext* p_ctx )
     CDatabasePtr db = p_ctx->database();
 
     // open file
-    ifstream is( m_file.c_str() );
+    string real_file = p_ctx->FindFile( m_file  );
+    p_ctx->out() << "Loading " << real_file << endl;
+
+    CInputFile is( real_file );
 
     if( ! is ) {
-        throw std::runtime_error( "Cannot open file '" + m_file + "'' for reading." );
+        throw runtime_error( "Cannot open file '" + real_file + "'' for reading." );
     }
 
-    // TODO
+    // load PREP file
+    nleap::CAmberPrep   reader( p_ctx->out() );
+    int                 top_id = p_ctx->m_index_counter.GetTopIndex();
+
+    reader.Read( is, db, top_id, m_prefix );
+    p_ctx->m_index_counter.SetTopIndex( top_id );
 }
 
 //------------------------------------------------------------------------------
@@ -92,12 +100,16 @@ void CLoadAmberPrepCommand::Exec( CContext* p_ctx )
 shared_ptr< CCommand > CLoadAmberPrepCommand::Clone( CContext* p_ctx, const CParser& cmdline ) const
 {
     NoAssigmentPossible( cmdline );
-    CheckNumberOfArguments( cmdline, 1, 1);
+    CheckNumberOfArguments( cmdline, 1, 2);
 
     string file;
+    string prefix;
     ExpandArgument( p_ctx, cmdline, 0, file );
+    if( cmdline.GetArgs().size() > 1 ){
+        ExpandArgument( p_ctx, cmdline, 1, prefix );
+    }
 
-    return shared_ptr< CCommand >( new CLoadAmberPrepCommand(m_action, file) );
+    return shared_ptr< CCommand >( new CLoadAmberPrepCommand(m_action, file, prefix) );
 }
 
 //==============================================================================
@@ -36,7 +36,7 @@ public:
 
     CLoadAmberPrepCommand(const string& cmd_name);
 
-    CLoadAmberPrepCommand(const string& cmd_name, const string& file);
+    CLoadAmberPrepCommand(const string& cmd_name, const string& file, const string& prefix);
 
     virtual const char* Info(EHelp type = help_full) const;
 
@@ -47,6 +47,7 @@ public:
 // private data and methods ----------------------------------------------------
 private:
     string m_file;
+    string m_prefix;
 };
 
 //------------------------------------------------------------------------------
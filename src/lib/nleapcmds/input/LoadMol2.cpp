@@ -20,7 +20,7 @@
 // =============================================================================
 
 #include <LoadMol2.hpp>
-#include <fstream>
+#include <format/FileStream.hpp>
 #include <engine/Context.hpp>
 #include <types/Factory.hpp>
 #include <format/SybylMol2.hpp>
@@ -76,7 +76,7 @@ void CLoadMol2Command::Exec( CContext* p_ctx )
     CDatabasePtr db = p_ctx->database();
 
     // open file
-    ifstream is( m_file.c_str() );
+    CInputFile is( m_file );
 
     if( ! is ) {
         throw std::runtime_error( "Cannot open file '" + m_file + "'' for reading." );
@@ -0,0 +1,470 @@
+// =============================================================================
+// nLEaP - A molecular manipulation program and coding environment
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2011 Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2006 gLEaP authors, see AUTHORS file in the main directory
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <ProcessMolecules.hpp>
+#include <format/FileStream.hpp>
+#include <sstream>
+#include <cstring>
+#include <engine/Context.hpp>
+#include <engine/Parser.hpp>
+#include <types/Factory.hpp>
+#include <format/SybylMol2.hpp>
+#include <format/FormatOB.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/format.hpp>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace nleapcmds {
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+
+CProcessMoleculesCommand::CProcessMoleculesCommand( const string& cmd_name )
+    : CCommand( cmd_name )
+{
+    m_change_state = false;
+    m_workers = 0;
+}
+
+//------------------------------------------------------------------------------
+
+CProcessMoleculesCommand::CProcessMoleculesCommand( const string& cmd_name, const string& file,
+                                                    const string& script, int workers )
+    : CCommand( cmd_name, cmd_name ), m_file( file ), m_script( script ), m_workers( workers )
+{
+    m_change_state = false;
+}
+
+//------------------------------------------------------------------------------
+
+const char* CProcessMoleculesCommand::Info(  EHelp type ) const
+{
+    if( type == help_group )
+    {
+        return("input");
+    }
+
+    if( type == help_short )
+    {
+        return("apply a script to every molecule of a multi-molecule file");
+    }
+    return(
+    "<b>NAME:</b>\n"
+    "       <b>processMolecules</b> - apply a script to every molecule of a multi-molecule file\n"
+    "\n"
+    "<b>SYNOPSIS:</b>\n"
+    "       <b>processMolecules</b> <u>filename</u> <u>script</u> [<u>workers</u>]\n"
+    "\n"
+    "<b>DESCRIPTION:</b>\n"
+    "Read molecules from <u>filename</u> one by one and execute commands from the file <u>script</u> "
+    "for each of them. The molecule is loaded into a scratch UNIT referenced by the variable <b>mol</b>, "
+    "the unit is reused for all molecules. Occurrences of <b>%name%</b> and <b>%index%</b> in the script "
+    "are replaced by the molecule name and by its index in the file (starting from 1), "
+    "e.g. <b>saveGromacs mol %name%.top %name%.gro</b>.\n"
+    "\n"
+    "Molecules are processed by <u>workers</u> independent workers (all available threads by default). "
+    "Each worker obtains a private copy of the current database and a contiguous chunk of molecules, "
+    "the file is split at <b>@<TRIPOS>MOLECULE</b> records for MOL2 files and at <b>$$$$</b> records for "
+    "SDF files. Other formats supported by OpenBabel are processed sequentially by a single worker. "
+    "Changes done by the script are not propagated back to the current database and cannot be undone. "
+    "Molecules, for which the script fails, are reported and skipped. "
+    "The file <u>filename</u> is not searched in the PATH, the file <u>script</u> is searched in the PATH "
+    "(see <b>nleap</b> command).\n"
+    );
+}
+
+//------------------------------------------------------------------------------
+
+void CProcessMoleculesCommand::Exec( CContext* p_ctx )
+{
+    vector<string> commands;
+    ReadScript( p_ctx, commands );
+
+    // determine file format, suffix of compressed file is ignored
+    EFormat format = format_other;
+    bool    compressed = CInputFile::DetectCompression( m_file ) != compression_none;
+    string  name = m_file;
+    for(int i=0; CompressedSuffixes[i] != NULL; i++){
+        if( ends_with( name, CompressedSuffixes[i] ) ){
+            name = name.substr( 0, name.size() - strlen(CompressedSuffixes[i]) );
+            break;
+        }
+    }
+    string  ext;
+    size_t  dot = name.rfind('.');
+    if( dot != string::npos ) ext = to_lower_copy( name.substr(dot+1) );
+    if( ext == "mol2" ) format = format_mol2;
+    if( (ext == "sdf") || (ext == "sd") || (ext == "mol") ) format = format_sdf;
+
+    vector<streamoff>   starts;
+    streamoff           end = 0;
+    int                 nmols = -1;     // unknown for sequential processing
+
+    if( format != format_other ){
+        ScanMolecules( format, starts, end );
+        nmols = starts.size();
+        p_ctx->out() << "Found " << nmols << " molecule(s) in " << m_file << endl;
+        if( nmols == 0 ) return;
+    }
+
+    // number of workers
+    int nworkers = m_workers;
+    if( nworkers <= 0 ){
+        nworkers = 1;
+#ifdef _OPENMP
+        nworkers = omp_get_max_threads();
+#endif
+    }
+#ifndef _OPENMP
+    nworkers = 1;
+#endif
+    // compressed data can be read only sequentially
+    if( (format == format_other) || compressed ) nworkers = 1;
+    if( (nmols >= 0) && (nworkers > nmols) ) nworkers = nmols;
+
+    // worker contexts must be set up sequentially, cloning reads the parent database
+    vector<CContextPtr>                 workers;
+    vector< shared_ptr<ostringstream> > outputs;
+    for(int i=0; i < nworkers; i++){
+        shared_ptr<ostringstream> output( new ostringstream );
+        CContextPtr worker( new CContext );
+        worker->InitWorker( p_ctx );
+        worker->SetOut( output.get() );
+        outputs.push_back( output );
+        workers.push_back( worker );
+    }
+
+    p_ctx->out() << "Processing molecules by " << nworkers << " worker(s) ..." << endl;
+
+    int nfailed = 0;
+    int nprocessed = 0;
+
+#ifdef _OPENMP
+    #pragma omp parallel for num_threads(nworkers) schedule(static,1) reduction(+:nfailed,nprocessed)
+#endif
+    for(int w=0; w < nworkers; w++){
+        int first = 0;
+        int last = -1;
+        if( nmols >= 0 ){
+            first = (int)((long)nmols*w/nworkers);
+            last  = (int)((long)nmols*(w+1)/nworkers);
+        }
+        int nchunk = 0;
+        nfailed += ProcessChunk( p_ctx, workers[w].get(), *outputs[w], format, commands,
+                                 starts, end, first, last, nchunk );
+        nprocessed += nchunk;
+    }
+
+    p_ctx->out() << "Processed molecules : " << nprocessed << endl;
+    p_ctx->out() << "Failed molecules    : " << nfailed << endl;
+}
+
+//------------------------------------------------------------------------------
+
+void CProcessMoleculesCommand::ReadScript( CContext* p_ctx, vector<string>& commands )
+{
+    string real_file = p_ctx->FindFile( m_script );
+
+    CInputFile stream( real_file );
+    if( ! stream ){
+        throw runtime_error( "unable to open script '" + real_file + "'" );
+    }
+
+    // join continued lines in the same way as CContext::Process
+    string line;
+    string pending;
+    while( getline( stream, line ) ){
+        string tline = trim_copy( line );
+        if( tline.empty() || (tline[0] == '#') ) continue;
+
+        pending += line + " ";
+        CParser::ESyntaxStatus result = CParser::CheckSyntax( pending );
+        if( result == CParser::syntax_error ){
+            throw runtime_error( "syntax error in script '" + real_file + "' near '" + line + "'" );
+        }
+        if( result == CParser::syntax_intermediate ) continue;
+
+        commands.push_back( pending );
+        pending = "";
+    }
+
+    if( ! pending.empty() ){
+        throw runtime_error( "incomplete command at the end of script '" + real_file + "'" );
+    }
+    if( commands.empty() ){
+        throw runtime_error( "script '" + real_file + "' does not contain any command" );
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void CProcessMoleculesCommand::ScanMolecules( EFormat format, vector<streamoff>& starts,
+                                              streamoff& end )
+{
+    CInputFile is( m_file, ios_base::in | ios_base::binary );
+    if( ! is ) {
+        throw std::runtime_error( "Cannot open file '" + m_file + "'' for reading." );
+    }
+
+    // offsets are accumulated from line lengths, the file is opened in binary mode
+    string      line;
+    streamoff   pos = 0;
+    bool        new_record = (format == format_sdf);
+
+    while( getline( is, line ) ){
+        switch( format ){
+            case format_mol2:
+                if( starts_with( line, "@<TRIPOS>MOLECULE" ) ) starts.push_back( pos );
+                break;
+            case format_sdf:
+                if( new_record && ! trim_copy( line ).empty() ){
+                    starts.push_back( pos );
+                    new_record = false;
+                }
+                if( starts_with( line, "$$$$" ) ) new_record = true;
+                break;
+            default:
+                break;
+        }
+        pos += line.size() + 1;
+    }
+
+    end = pos;
+}
+
+//------------------------------------------------------------------------------
+
+int CProcessMoleculesCommand::ProcessChunk( CContext* p_ctx, CContext* p_worker,
+                                            ostringstream& output, EFormat format,
+                                            const vector<string>& commands,
+                                            const vector<streamoff>& starts, streamoff end,
+                                            int first, int last, int& nprocessed )
+{
+    int nfailed = 0;
+    int index = first;
+
+    try {
+        CInputFile is( m_file, ios_base::in | ios_base::binary );
+        if( ! is ) {
+            throw std::runtime_error( "Cannot open file '" + m_file + "'' for reading." );
+        }
+
+        // scratch unit reused for all molecules
+        CDatabasePtr db = p_worker->database();
+        int top_id = p_worker->m_index_counter.GetTopIndex();
+        CUnitPtr unit = db->CreateUnit( top_id );
+        p_worker->m_index_counter.SetTopIndex( top_id );
+
+        shared_ptr<CSybylMol2>  mol2_reader;
+        string                  record;
+
+        if( format != format_other ){
+            if( is.IsCompressed() ){
+                // offsets refer to decompressed data, the only worker skips them
+                is.ignore( starts[first] );
+            } else {
+                is.seekg( starts[first] );
+            }
+        }
+
+        while( (last < 0) || (index < last) ){
+            if( format == format_other ){
+                is >> ws;
+                if( is.eof() ) break;
+            }
+
+            // load molecule into the scratch unit
+            bool loaded = false;
+            unit->Clear();
+            unit->SetName( string() );
+            top_id = p_worker->m_index_counter.GetTopIndex();
+
+            // compressed stream cannot be repositioned after a broken molecule,
+            // so its molecules are read as whole records
+            bool use_record = (format == format_sdf) || ((format == format_mol2) && is.IsCompressed());
+            if( use_record ){
+                streamoff rend = (index + 1 < (int)starts.size()) ? starts[index+1] : end;
+                record.resize( rend - starts[index] );
+                is.read( &record[0], record.size() );
+            }
+
+            try {
+                switch( format ){
+                    case format_mol2:
+                        if( use_record ){
+                            istringstream   ris( record );
+                            CSybylMol2      reader( p_worker->out() );
+                            if( reader.ReadNext( ris, unit, top_id ) == false ){
+                                throw runtime_error( "unexpected end of file" );
+                            }
+                            break;
+                        }
+                        if( ! mol2_reader ){
+                            mol2_reader = shared_ptr<CSybylMol2>( new CSybylMol2( p_worker->out() ) );
+                        }
+                        if( mol2_reader->ReadNext( is, unit, top_id ) == false ){
+                            throw runtime_error( "unexpected end of file" );
+                        }
+                        break;
+                    case format_sdf: {
+                        // OpenBabel calls are serialized by CFormatOB
+                        istringstream   ris( record );
+                        CFormatOB       reader( p_worker->out() );
+                        reader.Read( ris, unit, top_id, "sdf" );
+                        }
+                        break;
+                    case format_other: {
+                        CFormatOB reader( p_worker->out() );
+                        reader.Read( is, unit, top_id, "auto", m_file );
+                        }
+                        break;
+                }
+                loaded = true;
+            } catch( std::exception& e ) {
+                p_worker->out() << "<b><red>Error:</red></b> unable to read molecule #" << index + 1
+                                << ": " << e.what() << endl;
+                if( format == format_other ){
+                    // position in the stream is lost
+                    nfailed++;
+                    index++;
+                    FlushOutput( p_ctx, output );
+                    break;
+                }
+                // continue with the next molecule
+                mol2_reader = shared_ptr<CSybylMol2>();
+                if( ! use_record && (index + 1 < (int)starts.size()) ){
+                    is.clear();
+                    is.seekg( starts[index+1] );
+                }
+            }
+            p_worker->m_index_counter.SetTopIndex( top_id );
+
+            if( ! loaded || (ProcessMolecule( p_worker, unit, commands, index + 1 ) == false) ){
+                nfailed++;
+            }
+            index++;
+            FlushOutput( p_ctx, output );
+        }
+
+    } catch( std::exception& e ) {
+        p_worker->out() << "<b><red>Error:</red></b> " << e.what() << endl;
+        FlushOutput( p_ctx, output );
+        // remaining molecules of the chunk are not processed
+        if( last > index ){
+            nfailed += last - index;
+            index = last;
+        }
+    }
+
+    nprocessed = index - first;
+    return( nfailed );
+}
+
+//------------------------------------------------------------------------------
+
+bool CProcessMoleculesCommand::ProcessMolecule( CContext* p_worker, CUnitPtr& unit,
+                                                const vector<string>& commands, int index )
+{
+    // molecule name is used in file names
+    string name = unit->GetName();
+    for(size_t i=0; i < name.size(); i++){
+        if( ! (isalnum((unsigned char)name[i]) || (name[i] == '_') || (name[i] == '-') || (name[i] == '.')) ){
+            name[i] = '_';
+        }
+    }
+    trim_if( name, is_any_of("_.") );
+    if( name.empty() ) name = str( format("mol%d") % index );
+
+    p_worker->out() << "> Molecule #" << index << " (" << name << ")" << endl;
+
+    // the script may reassign or release the variable
+    CDatabasePtr db = p_worker->database();
+    if( db->GetVariableObject( "mol" ) != unit ){
+        int top_id = p_worker->m_index_counter.GetTopIndex();
+        db->SetVariable( top_id, "mol", unit );
+        p_worker->m_index_counter.SetTopIndex( top_id );
+    }
+
+    for(size_t i=0; i < commands.size(); i++){
+        if( p_worker->Run( ExpandTemplate( commands[i], name, index ) ) == false ){
+            p_worker->out() << "<b><red>Error:</red></b> script failed for molecule #" << index
+                            << " (" << name << ")" << endl;
+            return(false);
+        }
+    }
+
+    return(true);
+}
+
+//------------------------------------------------------------------------------
+
+void CProcessMoleculesCommand::FlushOutput( CContext* p_ctx, ostringstream& output )
+{
+#ifdef _OPENMP
+    #pragma omp critical(nleap_output)
+#endif
+    {
+        p_ctx->out() << output.str();
+        p_ctx->out().flush();
+    }
+    output.str( string() );
+}
+
+//------------------------------------------------------------------------------
+
+string CProcessMoleculesCommand::ExpandTemplate( const string& cmd, const string& name, int index )
+{
+    string expanded = cmd;
+    replace_all( expanded, "%name%", name );
+    replace_all( expanded, "%index%", str( format("%d") % index ) );
+    return( expanded );
+}
+
+//------------------------------------------------------------------------------
+
+shared_ptr< CCommand > CProcessMoleculesCommand::Clone( CContext* p_ctx, const CParser& cmdline ) const
+{
+    NoAssigmentPossible( cmdline );
+    CheckNumberOfArguments( cmdline, 2 , 3);
+
+    string  file;
+    string  script;
+    int     workers = 0;
+
+    ExpandArgument( p_ctx, cmdline, 0, file );
+    ExpandArgument( p_ctx, cmdline, 1, script );
+
+    if( cmdline.GetArgs().size() == 3 ){
+        ExpandArgument( p_ctx, cmdline, 2, workers );
+        if( workers <= 0 ){
+            WrongArgument( cmdline, 2, "number of workers must be positive" );
+        }
+    }
+
+    return shared_ptr< CCommand >( new CProcessMoleculesCommand(m_action, file, script, workers) );
+}
+
+//==============================================================================
+//------------------------------------------------------------------------------
+//==============================================================================
+}
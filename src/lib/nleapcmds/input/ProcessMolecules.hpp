@@ -0,0 +1,88 @@
+#ifndef NLEAPSCMDS_PROCESSMOLECULES_H
+#define NLEAPSCMDS_PROCESSMOLECULES_H
+// =============================================================================
+// nLEaP - A molecular manipulation program and coding environment
+// -----------------------------------------------------------------------------
+//     Copyright (C) 2011 Petr Kulhanek, kulhanek@chemi.muni.cz
+//     Copyright (C) 2006 gLEaP authors, see AUTHORS file in the main directory
+//
+//     This program is free software; you can redistribute it and/or modify
+//     it under the terms of the GNU General Public License as published by
+//     the Free Software Foundation; either version 2 of the License, or
+//     (at your option) any later version.
+//
+//     This program is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU General Public License for more details.
+//
+//     You should have received a copy of the GNU General Public License along
+//     with this program; if not, write to the Free Software Foundation, Inc.,
+//     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+// =============================================================================
+
+#include <engine/Command.hpp>
+#include <types/Unit.hpp>
+#include <iosfwd>
+#include <vector>
+
+namespace nleapcmds {
+//------------------------------------------------------------------------------
+
+using namespace nleap;
+
+//------------------------------------------------------------------------------
+/// apply script template to every molecule of multi-molecule file
+/// \ingroup nleapcmds
+class CProcessMoleculesCommand : public CCommand {
+public:
+
+    CProcessMoleculesCommand(const string& cmd_name);
+
+    CProcessMoleculesCommand(const string& cmd_name, const string& file, const string& script,
+                             int workers);
+
+    virtual const char* Info(EHelp type = help_full) const;
+
+    virtual void Exec(CContext* p_ctx);
+
+    virtual shared_ptr< CCommand > Clone(CContext* p_ctx, const CParser& cmdline) const;
+
+// private data and methods ----------------------------------------------------
+private:
+    enum EFormat {
+        format_mol2,    // split at @<TRIPOS>MOLECULE records
+        format_sdf,     // split at $$$$ records
+        format_other    // any OpenBabel format, read sequentially
+    };
+
+    string  m_file;
+    string  m_script;
+    int     m_workers;
+
+    /// read script and split it into complete commands
+    void ReadScript(CContext* p_ctx, vector<string>& commands);
+
+    /// find offsets of all molecules in the file
+    void ScanMolecules(EFormat format, vector<streamoff>& starts, streamoff& end);
+
+    /// process molecules [first,last) by worker, return number of failed molecules
+    int ProcessChunk(CContext* p_ctx, CContext* p_worker, ostringstream& output,
+                     EFormat format, const vector<string>& commands,
+                     const vector<streamoff>& starts, streamoff end, int first, int last,
+                     int& nprocessed);
+
+    /// run script for the molecule loaded into the scratch unit
+    bool ProcessMolecule(CContext* p_worker, CUnitPtr& unit, const vector<string>& commands,
+                         int index);
+
+    /// copy worker output to the context output
+    void FlushOutput(CContext* p_ctx, ostringstream& output);
+
+    /// substitute %name% and %index% placeholders
+    static string ExpandTemplate(const string& cmd, const string& name, int index);
+};
+
+//------------------------------------------------------------------------------
+}
+#endif
@@ -20,7 +20,7 @@
 // =============================================================================
 
 #include <LoadOB.hpp>
-#include <fstream>
+#include <format/FileStream.hpp>
 #include <engine/Context.hpp>
 #include <types/Factory.hpp>
 #include <format/FormatOB.hpp>
@@ -64,7 +64,7 @@ const char* CLoadOBCommand::Info(  EHelp type ) const
     "\n"
     "<b>DESCRIPTION:</b>\n"
     "Load the file <u>filename</u> into the UNIT referenced by the <u>variable</u>. "
-    "The format of the file is autodetected. However if the autodetection fails the user can "
+    "The format of the file is autodetected from <u>filename</u> extension. If the autodetection fails the user can "
     "specify the format using the <u>format</u> option. The list of formats can be obtained by "
     " <b>listOBFormats</b>. "
     "The file <u>filename</u> is not searched in the PATH (see <b>nleap</b> command).\n"
@@ -78,7 +78,7 @@ void CLoadOBCommand::Exec( CContext* p_ctx )
     CDatabasePtr db = p_ctx->database();
 
     // open file
-    ifstream is( m_file.c_str() );
+    CInputFile is( m_file );
 
     if( ! is ) {
         throw std::runtime_error( "Cannot open file '" + m_file + "'' for reading." );
@@ -89,7 +89,7 @@ void CLoadOBCommand::Exec( CContext* p_ctx )
     CUnitPtr unit = db->CreateUnit( top_id );
 
     CFormatOB  reader( p_ctx->out() );
-    reader.Read( is, unit, top_id, m_format );
+    reader.Read( is, unit, top_id, m_format, m_file );
 
     // set variable
     db->SetVariable( top_id, m_var, unit );
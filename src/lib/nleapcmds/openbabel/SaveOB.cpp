@@ -20,7 +20,7 @@
 // =============================================================================
 
 #include <SaveOB.hpp>
-#include <fstream>
+#include <format/FileStream.hpp>
 #include <engine/Context.hpp>
 #include <types/Factory.hpp>
 #include <format/FormatOB.hpp>
@@ -75,7 +75,7 @@ const char* CSaveOBCommand::Info(  EHelp type ) const
 void CSaveOBCommand::Exec( CContext* p_ctx )
 {
     // open file
-    ofstream os( m_file.c_str() );
+    COutputFile os( m_file );
 
     if( ! os ) {
         throw std::runtime_error( "Cannot open file '" + m_file + "'' for writing." );
@@ -84,7 +84,8 @@ void CSaveOBCommand::Exec( CContext* p_ctx )
     CUnitPtr unit = dynamic_pointer_cast<CUnit>( m_unit );
 
     CFormatOB  writer( p_ctx->out() );
-    writer.Write( os, unit, m_format );
+    writer.Write( os, unit, m_format, m_file );
+    os.Close();
 }
 
 //------------------------------------------------------------------------------
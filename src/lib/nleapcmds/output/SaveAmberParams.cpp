@@ -20,9 +20,11 @@
 // =============================================================================
 
 #include <SaveAmberParams.hpp>
-#include <fstream>
+#include <format/FileStream.hpp>
 #include <engine/Context.hpp>
 #include <types/Factory.hpp>
+#include <types/AmberFF.hpp>
+#include <format/AmberParams.hpp>
 
 
 namespace nleapcmds {
@@ -33,13 +35,15 @@ namespace nleapcmds {
 CSaveAmberParamsCommand::CSaveAmberParamsCommand( const string& cmd_name )
     : CCommand( cmd_name )
 {
+    m_change_state = false;
 }
 
 //------------------------------------------------------------------------------
 
-CSaveAmberParamsCommand::CSaveAmberParamsCommand( const string& cmd_name, const CEntityPtr& unit, const string& file )
-    : CCommand( cmd_name, cmd_name ), m_unit( unit ), m_file( file )
+CSaveAmberParamsCommand::CSaveAmberParamsCommand( const string& cmd_name, const CEntityPtr& object, const string& file )
+    : CCommand( cmd_name, cmd_name ), m_object( object ), m_file( file )
 {
+    m_change_state = false;
 }
 
 //------------------------------------------------------------------------------
@@ -56,7 +60,18 @@ const char* CSaveAmberParamsCommand::Info(  EHelp type ) const
         return("save an AMBER format parameter set file");
     }
     return(
-    ""
+    "<b>NAME:</b>\n"
+    "       <b>saveAmberParams</b> - save an AMBER format parameter set file\n"
+    "\n"
+    "<b>SYNOPSIS:</b>\n"
+    "       <b>saveAmberParams</b> <u>object</u> <u>filename</u>\n"
+    "\n"
+    "<b>DESCRIPTION:</b>\n"
+    "If <u>object</u> is an AmberFF parameter set, the whole set is written into <u>filename</u>. "
+    "If <u>object</u> is a UNIT, only the parameters of atom types, bonds, angles, torsions, "
+    "and impropers present in the UNIT are taken from the loaded AmberFF parameter sets and written "
+    "into <u>filename</u> as a frcmod file. Records are sorted by their atom types. "
+    "Both files can be read back by the <b>loadAmberParams</b> command."
     );
 }
 
@@ -64,14 +79,32 @@ const char* CSaveAmberParamsCommand::Info(  EHelp type ) const
 
 void CSaveAmberParamsCommand::Exec( CContext* p_ctx )
 {
+    list<CAmberFFPtr> ffs;
+    if( m_object->GetType() == UNIT ) {
+        CAmberFF::CacheFFs( p_ctx->database(), ffs );
+        if( ffs.empty() ) {
+            throw std::runtime_error( "no AmberFF is loaded" );
+        }
+    }
+
     // open file
-    ofstream os( m_file.c_str() );
+    COutputFile os( m_file );
 
     if( ! os ) {
         throw std::runtime_error( "Cannot open file '" + m_file + "'' for writing." );
     }
 
-    // TODO
+    // write parameters
+    CAmberParams    writer( p_ctx->out() );
+
+    if( m_object->GetType() == UNIT ) {
+        CUnitPtr unit = dynamic_pointer_cast<CUnit>( m_object );
+        writer.WriteUsed( os, unit, ffs );
+    } else {
+        CAmberFFPtr ff = dynamic_pointer_cast<CAmberFF>( m_object );
+        writer.Write( os, ff );
+    }
+    os.Close();
 }
 
 //------------------------------------------------------------------------------
@@ -81,13 +114,16 @@ shared_ptr< CCommand > CSaveAmberParamsCommand::Clone( CContext* p_ctx, const CP
     NoAssigmentPossible( cmdline );
     CheckNumberOfArguments( cmdline, 2, 2);
 
-    CEntityPtr  unit;
+    CEntityPtr  object;
     string      file;
 
-    ExpandArgument( p_ctx , cmdline, 0, unit, UNIT );
+    ExpandArgument( p_ctx , cmdline, 0, object, ANY );
+    if( (object->GetType() != UNIT) && (object->GetType() != AMBERFF) ) {
+        WrongArgument( cmdline, 0, "UNIT or AMBERFF expected but " + object->GetType().GetName() + " provided" );
+    }
     ExpandArgument( p_ctx , cmdline, 1, file );
 
-    return shared_ptr< CCommand >( new CSaveAmberParamsCommand(m_action, unit, file) );
+    return shared_ptr< CCommand >( new CSaveAmberParamsCommand(m_action, object, file) );
 }
 
 //==============================================================================
@@ -37,7 +37,7 @@ public:
 
     CSaveAmberParamsCommand(const string& cmd_name);
 
-    CSaveAmberParamsCommand(const string& cmd_name, const CEntityPtr& unit, const string& file);
+    CSaveAmberParamsCommand(const string& cmd_name, const CEntityPtr& object, const string& file);
 
     virtual const char* Info(EHelp type = help_full) const;
 
@@ -47,7 +47,7 @@ public:
 
 // private data and methods ----------------------------------------------------
 private:
-    CEntityPtr  m_unit;
+    CEntityPtr  m_object;   // unit or amberff
     string      m_file;
 };
 
@@ -20,7 +20,7 @@
 // =============================================================================
 
 #include <SaveGaussian.hpp>
-#include <fstream>
+#include <format/FileStream.hpp>
 #include <engine/Context.hpp>
 #include <types/Factory.hpp>
 
@@ -64,7 +64,7 @@ const char* CSaveGaussianCommand::Info(  EHelp type ) const
 void CSaveGaussianCommand::Exec( CContext* p_ctx )
 {
     // open file
-    ofstream os( m_file.c_str() );
+    COutputFile os( m_file );
 
     if( ! os ) {
         throw std::runtime_error( "Cannot open file '" + m_file + "'' for writing." );
@@ -20,9 +20,12 @@
 // =============================================================================
 
 #include <SaveGromacs.hpp>
-#include <fstream>
+#include <format/FileStream.hpp>
 #include <engine/Context.hpp>
 #include <types/Factory.hpp>
+#include <types/AmberFF.hpp>
+#include <format/Gromacs.hpp>
+#include <boost/algorithm/string.hpp>
 
 namespace nleapcmds {
 //==============================================================================
@@ -32,13 +35,17 @@ namespace nleapcmds {
 CSaveGromacsCommand::CSaveGromacsCommand( const string& cmd_name )
     : CCommand( cmd_name )
 {
+    m_change_state = false;
 }
 
 //------------------------------------------------------------------------------
 
-CSaveGromacsCommand::CSaveGromacsCommand( const string& cmd_name, const CEntityPtr& unit, const string& file )
-    : CCommand( cmd_name, cmd_name ), m_unit( unit ), m_file( file )
+CSaveGromacsCommand::CSaveGromacsCommand( const string& cmd_name, const CEntityPtr& unit,
+                                          const string& file, const string& crd_file, double buffer )
+    : CCommand( cmd_name, cmd_name ), m_unit( unit ), m_file( file ), m_crd_file( crd_file ),
+      m_buffer( buffer )
 {
+    m_change_state = false;
 }
 
 //------------------------------------------------------------------------------
@@ -52,10 +59,30 @@ const char* CSaveGromacsCommand::Info(  EHelp type ) const
 
     if( type == help_short )
     {
-        return("");
+        return("save GROMACS topology and coordinate files");
     }
     return(
-    ""
+    "<b>NAME:</b>\n"
+    "       <b>saveGromacs</b> - save GROMACS topology and coordinate files\n"
+    "\n"
+    "<b>SYNOPSIS:</b>\n"
+    "       <b>saveGromacs</b> <u>unit</u> <u>topfile</u> [<u>grofile</u> [<u>buffer</u>]]\n"
+    "\n"
+    "<b>DESCRIPTION:</b>\n"
+    "Write the UNIT <u>unit</u> into the GROMACS topology file <u>topfile</u> and the coordinate "
+    "file <u>grofile</u>. If <u>grofile</u> is not given, it is derived from <u>topfile</u> "
+    "by replacing the .top extension with .gro. Parameters are taken from the loaded "
+    "AmberFF parameter sets and converted to GROMACS units.\n"
+    "\n"
+    "Identical molecules, e.g. solvent molecules or repeated chains, are written as one "
+    "[ moleculetype ] and counted in [ molecules ], thus the size of the topology depends "
+    "on the number of unique molecules only.\n"
+    "\n"
+    "The unit has no periodic box, thus the box vectors in the coordinate file are derived from "
+    "the bounding box of the unit. If <u>buffer</u> (in angstroms) is given, the bounding box is "
+    "enlarged by <u>buffer</u> on each side and the unit is moved into it. Otherwise, the bounding "
+    "box is used as it is and a warning is printed since periodic images of atoms at the box faces "
+    "overlap."
     );
 }
 
@@ -63,18 +90,34 @@ const char* CSaveGromacsCommand::Info(  EHelp type ) const
 
 void CSaveGromacsCommand::Exec( CContext* p_ctx )
 {
-    // open file
-    ofstream os( m_file.c_str() );
+    list<CAmberFFPtr> ffs;
+    CAmberFF::CacheFFs( p_ctx->database(), ffs );
 
-    if( ! os ) {
+    if( ffs.empty() ) {
+        throw std::runtime_error( "no AmberFF is loaded" );
+    }
+
+    // open files
+    COutputFile top( m_file );
+
+    if( ! top ) {
         throw std::runtime_error( "Cannot open file '" + m_file + "'' for writing." );
     }
 
-    // write unit
+    COutputFile gro( m_crd_file );
 
+    if( ! gro ) {
+        throw std::runtime_error( "Cannot open file '" + m_crd_file + "'' for writing." );
+    }
+
+    // write unit
+    CGromacs    writer( p_ctx->out() );
+    writer.SetBoxBuffer( m_buffer );
 
     CUnitPtr unit = dynamic_pointer_cast<CUnit>( m_unit );
-    // TODO
+    writer.Write( top, gro, unit, ffs );
+    top.Close();
+    gro.Close();
 }
 
 //------------------------------------------------------------------------------
@@ -82,15 +125,43 @@ void CSaveGromacsCommand::Exec( CContext* p_ctx )
 shared_ptr< CCommand > CSaveGromacsCommand::Clone( CContext* p_ctx, const CParser& cmdline ) const
 {
     NoAssigmentPossible( cmdline );
-    CheckNumberOfArguments( cmdline, 2, 2);
+    CheckNumberOfArguments( cmdline, 2, 4);
 
     CEntityPtr  unit;
     string      file;
+    string      crd_file;
 
     ExpandArgument( p_ctx, cmdline, 0, unit, UNIT );
     ExpandArgument( p_ctx, cmdline, 1, file );
 
-    return shared_ptr< CCommand >( new CSaveGromacsCommand(m_action, unit, file) );
+    if( cmdline.GetArgs().size() > 2 ){
+        ExpandArgument( p_ctx, cmdline, 2, crd_file );
+    } else {
+        // name.top[.gz] -> name.gro[.gz]
+        string suffix;
+        crd_file = file;
+        for(int i=0; CompressedSuffixes[i] != NULL; i++){
+            if( ends_with( crd_file, CompressedSuffixes[i] ) ){
+                suffix = CompressedSuffixes[i];
+                crd_file.erase( crd_file.size() - suffix.size() );
+                break;
+            }
+        }
+        if( ends_with( crd_file, ".top" ) ){
+            crd_file.erase( crd_file.size() - 4 );
+        }
+        crd_file += ".gro" + suffix;
+    }
+
+    double buffer = 0.0;
+    if( cmdline.GetArgs().size() > 3 ){
+        ExpandArgument( p_ctx, cmdline, 3, buffer );
+        if( buffer < 0.0 ){
+            WrongArgument( cmdline, 3, "buffer has to be a non-negative number" );
+        }
+    }
+
+    return shared_ptr< CCommand >( new CSaveGromacsCommand(m_action, unit, file, crd_file, buffer) );
 }
 
 //==============================================================================
@@ -29,7 +29,7 @@ namespace nleapcmds {
 using namespace nleap;
 
 //------------------------------------------------------------------------------
-/// savemol2 structure
+/// save GROMACS topology and coordinates
 /// \ingroup nleapcmds
 
 class CSaveGromacsCommand : public CCommand {
@@ -37,7 +37,8 @@ public:
 
     CSaveGromacsCommand(const string& cmd_name);
 
-    CSaveGromacsCommand(const string& cmd_name, const CEntityPtr& unit, const string& file);
+    CSaveGromacsCommand(const string& cmd_name, const CEntityPtr& unit,
+                        const string& file, const string& crd_file, double buffer);
 
     virtual const char* Info(EHelp type = help_full) const;
 
@@ -49,6 +50,8 @@ public:
 private:
     CEntityPtr  m_unit;
     string      m_file;
+    string      m_crd_file;
+    double      m_buffer;
 };
 
 //------------------------------------------------------------------------------
@@ -20,7 +20,7 @@
 // =============================================================================
 
 #include <SaveMol2.hpp>
-#include <fstream>
+#include <format/FileStream.hpp>
 #include <engine/Context.hpp>
 #include <types/Factory.hpp>
 #include <format/SybylMol2.hpp>
@@ -72,7 +72,7 @@ const char* CSaveMol2Command::Info(  EHelp type ) const
 void CSaveMol2Command::Exec( CContext* p_ctx )
 {
     // open file
-    ofstream os( m_file.c_str() );
+    COutputFile os( m_file );
 
     if( ! os ) {
         throw std::runtime_error( "Cannot open file '" + m_file + "'' for writing." );
@@ -83,6 +83,7 @@ void CSaveMol2Command::Exec( CContext* p_ctx )
 
     CUnitPtr unit = dynamic_pointer_cast<CUnit>( m_unit );
     writer.Write( os, unit );
+    os.Close();
 }
 
 //------------------------------------------------------------------------------
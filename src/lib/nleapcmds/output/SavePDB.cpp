@@ -20,7 +20,7 @@
 // =============================================================================
 
 #include <SavePDB.hpp>
-#include <fstream>
+#include <format/FileStream.hpp>
 #include <engine/Context.hpp>
 #include <types/Factory.hpp>
 #include <format/SybylMol2.hpp>
@@ -74,7 +74,7 @@ void CSavePDBCommand::Exec( CContext* p_ctx )
     CDatabasePtr db = p_ctx->database();
 
     // open file
-    ofstream is( m_file.c_str() );
+    COutputFile is( m_file );
 
     if( ! is ) {
         throw std::runtime_error( "Cannot open file '" + m_file + "'' for writing." );
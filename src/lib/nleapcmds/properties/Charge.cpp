@@ -21,6 +21,7 @@
 
 #include <Charge.hpp>
 #include <engine/Context.hpp>
+#include <types/Unit.hpp>
 #include <iomanip>
 
 namespace nleapcmds {
@@ -77,15 +78,9 @@ void CChargeCommand::Exec( CContext* p_ctx )
     if( m_obj->GetType() == ATOM ){
         charge = m_obj->Get<double>(CHARGE);
     } else {
-        CRecursiveIterator it = CRecursiveIterator(m_obj);
-        it.SetFilter(ATOM);
-        it.SetToBegin();
-        CRecursiveIterator ie = it;
-        ie.SetToEnd();
-
-        while( it != ie ){
+        CAtomRange atoms = GetAtomRange(m_obj);
+        for(CAtomRange::iterator it = atoms.begin(); it != atoms.end(); it++){
             charge += it->Get<double>(CHARGE);
-            it++;
         }
     }
 
@@ -21,6 +21,7 @@
 
 #include <Dipole.hpp>
 #include <engine/Context.hpp>
+#include <types/Unit.hpp>
 #include <Point.hpp>
 #include <iomanip>
 
@@ -73,16 +74,12 @@ const char* CDipoleCommand::Info( EHelp type ) const
 
 void CDipoleCommand::Exec( CContext* p_ctx )
 {
-    CRecursiveIterator it = CRecursiveIterator(m_obj);
-    it.SetFilter(ATOM);
-    it.SetToBegin();
-    CRecursiveIterator ie = it;
-    ie.SetToEnd();
+    CAtomRange atoms = GetAtomRange(m_obj);
 
     // calculate COM -----------------------
     CPoint com;
     double tmass = 0.0;
-    while( it != ie ){
+    for(CAtomRange::iterator it = atoms.begin(); it != atoms.end(); it++){
         CPoint pos;
         double mass;
         pos.x = it->Get<double>(POSX);
@@ -91,7 +88,6 @@ void CDipoleCommand::Exec( CContext* p_ctx )
         mass  = CAtomTypes::GetMass( p_ctx, it->Get<string>(TYPE) );
         com   += pos*mass;
         tmass += mass;
-        it++;
     }
 
     if( tmass == 0 ){
@@ -101,10 +97,9 @@ void CDipoleCommand::Exec( CContext* p_ctx )
     com /= tmass;
 
     // calculate dipole moment -------------
-    it.SetToBegin();
     CPoint dip;
 
-    while( it != ie ){
+    for(CAtomRange::iterator it = atoms.begin(); it != atoms.end(); it++){
         CPoint pos;
         double charge;
         pos.x  = it->Get<double>(POSX);
@@ -113,8 +108,6 @@ void CDipoleCommand::Exec( CContext* p_ctx )
         charge = it->Get<double>(CHARGE);
 
         dip += (pos - com)*charge;
-
-        it++;
     }
 
     // convert to Debye